@@ -15,48 +15,71 @@
  * numbers. To calculate: Letter*16 + number
  * UART1TX = F8
  */
-static const int LED_PIN = 65; //LED2 red
-static const int TIME_STEP = 106; //Time step in milliseconds
-static const int NUM_SERVOS = 12; //Servos numbered 0-31
-
-enum JointType { 
-    HIP1,   //Hip Rotate
-    HIP2,   //Hip in/out
-    HIP3,   //Hip front/back
-    KNEE,   //Knee
-    ANKLE1, //Ankle front/back, 
-    ANKLE2  //Ankle left/right 
-};
+#include <stdio.h>
+#include <string.h>
+#include <FixMath.h>
+#include <LegIK.h>
+#include <FootPlanner.h>
+#include <Interpolator.h>
+#include <MotionBlend.h>
+#include <Cpg.h>
+#include <GaitSet.h>
+#include <GaitTable.h>
+#include "ReportGait.h"
+#include <ServoTable.h>
+#include <Crc16.h>
+#include <ServoCal.h>
+#include <Profiler.h>
+#include <Trace.h>
+#include <Wire.h>
+#include <ImuFusion.h>
+#include <FuzzyTS.h>
+#include <BalancePD.h>
+#include <CurrentBudget.h>
+#include <GaitEngine.h>
 
-typedef struct {
-    JointType jointType;
-    String pin;
-    String postion;
-    String movTime;
-    String command;
-} Servo;
+static const int LED_PIN = 65; //LED2 red
+static const int IMU_PERIOD = 5; //IMU sample period in milliseconds
+static const int IMU_GYRO_RANGE = 250; //Gyro full scale set by imuSetup() in degrees per second
 
-String servoIDs[NUM_SERVOS];
-String sscOutputs[NUM_SERVOS];
-String sscSpeeds[NUM_SERVOS];
-String sscCommands[NUM_SERVOS];
+// The robot's servos, see GaitEngine.h
+SERVO_TABLE_DEFINE(ENGINE_SERVO_TABLE)
 
-String sscFinalCommand = "";
 String terminalCommand = ""; //command from PC terminal
-
-int counter = 0;
-int operatingMode = 2; // 0 stop, 1 move, 2 manual servo control
 bool commandComplete = false;
 
-// Given a servo calculate output as ssc Positon Value
-String calcServoOutput(int servo, int time);
-// A sine function that generates an output from 500 to 2500
-String sineFunctionA(int time);
+/* The modes, the gaits, the balance, the current budget and the
+ * calibration are the gait engine's (libraries/GaitEngine), shared with
+ * MPLABprojects/RobotController. This sketch reads the PC's commands and
+ * the IMU (mpu6050.pde) and sends the engine's frames to the SSC32.
+ */
+GaitEngine engine;
+
+void printLine(const char *line)
+{
+    Serial.println(line);
+}
+
+// Calibration from the servo table, nothing saved until "calsave"
+void calDefaults(ServoCal *cal)
+{
+    servocal_init(cal, NUM_SERVOS);
+    ServoFrame<NUM_SERVOS>::describe(cal->neutral, cal->minPulse, cal->maxPulse, cal->dir, cal->gain);
+    servocal_update(cal);
+}
+
+static const EngineConfig engineConfig = {
+    NUM_SERVOS, servoChannel, &reportGait, IMU_GYRO_RANGE, printLine, calDefaults
+};
+
+unsigned long imuSampleTime; // micros() of the last fused sample
+unsigned long imuReadTime;   // micros() of the last read, good or not
 
 void setup() 
 {   
-    //UART to SSC32
-    Serial0.begin(38400);   
+    //UART to SSC32, baud jumpers set to 115.2k. A 12 servo frame is about
+    //100 characters, 9ms here but 26ms at 38.4k, longer than ENGINE_FRAME_MS
+    Serial0.begin(115200);   
 
     //USB to PC for commands/debug
     Serial.begin(9600);
@@ -65,22 +88,10 @@ void setup()
     pinMode(LED_PIN, OUTPUT); 
     digitalWrite(LED_PIN, HIGH); //High is off
 
-    //Initialize Servo pins;
-    //Right leg 0-5
-    servoIDs[0] = 0; //Hip Rotate
-    servoIDs[1] = 1; //Hip in/out
-    servoIDs[2] = 2; //Hip front/back
-    servoIDs[3] = 3; //Knee
-    servoIDs[4] = 4; //Ankle front/back
-    servoIDs[5] = 5; //Ankle left/right
-
-    //Left leg 16-21
-    servoIDs[6] = 16; //Hip Rotate
-    servoIDs[7] = 17; //Hip in/out
-    servoIDs[8] = 18; //Hip front/back
-    servoIDs[9] = 19; //Knee
-    servoIDs[10] = 20; //Ankle front/back
-    servoIDs[11] = 21; //Ankle left/right
+    engine_init(&engine, &engineConfig);
+    engine.imuReady = imuSetup();
+    if (!engine.imuReady)
+        Serial.println("no IMU, balance disabled");
 }
 
 void loop()
@@ -92,15 +103,15 @@ void loop()
     readCommand();
     parseCommand();
 
-    if (operatingMode == 1) 
-        walkingMode();
-    else if (operatingMode == 0) 
-        stopMode();
+    imuTask();
+    controlFrame();
 }
 
+// Reads up to the end of one line, the rest waits in the serial buffer for
+// the next pass so a PC tool may send several commands in one write
 void readCommand()
 {
-    while (Serial.available()>0) {
+    while (!commandComplete && Serial.available()>0) {
         char c = (char)Serial.read();
         Serial.print(c);
 
@@ -113,125 +124,160 @@ void readCommand()
     }
 }
 
+/* Hands a complete line to the gait engine without its end. What neither
+ * the engine nor debugCommand() takes goes to the SSC32 as it is, and the
+ * engine starts its next frame from wherever that leaves the servos.
+ */
 void parseCommand()
 {
+    char text[SERVO_FRAME_SIZE(32)];
+    int length;
+
     if (commandComplete) {
+        TRACE_INSTANT(TRACE_COMMAND, terminalCommand.length());
         Serial.print("Recieved: " + terminalCommand);
-        if (terminalCommand == "walk\n")
-            operatingMode = 1;
-        else if (terminalCommand == "stand\n")
-            operatingMode = 0;
-        else if (terminalCommand == "direct\n")
-            operatingMode = 2;
-        else {
-            sendSSC32Command(terminalCommand);
+        terminalCommand.toCharArray(text, sizeof(text));
+        length = strlen(text);
+        while (length > 0 && (text[length - 1] == '\n' || text[length - 1] == '\r'))
+            text[--length] = 0;
+        if (!engine_command(&engine, text) && !debugCommand(text)) {
+            sendSSC32Command(text);
+            engine_servos_moved(&engine);
         }
         terminalCommand = "";
         commandComplete = false;
         Serial.print("Current mode: ");
-        Serial.println(operatingMode);
+        Serial.println(engine.mode);
     }
 }
 
-void sendSSC32Command(String command) 
+// The profiler and trace dumps, true if the command was one
+bool debugCommand(const char *command)
 {
+#ifdef PROFILE_ENABLE
+    if (strcmp(command, "prof") == 0) {
+        sendProfile();
+        return true;
+    }
+    if (strcmp(command, "profreset") == 0) {
+        prof_reset();
+        return true;
+    }
+#endif
+#ifdef TRACE_ENABLE
+    if (strcmp(command, "trace") == 0) {
+        sendTrace();
+        return true;
+    }
+#endif
+    return false;
+}
+
+void sendSSC32Command(const char *command) 
+{
+    PROF_START(PROF_SEND_SSC32);
+    TRACE_BEGIN(TRACE_SSC32_SEND, strlen(command));
     digitalWrite(LED_PIN, LOW);
 
     Serial0.println(command);
 
     digitalWrite(LED_PIN, HIGH);  
+    TRACE_END(TRACE_SSC32_SEND, 0);
+    PROF_STOP(PROF_SEND_SSC32);
 }
 
-void walkingMode()
+#ifdef PROFILE_ENABLE
+/* Dumps the profiler statistics to the PC as one CSV block,
+ * times are in core timer ticks of 25ns
+ */
+void sendProfile()
 {
-    int start = millis();
-    for (int i = 0; i < NUM_SERVOS; i++) {
-        sscOutputs[i] = calcServoOutput(i, counter);
-        sscSpeeds[i] = TIME_STEP;
-        sscCommands[i] = "#" + servoIDs[i] + " P" + sscOutputs[i];
-        sscFinalCommand += sscCommands[i] + " ";
-    }
-    sscFinalCommand += "T" + String(TIME_STEP);
-    int stop = millis() - start;
-
-    delay(TIME_STEP-12-stop-28);
+    static char csv[PROF_CSV_SIZE];
+    int length = prof_write_csv(csv, sizeof(csv));
 
-    sendSSC32Command(sscFinalCommand);
-    sscFinalCommand = "";
-    delay(6);
-    counter++;
+    Serial.write((const uint8_t *)csv, length);
 }
+#endif
 
-void stopMode()
+#ifdef TRACE_ENABLE
+/* Dumps the event trace to the PC as one binary block and starts a new
+ * trace, convert it with PCprojects/TraceExport
+ */
+void sendTrace()
 {
-    for (int i = 0; i < NUM_SERVOS; i++) {
-        sscOutputs[i] = 1500;
-        sscSpeeds[i] = TIME_STEP;
-        sscCommands[i] = "#" + servoIDs[i] + " P" + sscOutputs[i];
-        sscFinalCommand += sscCommands[i] + " ";
+    uint8_t chunk[64];
+    int offset = 0;
+    int length;
+
+    trace_enable(0);
+    while ((length = trace_read(chunk, offset, sizeof(chunk))) > 0) {
+        Serial.write(chunk, length);
+        offset += length;
     }
-
-    sscFinalCommand += "T" + String(TIME_STEP);
-
-    sendSSC32Command(sscFinalCommand);
-    sscFinalCommand = "";
-
-    delay(TIME_STEP+100);
+    trace_clear();
+    trace_enable(1);
 }
+#endif
 
-String calcServoOutput(int servo, int time) {
-    switch (servo) {
-        case 0:
-            return "1400";
-            break;
-        case 1:
-            return "1500";
-            break;
-        case 2:
-            return sineKnee(time);
-            break;
-        case 3:
-            return "1600";
-            break;
-        default:
-            return "1600";
-            break;
-    }
+/* True once every ENGINE_FRAME_MS, the frame clock shared by the walking modes.
+ * After a stall it restarts from now rather than bursting to catch up.
+ */
+bool frameDue(unsigned long now)
+{
+    static unsigned long nextFrame = now;
+
+    if ((long)(now - nextFrame) < 0)
+        return false;
+    nextFrame += ENGINE_FRAME_MS;
+    if ((long)(now - nextFrame) >= 0)
+        nextFrame = now + ENGINE_FRAME_MS;
+    return true;
 }
 
-/* Sine function for knee joint
- * Output values:
- * 2500 is fully straightened
- * 1250 is fully curled
- */
-String sineKnee(int time) {
-    // calulate output
-    int period = 20; //number of time steps for full cycle
-    double coef = 2*3.14/period;
-    double sinVal = sin(coef*time); //
-    
-    // convert to int
-    int range = 2500 - 1250;
-    int minimum = 1250;
-    int sscVal = (1+sinVal)*range/2 + minimum;
-
-    return String(sscVal);
+// Sends one pulse per servo as a group move taking time ms
+void sendFrame(const unsigned short *pulse, int time)
+{
+    static char command[SERVO_FRAME_SIZE(NUM_SERVOS)];
+    char *p = ServoFrame<NUM_SERVOS>::format(command, pulse);
+
+    *p++ = 'T';
+    p = servo_put_uint(p, time);
+    *p = 0;
+    sendSSC32Command(command);
 }
 
-/* Sine function for hip foward/back
- * Output Values:
- * 1250 full back
- * 1500 full straight
- * 2500 full foward
+/* Sends the gait engine's frame every ENGINE_FRAME_MS, when it has one.
+ * There is no current sensing on this board, so the budget runs on its
+ * model alone.
  */
-String sineHipForwardBack(int time) {
-    int period = 20; //number of time steps for full cycle
-    double coef = 2*3.14/period;
-    double sinVal = sin(coef*time);
+void controlFrame()
+{
+    unsigned short pulse[NUM_SERVOS];
 
-    int range = 2500 - 1250;
-    int minimum = 1250;
-    int sscVal = (1+sinVal)*range/2 + minimum;
+    if (!frameDue(millis()))
+        return;
+    if (engine_frame(&engine, micros() - imuSampleTime, NULL, pulse))
+        sendFrame(pulse, ENGINE_FRAME_MS);
+}
 
-    return String(sscVal);
+/* Samples the IMU every IMU_PERIOD and hands it to the gait engine, which
+ * fuses the body attitude and works out the fuzzy balance correction at
+ * that rate while frames go out every ENGINE_FRAME_MS. The board is mounted
+ * with x forward, y left and z up; remap accel and gyro here if it is
+ * turned.
+ */
+void imuTask()
+{
+    unsigned long now = micros();
+    short accel[3], gyro[3];
+
+    if (!engine.imuReady || now - imuReadTime < IMU_PERIOD * 1000UL)
+        return;
+    // a failed read waits for the next period too rather than retrying
+    // the bus on every pass; the fusion step then spans both periods
+    imuReadTime = now;
+    if (!imuRead(accel, gyro))
+        return;
+    engine_imu_update(&engine, accel, gyro, now - imuSampleTime);
+    imuSampleTime = now;
 }
@@ -0,0 +1,274 @@
+/*
+ * Generated by gaitc, do not edit. Rebuild with
+ *     gaitc -p 0.3979 -n 256 -N reportGait
+ *
+ * SSC-32 pulses for the six joints of a leg in JointType order, one
+ * row every 1.55 ms of a 398 ms cycle.
+ */
+#ifndef __REPORT_GAIT_H__
+#define __REPORT_GAIT_H__
+
+#include <GaitTable.h>
+
+static const unsigned short reportGaitPulse[256 * 6] = {
+    1500, 1500, 1709, 1407, 1500, 1500,
+    1500, 1500, 1713, 1412, 1500, 1500,
+    1500, 1500, 1717, 1417, 1500, 1500,
+    1500, 1500, 1721, 1422, 1500, 1500,
+    1500, 1500, 1725, 1428, 1500, 1500,
+    1500, 1500, 1729, 1434, 1500, 1500,
+    1500, 1500, 1733, 1441, 1500, 1500,
+    1500, 1500, 1736, 1448, 1500, 1500,
+    1500, 1500, 1740, 1456, 1500, 1500,
+    1500, 1500, 1743, 1463, 1500, 1500,
+    1500, 1500, 1747, 1471, 1500, 1500,
+    1500, 1500, 1750, 1479, 1500, 1500,
+    1500, 1500, 1753, 1488, 1500, 1500,
+    1500, 1500, 1756, 1497, 1500, 1500,
+    1500, 1500, 1758, 1505, 1500, 1500,
+    1500, 1500, 1761, 1514, 1500, 1500,
+    1500, 1500, 1763, 1523, 1500, 1500,
+    1500, 1500, 1765, 1532, 1500, 1500,
+    1500, 1500, 1767, 1541, 1500, 1500,
+    1500, 1500, 1769, 1550, 1500, 1500,
+    1500, 1500, 1771, 1559, 1500, 1500,
+    1500, 1500, 1772, 1568, 1500, 1500,
+    1500, 1500, 1773, 1577, 1500, 1500,
+    1500, 1500, 1774, 1585, 1500, 1500,
+    1500, 1500, 1775, 1594, 1500, 1500,
+    1500, 1500, 1775, 1602, 1500, 1500,
+    1500, 1500, 1775, 1610, 1500, 1500,
+    1500, 1500, 1775, 1618, 1500, 1500,
+    1500, 1500, 1775, 1625, 1500, 1500,
+    1500, 1500, 1775, 1633, 1500, 1500,
+    1500, 1500, 1774, 1640, 1500, 1500,
+    1500, 1500, 1773, 1646, 1500, 1500,
+    1500, 1500, 1772, 1653, 1500, 1500,
+    1500, 1500, 1770, 1659, 1500, 1500,
+    1500, 1500, 1768, 1665, 1500, 1500,
+    1500, 1500, 1766, 1670, 1500, 1500,
+    1500, 1500, 1764, 1675, 1500, 1500,
+    1500, 1500, 1762, 1680, 1500, 1500,
+    1500, 1500, 1759, 1684, 1500, 1500,
+    1500, 1500, 1756, 1688, 1500, 1500,
+    1500, 1500, 1753, 1691, 1500, 1500,
+    1500, 1500, 1750, 1694, 1500, 1500,
+    1500, 1500, 1747, 1697, 1500, 1500,
+    1500, 1500, 1743, 1700, 1500, 1500,
+    1500, 1500, 1739, 1702, 1500, 1500,
+    1500, 1500, 1735, 1703, 1500, 1500,
+    1500, 1500, 1731, 1705, 1500, 1500,
+    1500, 1500, 1727, 1706, 1500, 1500,
+    1500, 1500, 1722, 1706, 1500, 1500,
+    1500, 1500, 1717, 1707, 1500, 1500,
+    1500, 1500, 1713, 1707, 1500, 1500,
+    1500, 1500, 1708, 1706, 1500, 1500,
+    1500, 1500, 1703, 1706, 1500, 1500,
+    1500, 1500, 1698, 1705, 1500, 1500,
+    1500, 1500, 1692, 1704, 1500, 1500,
+    1500, 1500, 1687, 1702, 1500, 1500,
+    1500, 1500, 1682, 1700, 1500, 1500,
+    1500, 1500, 1676, 1699, 1500, 1500,
+    1500, 1500, 1671, 1696, 1500, 1500,
+    1500, 1500, 1665, 1694, 1500, 1500,
+    1500, 1500, 1659, 1691, 1500, 1500,
+    1500, 1500, 1653, 1689, 1500, 1500,
+    1500, 1500, 1648, 1686, 1500, 1500,
+    1500, 1500, 1642, 1682, 1500, 1500,
+    1500, 1500, 1636, 1679, 1500, 1500,
+    1500, 1500, 1630, 1676, 1500, 1500,
+    1500, 1500, 1624, 1672, 1500, 1500,
+    1500, 1500, 1618, 1669, 1500, 1500,
+    1500, 1500, 1613, 1665, 1500, 1500,
+    1500, 1500, 1607, 1661, 1500, 1500,
+    1500, 1500, 1601, 1657, 1500, 1500,
+    1500, 1500, 1595, 1653, 1500, 1500,
+    1500, 1500, 1589, 1649, 1500, 1500,
+    1500, 1500, 1583, 1645, 1500, 1500,
+    1500, 1500, 1578, 1641, 1500, 1500,
+    1500, 1500, 1572, 1637, 1500, 1500,
+    1500, 1500, 1566, 1633, 1500, 1500,
+    1500, 1500, 1561, 1628, 1500, 1500,
+    1500, 1500, 1555, 1624, 1500, 1500,
+    1500, 1500, 1549, 1620, 1500, 1500,
+    1500, 1500, 1544, 1616, 1500, 1500,
+    1500, 1500, 1538, 1612, 1500, 1500,
+    1500, 1500, 1533, 1608, 1500, 1500,
+    1500, 1500, 1527, 1604, 1500, 1500,
+    1500, 1500, 1522, 1600, 1500, 1500,
+    1500, 1500, 1516, 1596, 1500, 1500,
+    1500, 1500, 1511, 1592, 1500, 1500,
+    1500, 1500, 1506, 1588, 1500, 1500,
+    1500, 1500, 1501, 1584, 1500, 1500,
+    1500, 1500, 1495, 1580, 1500, 1500,
+    1500, 1500, 1490, 1576, 1500, 1500,
+    1500, 1500, 1485, 1572, 1500, 1500,
+    1500, 1500, 1480, 1569, 1500, 1500,
+    1500, 1500, 1475, 1565, 1500, 1500,
+    1500, 1500, 1470, 1561, 1500, 1500,
+    1500, 1500, 1465, 1558, 1500, 1500,
+    1500, 1500, 1460, 1554, 1500, 1500,
+    1500, 1500, 1455, 1551, 1500, 1500,
+    1500, 1500, 1450, 1548, 1500, 1500,
+    1500, 1500, 1445, 1544, 1500, 1500,
+    1500, 1500, 1440, 1541, 1500, 1500,
+    1500, 1500, 1435, 1538, 1500, 1500,
+    1500, 1500, 1431, 1535, 1500, 1500,
+    1500, 1500, 1426, 1532, 1500, 1500,
+    1500, 1500, 1421, 1530, 1500, 1500,
+    1500, 1500, 1416, 1527, 1500, 1500,
+    1500, 1500, 1412, 1524, 1500, 1500,
+    1500, 1500, 1407, 1522, 1500, 1500,
+    1500, 1500, 1403, 1520, 1500, 1500,
+    1500, 1500, 1398, 1518, 1500, 1500,
+    1500, 1500, 1394, 1516, 1500, 1500,
+    1500, 1500, 1389, 1514, 1500, 1500,
+    1500, 1500, 1385, 1512, 1500, 1500,
+    1500, 1500, 1381, 1511, 1500, 1500,
+    1500, 1500, 1376, 1509, 1500, 1500,
+    1500, 1500, 1372, 1508, 1500, 1500,
+    1500, 1500, 1368, 1507, 1500, 1500,
+    1500, 1500, 1364, 1507, 1500, 1500,
+    1500, 1500, 1360, 1506, 1500, 1500,
+    1500, 1500, 1356, 1506, 1500, 1500,
+    1500, 1500, 1352, 1506, 1500, 1500,
+    1500, 1500, 1349, 1506, 1500, 1500,
+    1500, 1500, 1345, 1507, 1500, 1500,
+    1500, 1500, 1342, 1508, 1500, 1500,
+    1500, 1500, 1339, 1509, 1500, 1500,
+    1500, 1500, 1335, 1510, 1500, 1500,
+    1500, 1500, 1332, 1512, 1500, 1500,
+    1500, 1500, 1330, 1514, 1500, 1500,
+    1500, 1500, 1327, 1517, 1500, 1500,
+    1500, 1500, 1324, 1520, 1500, 1500,
+    1500, 1500, 1322, 1523, 1500, 1500,
+    1500, 1500, 1320, 1527, 1500, 1500,
+    1500, 1500, 1318, 1531, 1500, 1500,
+    1500, 1500, 1316, 1535, 1500, 1500,
+    1500, 1500, 1314, 1540, 1500, 1500,
+    1500, 1500, 1313, 1545, 1500, 1500,
+    1500, 1500, 1312, 1550, 1500, 1500,
+    1500, 1500, 1311, 1556, 1500, 1500,
+    1500, 1500, 1310, 1563, 1500, 1500,
+    1500, 1500, 1310, 1570, 1500, 1500,
+    1500, 1500, 1309, 1577, 1500, 1500,
+    1500, 1500, 1309, 1585, 1500, 1500,
+    1500, 1500, 1310, 1593, 1500, 1500,
+    1500, 1500, 1310, 1601, 1500, 1500,
+    1500, 1500, 1311, 1610, 1500, 1500,
+    1500, 1500, 1312, 1619, 1500, 1500,
+    1500, 1500, 1313, 1629, 1500, 1500,
+    1500, 1500, 1315, 1639, 1500, 1500,
+    1500, 1500, 1317, 1649, 1500, 1500,
+    1500, 1500, 1319, 1660, 1500, 1500,
+    1500, 1500, 1321, 1671, 1500, 1500,
+    1500, 1500, 1324, 1683, 1500, 1500,
+    1500, 1500, 1327, 1694, 1500, 1500,
+    1500, 1500, 1330, 1706, 1500, 1500,
+    1500, 1500, 1333, 1719, 1500, 1500,
+    1500, 1500, 1337, 1731, 1500, 1500,
+    1500, 1500, 1341, 1744, 1500, 1500,
+    1500, 1500, 1345, 1757, 1500, 1500,
+    1500, 1500, 1349, 1770, 1500, 1500,
+    1500, 1500, 1354, 1783, 1500, 1500,
+    1500, 1500, 1359, 1796, 1500, 1500,
+    1500, 1500, 1364, 1810, 1500, 1500,
+    1500, 1500, 1370, 1823, 1500, 1500,
+    1500, 1500, 1375, 1837, 1500, 1500,
+    1500, 1500, 1381, 1850, 1500, 1500,
+    1500, 1500, 1387, 1864, 1500, 1500,
+    1500, 1500, 1393, 1877, 1500, 1500,
+    1500, 1500, 1400, 1891, 1500, 1500,
+    1500, 1500, 1406, 1904, 1500, 1500,
+    1500, 1500, 1413, 1917, 1500, 1500,
+    1500, 1500, 1420, 1930, 1500, 1500,
+    1500, 1500, 1427, 1942, 1500, 1500,
+    1500, 1500, 1434, 1954, 1500, 1500,
+    1500, 1500, 1441, 1966, 1500, 1500,
+    1500, 1500, 1448, 1978, 1500, 1500,
+    1500, 1500, 1456, 1989, 1500, 1500,
+    1500, 1500, 1463, 2000, 1500, 1500,
+    1500, 1500, 1470, 2010, 1500, 1500,
+    1500, 1500, 1478, 2020, 1500, 1500,
+    1500, 1500, 1485, 2029, 1500, 1500,
+    1500, 1500, 1493, 2038, 1500, 1500,
+    1500, 1500, 1501, 2046, 1500, 1500,
+    1500, 1500, 1508, 2054, 1500, 1500,
+    1500, 1500, 1516, 2061, 1500, 1500,
+    1500, 1500, 1523, 2067, 1500, 1500,
+    1500, 1500, 1531, 2073, 1500, 1500,
+    1500, 1500, 1538, 2078, 1500, 1500,
+    1500, 1500, 1545, 2082, 1500, 1500,
+    1500, 1500, 1552, 2086, 1500, 1500,
+    1500, 1500, 1560, 2088, 1500, 1500,
+    1500, 1500, 1567, 2090, 1500, 1500,
+    1500, 1500, 1574, 2092, 1500, 1500,
+    1500, 1500, 1580, 2092, 1500, 1500,
+    1500, 1500, 1587, 2092, 1500, 1500,
+    1500, 1500, 1593, 2091, 1500, 1500,
+    1500, 1500, 1600, 2089, 1500, 1500,
+    1500, 1500, 1606, 2086, 1500, 1500,
+    1500, 1500, 1612, 2083, 1500, 1500,
+    1500, 1500, 1618, 2078, 1500, 1500,
+    1500, 1500, 1623, 2073, 1500, 1500,
+    1500, 1500, 1629, 2068, 1500, 1500,
+    1500, 1500, 1634, 2061, 1500, 1500,
+    1500, 1500, 1639, 2054, 1500, 1500,
+    1500, 1500, 1644, 2046, 1500, 1500,
+    1500, 1500, 1649, 2037, 1500, 1500,
+    1500, 1500, 1653, 2028, 1500, 1500,
+    1500, 1500, 1658, 2017, 1500, 1500,
+    1500, 1500, 1662, 2007, 1500, 1500,
+    1500, 1500, 1666, 1995, 1500, 1500,
+    1500, 1500, 1669, 1983, 1500, 1500,
+    1500, 1500, 1673, 1971, 1500, 1500,
+    1500, 1500, 1676, 1958, 1500, 1500,
+    1500, 1500, 1679, 1944, 1500, 1500,
+    1500, 1500, 1682, 1930, 1500, 1500,
+    1500, 1500, 1685, 1916, 1500, 1500,
+    1500, 1500, 1687, 1901, 1500, 1500,
+    1500, 1500, 1690, 1886, 1500, 1500,
+    1500, 1500, 1692, 1871, 1500, 1500,
+    1500, 1500, 1694, 1855, 1500, 1500,
+    1500, 1500, 1696, 1839, 1500, 1500,
+    1500, 1500, 1698, 1823, 1500, 1500,
+    1500, 1500, 1699, 1807, 1500, 1500,
+    1500, 1500, 1701, 1790, 1500, 1500,
+    1500, 1500, 1702, 1774, 1500, 1500,
+    1500, 1500, 1703, 1757, 1500, 1500,
+    1500, 1500, 1704, 1741, 1500, 1500,
+    1500, 1500, 1705, 1724, 1500, 1500,
+    1500, 1500, 1706, 1708, 1500, 1500,
+    1500, 1500, 1707, 1692, 1500, 1500,
+    1500, 1500, 1707, 1676, 1500, 1500,
+    1500, 1500, 1708, 1660, 1500, 1500,
+    1500, 1500, 1708, 1644, 1500, 1500,
+    1500, 1500, 1709, 1629, 1500, 1500,
+    1500, 1500, 1709, 1614, 1500, 1500,
+    1500, 1500, 1709, 1599, 1500, 1500,
+    1500, 1500, 1709, 1585, 1500, 1500,
+    1500, 1500, 1710, 1571, 1500, 1500,
+    1500, 1500, 1710, 1558, 1500, 1500,
+    1500, 1500, 1710, 1545, 1500, 1500,
+    1500, 1500, 1710, 1532, 1500, 1500,
+    1500, 1500, 1710, 1520, 1500, 1500,
+    1500, 1500, 1710, 1509, 1500, 1500,
+    1500, 1500, 1710, 1498, 1500, 1500,
+    1500, 1500, 1710, 1488, 1500, 1500,
+    1500, 1500, 1710, 1478, 1500, 1500,
+    1500, 1500, 1710, 1469, 1500, 1500,
+    1500, 1500, 1710, 1460, 1500, 1500,
+    1500, 1500, 1710, 1452, 1500, 1500,
+    1500, 1500, 1710, 1445, 1500, 1500,
+    1500, 1500, 1710, 1438, 1500, 1500,
+    1500, 1500, 1710, 1432, 1500, 1500,
+    1500, 1500, 1710, 1426, 1500, 1500,
+    1500, 1500, 1709, 1421, 1500, 1500,
+    1500, 1500, 1709, 1417, 1500, 1500,
+    1500, 1500, 1709, 1413, 1500, 1500,
+    1500, 1500, 1709, 1410, 1500, 1500,
+};
+
+static const GaitTable reportGait = { 256, 8, 6, 398, reportGaitPulse };
+
+#endif
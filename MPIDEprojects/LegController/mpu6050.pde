@@ -12,6 +12,10 @@
 //
 // Open Source / Public Domain
 //
+// Cut down for the leg controller: the example's setup()
+// and loop() are now imuSetup() and imuRead(), the leg
+// controller's own setup() and loop() call them.
+//
 // Using Arduino 1.0.1
 // It will not work with an older version, 
 // since Wire.endTransmission() uses a parameter 
@@ -668,69 +672,61 @@ typedef union accel_t_gyro_union
 };
 
 
-void setup()
-{      
+// --------------------------------------------------------
+// imuSetup
+//
+// Starts the sensor for the leg controller, in place of
+// the example's setup(): gyro at 250 degrees/s, accel at
+// 2g, the gyro X clock, and the 44 Hz low pass filter so
+// footfalls do not alias into reads every few ms.
+//
+// Returns false when the sensor does not answer.
+//
+bool imuSetup()
+{
   int error;
   uint8_t c;
 
-
-  Serial.begin(9600);
-  Serial.println(F("InvenSense MPU-6050"));
-  Serial.println(F("June 2012"));
-
   // Initialize the 'Wire' class for the I2C-bus.
   Wire.begin();
 
-
-  // default at power-up:
-  //    Gyro at 250 degrees second
-  //    Acceleration at 2g
-  //    Clock source at internal 8MHz
-  //    The device is in sleep mode.
-  //
-
+  // WHO_AM_I reads 0x68 whatever the AD0 pin is.
   error = MPU6050_read (MPU6050_WHO_AM_I, &c, 1);
-  Serial.print(F("WHO_AM_I : "));
-  Serial.print(c,HEX);
-  Serial.print(F(", error = "));
-  Serial.println(error,DEC);
-
-  // According to the datasheet, the 'sleep' bit
-  // should read a '1'.
-  // That bit has to be cleared, since the sensor
-  // is in sleep mode at power-up. 
-  error = MPU6050_read (MPU6050_PWR_MGMT_1, &c, 1);
-  Serial.print(F("PWR_MGMT_1 : "));
-  Serial.print(c,HEX);
-  Serial.print(F(", error = "));
-  Serial.println(error,DEC);
-
-
-  // Clear the 'sleep' bit to start the sensor.
-  MPU6050_write_reg (MPU6050_PWR_MGMT_1, 0);
+  if (error != 0 || c != 0x68)
+    return false;
+
+  // Clear the 'sleep' bit to start the sensor, and take
+  // the clock from a gyro, which is steadier than the
+  // internal oscillator.
+  error = MPU6050_write_reg (MPU6050_PWR_MGMT_1, MPU6050_CLKSEL_X);
+  error |= MPU6050_write_reg (MPU6050_CONFIG, MPU6050_DLPF_44HZ);
+  error |= MPU6050_write_reg (MPU6050_GYRO_CONFIG, MPU6050_FS_SEL_250);
+  error |= MPU6050_write_reg (MPU6050_ACCEL_CONFIG, MPU6050_AFS_SEL_2G);
+  return error == 0;
 }
 
 
-void loop()
+// --------------------------------------------------------
+// imuRead
+//
+// Reads acceleration and rates in one burst, in place of
+// the example's loop(). Raw register values, swapped to
+// the PIC32's byte order.
+//
+// Returns false on an I2C error.
+//
+bool imuRead(short *accel, short *gyro)
 {
   int error;
-  double dT;
   accel_t_gyro_union accel_t_gyro;
 
-
-  Serial.println(F(""));
-  Serial.println(F("MPU-6050"));
-
-  // Read the raw values.
   // Read 14 bytes at once, 
   // containing acceleration, temperature and gyro.
-  // With the default settings of the MPU-6050,
-  // there is no filter enabled, and the values
-  // are not very stable.
+  TRACE_BEGIN(TRACE_I2C_READ, MPU6050_ACCEL_XOUT_H);
   error = MPU6050_read (MPU6050_ACCEL_XOUT_H, (uint8_t *) &accel_t_gyro, sizeof(accel_t_gyro));
-  Serial.print(F("Read accel, temp and gyro, error = "));
-  Serial.println(error,DEC);
-
+  TRACE_END(TRACE_I2C_READ, error);
+  if (error != 0)
+    return false;
 
   // Swap all high and low bytes.
   // After this, the registers values are swapped, 
@@ -742,48 +738,17 @@ void loop()
   SWAP (accel_t_gyro.reg.x_accel_h, accel_t_gyro.reg.x_accel_l);
   SWAP (accel_t_gyro.reg.y_accel_h, accel_t_gyro.reg.y_accel_l);
   SWAP (accel_t_gyro.reg.z_accel_h, accel_t_gyro.reg.z_accel_l);
-  SWAP (accel_t_gyro.reg.t_h, accel_t_gyro.reg.t_l);
   SWAP (accel_t_gyro.reg.x_gyro_h, accel_t_gyro.reg.x_gyro_l);
   SWAP (accel_t_gyro.reg.y_gyro_h, accel_t_gyro.reg.y_gyro_l);
   SWAP (accel_t_gyro.reg.z_gyro_h, accel_t_gyro.reg.z_gyro_l);
 
-
-  // Print the raw acceleration values
-
-  Serial.print(F("accel x,y,z: "));
-  Serial.print(accel_t_gyro.value.x_accel, DEC);
-  Serial.print(F(", "));
-  Serial.print(accel_t_gyro.value.y_accel, DEC);
-  Serial.print(F(", "));
-  Serial.print(accel_t_gyro.value.z_accel, DEC);
-  Serial.println(F(""));
-
-
-  // The temperature sensor is -40 to +85 degrees Celsius.
-  // It is a signed integer.
-  // According to the datasheet: 
-  //   340 per degrees Celsius, -512 at 35 degrees.
-  // At 0 degrees: -512 - (340 * 35) = -12412
-
-  Serial.print(F("temperature: "));
-  dT = ( (double) accel_t_gyro.value.temperature + 12412.0) / 340.0;
-  Serial.print(dT, 3);
-  Serial.print(F(" degrees Celsius"));
-  Serial.println(F(""));
-
-
-  // Print the raw gyro values.
-
-  Serial.print(F("gyro x,y,z : "));
-  Serial.print(accel_t_gyro.value.x_gyro, DEC);
-  Serial.print(F(", "));
-  Serial.print(accel_t_gyro.value.y_gyro, DEC);
-  Serial.print(F(", "));
-  Serial.print(accel_t_gyro.value.z_gyro, DEC);
-  Serial.print(F(", "));
-  Serial.println(F(""));
-
-  delay(1000);
+  accel[0] = accel_t_gyro.value.x_accel;
+  accel[1] = accel_t_gyro.value.y_accel;
+  accel[2] = accel_t_gyro.value.z_accel;
+  gyro[0] = accel_t_gyro.value.x_gyro;
+  gyro[1] = accel_t_gyro.value.y_gyro;
+  gyro[2] = accel_t_gyro.value.z_gyro;
+  return true;
 }
 
 
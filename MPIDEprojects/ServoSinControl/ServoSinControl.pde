@@ -15,9 +15,12 @@
  * numbers. To calculate: Letter*16 + number
  * UART1TX = F8
  */
+#include <FixMath.h>
+#include <ServoTable.h>
+
 static const int LED_PIN = 65; //LED2 red
 static const int TIME_STEP = 1000; //Time step in milliseconds
-static const int NUM_SERVOS = 12; //Servos numbered 0-31
+static const int SINE_PERIOD = 20; //Time steps for a full sine cycle
 
 enum JointType { 
     HIP1,   //Hip Rotate
@@ -28,28 +31,30 @@ enum JointType {
     ANKLE2  //Ankle left/right 
 };
 
-typedef struct {
-    JointType jointType;
-    String pin;
-    String postion;
-    String movTime;
-    String command;
-} Servo;
-
-String servoIDs[NUM_SERVOS];
-String sscOutputs[NUM_SERVOS];
-String sscSpeeds[NUM_SERVOS];
-String sscCommands[NUM_SERVOS];
-
-String sscFinalCommand = "";
+/* Servo 2 sweeps 1250 (full back) to 2500 (full forward) on a sine, the
+ * rest hold still
+ */
+// name, SSC-32 channel, joint, neutral, min and max pulse, direction, source
+#define SERVO_TABLE(X) \
+    X(R_HIP1,    0, HIP1,   1400,  500, 2500, 1, SERVO_HOLD)  \
+    X(R_HIP2,    1, HIP2,   1500,  500, 2500, 1, SERVO_HOLD)  \
+    X(R_HIP3,    2, HIP3,   1875, 1250, 2500, 1, SERVO_ANGLE) \
+    X(R_KNEE,    3, KNEE,   1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(R_ANKLE1,  4, ANKLE1, 1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(R_ANKLE2,  5, ANKLE2, 1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_HIP1,   16, HIP1,   1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_HIP2,   17, HIP2,   1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_HIP3,   18, HIP3,   1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_KNEE,   19, KNEE,   1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_ANKLE1, 20, ANKLE1, 1600,  500, 2500, 1, SERVO_HOLD)  \
+    X(L_ANKLE2, 21, ANKLE2, 1600,  500, 2500, 1, SERVO_HOLD)
+SERVO_TABLE_DEFINE(SERVO_TABLE)
+
+// Sine amplitude, 625us either side of neutral as an angle (16384 is 1000us)
+static const int SWEEP_ANGLE = 625 * 16384 / 1000;
 
 int counter = 0;
 
-// Given a servo calculate output as ssc Positon Value
-String calcServoOutput(int servo, int time);
-// A sine function that generates an output from 500 to 2500
-String sineFunctionA(int time);
-
 void setup() 
 {   
     //UART to SSC32
@@ -61,23 +66,6 @@ void setup()
     //LED to flash satus
     pinMode(LED_PIN, OUTPUT); 
     digitalWrite(LED_PIN, HIGH); //High is off
-
-    //Initialize Servo pins;
-    //Right leg 0-5
-    servoIDs[0] = 0; //Hip Rotate
-    servoIDs[1] = 1; //Hip in/out
-    servoIDs[2] = 2; //Hip front/back
-    servoIDs[3] = 3; //Knee
-    servoIDs[4] = 4; //Ankle front/back
-    servoIDs[5] = 5; //Ankle left/right
-
-    //Left leg 16-21
-    servoIDs[6] = 16; //Hip Rotate
-    servoIDs[7] = 17; //Hip in/out
-    servoIDs[8] = 18; //Hip front/back
-    servoIDs[9] = 19; //Knee
-    servoIDs[10] = 20; //Ankle front/back
-    servoIDs[11] = 21; //Ankle left/right
 }
 
 void loop()
@@ -85,80 +73,25 @@ void loop()
     //Serial0.println("#1 P500 T1000"); //turns the servo to the initial position in 1 second
     //Serial0.println("#1 P2500 T1000"); //turns the servo to the final position in 1 second
 
-    for (int i = 0; i < NUM_SERVOS; i++) {
-        sscOutputs[i] = calcServoOutput(i, counter);
-        sscSpeeds[i] = TIME_STEP;
-        sscCommands[i] = "#" + servoIDs[i] + " P" + sscOutputs[i];
-        sscFinalCommand += sscCommands[i] + " ";
-    }
+    int angle[NUM_SERVOS] = { 0 };
+    unsigned short pulse[NUM_SERVOS];
+    char command[SERVO_FRAME_SIZE(NUM_SERVOS)];
+
+    angle[R_HIP3] = (fx_sin((fx_angle)(counter % SINE_PERIOD * 65536 / SINE_PERIOD)) * SWEEP_ANGLE) >> 15;
+    ServoFrame<NUM_SERVOS>::fromAngles(angle, pulse);
 
-    sscFinalCommand += "T" + String(TIME_STEP);
+    char *p = ServoFrame<NUM_SERVOS>::format(command, pulse);
+    *p++ = 'T';
+    p = servo_put_uint(p, TIME_STEP);
+    *p = 0;
 
     digitalWrite(LED_PIN, LOW);
 
-    Serial.println(sscFinalCommand);
-    Serial0.println(sscFinalCommand);
-    sscFinalCommand = "";
+    Serial.println(command);
+    Serial0.println(command);
 
     digitalWrite(LED_PIN, HIGH);  
 
     delay(TIME_STEP+100);
     counter++;
 }
-
-String calcServoOutput(int servo, int time) {
-    switch (servo) {
-        case 0:
-            return "1400";
-            break;
-        case 1:
-            return "1500";
-            break;
-        case 2:
-            return sineKnee(time);
-            break;
-        case 3:
-            return "1600";
-            break;
-        default:
-            return "1600";
-            break;
-    }
-}
-
-/* Sine function for knee joint
- * Output values:
- * 2500 is fully straightened
- * 1250 is fully curled
- */
-String sineKnee(int time) {
-    // calulate output
-    int period = 20; //number of time steps for full cycle
-    double coef = 2*3.14/period;
-    double sinVal = sin(coef*time); //
-    
-    // convert to int
-    int range = 2500 - 1250;
-    int minimum = 1250;
-    int sscVal = (1+sinVal)*range/2 + minimum;
-
-    return String(sscVal);
-}
-
-/* Sine function for hip foward/back
- * Output Values:
- * 1250 full back
- * 1500 full straight
- * 2500 full foward
- */
-String sineHipForwardBack(int time) {
-    int period = 20; //number of time steps for full cycle
-    double coef = 2*3.14/period;
-    double sinVal = sin(coef*time);
-
-    int range = 2500 - 1250;
-    int minimum = 1250;
-    int sscVal = (1+sinVal)*range/2 + minimum;
-
-    return String(sscVal);
-}
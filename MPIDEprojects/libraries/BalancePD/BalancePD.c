@@ -0,0 +1,57 @@
+/*=============================================================================
+ * PD balance with latency compensation, see BalancePD.h
+ *===========================================================================*/
+#include "BalancePD.h"
+
+// Largest rate taken, 180 deg/s, keeps kd * rate in 32 bits
+#define MAX_RATE 32767
+
+static int clamp(int x, int low, int high)
+{
+    return x < low ? low : x > high ? high : x;
+}
+
+void balance_init(BalancePD *pd, int kp, int kd, fx_angle limit, fx_angle slew)
+{
+    balance_set_gain(pd, kp, kd);
+    balance_set_limit(pd, limit, slew);
+    pd->offset = 0;
+}
+
+void balance_set_gain(BalancePD *pd, int kp, int kd)
+{
+    pd->kp = clamp(kp, -32767, 32767);
+    pd->kd = clamp(kd, -32767, 32767);
+}
+
+void balance_set_limit(BalancePD *pd, fx_angle limit, fx_angle slew)
+{
+    pd->limit = clamp((short)limit, 0, 32767);
+    pd->slew = clamp((short)slew, 0, 32767);
+}
+
+void balance_reset(BalancePD *pd)
+{
+    pd->offset = 0;
+}
+
+fx_angle balance_predict(fx_angle angle, int rate, unsigned int latencyUs)
+{
+    if (latencyUs > BALANCE_MAX_LATENCY_US)
+        latencyUs = BALANCE_MAX_LATENCY_US;
+    // rate * latency / 1e6, the divide as 4295 / 2^32
+    return (fx_angle)((short)angle + (int)(((long long)rate * latencyUs * 4295) >> 32));
+}
+
+int balance_update(BalancePD *pd, fx_angle predicted, int rate)
+{
+    int u, step;
+
+    rate = clamp(rate, -MAX_RATE, MAX_RATE);
+    // each product within 2^30, so the sum fits
+    u = -((pd->kp * (short)predicted + pd->kd * rate) >> 12);
+    u = clamp(u, -pd->limit, pd->limit);
+    step = clamp(u - pd->offset, -pd->slew, pd->slew);
+    pd->offset += step;
+    return pd->offset;
+}
@@ -0,0 +1,65 @@
+/*=============================================================================
+ * PD balance on the fused body attitude, with latency compensation
+ *
+ * Each channel turns one body angle and its rate into a joint offset,
+ *
+ *     predicted = angle + rate * latency
+ *     u         = -(kp * predicted + kd * rate)
+ *
+ * A correction reaches the body only after the wait for the next frame,
+ * the SSC-32 serial frame and the servo's own response, some tens of ms.
+ * Acting on the angle the gyro rate says the body will have by then, rather
+ * than the one it had, is a phase lead that keeps the loop from ringing at
+ * gains it would otherwise not take.
+ *
+ * The output is saturated in size, so a fall cannot drag a joint far from
+ * the gait, and in change per update, so a gyro spike or a gain change
+ * does not kick the servos. There is no integral term to wind up while
+ * saturated.
+ *
+ * Angles are fx_angle, rates fx_angle per second, kp Q12 (4096 is 1.0)
+ * joint per body angle and kd Q12 seconds. An update is a couple of
+ * multiplies and clamps, no divide, so it can run every servo frame.
+ *===========================================================================*/
+#ifndef __BALANCE_PD_H__
+#define __BALANCE_PD_H__
+
+#include "FixMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest prediction taken, further ahead the gyro rate says little
+#define BALANCE_MAX_LATENCY_US 100000
+
+typedef struct {
+    int kp, kd;                     // Q12, kd in seconds
+    int limit;                      // largest offset, fx_angle
+    int slew;                       // largest offset change per update
+    int offset;                     // the last output
+} BalancePD;
+
+// Gains as balance_set_gain(), output held to limit and moving at most slew an update
+void balance_init(BalancePD *pd, int kp, int kd, fx_angle limit, fx_angle slew);
+
+// Gains within +-32767, Q12, positive gains oppose the angle
+void balance_set_gain(BalancePD *pd, int kp, int kd);
+
+// Sets the saturation, limit and slew at least 0
+void balance_set_limit(BalancePD *pd, fx_angle limit, fx_angle slew);
+
+// Drops the output to 0 at once, for when the correction is switched in
+void balance_reset(BalancePD *pd);
+
+// Angle latencyUs ahead at rate, latency clamped to BALANCE_MAX_LATENCY_US
+fx_angle balance_predict(fx_angle angle, int rate, unsigned int latencyUs);
+
+// One update, the saturated offset for the predicted angle and its rate
+int balance_update(BalancePD *pd, fx_angle predicted, int rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
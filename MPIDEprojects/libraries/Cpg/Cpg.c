@@ -0,0 +1,104 @@
+/*=============================================================================
+ * Central pattern generator, see Cpg.h
+ *===========================================================================*/
+#include "Cpg.h"
+
+// Phase per ms at 1 mHz, 2^32 / 10^6
+#define PHASE_PER_MHZ_MS 4295
+
+static int clampInt(int value, int low, int high)
+{
+    return value < low ? low : value > high ? high : value;
+}
+
+// First order step of value toward target over dtMs with time constant rampMs
+static int ramp(int value, int target, unsigned int dtMs, unsigned int rampMs)
+{
+    int diff = target - value;
+    int step = diff * (int)dtMs / (int)(rampMs + dtMs);
+
+    // the last few counts would never close by division
+    return value + (step ? step : diff);
+}
+
+void cpg_init(Cpg *cpg, int count, int frequency, unsigned int rampMs)
+{
+    int i, j;
+
+    if (count > CPG_MAX_OSCILLATORS)
+        count = CPG_MAX_OSCILLATORS;
+    frequency = clampInt(frequency, 0, CPG_MAX_FREQUENCY);
+    cpg->count = count;
+    cpg->rampMs = rampMs;
+    for (i = 0; i < count; i++) {
+        cpg->phase[i] = 0;
+        cpg->frequency[i] = frequency;
+        cpg->targetFrequency[i] = frequency;
+        cpg->amplitude[i] = 0;
+        cpg->targetAmplitude[i] = 0;
+        for (j = 0; j < count; j++) {
+            cpg->coupling[i][j] = 0;
+            cpg->offset[i][j] = 0;
+        }
+    }
+}
+
+void cpg_couple(Cpg *cpg, int i, int j, int strength, fx_angle offset)
+{
+    strength = clampInt(strength, 0, CPG_MAX_FREQUENCY);
+    cpg->coupling[i][j] = strength;
+    cpg->offset[i][j] = offset;
+    cpg->coupling[j][i] = strength;
+    cpg->offset[j][i] = (fx_angle)-offset;
+}
+
+void cpg_set_frequency(Cpg *cpg, int frequency)
+{
+    int i;
+
+    frequency = clampInt(frequency, 0, CPG_MAX_FREQUENCY);
+    for (i = 0; i < cpg->count; i++)
+        cpg->targetFrequency[i] = frequency;
+}
+
+void cpg_set_amplitude(Cpg *cpg, int i, int amplitude)
+{
+    cpg->targetAmplitude[i] = clampInt(amplitude, 0, 32768);
+}
+
+void cpg_correct(Cpg *cpg, int i, unsigned int phase, int gain)
+{
+    int error = (int)(phase - cpg->phase[i]);
+
+    cpg->phase[i] += (unsigned int)(((long long)error * gain) >> 15);
+}
+
+void cpg_tick(Cpg *cpg, unsigned int dtMs)
+{
+    int rate[CPG_MAX_OSCILLATORS];
+    int i, j;
+
+    // rates from the phases before the step, so the order does not matter
+    for (i = 0; i < cpg->count; i++) {
+        rate[i] = cpg->frequency[i];
+        for (j = 0; j < cpg->count; j++) {
+            if (cpg->coupling[i][j]) {
+                unsigned int diff = cpg->phase[j] - cpg->phase[i];
+                fx_angle error = (fx_angle)((diff >> 16) - cpg->offset[i][j]);
+                rate[i] += (cpg->coupling[i][j] * fx_sin(error)) >> 15;
+            }
+        }
+    }
+
+    for (i = 0; i < cpg->count; i++) {
+        // wraps mod 2^32 like the phase, a negative rate steps back
+        cpg->phase[i] += (unsigned int)(rate[i] * PHASE_PER_MHZ_MS) * dtMs;
+        cpg->frequency[i] = ramp(cpg->frequency[i], cpg->targetFrequency[i], dtMs, cpg->rampMs);
+        cpg->amplitude[i] = ramp(cpg->amplitude[i], cpg->targetAmplitude[i], dtMs, cpg->rampMs);
+    }
+}
+
+fx_angle cpg_phase(const Cpg *cpg, int i)
+{
+    return (fx_angle)(cpg->phase[i] >> 16);
+}
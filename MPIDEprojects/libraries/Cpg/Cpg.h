@@ -0,0 +1,81 @@
+/*=============================================================================
+ * Central pattern generator, a network of coupled phase oscillators
+ *
+ * One oscillator per leg or joint group keeps a phase that advances at its
+ * frequency and is pulled toward a set phase difference from the others:
+ *
+ *     dphi_i/dt = f_i + sum_j k_ij sin(phi_j - phi_i - psi_ij)
+ *
+ * with k_ij the coupling and psi_ij the wanted lead of j over i. Coupled
+ * legs fall into their offsets from any start and return to them after a
+ * disturbance, instead of sharing one clock that cannot be pushed. Each
+ * oscillator also has an amplitude, 0..1, for the size of its motion.
+ *
+ * Frequency and amplitude follow their set values with a first order lag,
+ * so changing the speed or stopping is a smooth ramp. Sensor feedback moves
+ * phases directly: cpg_correct() pulls an oscillator toward a phase, all
+ * the way for a reset on foot contact or partly for a gentler advance, and
+ * the coupling carries the change to the rest of the network.
+ *
+ * Phases are 32 bit, 2^32 a cycle, the top 16 bits an fx_angle.
+ * Frequencies and couplings are in mHz, amplitudes Q15. A tick is a handful
+ * of multiplies and one fx_sin per coupled pair.
+ *===========================================================================*/
+#ifndef __CPG_H__
+#define __CPG_H__
+
+#include "FixMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPG_MAX_OSCILLATORS 4
+
+// Highest frequency and coupling in mHz, keeps phase rates in 32 bits
+#define CPG_MAX_FREQUENCY 20000
+
+typedef struct {
+    int count;
+    unsigned int rampMs;                        // lag of frequency and amplitude
+
+    unsigned int phase[CPG_MAX_OSCILLATORS];
+    int frequency[CPG_MAX_OSCILLATORS];         // mHz
+    int targetFrequency[CPG_MAX_OSCILLATORS];
+    int amplitude[CPG_MAX_OSCILLATORS];         // Q15
+    int targetAmplitude[CPG_MAX_OSCILLATORS];
+
+    // pull of j on i in mHz at a quarter cycle of error, 0 for none
+    int coupling[CPG_MAX_OSCILLATORS][CPG_MAX_OSCILLATORS];
+    fx_angle offset[CPG_MAX_OSCILLATORS][CPG_MAX_OSCILLATORS];  // psi_ij
+} Cpg;
+
+// count uncoupled oscillators at phase 0 and amplitude 0, running at frequency
+void cpg_init(Cpg *cpg, int count, int frequency, unsigned int rampMs);
+
+/*
+ * Couples i and j both ways with strength in mHz, j leading i by offset
+ * (0x8000 for legs in anti-phase)
+ */
+void cpg_couple(Cpg *cpg, int i, int j, int strength, fx_angle offset);
+
+// Frequency every oscillator ramps to, mHz
+void cpg_set_frequency(Cpg *cpg, int frequency);
+
+// Amplitude oscillator i ramps to, Q15
+void cpg_set_amplitude(Cpg *cpg, int i, int amplitude);
+
+// Moves oscillator i gain (Q15, 32768 is all the way) of the shortest way to phase
+void cpg_correct(Cpg *cpg, int i, unsigned int phase, int gain);
+
+// Advances the network dtMs
+void cpg_tick(Cpg *cpg, unsigned int dtMs);
+
+// Phase of oscillator i as an fx_angle
+fx_angle cpg_phase(const Cpg *cpg, int i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
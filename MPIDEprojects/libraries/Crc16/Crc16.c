@@ -0,0 +1,17 @@
+/*=============================================================================
+ * CRC-16/CCITT, see Crc16.h
+ *===========================================================================*/
+#include "Crc16.h"
+
+unsigned short crc16_update(unsigned short crc, const void *data, unsigned int length)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    int bit;
+
+    while (length--) {
+        crc ^= (unsigned short)(*p++ << 8);
+        for (bit = 0; bit < 8; bit++)
+            crc = (unsigned short)(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
+    }
+    return crc;
+}
@@ -0,0 +1,24 @@
+/*=============================================================================
+ * CRC-16/CCITT for stored and transferred records
+ *
+ * Polynomial 0x1021, start with CRC16_INIT (0xFFFF), no final xor. Feeding
+ * a buffer in pieces gives the same result as all at once. Bitwise, about
+ * eight cycles a bit, meant for records of a few hundred bytes checked at
+ * load or on command rather than per frame.
+ *===========================================================================*/
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC16_INIT 0xFFFF
+
+unsigned short crc16_update(unsigned short crc, const void *data, unsigned int length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+/*=============================================================================
+ * Servo current budget, see CurrentBudget.h
+ *===========================================================================*/
+#include "CurrentBudget.h"
+
+// Largest current one joint's move is taken to draw, keeps the sums in 32 bits
+#define MAX_MOVE_MA (1 << 24)
+
+static int clamp(int x, int low, int high)
+{
+    return x < low ? low : x > high ? high : x;
+}
+
+static int absolute(int x)
+{
+    return x < 0 ? -x : x;
+}
+
+// Current over holding of moving a joint by delta in one frame, mA
+static int moveCurrent(const CurrentBudget *cb, int j, int delta)
+{
+    const CbudgetJoint *joint = &cb->joint[j];
+    long long ma = (long long)joint->moveMa * absolute(delta) * 1000
+                   / ((long long)joint->fullSpeed * cb->frameMs);
+
+    return ma > MAX_MOVE_MA ? MAX_MOVE_MA : (int)ma;
+}
+
+// Part of a move, fraction Q15
+static int part(int x, int fraction)
+{
+    return (int)((long long)x * fraction / 32768);
+}
+
+void cbudget_init(CurrentBudget *cb, int joints, int groups, int frameMs, int budgetMa, int mode)
+{
+    int i;
+
+    cb->joints = clamp(joints, 1, CBUDGET_MAX_JOINTS);
+    cb->groups = clamp(groups, 1, CBUDGET_MAX_GROUPS);
+    cb->frameMs = frameMs < 1 ? 1 : frameMs;
+    for (i = 0; i < CBUDGET_MAX_JOINTS; i++) {
+        cb->joint[i].holdMa = 0;
+        cb->joint[i].moveMa = 0;
+        cb->joint[i].fullSpeed = 1;
+        cb->joint[i].group = 0;
+    }
+    for (i = 0; i < CBUDGET_MAX_GROUPS; i++) {
+        cb->model[i] = 0;
+        cb->correction[i] = 0;
+    }
+    cbudget_set_budget(cb, budgetMa, mode);
+    cbudget_reset(cb);
+    cb->predicted = 0;
+    cb->lag = 0;
+    cb->lagMax = 0;
+    cb->limited = 0;
+}
+
+void cbudget_set_joint(CurrentBudget *cb, int joint, int holdMa, int moveMa, int fullSpeed, int group)
+{
+    CbudgetJoint *j;
+
+    if (joint < 0 || joint >= cb->joints)
+        return;
+    j = &cb->joint[joint];
+    j->holdMa = clamp(holdMa, 0, MAX_MOVE_MA);
+    j->moveMa = clamp(moveMa, 0, MAX_MOVE_MA);
+    j->fullSpeed = fullSpeed < 1 ? 1 : fullSpeed;
+    j->group = clamp(group, 0, cb->groups - 1);
+}
+
+void cbudget_set_budget(CurrentBudget *cb, int budgetMa, int mode)
+{
+    cb->budgetMa = budgetMa < 0 ? 0 : budgetMa;
+    cb->mode = mode == CBUDGET_STAGGER ? CBUDGET_STAGGER : CBUDGET_STRETCH;
+}
+
+void cbudget_reset(CurrentBudget *cb)
+{
+    cb->started = 0;
+    cb->next = 0;
+}
+
+int cbudget_schedule(CurrentBudget *cb, const int *target, int *out)
+{
+    int delta[CBUDGET_MAX_JOINTS], current[CBUDGET_MAX_JOINTS];
+    int base = 0, moving = 0, spare, fraction, lag = 0;
+    int i, j, k, g;
+
+    if (!cb->started) {
+        for (j = 0; j < cb->joints; j++)
+            cb->sent[j] = target[j];
+        cb->started = 1;
+    }
+
+    // holding current, with what the sensing says the model leaves out
+    for (g = 0; g < cb->groups; g++)
+        cb->model[g] = 0;
+    for (j = 0; j < cb->joints; j++)
+        cb->model[cb->joint[j].group] += cb->joint[j].holdMa;
+    for (g = 0; g < cb->groups; g++) {
+        int held = cb->model[g] + cb->correction[g];
+        base += held > 0 ? held : 0;
+    }
+
+    for (j = 0; j < cb->joints; j++) {
+        delta[j] = target[j] - cb->sent[j];
+        current[j] = moveCurrent(cb, j, delta[j]);
+        moving += current[j];
+    }
+
+    spare = cb->budgetMa - base;
+    if (cb->budgetMa != 0 && moving > spare) {
+        cb->limited++;
+        if (spare <= 0) {
+            // holding still already takes the budget, nothing moves
+            for (j = 0; j < cb->joints; j++)
+                delta[j] = current[j] = 0;
+        } else if (cb->mode == CBUDGET_STRETCH) {
+            fraction = (int)((long long)spare * 32768 / moving);
+            for (j = 0; j < cb->joints; j++) {
+                delta[j] = part(delta[j], fraction);
+                current[j] = part(current[j], fraction);
+            }
+        } else {
+            for (k = 0; k < cb->joints; k++) {
+                j = (cb->next + k) % cb->joints;
+                if (current[j] <= spare) {
+                    spare -= current[j];
+                    continue;
+                }
+                fraction = (int)((long long)spare * 32768 / current[j]);
+                delta[j] = part(delta[j], fraction);
+                current[j] = part(current[j], fraction);
+                spare = 0;
+            }
+            cb->next = (cb->next + 1) % cb->joints;
+        }
+    }
+
+    cb->predicted = base;
+    for (j = 0; j < cb->joints; j++) {
+        cb->sent[j] += delta[j];
+        cb->model[cb->joint[j].group] += current[j];
+        cb->predicted += current[j];
+        i = absolute(target[j] - cb->sent[j]);
+        if (i > lag)
+            lag = i;
+        out[j] = cb->sent[j];
+    }
+    cb->lag = lag;
+    if (lag > cb->lagMax)
+        cb->lagMax = lag;
+    return cb->predicted;
+}
+
+void cbudget_measure(CurrentBudget *cb, const int *measuredMa)
+{
+    int g;
+
+    for (g = 0; g < cb->groups; g++)
+        cb->correction[g] += (measuredMa[g] - cb->model[g] - cb->correction[g]) >> CBUDGET_FEEDBACK_SHIFT;
+}
+
+int cbudget_take_lag(CurrentBudget *cb)
+{
+    int lag = cb->lagMax;
+
+    cb->lagMax = cb->lag;
+    return lag;
+}
+
+unsigned int cbudget_take_limited(CurrentBudget *cb)
+{
+    unsigned int limited = cb->limited;
+
+    cb->limited = 0;
+    return limited;
+}
@@ -0,0 +1,113 @@
+/*=============================================================================
+ * Servo current budget for SSC-32 group moves
+ *
+ * A group move starts every servo at once, and a dozen servos each pulling
+ * an amp or more on a step take more than the supply gives. Each frame the
+ * joint targets go through cbudget_schedule(), which predicts the current
+ * of the move from the last angles sent and holds it to a budget.
+ *
+ * A joint's current is modelled as
+ *
+ *     holdMa + moveMa * speed / fullSpeed
+ *
+ * its draw standing still plus a part of the draw at full speed, speed the
+ * move's angle over the frame time. Each joint belongs to a group, a leg,
+ * whose current can be measured; cbudget_measure() then learns how far the
+ * measured current runs over the model (the load of a stance leg, mostly)
+ * and adds that to later predictions. Without sensing that term stays 0.
+ *
+ * When a frame's prediction is over budget the joints move only part of
+ * the way:
+ *
+ *     CBUDGET_STRETCH  every joint the same part, the group move stretched
+ *                      in time, so the joints stay coordinated
+ *     CBUDGET_STAGGER  joints in turn take their whole move until the
+ *                      budget is spent, the rest wait for later frames,
+ *                      the first joint to go moving round every frame
+ *
+ * Either way the gait itself keeps its timing: targets still come from the
+ * gait phase, and what a joint did not move is part of the next frame's
+ * move, caught up as soon as the budget has room. The lag, how far the
+ * servos trail the gait, is kept for reporting.
+ *
+ * Angles are the caller's units (fx_angle on the robot), speeds those units
+ * per second and currents mA. A schedule is a few multiplies and a divide
+ * per joint.
+ *===========================================================================*/
+#ifndef __CURRENT_BUDGET_H__
+#define __CURRENT_BUDGET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CBUDGET_MAX_JOINTS 12
+#define CBUDGET_MAX_GROUPS 4
+
+// Measured over model error taken per measurement, 2^-n of it
+#define CBUDGET_FEEDBACK_SHIFT 3
+
+enum CbudgetMode {
+    CBUDGET_STRETCH,
+    CBUDGET_STAGGER
+};
+
+typedef struct {
+    int holdMa;             // still, unloaded
+    int moveMa;             // more at full speed
+    int fullSpeed;          // angle units per second
+    int group;              // current sense it is measured by
+} CbudgetJoint;
+
+typedef struct {
+    int joints, groups;
+    int frameMs;
+    int budgetMa;                           // 0 for no limit
+    int mode;
+    CbudgetJoint joint[CBUDGET_MAX_JOINTS];
+    int sent[CBUDGET_MAX_JOINTS];           // angles last sent
+    int started;                            // sent is set
+    int next;                               // first joint to move when staggering
+    int model[CBUDGET_MAX_GROUPS];          // mA the model gave the last frame
+    int correction[CBUDGET_MAX_GROUPS];     // mA measured over the model, filtered
+    int predicted;                          // mA for the last frame, all groups
+    int lag;                                // largest target less sent, last frame
+    int lagMax;                             // the largest since taken
+    unsigned int limited;                   // frames held to the budget since taken
+} CurrentBudget;
+
+// Joints and groups clamped to their ranges, every joint in group 0
+// drawing nothing until set, budget as cbudget_set_budget()
+void cbudget_init(CurrentBudget *cb, int joints, int groups, int frameMs, int budgetMa, int mode);
+
+// A joint's model, currents at least 0 and fullSpeed at least 1
+void cbudget_set_joint(CurrentBudget *cb, int joint, int holdMa, int moveMa, int fullSpeed, int group);
+
+// Budget in mA for all the joints together, 0 for no limit, and how an
+// over budget frame is cut
+void cbudget_set_budget(CurrentBudget *cb, int budgetMa, int mode);
+
+// Forgets the angles sent, the next frame is taken as where the servos are
+void cbudget_reset(CurrentBudget *cb);
+
+/*
+ * The angles to send this frame on the way to target, into out (which may
+ * be target). Returns the predicted current of the frame in mA, within the
+ * budget unless holding still already takes more.
+ */
+int cbudget_schedule(CurrentBudget *cb, const int *target, int *out);
+
+// Measured current of each group in mA, for the frame last scheduled
+void cbudget_measure(CurrentBudget *cb, const int *measuredMa);
+
+// Largest lag since the last call, then starts again
+int cbudget_take_lag(CurrentBudget *cb);
+
+// Frames held to the budget since the last call, then starts again
+unsigned int cbudget_take_limited(CurrentBudget *cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
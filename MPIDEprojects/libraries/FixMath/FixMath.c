@@ -0,0 +1,321 @@
+/*=============================================================================
+ * Fixed point math kernels, see FixMath.h
+ *
+ * The tables were generated with Python's math module and are interpolated
+ * linearly, 256 steps keep the interpolation error well under one LSB.
+ *===========================================================================*/
+#include "FixMath.h"
+
+// log2(e) in 8.24
+#define LOG2E_Q24 24204406
+
+// fx_exp input range, e^x still fits Q16.16 and is at least one LSB
+#define EXP_MAX_X 681391
+#define EXP_MIN_X (-772243)
+
+// sin over a quarter turn in 256 steps, 32768 is 1.0, padded for interpolation
+static const unsigned short sinTable[258] = {
+        0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+     2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6787,  6983,
+     7180,  7376,  7571,  7767,  7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+     9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+    14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+    16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+    20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+    22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+    23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+    26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+    28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+    29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+    31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+    31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+    32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+    32758, 32762, 32766, 32767, 32768, 32768,
+};
+
+// atan(i / 256) as an angle, padded for interpolation
+static const unsigned short atanTable[258] = {
+       0,   41,   81,  122,  163,  204,  244,  285,  326,  367,  407,  448,
+     489,  529,  570,  610,  651,  692,  732,  773,  813,  854,  894,  935,
+     975, 1015, 1056, 1096, 1136, 1177, 1217, 1257, 1297, 1337, 1377, 1417,
+    1457, 1497, 1537, 1577, 1617, 1656, 1696, 1736, 1775, 1815, 1854, 1894,
+    1933, 1973, 2012, 2051, 2090, 2129, 2168, 2207, 2246, 2285, 2324, 2363,
+    2401, 2440, 2478, 2517, 2555, 2594, 2632, 2670, 2708, 2746, 2784, 2822,
+    2860, 2897, 2935, 2973, 3010, 3047, 3085, 3122, 3159, 3196, 3233, 3270,
+    3307, 3344, 3380, 3417, 3453, 3490, 3526, 3562, 3599, 3635, 3670, 3706,
+    3742, 3778, 3813, 3849, 3884, 3920, 3955, 3990, 4025, 4060, 4095, 4129,
+    4164, 4199, 4233, 4267, 4302, 4336, 4370, 4404, 4438, 4471, 4505, 4539,
+    4572, 4605, 4639, 4672, 4705, 4738, 4771, 4803, 4836, 4869, 4901, 4933,
+    4966, 4998, 5030, 5062, 5094, 5125, 5157, 5188, 5220, 5251, 5282, 5313,
+    5344, 5375, 5406, 5437, 5467, 5498, 5528, 5559, 5589, 5619, 5649, 5679,
+    5708, 5738, 5768, 5797, 5826, 5856, 5885, 5914, 5943, 5972, 6000, 6029,
+    6058, 6086, 6114, 6142, 6171, 6199, 6227, 6254, 6282, 6310, 6337, 6365,
+    6392, 6419, 6446, 6473, 6500, 6527, 6554, 6580, 6607, 6633, 6660, 6686,
+    6712, 6738, 6764, 6790, 6815, 6841, 6867, 6892, 6917, 6943, 6968, 6993,
+    7018, 7043, 7068, 7092, 7117, 7141, 7166, 7190, 7214, 7238, 7262, 7286,
+    7310, 7334, 7358, 7381, 7405, 7428, 7451, 7475, 7498, 7521, 7544, 7566,
+    7589, 7612, 7635, 7657, 7679, 7702, 7724, 7746, 7768, 7790, 7812, 7834,
+    7856, 7877, 7899, 7920, 7942, 7963, 7984, 8005, 8026, 8047, 8068, 8089,
+    8110, 8131, 8151, 8172, 8192, 8192,
+};
+
+// 2^(i / 256) in 2.30, padded for interpolation
+static const unsigned int exp2Table[258] = {
+    1073741824, 1076653033, 1079572136, 1082499153, 1085434106, 1088377016,
+    1091327906, 1094286796, 1097253708, 1100228665, 1103211687, 1106202798,
+    1109202018, 1112209370, 1115224875, 1118248556, 1121280436, 1124320536,
+    1127368878, 1130425485, 1133490379, 1136563583, 1139645120, 1142735011,
+    1145833280, 1148939949, 1152055042, 1155178580, 1158310587, 1161451085,
+    1164600099, 1167757650, 1170923762, 1174098458, 1177281762, 1180473697,
+    1183674286, 1186883552, 1190101520, 1193328213, 1196563654, 1199807867,
+    1203060876, 1206322705, 1209593378, 1212872918, 1216161350, 1219458698,
+    1222764986, 1226080238, 1229404479, 1232737732, 1236080024, 1239431376,
+    1242791816, 1246161366, 1249540052, 1252927899, 1256324931, 1259731174,
+    1263146652, 1266571390, 1270005413, 1273448747, 1276901417, 1280363448,
+    1283834865, 1287315695, 1290805962, 1294305692, 1297814910, 1301333643,
+    1304861917, 1308399756, 1311947188, 1315504238, 1319070932, 1322647296,
+    1326233356, 1329829140, 1333434672, 1337049980, 1340675091, 1344310030,
+    1347954824, 1351609500, 1355274085, 1358948606, 1362633090, 1366327563,
+    1370032052, 1373746586, 1377471191, 1381205894, 1384950723, 1388705706,
+    1392470869, 1396246240, 1400031848, 1403827719, 1407633882, 1411450365,
+    1415277195, 1419114401, 1422962010, 1426820052, 1430688553, 1434567544,
+    1438457051, 1442357104, 1446267730, 1450188960, 1454120821, 1458063343,
+    1462016553, 1465980482, 1469955159, 1473940611, 1477936870, 1481943963,
+    1485961921, 1489990772, 1494030547, 1498081275, 1502142985, 1506215708,
+    1510299473, 1514394310, 1518500250, 1522617322, 1526745556, 1530884983,
+    1535035634, 1539197537, 1543370725, 1547555228, 1551751076, 1555958300,
+    1560176931, 1564406999, 1568648537, 1572901575, 1577166143, 1581442275,
+    1585730000, 1590029350, 1594340357, 1598663052, 1602997467, 1607343634,
+    1611701585, 1616071351, 1620452965, 1624846459, 1629251865, 1633669214,
+    1638098541, 1642539877, 1646993254, 1651458706, 1655936265, 1660425963,
+    1664927835, 1669441912, 1673968228, 1678506817, 1683057710, 1687620943,
+    1692196547, 1696784557, 1701385007, 1705997930, 1710623359, 1715261330,
+    1719911875, 1724575029, 1729250827, 1733939301, 1738640488, 1743354420,
+    1748081133, 1752820662, 1757573041, 1762338305, 1767116489, 1771907628,
+    1776711757, 1781528911, 1786359126, 1791202437, 1796058879, 1800928489,
+    1805811301, 1810707353, 1815616678, 1820539314, 1825475297, 1830424663,
+    1835387448, 1840363688, 1845353420, 1850356681, 1855373507, 1860403934,
+    1865448001, 1870505744, 1875577199, 1880662405, 1885761398, 1890874216,
+    1896000896, 1901141476, 1906295993, 1911464486, 1916646992, 1921843549,
+    1927054196, 1932278970, 1937517909, 1942771053, 1948038440, 1953320108,
+    1958616096, 1963926443, 1969251188, 1974590370, 1979944027, 1985312200,
+    1990694927, 1996092249, 2001504204, 2006930832, 2012372174, 2017828268,
+    2023299156, 2028784876, 2034285470, 2039800978, 2045331439, 2050876895,
+    2056437387, 2062012954, 2067603638, 2073209480, 2078830522, 2084466803,
+    2090118366, 2095785251, 2101467502, 2107165158, 2112878262, 2118606857,
+    2124350982, 2130110682, 2135885998, 2141676973, 2147483648, 2147483648,
+};
+/*---------------------------------------------------------------------------*/
+
+q16_t fx_angle_to_rad(fx_angle a)
+{
+    // 2 pi in Q16.16 per turn
+    return (q16_t)(((long long)(short)a * 411775 + 0x8000) >> 16);
+}
+
+fx_angle fx_rad_to_angle(q16_t rad)
+{
+    // 2^32 / (2 pi), the angle wraps with the low 16 bits
+    return (fx_angle)(((long long)rad * 683565276 + 0x80000000LL) >> 32);
+}
+
+q16_t fx_angle_to_deg(fx_angle a)
+{
+    return (short)a * 360;
+}
+
+/*---------------------------------------------------------------------------*/
+
+// sin of a quarter turn angle 0..16384, 0..32768
+static int sinQuarter(unsigned int a)
+{
+    unsigned int i = a >> 6;
+    int f = a & 63;
+    int s0 = sinTable[i];
+    return s0 + (((sinTable[i + 1] - s0) * f + 32) >> 6);
+}
+
+q15_t fx_sin(fx_angle a)
+{
+    unsigned int quadrant = a >> 14;
+    unsigned int r = a & 0x3FFF;
+    int v;
+
+    // mirror the 2nd and 4th quadrants, negate the lower half turn
+    if (quadrant & 1)
+        r = 0x4000 - r;
+    v = sinQuarter(r);
+    if (v > FX_Q15_ONE)
+        v = FX_Q15_ONE;
+    return (q15_t)((quadrant & 2) ? -v : v);
+}
+
+q15_t fx_cos(fx_angle a)
+{
+    return fx_sin((fx_angle)(a + 0x4000));
+}
+
+/*---------------------------------------------------------------------------*/
+
+// atan of a ratio 0..65536 (0..1 in Q16) as an angle 0..8192
+static int atanRatio(unsigned int z)
+{
+    unsigned int i = z >> 8;
+    int f = z & 255;
+    int t0 = atanTable[i];
+    return t0 + (((atanTable[i + 1] - t0) * f + 128) >> 8);
+}
+
+fx_angle fx_atan2(int y, int x)
+{
+    unsigned int ax = x < 0 ? 0u - (unsigned int)x : (unsigned int)x;
+    unsigned int ay = y < 0 ? 0u - (unsigned int)y : (unsigned int)y;
+    unsigned int lo = ay < ax ? ay : ax;
+    unsigned int hi = ay < ax ? ax : ay;
+    int a;
+
+    if (hi == 0)
+        return 0;
+
+    // scale hi below 2^16 so the ratio fits 32 bits, rounding both
+    if (hi >= 0x10000) {
+        int shift = 16 - __builtin_clz(hi);
+        lo = (lo + (1u << (shift - 1))) >> shift;
+        hi = (hi + (1u << (shift - 1))) >> shift;
+    }
+    a = atanRatio(((lo << 16) + (hi >> 1)) / hi);
+
+    // back to the octant of (x, y)
+    if (ay > ax)
+        a = 0x4000 - a;
+    if (x < 0)
+        a = 0x8000 - a;
+    if (y < 0)
+        a = -a;
+    return (fx_angle)a;
+}
+
+/*---------------------------------------------------------------------------*/
+
+unsigned int fx_isqrt(unsigned int x)
+{
+    unsigned int root = 0;
+    unsigned int bit;
+
+    if (x == 0)
+        return 0;
+
+    // highest power of four not above x, then one result bit per step
+    bit = 1u << ((31 - __builtin_clz(x)) & ~1);
+    while (bit != 0) {
+        // branch free, mask is all ones when the trial bit fits
+        unsigned int trial = root + bit;
+        unsigned int mask = 0u - (x >= trial);
+        x -= trial & mask;
+        root = (root >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+    return root;
+}
+
+q16_t fx_sqrt_q16(q16_t x)
+{
+    unsigned long long v, bit;
+    unsigned long long root = 0;
+
+    if (x <= 0)
+        return 0;
+    if (x < 0x10000)
+        return fx_isqrt((unsigned int)x << 16);
+
+    // sqrt(x * 2^16) needs 48 bits of radicand
+    v = (unsigned long long)x << 16;
+    bit = 1ULL << (((31 - __builtin_clz(x)) & ~1) + 16);
+    while (bit != 0) {
+        unsigned long long trial = root + bit;
+        unsigned long long mask = 0ULL - (v >= trial);
+        v -= trial & mask;
+        root = (root >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+    return (q16_t)root;
+}
+
+/*---------------------------------------------------------------------------*/
+
+q16_t fx_exp(q16_t x)
+{
+    int y, k, shift;
+    unsigned int i, f, m;
+
+    if (x > EXP_MAX_X)
+        return 0x7FFFFFFF;
+    if (x < EXP_MIN_X)
+        return 0;
+
+    // e^x = 2^(x log2 e) = 2^k * 2^(i/256 + f/2^24), y in 8.24
+    y = (int)(((long long)x * LOG2E_Q24 + 0x8000) >> 16);
+    k = y >> 24;
+    i = (y >> 16) & 255;
+    f = y & 0xFFFF;
+    m = exp2Table[i] + (unsigned int)(((unsigned long long)(exp2Table[i + 1] - exp2Table[i]) * f + 0x8000) >> 16);
+
+    // m is 2.30, the result Q16.16
+    shift = 14 - k;
+    if (shift <= 0)
+        return m > 0x7FFFFFFFu ? 0x7FFFFFFF : (q16_t)m;
+    if (shift > 31)
+        return 0;
+    return (q16_t)((m + (1u << (shift - 1))) >> shift);
+}
+
+q15_t fx_sigmoid(q16_t x)
+{
+    unsigned int e, d, s;
+
+    // 1 / (1 + e^-|x|) is 0.5..1, the negative side mirrors it
+    e = fx_exp(x >= 0 ? -x : x);
+    d = FX_Q16_ONE + e;
+    s = (0x80000000u + (d >> 1)) / d;
+    if (x < 0)
+        return (q15_t)(32768 - s);
+    return (q15_t)(s > FX_Q15_ONE ? FX_Q15_ONE : s);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void fx_sin_batch(const fx_angle *a, q15_t *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        out[i] = fx_sin(a[i]);
+}
+
+void fx_cos_batch(const fx_angle *a, q15_t *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        out[i] = fx_sin((fx_angle)(a[i] + 0x4000));
+}
+
+void fx_sincos_batch(const fx_angle *a, q15_t *sinOut, q15_t *cosOut, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+        sinOut[i] = fx_sin(a[i]);
+        cosOut[i] = fx_sin((fx_angle)(a[i] + 0x4000));
+    }
+}
+
+void fx_atan2_batch(const int *y, const int *x, fx_angle *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        out[i] = fx_atan2(y[i], x[i]);
+}
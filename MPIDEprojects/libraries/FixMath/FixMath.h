@@ -0,0 +1,82 @@
+/*=============================================================================
+ * Fixed point math kernels for the FPU-less PIC32MX
+ *
+ * float and double are soft float on the PIC32MX795, a libm sin() costs
+ * thousands of cycles. These kernels use small interpolated tables and
+ * integer arithmetic only, so control code can drop <math.h>.
+ *
+ * Formats:
+ *     q15_t    signed 1.15,  1.0 = 32768 (saturates at 32767)
+ *     q16_t    signed 16.16, 1.0 = 65536
+ *     fx_angle binary angle, a full turn is 65536, wraps naturally. As a
+ *              signed short it is -pi..pi, see FX_DEG() and fx_angle_to_rad()
+ *
+ * Maximum errors, checked over the whole input range against libm by
+ * PCprojects/FixMathBench:
+ *     fx_sin, fx_cos      1.5 LSB of Q15 (4.6e-5)
+ *     fx_atan2            1.5 LSB of the angle (1.4e-4 rad, 0.008 deg)
+ *     fx_isqrt            exact floor
+ *     fx_sqrt_q16         1 LSB of Q16.16
+ *     fx_exp              relative 2e-5, or 1 LSB for results below 1.0
+ *     fx_sigmoid          1 LSB of Q15
+ *
+ * The _batch variants process arrays in one call, for legs and keyframes
+ * that need many angles per control tick.
+ *===========================================================================*/
+#ifndef __FIX_MATH_H__
+#define __FIX_MATH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef short q15_t;
+typedef int q16_t;
+typedef unsigned short fx_angle;
+
+#define FX_Q15_ONE 32767
+#define FX_Q16_ONE 65536
+
+// Constant conversions, for literals only, they use floating point
+#define FX_Q15(x) ((q15_t)((x) >= 1.0 ? FX_Q15_ONE : (x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define FX_Q16(x) ((q16_t)((x) * 65536.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define FX_DEG(x) ((fx_angle)(short)((x) * 65536.0 / 360.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+#define FX_Q16_PI 205887
+
+// Products with rounding, the 64 bit multiply is one MIPS mult
+#define fx_mul_q15(a, b) ((q15_t)(((int)(a) * (b) + 0x4000) >> 15))
+#define fx_mul_q16(a, b) ((q16_t)(((long long)(a) * (b) + 0x8000) >> 16))
+
+// Angle conversions, radians in Q16.16 and degrees in Q16.16
+q16_t fx_angle_to_rad(fx_angle a);
+fx_angle fx_rad_to_angle(q16_t rad);
+q16_t fx_angle_to_deg(fx_angle a);
+
+q15_t fx_sin(fx_angle a);
+q15_t fx_cos(fx_angle a);
+
+// Angle of the vector (x, y), -pi..pi as a signed angle, 0 for (0, 0)
+fx_angle fx_atan2(int y, int x);
+
+// Square roots, integer floor and Q16.16
+unsigned int fx_isqrt(unsigned int x);
+q16_t fx_sqrt_q16(q16_t x);
+
+// e^x in Q16.16, saturates above x = 10.39 and is 0 below x = -11.09
+q16_t fx_exp(q16_t x);
+
+// Logistic 1 / (1 + e^-x) in Q15, for fuzzy membership functions
+q15_t fx_sigmoid(q16_t x);
+
+// Array variants, out may not alias the inputs
+void fx_sin_batch(const fx_angle *a, q15_t *out, int n);
+void fx_cos_batch(const fx_angle *a, q15_t *out, int n);
+void fx_sincos_batch(const fx_angle *a, q15_t *sinOut, q15_t *cosOut, int n);
+void fx_atan2_batch(const int *y, const int *x, fx_angle *out, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/*=============================================================================
+ * Cartesian foot trajectories for walking, see FootPlanner.h
+ *===========================================================================*/
+#include "FootPlanner.h"
+
+// 1 / (2 pi) in Q15
+#define INV_TWO_PI_Q15 5215
+
+void planner_init(FootPlanner *planner, const GaitParams *params)
+{
+    int leg;
+
+    planner->params = *params;
+    planner->phase = 0;
+    for (leg = 0; leg < PLANNER_NUM_LEGS; leg++) {
+        planner->step[leg].startX = 0;
+        planner->step[leg].length = 0;
+        planner->step[leg].height = 0;
+        planner->step[leg].swinging = 0;
+    }
+}
+
+void planner_tick(FootPlanner *planner)
+{
+    unsigned int period = planner->params.period ? planner->params.period : 1;
+
+    planner->phase += (65536 + period / 2) / period;
+}
+
+/*
+ * Swing profile at progress u (a full swing is 65536): forward fraction and
+ * lift fraction, both Q15.
+ */
+static void swingProfile(int shape, unsigned int u, int *forward, int *lift)
+{
+    int t = u >> 1;
+
+    if (shape == SWING_BEZIER) {
+        // control points at the ends raised by 4/3 of the height give
+        // x = 3t^2 - 2t^3 and z = 4t(1 - t)
+        int t2 = (t * t) >> 15;
+        int t3 = (t2 * t) >> 15;
+        *forward = 3 * t2 - 2 * t3;
+        *lift = (4 * t * (32768 - t)) >> 15;
+    } else {
+        // x = t - sin(2 pi t) / 2 pi, z = (1 - cos(2 pi t)) / 2
+        *forward = t - ((fx_sin((fx_angle)u) * INV_TWO_PI_Q15) >> 15);
+        *lift = (32768 - fx_cos((fx_angle)u)) >> 1;
+    }
+}
+
+void planner_foot(FootPlanner *planner, int leg, FootPose *foot)
+{
+    planner_foot_at(planner, leg, (fx_angle)(planner->phase + (leg == PLANNER_LEFT_LEG ? 0x8000 : 0)), foot);
+}
+
+void planner_foot_at(FootPlanner *planner, int leg, fx_angle legPhase, FootPose *foot)
+{
+    const GaitParams *params = &planner->params;
+    FootStep *step = &planner->step[leg];
+    unsigned int phase = legPhase;
+    unsigned int swingEnd = (unsigned int)params->swingFraction * 2;
+    int forward, lift;
+
+    if (swingEnd < 1)
+        swingEnd = 1;
+    if (swingEnd > 65535)
+        swingEnd = 65535;
+
+    if (phase < swingEnd) {
+        // lift off, take the parameters for this step
+        if (!step->swinging) {
+            step->startX = -step->length / 2;
+            step->length = params->stepLength;
+            step->height = params->stepHeight;
+            step->swinging = 1;
+        }
+        swingProfile(params->swingShape, (phase << 16) / swingEnd, &forward, &lift);
+        foot->x = step->startX + (int)(((long long)(step->length / 2 - step->startX) * forward) >> 15);
+        foot->z = -params->standHeight + ((step->height * lift) >> 15);
+    } else {
+        // stance, push the foot back at constant speed
+        unsigned int v = ((phase - swingEnd) << 15) / (65536 - swingEnd);
+        step->swinging = 0;
+        foot->x = step->length / 2 - (int)(((long long)step->length * v) >> 15);
+        foot->z = -params->standHeight;
+    }
+
+    foot->y = leg == PLANNER_LEFT_LEG ? params->stanceWidth : -params->stanceWidth;
+    foot->yaw = 0;
+    foot->pitch = 0;
+    foot->roll = 0;
+}
@@ -0,0 +1,86 @@
+/*=============================================================================
+ * Cartesian foot trajectories for walking
+ *
+ * A gait is a few parameters (step length and height, stance width, stand
+ * height, cycle period, swing fraction) instead of joint sine waves. Each
+ * control tick the planner advances one phase accumulator and returns the
+ * foot pose of each leg in its hip frame, ready for legik_solve().
+ *
+ * Over a cycle each foot swings forward through the air and then pushes
+ * back along the ground in stance. The legs are half a cycle apart:
+ *
+ *     phase   0 ............ swingFraction ................... 1
+ *             swing -L/2 -> +L/2, lifted   stance +L/2 -> -L/2
+ *
+ * Swings follow a cycloid, zero velocity at lift off and touch down, or a
+ * cubic Bezier. Step length and height are latched at the start of each
+ * swing, so a change made at run time takes effect on the next step and the
+ * foot path stays continuous. Period changes only alter the phase rate.
+ *
+ * Lengths are in 0.1 mm (LEGIK_MM), poses use the LegIK hip frame.
+ *===========================================================================*/
+#ifndef __FOOT_PLANNER_H__
+#define __FOOT_PLANNER_H__
+
+#include "FixMath.h"
+#include "LegIK.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLANNER_NUM_LEGS 2
+
+// Legs in servo table order, the right foot is on the -y side
+#define PLANNER_RIGHT_LEG 0
+#define PLANNER_LEFT_LEG  1
+
+enum SwingShape {
+    SWING_CYCLOID,
+    SWING_BEZIER
+};
+
+typedef struct {
+    int stepLength;         // foot travel relative to the hip per step
+    int stepHeight;         // swing lift above the ground
+    int stanceWidth;        // foot offset outward from the hip
+    int standHeight;        // hip centre above the sole
+    unsigned short period;  // control ticks per gait cycle
+    q15_t swingFraction;    // part of the cycle each foot is in the air
+    unsigned char swingShape;
+} GaitParams;
+
+typedef struct {
+    int startX;             // where the current swing began
+    int length;             // step length latched for this step
+    int height;             // step height latched for this step
+    unsigned char swinging;
+} FootStep;
+
+typedef struct {
+    GaitParams params;      // may be changed between ticks
+    fx_angle phase;         // cycle phase of the right leg
+    FootStep step[PLANNER_NUM_LEGS];
+} FootPlanner;
+
+// Starts at phase 0 with both feet under the hips
+void planner_init(FootPlanner *planner, const GaitParams *params);
+
+// Advances one control tick
+void planner_tick(FootPlanner *planner);
+
+// Foot pose of a leg at the current phase, level and facing forward
+void planner_foot(FootPlanner *planner, int leg, FootPose *foot);
+
+/*
+ * Foot pose of a leg at its own cycle phase, 0 at lift off, for a phase
+ * source other than the planner's, such as a CPG. Steps still latch their
+ * length and height at each lift off.
+ */
+void planner_foot_at(FootPlanner *planner, int leg, fx_angle legPhase, FootPose *foot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
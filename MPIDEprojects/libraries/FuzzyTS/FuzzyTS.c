@@ -0,0 +1,122 @@
+/*=============================================================================
+ * Takagi-Sugeno fuzzy controller, see FuzzyTS.h
+ *===========================================================================*/
+#include "FuzzyTS.h"
+
+#define TABLE_STEPS (1 << FUZZY_TABLE_BITS)
+
+void fuzzy_init(FuzzyTS *fuzzy, int rules, int states, int outputs, fx_angle range)
+{
+    int r, i, j;
+    int halfWidth = (short)range;
+
+    if (rules < 1)
+        rules = 1;
+    if (rules > FUZZY_MAX_RULES)
+        rules = FUZZY_MAX_RULES;
+    if (states > FUZZY_MAX_STATES)
+        states = FUZZY_MAX_STATES;
+    if (outputs > FUZZY_MAX_OUTPUTS)
+        outputs = FUZZY_MAX_OUTPUTS;
+    if (halfWidth < 1)
+        halfWidth = 1;
+    if (halfWidth > 16384)
+        halfWidth = 16384;
+
+    fuzzy->rules = rules;
+    fuzzy->states = states;
+    fuzzy->outputs = outputs;
+    fuzzy->range = halfWidth;
+    fuzzy->scale = (TABLE_STEPS << 16) / (2 * halfWidth);
+
+    // equal weights, the remainder on the last rule so they sum to one
+    for (i = 0; i < FUZZY_TABLE_SIZE; i++) {
+        for (r = 0; r < rules; r++)
+            fuzzy->membership[r][i] = (unsigned short)(32768 / rules);
+        fuzzy->membership[rules - 1][i] += (unsigned short)(32768 % rules);
+    }
+    for (r = 0; r < FUZZY_MAX_RULES; r++)
+        for (j = 0; j < FUZZY_MAX_OUTPUTS; j++)
+            for (i = 0; i < FUZZY_MAX_STATES; i++)
+                fuzzy->gain[r][j][i] = 0;
+}
+
+void fuzzy_sigmoid_pair(FuzzyTS *fuzzy, q16_t slope, fx_angle edge)
+{
+    q16_t e = fx_angle_to_rad(edge);
+    int i;
+
+    if (fuzzy->rules != 2)
+        return;
+    for (i = 0; i < FUZZY_TABLE_SIZE; i++) {
+        int z = -fuzzy->range + 2 * fuzzy->range * i / TABLE_STEPS;
+        q16_t rad = fx_angle_to_rad((fx_angle)z);
+        int low = fx_sigmoid(fx_mul_q16(slope, rad + e));
+        int high = fx_sigmoid(fx_mul_q16(slope, rad - e));
+        int bump = ((32768 - high) * low + 0x4000) >> 15;
+
+        fuzzy->membership[0][i] = (unsigned short)bump;
+        fuzzy->membership[1][i] = (unsigned short)(32768 - bump);
+    }
+}
+
+void fuzzy_set_gain(FuzzyTS *fuzzy, int rule, const short *gain)
+{
+    int i, j;
+
+    if (rule < 0 || rule >= fuzzy->rules)
+        return;
+    for (j = 0; j < fuzzy->outputs; j++)
+        for (i = 0; i < fuzzy->states; i++)
+            fuzzy->gain[rule][j][i] = gain[j * fuzzy->states + i];
+}
+
+void fuzzy_weights(const FuzzyTS *fuzzy, fx_angle premise, unsigned short *weight)
+{
+    int z = (short)premise;
+    int position, index, frac, r, sum = 0;
+
+    if (z < -fuzzy->range)
+        z = -fuzzy->range;
+    if (z > fuzzy->range)
+        z = fuzzy->range;
+
+    // table position in Q16, the fraction taken to Q15 so a step times it fits
+    position = (z + fuzzy->range) * fuzzy->scale;
+    index = position >> 16;
+    frac = (position & 0xFFFF) >> 1;
+    if (index >= TABLE_STEPS) {
+        index = TABLE_STEPS - 1;
+        frac = 32768;
+    }
+    for (r = 0; r < fuzzy->rules; r++) {
+        int a = fuzzy->membership[r][index];
+        int b = fuzzy->membership[r][index + 1];
+
+        weight[r] = (unsigned short)(a + (((b - a) * frac) >> 15));
+        sum += weight[r];
+    }
+    // rounding can lose a count, the last rule takes it
+    weight[fuzzy->rules - 1] += (unsigned short)(32768 - sum);
+}
+
+void fuzzy_control(const FuzzyTS *fuzzy, fx_angle premise, const int *state, int *output)
+{
+    unsigned short weight[FUZZY_MAX_RULES];
+    int r, i, j;
+
+    fuzzy_weights(fuzzy, premise, weight);
+    for (j = 0; j < fuzzy->outputs; j++) {
+        int u = 0;
+
+        for (i = 0; i < fuzzy->states; i++) {
+            // the blended gain, a convex sum of Q12 gains so it fits
+            int k = 0;
+            for (r = 0; r < fuzzy->rules; r++)
+                k += weight[r] * fuzzy->gain[r][j][i];
+            k >>= 15;
+            u += (k * state[i]) >> 12;
+        }
+        output[j] = -u;
+    }
+}
@@ -0,0 +1,78 @@
+/*=============================================================================
+ * Takagi-Sugeno fuzzy controller, parallel distributed compensation
+ *
+ * Each rule r holds a linear state feedback K_r for one region of a premise
+ * variable z, and the controller blends them by how strongly each rule
+ * fires:
+ *
+ *     u = -sum h_r(z) K_r x        sum h_r = 1
+ *
+ * as in matlab/fuzzyPendulumnTest.m, where the two rules split the
+ * pendulum angle at +-pi/6 with
+ *
+ *     w_1 = (1 - s(k (z - e))) s(k (z + e))    s the logistic, k 7, e pi/6
+ *     w_2 = 1 - w_1
+ *
+ * The membership functions are tabulated once over -range..range, already
+ * normalized so the weights of a point sum to one, and read with linear
+ * interpolation, which keeps the sum. Beyond the range the end values
+ * hold. A control step is a table lookup per rule and a multiply per rule,
+ * output and state, no exp and no divide.
+ *
+ * The premise is an fx_angle, states and outputs are the caller's integer
+ * units and gains are Q12 (4096 is 1.0) outputs per state unit.
+ *===========================================================================*/
+#ifndef __FUZZY_TS_H__
+#define __FUZZY_TS_H__
+
+#include "FixMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FUZZY_MAX_RULES   4
+#define FUZZY_MAX_STATES  4
+#define FUZZY_MAX_OUTPUTS 4
+
+// Membership table intervals, a power of two
+#define FUZZY_TABLE_BITS  6
+#define FUZZY_TABLE_SIZE  ((1 << FUZZY_TABLE_BITS) + 1)
+
+typedef struct {
+    int rules, states, outputs;
+    int range;                      // premise half-width covered by the tables, fx_angle
+    int scale;                      // table position per premise unit, Q16
+
+    // normalized firing strength of each rule, 32768 is 1.0
+    unsigned short membership[FUZZY_MAX_RULES][FUZZY_TABLE_SIZE];
+    short gain[FUZZY_MAX_RULES][FUZZY_MAX_OUTPUTS][FUZZY_MAX_STATES];   // Q12
+} FuzzyTS;
+
+/*
+ * rules, states and outputs up to the maximums, tables over -range..range,
+ * range at most 90 degrees. Rules start equal and gains zero.
+ */
+void fuzzy_init(FuzzyTS *fuzzy, int rules, int states, int outputs, fx_angle range);
+
+/*
+ * The two rule split of the MATLAB model: rule 0 the bump about zero
+ * (1 - s(k (z - edge))) s(k (z + edge)), rule 1 the rest, slope k per
+ * radian in Q16. Needs two rules.
+ */
+void fuzzy_sigmoid_pair(FuzzyTS *fuzzy, q16_t slope, fx_angle edge);
+
+// Rule's gains, outputs rows of states values, Q12
+void fuzzy_set_gain(FuzzyTS *fuzzy, int rule, const short *gain);
+
+// Firing strengths at premise, rules values summing to 32768
+void fuzzy_weights(const FuzzyTS *fuzzy, fx_angle premise, unsigned short *weight);
+
+// u = -sum h_r K_r x with the rules weighted at premise
+void fuzzy_control(const FuzzyTS *fuzzy, fx_angle premise, const int *state, int *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,994 @@
+/*=============================================================================
+ * Gait engine of the biped, see GaitEngine.h
+ *===========================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "GaitEngine.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+#define TIME_STEP 106           // between gait keyframes in ms
+#define BLEND_TIME 500          // default mode change cross-fade in ms
+#define CPG_COUPLING 1000       // pull between the leg oscillators in mHz
+#define CPG_RAMP 1000           // speed and step size lag in ms
+#define CPG_CONTACT_GAIN 16384  // part of the phase error a foot contact corrects, Q15
+#define CPG_PITCH_GAIN 4096     // phase advance per frame per fx_angle of forward pitch
+#define IMU_FILTER_TIME 500     // gyro to accelerometer crossover time constant in ms
+#define BALANCE_LIMIT FX_DEG(10)    // largest balance correction of a joint
+#define BALANCE_SLEW FX_DEG(1)      // largest PD balance correction change per frame
+#define BALANCE_LATENCY 40      // frame wait, SSC-32 frame and servo response in ms
+#define SERVO_HOLD_CURRENT 80   // servo draw standing still and unloaded in mA
+#define SERVO_MOVE_CURRENT 900  // servo draw over holding at full speed in mA
+#define SERVO_FULL_SPEED (375L * 65536 / 360)   // 60 degrees in 0.16 s, in fx_angle per second
+#define CURRENT_BUDGET 10000    // servo supply draw a frame may be predicted to take in mA, 0 for no limit
+
+// Software joint limits for the IK solver in degrees. Nominal values, set
+// them from the tested servo ranges.
+#define JOINT_MIN_HIP1      -45
+#define JOINT_MAX_HIP1      45
+#define JOINT_MIN_HIP2      -30
+#define JOINT_MAX_HIP2      30
+#define JOINT_MIN_HIP3      -90
+#define JOINT_MAX_HIP3      90
+#define JOINT_MIN_KNEE      0
+#define JOINT_MAX_KNEE      90
+#define JOINT_MIN_ANKLE1    -45
+#define JOINT_MAX_ANKLE1    45
+#define JOINT_MIN_ANKLE2    -30
+#define JOINT_MAX_ANKLE2    30
+
+#define JOINT_LIMITS(bound) { \
+    FX_DEG(JOINT_##bound##_HIP1), FX_DEG(JOINT_##bound##_HIP2), FX_DEG(JOINT_##bound##_HIP3), \
+    FX_DEG(JOINT_##bound##_KNEE), FX_DEG(JOINT_##bound##_ANKLE1), FX_DEG(JOINT_##bound##_ANKLE2) }
+
+// Link lengths and joint limits, in JointType order. Nominal values, set
+// them from the built legs.
+static const LegParams legParams[NUM_LEGS] = {
+    { LEGIK_MM(100), LEGIK_MM(100), LEGIK_MM(40), JOINT_LIMITS(MIN), JOINT_LIMITS(MAX) },
+    { LEGIK_MM(100), LEGIK_MM(100), LEGIK_MM(40), JOINT_LIMITS(MIN), JOINT_LIMITS(MAX) }
+};
+
+/* Every joint limit must fit its servo's pulse range in ENGINE_SERVO_TABLE
+ * at the nominal 1000 us per quarter turn. Otherwise the IK accepts poses
+ * that ServoCal then clamps, and the foot is not where the planner put it.
+ * A servo outside its range fails to compile here.
+ */
+#define JOINT_PULSE(neutral, dir, degrees) ((neutral) + (dir) * (degrees) * 1000 / 90)
+#define JOINT_FITS(neutral, minPulse, maxPulse, dir, degrees) \
+    (JOINT_PULSE(neutral, dir, degrees) >= (minPulse) && JOINT_PULSE(neutral, dir, degrees) <= (maxPulse))
+#define CHECK_JOINT_LIMITS(name, channel, joint, neutral, minPulse, maxPulse, dir, source) \
+    typedef char name##_limits_fit_pulses[ \
+        JOINT_FITS(neutral, minPulse, maxPulse, dir, JOINT_MIN_##joint) && \
+        JOINT_FITS(neutral, minPulse, maxPulse, dir, JOINT_MAX_##joint) ? 1 : -1];
+ENGINE_SERVO_TABLE(CHECK_JOINT_LIMITS)
+
+// Walking gait at start up, edit it with the "gait" command
+static const GaitParams defaultGait = {
+    LEGIK_MM(40),   // step length
+    LEGIK_MM(20),   // step height
+    LEGIK_MM(10),   // stance width, outward from each hip
+    LEGIK_MM(220),  // hip above the sole
+    20,             // time steps per cycle
+    FX_Q15(0.4),    // swing part of the cycle
+    SWING_CYCLOID
+};
+
+/* The fuzzy balance's premise is the fused pitch, split like
+ * matlab/fuzzyPendulumnTest.m into a rule near upright and one for large
+ * tilts; its sigmoids are narrowed from +-30 to +-10 degrees for a walking
+ * robot. Gain rows are HIP3 and ANKLE1, columns the pitch and its rate per
+ * second, Q12. Edit them with "fuzzygain".
+ */
+static const short BALANCE_UPRIGHT_GAIN[4] = { 1024, 41, 2048, 102 };
+static const short BALANCE_TILTED_GAIN[4] = { 2458, 82, 4096, 205 };
+
+static void changeMode(GaitEngine *e, int mode);
+
+static int clamp(int x, int low, int high)
+{
+    return x < low ? low : x > high ? high : x;
+}
+
+static void print(const GaitEngine *e, const char *line)
+{
+    e->config->print(line);
+}
+
+// Angle in degrees for a reply
+static int toDegrees(int angle)
+{
+    return angle * 90 / 16384;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Gait sets                                                                  */
+
+// Gait cycle rate in mHz, the planner period is in keyframes TIME_STEP apart
+static int gaitFrequency(const GaitEngine *e)
+{
+    return 1000000 / (e->planner.params.period * TIME_STEP);
+}
+
+// Hands the active gait set to the planner, the CPG and the table player
+static void applyGaitSet(GaitEngine *e)
+{
+    const GaitSet *set = gaitbank_active(&e->gaits);
+
+    e->planner.params.stepLength = set->stepLength;
+    e->planner.params.stepHeight = set->stepHeight;
+    e->planner.params.stanceWidth = set->stanceWidth;
+    e->planner.params.standHeight = set->standHeight;
+    e->planner.params.period = set->period;
+    e->planner.params.swingFraction = set->swingFraction;
+    e->planner.params.swingShape = set->swingShape;
+    cpg_couple(&e->cpg, RIGHT_LEG, LEFT_LEG, set->coupling, set->couplingOffset);
+    gaittable_set_period(&e->player, set->tablePeriodMs, ENGINE_FRAME_MS);
+}
+
+// The start up gait set, from defaultGait and the compiled gait table
+static void gaitSetDefaults(GaitEngine *e)
+{
+    GaitSet set;
+
+    set.version = GAITSET_VERSION;
+    set.swingShape = defaultGait.swingShape;
+    set.stepLength = defaultGait.stepLength;
+    set.stepHeight = defaultGait.stepHeight;
+    set.stanceWidth = defaultGait.stanceWidth;
+    set.standHeight = defaultGait.standHeight;
+    set.period = defaultGait.period;
+    set.swingFraction = defaultGait.swingFraction;
+    set.coupling = CPG_COUPLING;
+    set.couplingOffset = 0x8000;
+    set.tablePeriodMs = e->config->table->periodMs;
+    gaitbank_init(&e->gaits, &set);
+    applyGaitSet(e);
+}
+
+// Commits a set changed on the robot, swapped in at the end of the cycle.
+// A bad edit is refused before it reaches pending, which may hold a set
+// already staged.
+static void stageGaitSet(GaitEngine *e, const GaitSet *set)
+{
+    if (!gaitset_valid(set)) {
+        print(e, "gait set rejected");
+        return;
+    }
+    gaitbank_write(&e->gaits, 0, set, sizeof(GaitSet));
+    if (!gaitbank_commit(&e->gaits, gaitset_crc(set)))
+        print(e, "gait set rejected");
+}
+
+/* True where a gait cycle ends in the gait modes, when the cycle phase
+ * wraps, and on every frame in the others
+ */
+static int cycleBoundary(GaitEngine *e)
+{
+    unsigned int phase;
+    int wrapped;
+
+    if (e->mode == WALK_MODE)
+        phase = (unsigned int)e->planner.phase << 16;
+    else if (e->mode == CPG_MODE)
+        phase = e->cpg.phase[RIGHT_LEG];
+    else if (e->mode == TABLE_MODE)
+        phase = e->player.phase;
+    else {
+        e->lastPhase = 0;
+        return 1;
+    }
+    // only a forward step past 2^32, the CPG's corrections may step its
+    // phase back within a cycle
+    wrapped = phase - e->lastPhase < 0x80000000u && phase < e->lastPhase;
+    e->lastPhase = phase;
+    return wrapped;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Modes                                                                      */
+
+/* Asks for a new operating mode. Walking first finishes its step and stops
+ * with both feet down, see walkingMode(), CPG walking first shrinks its
+ * steps to nothing, other modes leave at once.
+ */
+static void requestMode(GaitEngine *e, int mode)
+{
+    e->requestedMode = mode;
+    if (e->mode == CPG_MODE) {
+        cpg_set_amplitude(&e->cpg, RIGHT_LEG, mode == CPG_MODE ? 32768 : 0);
+        cpg_set_amplitude(&e->cpg, LEFT_LEG, mode == CPG_MODE ? 32768 : 0);
+    }
+    else if (e->mode != WALK_MODE)
+        changeMode(e, mode);
+}
+
+/* Starts the gait at phase 0 with the interpolator at rest at the pose
+ * being sent, so the first step begins from where the legs are
+ */
+static void startWalking(GaitEngine *e)
+{
+    planner_init(&e->planner, &e->planner.params);
+    interp_init(&e->motion, NUM_LEG_SERVOS, INTERP_MIN_JERK, ENGINE_FRAME_MS, e->blend.last);
+    e->walkStopping = 0;
+}
+
+/* Starts the oscillators half a cycle apart with no step size, growing to
+ * full steps over CPG_RAMP
+ */
+static void startCpg(GaitEngine *e)
+{
+    int leg;
+
+    planner_init(&e->planner, &e->planner.params);
+    e->cpg.phase[RIGHT_LEG] = 0;
+    e->cpg.phase[LEFT_LEG] = 0x80000000u;
+    for (leg = 0; leg < NUM_LEGS; leg++) {
+        e->cpg.amplitude[leg] = 0;
+        cpg_set_amplitude(&e->cpg, leg, 32768);
+    }
+    cpg_set_frequency(&e->cpg, gaitFrequency(e));
+}
+
+// Enters a mode, cross-fading from wherever the last one left the servos
+static void changeMode(GaitEngine *e, int mode)
+{
+    if (mode == e->mode)
+        return;
+    TRACE_INSTANT(TRACE_MODE_CHANGE, mode);
+    if (mode == WALK_MODE)
+        startWalking(e);
+    else if (mode == CPG_MODE)
+        startCpg(e);
+    e->mode = mode;
+    blend_start(&e->blend, e->blendTime);
+}
+
+/* Queues the joint angles of both legs at the next gait phase, true when
+ * both feet are on the ground there
+ */
+static int pushGaitKeyframe(GaitEngine *e)
+{
+    int keyframe[NUM_LEG_SERVOS];
+    int grounded = 1;
+    int leg, j;
+
+    for (leg = 0; leg < NUM_LEGS; leg++) {
+        FootPose foot;
+        fx_angle angle[LEGIK_NUM_JOINTS];
+
+        // foot path for this step, then the joints that put the foot there
+        PROF_START(PROF_FOOT_PLAN);
+        TRACE_BEGIN(TRACE_FOOT_PLAN, leg);
+        planner_foot(&e->planner, leg, &foot);
+        TRACE_END(TRACE_FOOT_PLAN, leg);
+        PROF_STOP(PROF_FOOT_PLAN);
+        if (foot.z > -e->planner.params.standHeight)
+            grounded = 0;
+
+        PROF_START(PROF_LEG_IK);
+        legik_solve(&legParams[leg], &foot, angle);
+        PROF_STOP(PROF_LEG_IK);
+
+        for (j = 0; j < LEGIK_NUM_JOINTS; j++)
+            keyframe[leg * LEGIK_NUM_JOINTS + j] = (short)angle[j];
+    }
+    planner_tick(&e->planner);
+    interp_push(&e->motion, keyframe, TIME_STEP);
+    return grounded;
+}
+
+/* Walking joint angles for this frame, interpolated from gait keyframes
+ * TIME_STEP apart. Two keyframes are kept queued so the interpolator can
+ * pass through each one without stopping.
+ *
+ * When another mode is asked for, keyframes are queued until one has both
+ * feet on the ground, in double support or at a lift off, and the motion
+ * comes to rest there instead of dropping a foot mid-swing.
+ */
+static void walkingMode(GaitEngine *e, int *angle)
+{
+    int i;
+
+    while (!e->walkStopping && interp_queued(&e->motion) < 2)
+        e->walkStopping = pushGaitKeyframe(e) && e->requestedMode != WALK_MODE;
+
+    PROF_START(PROF_INTERP);
+    interp_tick(&e->motion, angle);
+    PROF_STOP(PROF_INTERP);
+
+    for (i = 0; i < NUM_LEG_SERVOS; i++) {
+        // the curve can overshoot between keyframes, keep it in the limits
+        const LegParams *params = &legParams[i / LEGIK_NUM_JOINTS];
+        int j = i % LEGIK_NUM_JOINTS;
+        angle[i] = clamp(angle[i], params->minAngle[j], params->maxAngle[j]);
+    }
+}
+
+/* Gait table joint angles for this frame, the legs half a cycle apart. The
+ * table holds nominal pulses about 1500, they are turned back into angles
+ * so the calibration applies as for any gait.
+ */
+static void tableMode(GaitEngine *e, int *angle)
+{
+    unsigned short pulse[NUM_LEG_SERVOS];
+    int i;
+
+    gaittable_sample(&e->player, 0, &pulse[RIGHT_LEG * LEGIK_NUM_JOINTS]);
+    gaittable_sample(&e->player, 0x80000000u, &pulse[LEFT_LEG * LEGIK_NUM_JOINTS]);
+    gaittable_tick(&e->player);
+    for (i = 0; i < NUM_LEG_SERVOS; i++)
+        angle[i] = ((int)pulse[i] - 1500) * 16384 / 1000;
+}
+
+/* A foot has touched the ground, pulls its oscillator toward the phase the
+ * planner puts touch down at. A foot landing early on a rise advances the
+ * gait, one landing late holds it back, and the coupling takes the other
+ * leg along.
+ */
+static void cpgContact(GaitEngine *e, int leg)
+{
+    unsigned int touchDown = (unsigned int)e->planner.params.swingFraction << 17;
+
+    cpg_correct(&e->cpg, leg, touchDown, CPG_CONTACT_GAIN);
+}
+
+/* With balance on, a forward lean advances both oscillators and a
+ * backward one holds them back, so the next step comes sooner under a body
+ * falling forward. The lean taken is held within the balance limit, well
+ * short of stopping or reversing the gait.
+ */
+static void cpgPitch(GaitEngine *e)
+{
+    int pitch = clamp((short)imu_pitch(&e->imu), -BALANCE_LIMIT, BALANCE_LIMIT);
+    int advance = pitch * CPG_PITCH_GAIN;
+    int leg;
+
+    for (leg = 0; leg < NUM_LEGS; leg++)
+        cpg_correct(&e->cpg, leg, e->cpg.phase[leg] + advance, 32768);
+}
+
+/* CPG walking joint angles for this frame. Each leg's foot follows the
+ * planner's path at its oscillator's phase, scaled by its amplitude, and
+ * goes through the IK every frame, so a phase change from a sensor shows
+ * at once rather than after the queued keyframes.
+ */
+static void cpgMode(GaitEngine *e, int *angle)
+{
+    int standHeight = e->planner.params.standHeight;
+    int leg, j;
+
+    cpg_set_frequency(&e->cpg, gaitFrequency(e));
+    cpg_tick(&e->cpg, ENGINE_FRAME_MS);
+    if (e->balanceMode != BALANCE_OFF)
+        cpgPitch(e);
+
+    for (leg = 0; leg < NUM_LEGS; leg++) {
+        FootPose foot;
+        fx_angle legAngle[LEGIK_NUM_JOINTS];
+        int amplitude = e->cpg.amplitude[leg];
+
+        PROF_START(PROF_FOOT_PLAN);
+        TRACE_BEGIN(TRACE_FOOT_PLAN, leg);
+        planner_foot_at(&e->planner, leg, cpg_phase(&e->cpg, leg), &foot);
+        foot.x = (foot.x * amplitude) >> 15;
+        foot.z = -standHeight + (((foot.z + standHeight) * amplitude) >> 15);
+        TRACE_END(TRACE_FOOT_PLAN, leg);
+        PROF_STOP(PROF_FOOT_PLAN);
+
+        PROF_START(PROF_LEG_IK);
+        legik_solve(&legParams[leg], &foot, legAngle);
+        PROF_STOP(PROF_LEG_IK);
+
+        for (j = 0; j < LEGIK_NUM_JOINTS; j++)
+            angle[leg * LEGIK_NUM_JOINTS + j] = (short)legAngle[j];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Balance                                                                    */
+
+/* T-S fuzzy correction of pitch on the hips and ankles, both legs alike,
+ * with the fused pitch as the premise and pitch and its rate as the state
+ */
+static void fuzzyBalance(GaitEngine *e)
+{
+    fx_angle pitch = imu_pitch(&e->imu);
+    int state[2];
+    int u[2];
+    int leg;
+
+    state[0] = (short)pitch;
+    state[1] = clamp(e->imu.pitchRate, -32767, 32767);
+    fuzzy_control(&e->fuzzy, pitch, state, u);
+    for (leg = 0; leg < NUM_LEGS; leg++) {
+        e->balanceOffset[leg * LEGIK_NUM_JOINTS + HIP3] = clamp(u[0], -BALANCE_LIMIT, BALANCE_LIMIT);
+        e->balanceOffset[leg * LEGIK_NUM_JOINTS + ANKLE1] = clamp(u[1], -BALANCE_LIMIT, BALANCE_LIMIT);
+    }
+}
+
+/* PD correction for this frame, pitch on the hips and ankles and roll on
+ * the ankles, both legs alike. The attitude is predicted over the sample's
+ * age and the latency to the servos, a few multiplies per joint.
+ */
+static void pdBalance(GaitEngine *e, unsigned int imuAgeUs)
+{
+    unsigned int ahead = imuAgeUs + e->balanceLatency * 1000u;
+    fx_angle pitch = balance_predict(imu_pitch(&e->imu), e->imu.pitchRate, ahead);
+    fx_angle roll = balance_predict(imu_roll(&e->imu), e->imu.rollRate, ahead);
+    int hip = balance_update(&e->pdHip, pitch, e->imu.pitchRate);
+    int ankle = balance_update(&e->pdAnkle, pitch, e->imu.pitchRate);
+    int ankleRoll = balance_update(&e->pdRoll, roll, e->imu.rollRate);
+    int leg;
+
+    for (leg = 0; leg < NUM_LEGS; leg++) {
+        e->balanceOffset[leg * LEGIK_NUM_JOINTS + HIP3] = hip;
+        e->balanceOffset[leg * LEGIK_NUM_JOINTS + ANKLE1] = ankle;
+        e->balanceOffset[leg * LEGIK_NUM_JOINTS + ANKLE2] = ankleRoll;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void engine_init(GaitEngine *e, const EngineConfig *config)
+{
+    int i;
+
+    e->config = config;
+    e->mode = DIRECT_MODE;
+    e->requestedMode = DIRECT_MODE;
+    e->walkStopping = 0;
+    e->lastPhase = 0;
+    e->frames = 0;
+    memset(e->directAngle, 0, sizeof(e->directAngle));
+    e->blendTime = BLEND_TIME;
+
+    config->calDefaults(&e->cal);
+    servocal_load(&e->cal);
+    servocal_reset(&e->cal);
+
+    blend_init(&e->blend, config->servos, ENGINE_FRAME_MS, e->directAngle);
+    planner_init(&e->planner, &defaultGait);
+    cpg_init(&e->cpg, NUM_LEGS, gaitFrequency(e), CPG_RAMP);
+    gaittable_init(&e->player, config->table, ENGINE_FRAME_MS);
+    gaitSetDefaults(e);
+
+    imu_init(&e->imu, config->gyroRange, IMU_FILTER_TIME);
+    e->imuReady = 1;
+    e->zeroCount = 0;
+
+    e->balanceMode = BALANCE_OFF;
+    memset(e->balanceOffset, 0, sizeof(e->balanceOffset));
+    fuzzy_init(&e->fuzzy, 2, 2, 2, FX_DEG(45));
+    fuzzy_sigmoid_pair(&e->fuzzy, FX_Q16(21.0), FX_DEG(10));
+    fuzzy_set_gain(&e->fuzzy, 0, BALANCE_UPRIGHT_GAIN);
+    fuzzy_set_gain(&e->fuzzy, 1, BALANCE_TILTED_GAIN);
+    balance_init(&e->pdHip, 1024, 41, BALANCE_LIMIT, BALANCE_SLEW);
+    balance_init(&e->pdAnkle, 2048, 102, BALANCE_LIMIT, BALANCE_SLEW);
+    balance_init(&e->pdRoll, 2048, 102, BALANCE_LIMIT, BALANCE_SLEW);
+    e->balanceLatency = BALANCE_LATENCY;
+
+    cbudget_init(&e->budget, NUM_LEG_SERVOS, NUM_LEGS, ENGINE_FRAME_MS, CURRENT_BUDGET, CBUDGET_STRETCH);
+    for (i = 0; i < NUM_LEG_SERVOS; i++)
+        cbudget_set_joint(&e->budget, i, SERVO_HOLD_CURRENT, SERVO_MOVE_CURRENT, SERVO_FULL_SPEED,
+                          i / LEGIK_NUM_JOINTS);
+    e->measuredMa = -1;
+}
+
+int engine_frame(GaitEngine *e, unsigned int imuAgeUs, const int *measuredMa, unsigned short *pulse)
+{
+    int angle[ENGINE_MAX_SERVOS];
+    int i;
+
+    if (cycleBoundary(e) && gaitbank_boundary(&e->gaits))
+        applyGaitSet(e);
+    if (e->mode == DIRECT_MODE && !blend_active(&e->blend) && e->balanceMode == BALANCE_OFF)
+        return 0;
+
+    PROF_START(PROF_WALKING_MODE);
+    TRACE_BEGIN(TRACE_CONTROL_TICK, e->frames);
+    memset(angle, 0, sizeof(angle));
+    if (e->mode == WALK_MODE)
+        walkingMode(e, angle);
+    else if (e->mode == TABLE_MODE)
+        tableMode(e, angle);
+    else if (e->mode == CPG_MODE)
+        cpgMode(e, angle);
+    else if (e->mode == DIRECT_MODE)
+        memcpy(angle, e->directAngle, sizeof(angle));
+    if (e->balanceMode == BALANCE_PD) {
+        PROF_START(PROF_BALANCE);
+        pdBalance(e, imuAgeUs);
+        PROF_STOP(PROF_BALANCE);
+    }
+    if (e->balanceMode != BALANCE_OFF)
+        for (i = 0; i < NUM_LEG_SERVOS; i++)
+            angle[i] += e->balanceOffset[i];
+    blend_tick(&e->blend, angle);
+    TRACE_END(TRACE_CONTROL_TICK, 0);
+    PROF_STOP(PROF_WALKING_MODE);
+
+    // the leg currents of the last frame correct the model
+    if (measuredMa) {
+        cbudget_measure(&e->budget, measuredMa);
+        e->measuredMa = measuredMa[RIGHT_LEG] + measuredMa[LEFT_LEG];
+    }
+    cbudget_schedule(&e->budget, angle, angle);
+    servocal_apply(&e->cal, angle, ENGINE_FRAME_MS, pulse);
+    e->frames++;
+
+    // the walk has come to rest with both feet down, hand over
+    if (e->walkStopping && !interp_busy(&e->motion)) {
+        e->walkStopping = 0;
+        changeMode(e, e->requestedMode);
+    }
+    // or the CPG steps have shrunk to standing in place
+    if (e->mode == CPG_MODE && e->requestedMode != CPG_MODE
+            && e->cpg.amplitude[RIGHT_LEG] == 0 && e->cpg.amplitude[LEFT_LEG] == 0)
+        changeMode(e, e->requestedMode);
+    return 1;
+}
+
+void engine_imu_update(GaitEngine *e, const short accel[3], const short gyro[3], unsigned int dtUs)
+{
+    int i;
+
+    PROF_START(PROF_IMU_FUSION);
+    imu_update(&e->imu, accel, gyro, dtUs);
+    PROF_STOP(PROF_IMU_FUSION);
+
+    if (e->zeroCount) {
+        for (i = 0; i < 3; i++)
+            e->zeroSum[i] += gyro[i];
+        if (--e->zeroCount == 0) {
+            short bias[3];
+            for (i = 0; i < 3; i++)
+                bias[i] = (short)(e->zeroSum[i] / ENGINE_ZERO_SAMPLES);
+            imu_set_bias(&e->imu, bias);
+        }
+    }
+
+    PROF_START(PROF_BALANCE);
+    if (e->balanceMode == BALANCE_FUZZY)
+        fuzzyBalance(e);
+    PROF_STOP(PROF_BALANCE);
+}
+
+void engine_imu_zero(GaitEngine *e)
+{
+    e->zeroCount = ENGINE_ZERO_SAMPLES;
+    e->zeroSum[0] = e->zeroSum[1] = e->zeroSum[2] = 0;
+}
+
+void engine_servos_moved(GaitEngine *e)
+{
+    cbudget_reset(&e->budget);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Commands                                                                   */
+
+/* Places one foot with the IK solver, "foot <leg> <x> <y> <z>" with leg 0
+ * right or 1 left and the sole position in mm from the hip, foot level
+ */
+static void footCommand(GaitEngine *e, const char *line)
+{
+    int leg, x, y, z, j, status;
+    FootPose foot;
+    fx_angle angle[LEGIK_NUM_JOINTS];
+
+    if (sscanf(line, "foot %d %d %d %d", &leg, &x, &y, &z) != 4 || leg < 0 || leg >= NUM_LEGS) {
+        print(e, "usage: foot <leg> <x> <y> <z>");
+        return;
+    }
+    foot.x = LEGIK_MM(x);
+    foot.y = LEGIK_MM(y);
+    foot.z = LEGIK_MM(z);
+    foot.yaw = 0;
+    foot.pitch = 0;
+    foot.roll = 0;
+
+    PROF_START(PROF_LEG_IK);
+    status = legik_solve(&legParams[leg], &foot, angle);
+    PROF_STOP(PROF_LEG_IK);
+    if (status & LEGIK_UNREACHABLE)
+        print(e, "foot out of reach");
+    if (status & LEGIK_LIMITED)
+        print(e, "joint limit reached");
+
+    // the other leg keeps the pose from its last foot command, the move
+    // is blended over TIME_STEP or the mode change into direct control
+    for (j = 0; j < LEGIK_NUM_JOINTS; j++)
+        e->directAngle[leg * LEGIK_NUM_JOINTS + j] = (short)angle[j];
+    if (e->mode == DIRECT_MODE)
+        blend_start(&e->blend, TIME_STEP);
+    else
+        requestMode(e, DIRECT_MODE);
+}
+
+/* Changes the walking gait, "gait <length> <height> <period>" in mm and
+ * time steps, from the end of the gait cycle
+ */
+static void gaitCommand(GaitEngine *e, const char *line)
+{
+    int length, height, period;
+    GaitSet set;
+
+    // checked before they are narrowed to the set's fields
+    if (sscanf(line, "gait %d %d %d", &length, &height, &period) != 3
+        || length < 0 || length > GAITSET_MAX_STEP_LENGTH / LEGIK_MM(1)
+        || height < 0 || height > GAITSET_MAX_STEP_HEIGHT / LEGIK_MM(1)
+        || period <= 0 || period > GAITSET_MAX_PERIOD) {
+        print(e, "usage: gait <length> <height> <period>, at most 100 mm, 100 mm and 200 steps");
+        return;
+    }
+    set = *gaitbank_latest(&e->gaits);
+    set.stepLength = LEGIK_MM(length);
+    set.stepHeight = LEGIK_MM(height);
+    set.period = period;
+    stageGaitSet(e, &set);
+}
+
+/* Changes the gait table cycle time, "period <ms>", the legs carry on from
+ * the same point in the cycle
+ */
+static void periodCommand(GaitEngine *e, const char *line)
+{
+    int period;
+    GaitSet set;
+
+    if (sscanf(line, "period %d", &period) != 1 || period <= 0 || period > 0xFFFF) {
+        print(e, "usage: period <ms>");
+        return;
+    }
+    set = *gaitbank_latest(&e->gaits);
+    set.tablePeriodMs = period;
+    stageGaitSet(e, &set);
+}
+
+/* Sets the leg oscillator coupling, "couple <strength> <offset>" with the
+ * strength in mHz and the left leg's lead over the right in degrees
+ */
+static void coupleCommand(GaitEngine *e, const char *line)
+{
+    int strength, offset;
+    GaitSet set;
+
+    if (sscanf(line, "couple %d %d", &strength, &offset) != 2 || strength < 0 || strength > CPG_MAX_FREQUENCY) {
+        print(e, "usage: couple <strength> <offset>");
+        return;
+    }
+    set = *gaitbank_latest(&e->gaits);
+    set.coupling = strength;
+    set.couplingOffset = (fx_angle)(offset * 65536 / 360);
+    stageGaitSet(e, &set);
+}
+
+// Reports a foot contact by hand, "contact <leg>", until there are foot switches
+static void contactCommand(GaitEngine *e, const char *line)
+{
+    int leg;
+
+    if (sscanf(line, "contact %d", &leg) != 1 || leg < 0 || leg >= NUM_LEGS) {
+        print(e, "usage: contact <leg>");
+        return;
+    }
+    cpgContact(e, leg);
+}
+
+/* Writes part of the pending gait set, "gpend <offset> <hex>" with the
+ * offset in bytes and the data as hex pairs, see PCprojects/gaitup
+ */
+static void pendCommand(GaitEngine *e, const char *line)
+{
+    unsigned char data[sizeof(GaitSet)];
+    unsigned int offset, length = 0, byte;
+    int start;
+    const char *p;
+
+    if (sscanf(line, "gpend %u %n", &offset, &start) != 1) {
+        print(e, "usage: gpend <offset> <hex>");
+        return;
+    }
+    for (p = line + start; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1])
+            && length < sizeof(data); p += 2) {
+        sscanf(p, "%2x", &byte);
+        data[length++] = (unsigned char)byte;
+    }
+    if (!gaitbank_write(&e->gaits, offset, data, length))
+        print(e, "gait set overrun");
+}
+
+// Checks and accepts the pending gait set, "gcommit <crc>" in hex
+static void commitCommand(GaitEngine *e, const char *line)
+{
+    unsigned int crc;
+
+    if (sscanf(line, "gcommit %x", &crc) != 1) {
+        print(e, "usage: gcommit <crc>");
+        return;
+    }
+    print(e, gaitbank_commit(&e->gaits, (unsigned short)crc) ? "gait set accepted" : "gait set rejected");
+}
+
+// Prints the active gait set, "gset <hex> <crc>"
+static void printGaitSet(GaitEngine *e)
+{
+    const GaitSet *set = gaitbank_active(&e->gaits);
+    const unsigned char *bytes = (const unsigned char *)set;
+    char text[16 + 2 * sizeof(GaitSet)];
+    char *p = text + sprintf(text, "gset ");
+    unsigned int i;
+
+    for (i = 0; i < sizeof(GaitSet); i++)
+        p += sprintf(p, "%02x", bytes[i]);
+    sprintf(p, " %04x", gaitset_crc(set));
+    print(e, text);
+}
+
+// Sets the mode change cross-fade time, "blend <ms>"
+static void blendCommand(GaitEngine *e, const char *line)
+{
+    int time;
+
+    if (sscanf(line, "blend %d", &time) != 1 || time < 0 || time > BLEND_MAX_TIME) {
+        print(e, "usage: blend <ms>");
+        return;
+    }
+    e->blendTime = time;
+}
+
+static void printCalibration(GaitEngine *e)
+{
+    char line[96];
+    int i;
+
+    print(e, "servo channel neutral offset gain dir min max slew");
+    for (i = 0; i < e->config->servos; i++) {
+        sprintf(line, "%2d %2d %4d %4d %4d %2d %4d %4d %5u", i, e->config->channel[i], e->cal.neutral[i],
+                e->cal.offset[i], e->cal.gain[i], e->cal.dir[i], e->cal.minPulse[i],
+                e->cal.maxPulse[i], e->cal.slew[i]);
+        print(e, line);
+    }
+}
+
+/* Sets one servo's calibration,
+ * "cal <servo> <offset> <gain> <dir> <min> <max> <slew>" with the servo
+ * index from the servo table, pulses in us, gain in us per 90 degrees and
+ * slew in us per second. Takes effect on the next frame, "calsave" keeps it.
+ */
+static void calCommand(GaitEngine *e, const char *line)
+{
+    int i, offset, gain, dir, minPulse, maxPulse, slew;
+
+    if (sscanf(line, "cal %d %d %d %d %d %d %d", &i, &offset, &gain, &dir, &minPulse, &maxPulse, &slew) != 7
+            || i < 0 || i >= e->config->servos) {
+        print(e, "usage: cal <servo> <offset> <gain> <dir> <min> <max> <slew>");
+        return;
+    }
+    dir = dir < 0 ? -1 : 1;
+    if (!servocal_valid(offset, gain, dir, minPulse, maxPulse, slew)) {
+        print(e, "cal: out of range, offset +-500, gain 0..4000, 500 <= min <= max <= 2500, slew 0..65535");
+        return;
+    }
+    e->cal.offset[i] = offset;
+    e->cal.gain[i] = gain;
+    e->cal.dir[i] = dir;
+    e->cal.minPulse[i] = minPulse;
+    e->cal.maxPulse[i] = maxPulse;
+    e->cal.slew[i] = slew;
+    servocal_update(&e->cal);
+    printCalibration(e);
+}
+
+/* Switches the balance correction, "balance <off|fuzzy|pd>", cross-fading in
+ * or out over the blend time
+ */
+static void balanceCommand(GaitEngine *e, const char *line)
+{
+    int mode;
+
+    if (strcmp(line, "balance off") == 0)
+        mode = BALANCE_OFF;
+    else if (strcmp(line, "balance fuzzy") == 0)
+        mode = BALANCE_FUZZY;
+    else if (strcmp(line, "balance pd") == 0)
+        mode = BALANCE_PD;
+    else {
+        print(e, "usage: balance <off|fuzzy|pd>");
+        return;
+    }
+    if (mode != BALANCE_OFF && !e->imuReady) {
+        print(e, "no IMU");
+        return;
+    }
+    e->balanceMode = mode;
+    memset(e->balanceOffset, 0, sizeof(e->balanceOffset));
+    balance_reset(&e->pdHip);
+    balance_reset(&e->pdAnkle);
+    balance_reset(&e->pdRoll);
+    blend_start(&e->blend, e->blendTime);
+}
+
+/* Sets one fuzzy rule's balance gains, Q12,
+ * "fuzzygain <rule> <hip p> <hip d> <ankle p> <ankle d>" with rule 0 near
+ * upright and 1 for large tilts, the d gains in seconds
+ */
+static void fuzzyGainCommand(GaitEngine *e, const char *line)
+{
+    int rule, value[4], i;
+    short gain[4];
+
+    if (sscanf(line, "fuzzygain %d %d %d %d %d", &rule, &value[0], &value[1], &value[2], &value[3]) != 5
+            || rule < 0 || rule > 1) {
+        print(e, "usage: fuzzygain <rule> <hip p> <hip d> <ankle p> <ankle d>");
+        return;
+    }
+    for (i = 0; i < 4; i++)
+        gain[i] = (short)clamp(value[i], -32767, 32767);
+    fuzzy_set_gain(&e->fuzzy, rule, gain);
+}
+
+/* Sets the PD balance gains, Q12,
+ * "pdgain <hip p> <hip d> <ankle p> <ankle d> <roll p> <roll d>", the d
+ * gains in seconds
+ */
+static void pdGainCommand(GaitEngine *e, const char *line)
+{
+    int v[6];
+
+    if (sscanf(line, "pdgain %d %d %d %d %d %d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) {
+        print(e, "usage: pdgain <hip p> <hip d> <ankle p> <ankle d> <roll p> <roll d>");
+        return;
+    }
+    balance_set_gain(&e->pdHip, v[0], v[1]);
+    balance_set_gain(&e->pdAnkle, v[2], v[3]);
+    balance_set_gain(&e->pdRoll, v[4], v[5]);
+}
+
+/* Sets the PD balance saturation of every joint,
+ * "pdlimit <deg> <deg per second>"
+ */
+static void pdLimitCommand(GaitEngine *e, const char *line)
+{
+    int limit, rate;
+    fx_angle slew;
+
+    if (sscanf(line, "pdlimit %d %d", &limit, &rate) != 2 || limit < 0 || limit > 45
+            || rate < 1 || rate > 1000) {
+        print(e, "usage: pdlimit <deg> <deg per second>");
+        return;
+    }
+    slew = (fx_angle)(rate * ENGINE_FRAME_MS * 16384 / 90000);
+    balance_set_limit(&e->pdHip, FX_DEG(limit), slew);
+    balance_set_limit(&e->pdAnkle, FX_DEG(limit), slew);
+    balance_set_limit(&e->pdRoll, FX_DEG(limit), slew);
+}
+
+// Sets how far ahead the PD balance predicts the attitude, "pdlatency <ms>"
+static void pdLatencyCommand(GaitEngine *e, const char *line)
+{
+    int latency;
+
+    if (sscanf(line, "pdlatency %d", &latency) != 1 || latency < 0
+            || latency > BALANCE_MAX_LATENCY_US / 1000) {
+        print(e, "usage: pdlatency <ms>");
+        return;
+    }
+    e->balanceLatency = latency;
+}
+
+// Sets the servo current budget, "budget <mA> [stretch|stagger]", 0 for no limit.
+// The way over budget frames are cut stays as it was unless given.
+static void budgetCommand(GaitEngine *e, const char *line)
+{
+    char how[16];
+    int budget;
+
+    strcpy(how, e->budget.mode == CBUDGET_STAGGER ? "stagger" : "stretch");
+    if (sscanf(line, "budget %d %15s", &budget, how) < 1 || budget < 0
+            || (strcmp(how, "stretch") != 0 && strcmp(how, "stagger") != 0)) {
+        print(e, "usage: budget <mA> [stretch|stagger]");
+        return;
+    }
+    cbudget_set_budget(&e->budget, budget, strcmp(how, "stagger") == 0 ? CBUDGET_STAGGER : CBUDGET_STRETCH);
+}
+
+/* Prints the budget, the last frame's predicted current and, where the legs
+ * are sensed, the measured current and the model's correction per leg, then
+ * the frames held to the budget and how far the servos fell behind the gait
+ * since the last time
+ */
+static void printBudget(GaitEngine *e)
+{
+    char text[96];
+    char *p = text + sprintf(text, "budget %d mA %s, predicted %d mA", e->budget.budgetMa,
+                             e->budget.mode == CBUDGET_STAGGER ? "stagger" : "stretch", e->budget.predicted);
+
+    if (e->measuredMa >= 0)
+        sprintf(p, ", measured %d mA, correction %d %d mA", e->measuredMa,
+                e->budget.correction[RIGHT_LEG], e->budget.correction[LEFT_LEG]);
+    print(e, text);
+    sprintf(text, "%u frames limited, lag max %d deg", cbudget_take_limited(&e->budget),
+            toDegrees(cbudget_take_lag(&e->budget)));
+    print(e, text);
+}
+
+// Prints the fused attitude, "imu <pitch> <roll> <pitch rate> <roll rate>" in degrees
+static void printImu(GaitEngine *e)
+{
+    char text[64];
+
+    sprintf(text, "imu %d %d %d %d", toDegrees((short)imu_pitch(&e->imu)), toDegrees((short)imu_roll(&e->imu)),
+            toDegrees(e->imu.pitchRate), toDegrees(e->imu.rollRate));
+    print(e, text);
+}
+
+int engine_command(GaitEngine *e, const char *line)
+{
+    if (strcmp(line, "walk") == 0)
+        requestMode(e, WALK_MODE);
+    else if (strcmp(line, "stand") == 0)
+        requestMode(e, STAND_MODE);
+    else if (strcmp(line, "direct") == 0)
+        requestMode(e, DIRECT_MODE);
+    else if (strcmp(line, "table") == 0)
+        requestMode(e, TABLE_MODE);
+    else if (strcmp(line, "cpg") == 0)
+        requestMode(e, CPG_MODE);
+    else if (strncmp(line, "contact ", 8) == 0)
+        contactCommand(e, line);
+    else if (strncmp(line, "couple ", 7) == 0)
+        coupleCommand(e, line);
+    else if (strncmp(line, "foot ", 5) == 0)
+        footCommand(e, line);
+    else if (strncmp(line, "gait ", 5) == 0)
+        gaitCommand(e, line);
+    else if (strncmp(line, "period ", 7) == 0)
+        periodCommand(e, line);
+    else if (strncmp(line, "blend ", 6) == 0)
+        blendCommand(e, line);
+    else if (strncmp(line, "gpend ", 6) == 0)
+        pendCommand(e, line);
+    else if (strncmp(line, "gcommit ", 8) == 0)
+        commitCommand(e, line);
+    else if (strcmp(line, "grollback") == 0)
+        print(e, gaitbank_rollback(&e->gaits) ? "rollback at the next cycle" : "no earlier gait set");
+    else if (strcmp(line, "gget") == 0)
+        printGaitSet(e);
+    else if (strcmp(line, "cal") == 0)
+        printCalibration(e);
+    else if (strncmp(line, "cal ", 4) == 0)
+        calCommand(e, line);
+    else if (strcmp(line, "calsave") == 0)
+        print(e, servocal_save(&e->cal) ? "calibration saved" : "flash write failed");
+    else if (strcmp(line, "calload") == 0)
+        print(e, servocal_load(&e->cal) ? "calibration loaded" : "no calibration in flash");
+    else if (strcmp(line, "caldefault") == 0)
+        e->config->calDefaults(&e->cal);
+    else if (strncmp(line, "balance ", 8) == 0)
+        balanceCommand(e, line);
+    else if (strncmp(line, "fuzzygain ", 10) == 0)
+        fuzzyGainCommand(e, line);
+    else if (strncmp(line, "pdgain ", 7) == 0)
+        pdGainCommand(e, line);
+    else if (strncmp(line, "pdlimit ", 8) == 0)
+        pdLimitCommand(e, line);
+    else if (strncmp(line, "pdlatency ", 10) == 0)
+        pdLatencyCommand(e, line);
+    else if (strcmp(line, "budget") == 0)
+        printBudget(e);
+    else if (strncmp(line, "budget ", 7) == 0)
+        budgetCommand(e, line);
+    else if (strcmp(line, "imu") == 0)
+        printImu(e);
+    else if (strcmp(line, "imuzero") == 0) {
+        if (e->imuReady)
+            engine_imu_zero(e);
+        else
+            print(e, "no IMU");
+    }
+    else
+        return 0;
+    return 1;
+}
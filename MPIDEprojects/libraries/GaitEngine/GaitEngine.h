@@ -0,0 +1,186 @@
+/*=============================================================================
+ * Gait engine of the biped, shared by the LegController sketch and the
+ * RobotController firmware
+ *
+ * Everything between a command line from the PC and the servo pulses of a
+ * frame: the operating modes and the hand over between them, the foot
+ * planner and IK, the keyframe interpolator, the gait table, the leg
+ * oscillators, the gait sets from the PC, the mode change cross-fade, the
+ * fuzzy and PD balance, the current budget and the calibration. The
+ * platform keeps what differs between the boards:
+ *
+ *     - reading the PC's lines and printing the replies, through print()
+ *     - reading the IMU every few ms, passed in with engine_imu_update()
+ *     - the frame clock, calling engine_frame() every ENGINE_FRAME_MS and
+ *       sending the pulses it returns to the SSC-32
+ *     - lines engine_command() does not take, which go to the SSC-32 as
+ *       they are, followed by engine_servos_moved()
+ *     - the servo table, see ENGINE_SERVO_TABLE
+ *
+ * Servos are the legs first, NUM_LEGS * LEGIK_NUM_JOINTS of them in
+ * JointType order for the right then the left leg, then any others, which
+ * stay at their calibrated neutral.
+ *===========================================================================*/
+#ifndef __GAIT_ENGINE_H__
+#define __GAIT_ENGINE_H__
+
+#include "FixMath.h"
+#include "LegIK.h"
+#include "FootPlanner.h"
+#include "Interpolator.h"
+#include "MotionBlend.h"
+#include "Cpg.h"
+#include "GaitSet.h"
+#include "GaitTable.h"
+#include "ServoCal.h"
+#include "ImuFusion.h"
+#include "FuzzyTS.h"
+#include "BalancePD.h"
+#include "CurrentBudget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENGINE_FRAME_MS 20          // servo frame period
+#define ENGINE_MAX_SERVOS BLEND_MAX_JOINTS
+#define ENGINE_ZERO_SAMPLES 100     // gyro readings averaged by "imuzero"
+
+enum JointType {
+    HIP1,   // hip rotate
+    HIP2,   // hip in/out
+    HIP3,   // hip front/back
+    KNEE,
+    ANKLE1, // ankle front/back
+    ANKLE2  // ankle left/right
+};
+
+enum LegSide {
+    RIGHT_LEG,  // servos 0-5
+    LEFT_LEG,   // servos 6-11
+    NUM_LEGS
+};
+
+#define NUM_LEG_SERVOS (NUM_LEGS * LEGIK_NUM_JOINTS)
+
+enum OperatingMode {
+    STAND_MODE,     // hold the neutral pose
+    WALK_MODE,      // foot planner gait
+    DIRECT_MODE,    // foot commands and SSC-32 commands from the PC
+    TABLE_MODE,     // compiled gait table
+    CPG_MODE        // foot planner gait timed by coupled oscillators
+};
+
+enum BalanceMode {
+    BALANCE_OFF,    // open loop, the modes' poses as they are
+    BALANCE_FUZZY,  // T-S fuzzy pitch correction on HIP3 and ANKLE1
+    BALANCE_PD      // PD pitch correction on HIP3 and ANKLE1, roll on ANKLE2
+};
+
+/*
+ * The robot's servos for ServoTable's SERVO_TABLE_DEFINE, legs first as the
+ * engine fills them. Pulse limits hold the IK joint limits in
+ * GaitEngine.c, which checks them at compile time. Arms go after the legs,
+ * as SERVO_HOLD until something drives them.
+ */
+// name, SSC-32 channel, joint, neutral, min and max pulse, direction, source
+#define ENGINE_SERVO_TABLE(X) \
+    X(R_HIP1,    0, HIP1,   1500, 1000, 2000, 1, SERVO_ANGLE) \
+    X(R_HIP2,    1, HIP2,   1500, 1167, 1833, 1, SERVO_ANGLE) \
+    X(R_HIP3,    2, HIP3,   1500,  500, 2500, 1, SERVO_ANGLE) \
+    X(R_KNEE,    3, KNEE,   1500, 1500, 2500, 1, SERVO_ANGLE) \
+    X(R_ANKLE1,  4, ANKLE1, 1500, 1000, 2000, 1, SERVO_ANGLE) \
+    X(R_ANKLE2,  5, ANKLE2, 1500, 1167, 1833, 1, SERVO_ANGLE) \
+    X(L_HIP1,   16, HIP1,   1500, 1000, 2000, 1, SERVO_ANGLE) \
+    X(L_HIP2,   17, HIP2,   1500, 1167, 1833, 1, SERVO_ANGLE) \
+    X(L_HIP3,   18, HIP3,   1500,  500, 2500, 1, SERVO_ANGLE) \
+    X(L_KNEE,   19, KNEE,   1500, 1500, 2500, 1, SERVO_ANGLE) \
+    X(L_ANKLE1, 20, ANKLE1, 1500, 1000, 2000, 1, SERVO_ANGLE) \
+    X(L_ANKLE2, 21, ANKLE2, 1500, 1167, 1833, 1, SERVO_ANGLE)
+
+// What the engine needs from its platform, kept in flash
+typedef struct {
+    int servos;                             // legs first, at most ENGINE_MAX_SERVOS
+    const unsigned char *channel;           // SSC-32 channel of each, for "cal"
+    const GaitTable *table;                 // the gait played in table mode
+    int gyroRange;                          // IMU gyro full scale in degrees per second
+    void (*print)(const char *line);        // one reply line, without its end
+    void (*calDefaults)(ServoCal *cal);     // calibration from the servo table
+} EngineConfig;
+
+typedef struct {
+    const EngineConfig *config;
+
+    int mode;
+    int requestedMode;          // taken up once the current mode can leave
+    int walkStopping;           // last keyframe queued, walking to a stop
+    unsigned int lastPhase;     // gait cycle phase at the last frame
+    unsigned int frames;        // sent
+
+    FootPlanner planner;
+    Interpolator motion;        // gait keyframes to frames
+    GaitPlayer player;          // the compiled gait table
+    Cpg cpg;                    // leg oscillators, half a cycle apart
+    GaitBank gaits;             // in effect and the next from the PC
+    ServoCal cal;               // every output passes through it
+    int directAngle[ENGINE_MAX_SERVOS]; // set by "foot", held in direct mode
+    MotionBlend blend;          // cross-fades a mode change
+    int blendTime;
+
+    ImuFusion imu;
+    int imuReady;               // cleared by the platform when there is no IMU
+    int zeroCount;              // readings left to average into the gyro zero
+    int zeroSum[3];
+
+    int balanceMode;
+    int balanceOffset[NUM_LEG_SERVOS];  // added to every mode's pose
+    FuzzyTS fuzzy;              // worked out at the IMU rate
+    BalancePD pdHip, pdAnkle, pdRoll;   // worked out every frame
+    int balanceLatency;         // ms the PD balance predicts ahead
+
+    CurrentBudget budget;
+    int measuredMa;             // both legs, last engine_frame(), -1 unsensed
+} GaitEngine;
+
+// Loads the calibration and starts every mode's state, in direct mode at
+// the calibrated neutral pose
+void engine_init(GaitEngine *e, const EngineConfig *config);
+
+/*
+ * Handles a leg controller command, the line without its end, replying
+ * through print(). Returns 0 if it is not one, for the platform to pass on
+ * to the SSC-32.
+ */
+int engine_command(GaitEngine *e, const char *line);
+
+/*
+ * One frame, due every ENGINE_FRAME_MS: the current mode's pose with the
+ * balance correction, blended with the last mode's while a mode change is in
+ * progress, held to the current budget and calibrated into pulse, one per
+ * servo. imuAgeUs is the time since the last engine_imu_update() and
+ * measuredMa each leg's current over the last frame, or 0 without sensing.
+ * Returns 0 when there is nothing to send: direct mode only sends while
+ * blending or balancing, so SSC-32 commands typed at the PC are left alone.
+ */
+int engine_frame(GaitEngine *e, unsigned int imuAgeUs, const int *measuredMa, unsigned short *pulse);
+
+/*
+ * Fuses one IMU reading taken dtUs after the last, the board with x
+ * forward, y left and z up, then works out the fuzzy balance correction so
+ * that controller runs at the IMU rate.
+ */
+void engine_imu_update(GaitEngine *e, const short accel[3], const short gyro[3], unsigned int dtUs);
+
+// Averages the next ENGINE_ZERO_SAMPLES gyro readings into its zero, with
+// the robot held still
+void engine_imu_zero(GaitEngine *e);
+
+// SSC-32 commands from elsewhere have moved the servos, the next frame
+// starts from wherever they are
+void engine_servos_moved(GaitEngine *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+/*=============================================================================
+ * Gait parameter sets swapped at run time, see GaitSet.h
+ *===========================================================================*/
+#include <string.h>
+#include "GaitSet.h"
+#include "Crc16.h"
+#include "Cpg.h"
+
+unsigned short gaitset_crc(const GaitSet *set)
+{
+    return crc16_update(CRC16_INIT, set, sizeof(GaitSet));
+}
+
+int gaitset_valid(const GaitSet *set)
+{
+    return set->version == GAITSET_VERSION
+        && set->swingShape <= 1
+        && set->stepLength >= 0 && set->stepLength <= GAITSET_MAX_STEP_LENGTH
+        && set->stepHeight >= 0 && set->stepHeight <= GAITSET_MAX_STEP_HEIGHT
+        && set->standHeight > 0
+        && set->period > 0 && set->period <= GAITSET_MAX_PERIOD
+        && set->swingFraction > 0
+        && set->coupling <= CPG_MAX_FREQUENCY
+        && set->tablePeriodMs > 0;
+}
+
+void gaitbank_init(GaitBank *bank, const GaitSet *initial)
+{
+    bank->active = 0;
+    bank->pending = 1;
+    bank->previous = 2;
+    bank->ready = 0;
+    bank->hasPrevious = 0;
+    bank->set[bank->active] = *initial;
+    bank->set[bank->pending] = *initial;
+}
+
+const GaitSet *gaitbank_active(const GaitBank *bank)
+{
+    return &bank->set[bank->active];
+}
+
+const GaitSet *gaitbank_latest(const GaitBank *bank)
+{
+    return &bank->set[bank->ready ? bank->pending : bank->active];
+}
+
+int gaitbank_write(GaitBank *bank, unsigned int offset, const void *data, unsigned int length)
+{
+    if (offset > sizeof(GaitSet) || length > sizeof(GaitSet) - offset)
+        return 0;
+    // a committed set being changed again has to be committed again
+    bank->ready = 0;
+    memcpy((unsigned char *)&bank->set[bank->pending] + offset, data, length);
+    return 1;
+}
+
+int gaitbank_commit(GaitBank *bank, unsigned short crc)
+{
+    const GaitSet *pending = &bank->set[bank->pending];
+
+    if (gaitset_crc(pending) != crc || !gaitset_valid(pending)) {
+        bank->set[bank->pending] = bank->set[bank->active];
+        bank->ready = 0;
+        return 0;
+    }
+    bank->ready = 1;
+    return 1;
+}
+
+int gaitbank_rollback(GaitBank *bank)
+{
+    if (!bank->hasPrevious)
+        return 0;
+    bank->set[bank->pending] = bank->set[bank->previous];
+    bank->ready = 1;
+    return 1;
+}
+
+int gaitbank_boundary(GaitBank *bank)
+{
+    unsigned char old;
+
+    if (!bank->ready)
+        return 0;
+    old = bank->previous;
+    bank->previous = bank->active;
+    bank->active = bank->pending;
+    bank->pending = old;
+    bank->set[bank->pending] = bank->set[bank->active];
+    bank->ready = 0;
+    bank->hasPrevious = 1;
+    return 1;
+}
@@ -0,0 +1,100 @@
+/*=============================================================================
+ * Gait parameter sets swapped at run time
+ *
+ * A GaitSet is every gait parameter the PC may tune while the robot walks:
+ * the planner's step sizes, period and swing, the CPG leg coupling and the
+ * gait table's cycle time. A GaitBank keeps three of them:
+ *
+ *     active    what the gait engine reads, never written in place
+ *     pending   filled by the PC a piece at a time, starts as a copy of
+ *               active so an upload may change a single field
+ *     previous  the set active before the last swap, for rollback
+ *
+ * The PC writes pending with gaitbank_write() and commits it with the CRC
+ * of the whole record. A bad CRC, another layout's version or a value out
+ * of range discards it and leaves pending a copy of active again. A good
+ * one waits for the engine to call gaitbank_boundary() at the end of a
+ * gait cycle, where active, pending and previous swap roles by index, so
+ * the engine sees either the whole old set or the whole new one and never
+ * a mix, and a change in period or step size starts with a cycle. gaitbank_rollback() queues the
+ * previous set the same way.
+ *
+ * The record is packed little endian, the PC tools include this header for
+ * the layout. Lengths are 0.1 mm as in LegIK.
+ *===========================================================================*/
+#ifndef __GAIT_SET_H__
+#define __GAIT_SET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GAITSET_PACKED __attribute__((packed))
+
+// Bumped when the layout changes, gaitset_valid() rejects a set for another
+#define GAITSET_VERSION 1
+
+// Largest values gaitset_valid() accepts. Steps of 100 mm are at the legs'
+// reach; 200 keyframes is a 21 s cycle, far slower than any gait but still
+// a CPG frequency above 0 mHz.
+#define GAITSET_MAX_STEP_LENGTH 1000    // 0.1 mm
+#define GAITSET_MAX_STEP_HEIGHT 1000    // 0.1 mm
+#define GAITSET_MAX_PERIOD 200          // keyframes
+
+typedef struct GAITSET_PACKED {
+    unsigned char version;
+    unsigned char swingShape;       // SwingShape
+    short stepLength;
+    short stepHeight;
+    short stanceWidth;
+    short standHeight;
+    unsigned short period;          // planner keyframes per cycle
+    short swingFraction;            // Q15
+    unsigned short coupling;        // CPG leg coupling in mHz
+    unsigned short couplingOffset;  // left leg lead, fx_angle
+    unsigned short tablePeriodMs;   // gait table cycle time
+} GaitSet;
+
+typedef struct {
+    GaitSet set[3];
+    unsigned char active;           // index into set of each role
+    unsigned char pending;
+    unsigned char previous;
+    unsigned char ready;            // pending committed, swaps at the boundary
+    unsigned char hasPrevious;
+} GaitBank;
+
+// CRC-16 of a whole set as sent by the PC
+unsigned short gaitset_crc(const GaitSet *set);
+
+// True if every field is in the range the gait engine accepts
+int gaitset_valid(const GaitSet *set);
+
+// Starts with initial active and no previous set
+void gaitbank_init(GaitBank *bank, const GaitSet *initial);
+
+// The set the engine runs on, stays valid until the next swap
+const GaitSet *gaitbank_active(const GaitBank *bank);
+
+// The set the next boundary makes active: pending once committed, else
+// active. Edits made on the robot start from it, so two in one cycle both
+// take effect.
+const GaitSet *gaitbank_latest(const GaitBank *bank);
+
+// Copies data to offset in the pending set, 0 if it does not fit
+int gaitbank_write(GaitBank *bank, unsigned int offset, const void *data, unsigned int length);
+
+// Accepts the pending set if crc matches and it is valid, 0 if discarded
+int gaitbank_commit(GaitBank *bank, unsigned short crc);
+
+// Queues the set active before the last swap, 0 if there is none
+int gaitbank_rollback(GaitBank *bank);
+
+// Call at each gait cycle boundary, 1 if a new set became active
+int gaitbank_boundary(GaitBank *bank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
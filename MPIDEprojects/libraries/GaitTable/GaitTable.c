@@ -0,0 +1,37 @@
+/*=============================================================================
+ * Gait playback from precomputed pulse tables, see GaitTable.h
+ *===========================================================================*/
+#include "GaitTable.h"
+
+void gaittable_init(GaitPlayer *player, const GaitTable *table, unsigned int frameMs)
+{
+    player->table = table;
+    player->phase = 0;
+    gaittable_set_period(player, table->periodMs, frameMs);
+}
+
+void gaittable_set_period(GaitPlayer *player, unsigned int periodMs, unsigned int frameMs)
+{
+    if (periodMs < frameMs)
+        periodMs = frameMs;
+    player->increment = (unsigned int)(((unsigned long long)frameMs << 32) / periodMs);
+}
+
+void gaittable_tick(GaitPlayer *player)
+{
+    player->phase += player->increment;
+}
+
+void gaittable_sample(const GaitPlayer *player, unsigned int offset, unsigned short *pulse)
+{
+    const GaitTable *table = player->table;
+    unsigned int phase = player->phase + offset;
+    unsigned int index = phase >> (32 - table->bits);
+    int frac = (phase << table->bits) >> 17;
+    const unsigned short *a = table->pulse + index * table->joints;
+    const unsigned short *b = table->pulse + ((index + 1) & (table->samples - 1)) * table->joints;
+    int j;
+
+    for (j = 0; j < table->joints; j++)
+        pulse[j] = (unsigned short)(a[j] + ((((int)b[j] - a[j]) * frac) >> 15));
+}
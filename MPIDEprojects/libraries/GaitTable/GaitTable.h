@@ -0,0 +1,55 @@
+/*=============================================================================
+ * Gait playback from precomputed pulse tables
+ *
+ * A gait fixed by offline optimization, such as the Fourier series in the
+ * report, is sampled once on the PC by PCprojects/GaitCompiler (gaitc) over
+ * one cycle and stored as a const table of SSC-32 pulse widths, which the
+ * compiler places in flash. A row holds one pulse per joint of a leg.
+ *
+ * Playback keeps a 32 bit phase, a full turn per cycle, advanced by a fixed
+ * increment each frame. The top bits index the table and the next 15
+ * interpolate linearly to the following row, wrapping at the end of the
+ * cycle. A frame costs a few loads and one multiply per joint, and the gait
+ * speed is only the increment.
+ *===========================================================================*/
+#ifndef __GAIT_TABLE_H__
+#define __GAIT_TABLE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned short samples;         // rows per cycle, a power of two
+    unsigned char bits;             // log2(samples)
+    unsigned char joints;           // pulses per row
+    unsigned short periodMs;        // cycle time the gait was designed for
+    const unsigned short *pulse;    // samples rows of joints pulses
+} GaitTable;
+
+typedef struct {
+    const GaitTable *table;
+    unsigned int phase;             // 2^32 per cycle
+    unsigned int increment;         // phase per frame
+} GaitPlayer;
+
+// Starts at phase 0 at the table's own period
+void gaittable_init(GaitPlayer *player, const GaitTable *table, unsigned int frameMs);
+
+// Sets the cycle time, the phase carries on where it is
+void gaittable_set_period(GaitPlayer *player, unsigned int periodMs, unsigned int frameMs);
+
+// Advances one frame
+void gaittable_tick(GaitPlayer *player);
+
+/*
+ * Pulses for every joint at the current phase plus offset (0x80000000 is
+ * half a cycle, for the other leg)
+ */
+void gaittable_sample(const GaitPlayer *player, unsigned int offset, unsigned short *pulse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
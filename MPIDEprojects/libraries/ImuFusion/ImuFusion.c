@@ -0,0 +1,86 @@
+/*=============================================================================
+ * Complementary filter for body pitch and roll, see ImuFusion.h
+ *===========================================================================*/
+#include "ImuFusion.h"
+
+// Longest sample gap taken, keeps the gyro step in 32 bits
+#define MAX_DT_US 50000
+
+// Accelerations further than this from 1 g are not trusted for tilt
+#define G_TOLERANCE (IMU_ONE_G / 4)
+
+void imu_init(ImuFusion *imu, int gyroFullScale, unsigned int tauMs)
+{
+    int i;
+
+    imu->tauMs = tauMs;
+    imu->gyroFullScale = gyroFullScale;
+    // fx_angle / 256 per LSB us is fullScale * 2^8 / 180e6, in Q28
+    imu->gyroGain = (unsigned int)(((unsigned long long)gyroFullScale << 36) / 180000000u);
+    for (i = 0; i < 3; i++)
+        imu->gyroBias[i] = 0;
+    imu->started = 0;
+    imu->roll = 0;
+    imu->pitch = 0;
+    imu->rollRate = 0;
+    imu->pitchRate = 0;
+}
+
+void imu_set_bias(ImuFusion *imu, const short gyro[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+        imu->gyroBias[i] = gyro[i];
+}
+
+// One axis: gyro step, then the pull toward the tilt by k (Q16)
+static int fuse(int angle, int rate, unsigned int dtUs, unsigned int gain, fx_angle tilt, int k)
+{
+    angle += (int)(((long long)rate * dtUs * gain) >> 28);
+    if (k)
+        angle += (int)(((long long)((short)tilt * 256 - angle) * k) >> 16);
+    return angle;
+}
+
+void imu_update(ImuFusion *imu, const short accel[3], const short gyro[3], unsigned int dtUs)
+{
+    int x = accel[0], y = accel[1], z = accel[2];
+    int gx = gyro[0] - imu->gyroBias[0];
+    int gy = gyro[1] - imu->gyroBias[1];
+    fx_angle roll, pitch;
+    unsigned int norm;
+    int k = 0;
+
+    roll = fx_atan2(y, fx_isqrt((unsigned int)(x * x) + (unsigned int)(z * z)));
+    pitch = fx_atan2(-x, fx_isqrt((unsigned int)(y * y) + (unsigned int)(z * z)));
+    imu->rollRate = gx * imu->gyroFullScale / 180;
+    imu->pitchRate = gy * imu->gyroFullScale / 180;
+
+    if (!imu->started) {
+        imu->roll = (short)roll * 256;
+        imu->pitch = (short)pitch * 256;
+        imu->started = 1;
+        return;
+    }
+    if (dtUs > MAX_DT_US)
+        dtUs = MAX_DT_US;
+
+    // trust the tilt only near 1 g, dt / (tau + dt) in Q16
+    norm = fx_isqrt((unsigned int)(x * x) + (unsigned int)(y * y) + (unsigned int)(z * z));
+    if (norm > IMU_ONE_G - G_TOLERANCE && norm < IMU_ONE_G + G_TOLERANCE)
+        k = (int)(((unsigned long long)dtUs << 16) / (dtUs + imu->tauMs * 1000u));
+
+    imu->roll = fuse(imu->roll, gx, dtUs, imu->gyroGain, roll, k);
+    imu->pitch = fuse(imu->pitch, gy, dtUs, imu->gyroGain, pitch, k);
+}
+
+fx_angle imu_roll(const ImuFusion *imu)
+{
+    return (fx_angle)((imu->roll + 128) >> 8);
+}
+
+fx_angle imu_pitch(const ImuFusion *imu)
+{
+    return (fx_angle)((imu->pitch + 128) >> 8);
+}
@@ -0,0 +1,70 @@
+/*=============================================================================
+ * Body pitch and roll from the MPU-6050, complementary filter
+ *
+ * The gyro gives clean angle changes that drift, the accelerometer a tilt
+ * that does not drift but is shaken by every footfall. Each sample the
+ * filter integrates the gyro rates and pulls the result toward the
+ * accelerometer tilt by dt / (tau + dt):
+ *
+ *     angle += rate * dt
+ *     angle += (tilt - angle) * dt / (tau + dt)
+ *
+ * so the gyro dominates above 1 / (2 pi tau) and the accelerometer below.
+ * The tilt comes from the direction of gravity with the same formulas as
+ * Get_Accel_Angles() in the MPLAB MPU6050 project,
+ *
+ *     roll  = atan(y / sqrt(x^2 + z^2))      about x
+ *     pitch = atan(-x / sqrt(y^2 + z^2))     about y
+ *
+ * Samples whose acceleration is far from 1 g, a foot striking or the body
+ * swinging hard, are not pulled toward, only integrated.
+ *
+ * Raw register values go in with x forward, y left and z up; remap the
+ * chip's axes to those before imu_update(). Angles are kept to 1/256 of
+ * an fx_angle so slow gyro rates are not lost to rounding. An update is a
+ * couple of fx_atan2, three square roots and a divide.
+ *===========================================================================*/
+#ifndef __IMU_FUSION_H__
+#define __IMU_FUSION_H__
+
+#include "FixMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 1 g at the MPU-6050's +-2 g range
+#define IMU_ONE_G 16384
+
+typedef struct {
+    unsigned int tauMs;             // crossover time constant
+    unsigned int gyroGain;          // angle/256 per LSB us, Q28
+    int gyroFullScale;              // deg/s
+    short gyroBias[3];              // raw gyro reading at rest
+
+    int started;
+    int roll, pitch;                // fx_angle * 256
+    int rollRate, pitchRate;        // fx_angle per second
+} ImuFusion;
+
+/*
+ * gyroFullScale is the gyro range set in the chip, 250, 500, 1000 or
+ * 2000 deg/s. The first update takes the accelerometer tilt as it is.
+ */
+void imu_init(ImuFusion *imu, int gyroFullScale, unsigned int tauMs);
+
+// Takes the gyro reading at rest as its zero, the average of a few hundred ms still
+void imu_set_bias(ImuFusion *imu, const short gyro[3]);
+
+// One sample, dtUs since the last, clamped to 50 ms
+void imu_update(ImuFusion *imu, const short accel[3], const short gyro[3], unsigned int dtUs);
+
+// Fused angles, roll about x, left side up positive, and pitch about y, nose down positive
+fx_angle imu_roll(const ImuFusion *imu);
+fx_angle imu_pitch(const ImuFusion *imu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+/*=============================================================================
+ * Keyframe interpolation at the servo frame rate, see Interpolator.h
+ *
+ * A segment runs from the current value p0 to the next keyframe p1 over
+ * normalized time t in 0..1, with velocities V0 and V1 scaled to the
+ * segment (value change per segment). Accelerations are zero at every
+ * keyframe, which keeps min-jerk segments continuous in acceleration:
+ *
+ *     min-jerk  c3 = 10D - 6V0 - 4V1, c4 = -15D + 8V0 + 7V1,
+ *               c5 = 6D - 3V0 - 3V1
+ *     Hermite   c2 = 3D - 2V0 - V1,   c3 = -2D + V0 + V1
+ *
+ * with D = p1 - p0, c0 = p0 and c1 = V0. The coefficients always sum to
+ * p1, so a segment ends exactly on its keyframe.
+ *===========================================================================*/
+#include "Interpolator.h"
+
+#define QUEUE_MASK (INTERP_QUEUE - 1)
+
+void interp_init(Interpolator *ip, int numJoints, int mode, unsigned int frameMs, const int *start)
+{
+    int j;
+
+    if (numJoints > INTERP_MAX_JOINTS)
+        numJoints = INTERP_MAX_JOINTS;
+    ip->numJoints = numJoints;
+    ip->mode = mode;
+    ip->frameMs = frameMs ? frameMs : 1;
+    ip->head = 0;
+    ip->tail = 0;
+    ip->active = 0;
+    ip->degree = 0;
+    ip->duration = 1;
+    ip->elapsed = 0;
+    for (j = 0; j < numJoints; j++) {
+        ip->value[j] = start[j];
+        ip->velocity[j] = 0;
+    }
+}
+
+int interp_push(Interpolator *ip, const int *value, unsigned int duration)
+{
+    Keyframe *kf;
+    int j;
+
+    if (ip->tail - ip->head >= INTERP_QUEUE)
+        return 0;
+    kf = &ip->queue[ip->tail & QUEUE_MASK];
+    for (j = 0; j < ip->numJoints; j++)
+        kf->value[j] = value[j];
+    kf->duration = duration;
+    ip->tail++;
+    return 1;
+}
+
+int interp_queued(const Interpolator *ip)
+{
+    return ip->tail - ip->head;
+}
+
+int interp_busy(const Interpolator *ip)
+{
+    return ip->active || ip->tail != ip->head;
+}
+
+// Takes the next keyframe off the queue and works out its coefficients
+static void startSegment(Interpolator *ip)
+{
+    const Keyframe *kf = &ip->queue[ip->head & QUEUE_MASK];
+    const Keyframe *next = 0;
+    unsigned int duration = kf->duration ? kf->duration : 1;
+    int j;
+
+    ip->head++;
+    if (ip->tail != ip->head)
+        next = &ip->queue[ip->head & QUEUE_MASK];
+
+    for (j = 0; j < ip->numJoints; j++) {
+        int *c = ip->coef[j];
+        int p0 = ip->value[j];
+        int d = (kf->value[j] - p0) << 8;
+        int v0 = ip->velocity[j] * (int)duration;
+        int v1 = 0;
+
+        // Catmull-Rom, the slope from this segment's start to the next keyframe
+        if (next)
+            v1 = (int)(((long long)(next->value[j] - p0) << 8) / (int)(duration + (next->duration ? next->duration : 1)));
+        ip->velocity[j] = v1;
+        v1 *= (int)duration;
+        ip->target[j] = kf->value[j];
+
+        c[0] = p0 << 8;
+        c[1] = v0;
+        if (ip->mode == INTERP_HERMITE) {
+            c[2] = 3 * d - 2 * v0 - v1;
+            c[3] = -2 * d + v0 + v1;
+        } else {
+            c[2] = 0;
+            c[3] = 10 * d - 6 * v0 - 4 * v1;
+            c[4] = -15 * d + 8 * v0 + 7 * v1;
+            c[5] = 6 * d - 3 * v0 - 3 * v1;
+        }
+    }
+
+    ip->degree = ip->mode == INTERP_HERMITE ? 3 : 5;
+    ip->duration = duration;
+    ip->elapsed = 0;
+    ip->active = 1;
+}
+
+void interp_tick(Interpolator *ip, int *out)
+{
+    int j, k;
+
+    if (!ip->active && ip->tail != ip->head)
+        startSegment(ip);
+
+    if (ip->active) {
+        unsigned int elapsed = ip->elapsed + ip->frameMs;
+
+        // carry whatever time is left over into the following segments
+        while (elapsed >= ip->duration) {
+            elapsed -= ip->duration;
+            for (j = 0; j < ip->numJoints; j++)
+                ip->value[j] = ip->target[j];
+            if (ip->tail == ip->head) {
+                ip->active = 0;
+                break;
+            }
+            startSegment(ip);
+        }
+
+        if (ip->active) {
+            int tau = (int)((elapsed << 16) / ip->duration);
+            ip->elapsed = elapsed;
+            for (j = 0; j < ip->numJoints; j++) {
+                const int *c = ip->coef[j];
+                int acc = c[ip->degree];
+                for (k = ip->degree - 1; k >= 0; k--)
+                    acc = c[k] + (int)(((long long)acc * tau) >> 16);
+                ip->value[j] = (acc + 0x80) >> 8;
+            }
+        }
+    }
+
+    for (j = 0; j < ip->numJoints; j++)
+        out[j] = ip->value[j];
+}
@@ -0,0 +1,88 @@
+/*=============================================================================
+ * Keyframe interpolation at the servo frame rate
+ *
+ * Sparse keyframes, a value per joint and the time to reach it, are queued
+ * by the gait engine, a host stream or a recorded motion. Every output
+ * frame interp_tick() evaluates a smooth curve through them:
+ *
+ *     INTERP_MIN_JERK  quintic, continuous position, velocity and
+ *                      acceleration
+ *     INTERP_HERMITE   cubic Hermite, continuous position and velocity
+ *
+ * Each keyframe is passed with a Catmull-Rom velocity taken from its
+ * neighbours when the keyframe after it is already queued, otherwise the
+ * motion comes to rest there. Streams should stay one keyframe ahead.
+ * Passing through keyframes can overshoot between them, so callers clamp
+ * the output to their joint limits.
+ *
+ * Coefficients are worked out once when a segment starts, a tick is one
+ * divide for the segment time and a Horner evaluation per joint, five
+ * multiply-adds for min-jerk, all in fixed point. Storage is static,
+ * sized by INTERP_MAX_JOINTS and INTERP_QUEUE.
+ *
+ * Values are in whatever unit the caller uses, signed joint angles or pulse
+ * widths, and must stay within +-32767 so the coefficients fit 32 bits.
+ *===========================================================================*/
+#ifndef __INTERPOLATOR_H__
+#define __INTERPOLATOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERP_MAX_JOINTS 12
+
+// Keyframes waiting behind the current segment, power of two
+#define INTERP_QUEUE 8
+
+enum InterpMode {
+    INTERP_MIN_JERK,
+    INTERP_HERMITE
+};
+
+typedef struct {
+    int value[INTERP_MAX_JOINTS];
+    unsigned int duration;                  // ms from the previous keyframe
+} Keyframe;
+
+typedef struct {
+    int numJoints;
+    int mode;
+    unsigned int frameMs;
+
+    Keyframe queue[INTERP_QUEUE];
+    unsigned int head;                      // next keyframe to start
+    unsigned int tail;                      // next free slot
+
+    // current segment, coefficients in 24.8 over normalized time
+    int active;
+    int degree;
+    unsigned int duration;
+    unsigned int elapsed;                   // ms into the segment
+    int coef[INTERP_MAX_JOINTS][6];
+    int velocity[INTERP_MAX_JOINTS];        // at the segment end, 24.8 per ms
+    int target[INTERP_MAX_JOINTS];          // the segment's keyframe, its queue slot is free
+
+    int value[INTERP_MAX_JOINTS];           // last output
+} Interpolator;
+
+// Starts at rest at start, frameMs is the interp_tick() period
+void interp_init(Interpolator *ip, int numJoints, int mode, unsigned int frameMs, const int *start);
+
+// Queues a keyframe reached duration ms after the previous one, 0 if full
+int interp_push(Interpolator *ip, const int *value, unsigned int duration);
+
+// Keyframes queued and not yet started
+int interp_queued(const Interpolator *ip);
+
+// True while a segment is running or keyframes are waiting
+int interp_busy(const Interpolator *ip);
+
+// Advances one frame and writes the setpoint of every joint to out
+void interp_tick(Interpolator *ip, int *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
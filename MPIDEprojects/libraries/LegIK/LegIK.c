@@ -0,0 +1,231 @@
+/*=============================================================================
+ * Analytic inverse kinematics for the 6-DOF leg, see LegIK.h
+ *
+ * Rotations are 3x3 Q15 matrices built from fx_sin/fx_cos, positions are
+ * integers in 0.1 mm. The few products that can pass 32 bits use 64 bit
+ * intermediates.
+ *===========================================================================*/
+#include "LegIK.h"
+
+typedef int Mat3[3][3];
+
+#define MUL_Q15(a, b) (((a) * (b) + 0x4000) >> 15)
+
+static void rotX(Mat3 m, fx_angle a)
+{
+    int s = fx_sin(a), c = fx_cos(a);
+    m[0][0] = 32767; m[0][1] = 0; m[0][2] = 0;
+    m[1][0] = 0;     m[1][1] = c; m[1][2] = -s;
+    m[2][0] = 0;     m[2][1] = s; m[2][2] = c;
+}
+
+static void rotY(Mat3 m, fx_angle a)
+{
+    int s = fx_sin(a), c = fx_cos(a);
+    m[0][0] = c;  m[0][1] = 0;     m[0][2] = s;
+    m[1][0] = 0;  m[1][1] = 32767; m[1][2] = 0;
+    m[2][0] = -s; m[2][1] = 0;     m[2][2] = c;
+}
+
+static void rotZ(Mat3 m, fx_angle a)
+{
+    int s = fx_sin(a), c = fx_cos(a);
+    m[0][0] = c; m[0][1] = -s; m[0][2] = 0;
+    m[1][0] = s; m[1][1] = c;  m[1][2] = 0;
+    m[2][0] = 0; m[2][1] = 0;  m[2][2] = 32767;
+}
+
+// out = a * b, out may not alias a or b
+static void mulMat(const Mat3 a, const Mat3 b, Mat3 out)
+{
+    int i, j;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            out[i][j] = MUL_Q15(a[i][0], b[0][j]) + MUL_Q15(a[i][1], b[1][j]) + MUL_Q15(a[i][2], b[2][j]);
+}
+
+// out = m * v, or the transpose of m when transpose is set
+static void mulVec(const Mat3 m, const int v[3], int out[3], int transpose)
+{
+    int i;
+    for (i = 0; i < 3; i++) {
+        int sum = transpose ? m[0][i] * v[0] + m[1][i] * v[1] + m[2][i] * v[2]
+                            : m[i][0] * v[0] + m[i][1] * v[1] + m[i][2] * v[2];
+        out[i] = (sum + 0x4000) >> 15;
+    }
+}
+
+// foot orientation, yaw then pitch then roll
+static void footRotation(const FootPose *foot, Mat3 r)
+{
+    Mat3 z, y, x, zy;
+    rotZ(z, foot->yaw);
+    rotY(y, foot->pitch);
+    rotX(x, foot->roll);
+    mulMat(z, y, zy);
+    mulMat(zy, x, r);
+}
+
+// How far the angles run outside the joint limits, summed, 0 when within
+static int limitExcess(const LegParams *leg, const fx_angle angle[LEGIK_NUM_JOINTS])
+{
+    int excess = 0;
+    int i;
+
+    for (i = 0; i < LEGIK_NUM_JOINTS; i++) {
+        short q = (short)angle[i];
+        if (q < leg->minAngle[i])
+            excess += leg->minAngle[i] - q;
+        else if (q > leg->maxAngle[i])
+            excess += q - leg->maxAngle[i];
+    }
+    return excess;
+}
+
+/*
+ * The ankle and hip angles for one of the two branches. The hip to ankle
+ * line d, in foot coordinates, fixes the ankle roll only up to a half
+ * turn: rolling the ankle another half turn and mirroring the ankle pitch
+ * places the foot the same. With hipBelow clear the hip is above the ankle
+ * in the rolled foot frame, set it is below, as when a folded leg pitched
+ * forward carries the hip past the ankle.
+ */
+static void solveBranch(const Mat3 r7, const int d[3], int knee, int alpha, int hipBelow,
+                        fx_angle angle[LEGIK_NUM_JOINTS])
+{
+    Mat3 rx, ry, t, r;
+    int height, s1, c1;
+
+    // the hip's height over the ankle once the roll is taken out
+    height = fx_isqrt((unsigned int)(d[1] * d[1]) + (unsigned int)(d[2] * d[2]));
+    if (hipBelow)
+        height = -height;
+    angle[3] = (fx_angle)knee;
+    angle[4] = (fx_angle)(-(short)fx_atan2(d[0], height) - alpha);
+    angle[5] = hipBelow ? fx_atan2(-d[1], -d[2]) : fx_atan2(d[1], d[2]);
+
+    // what is left for the hip, R7 * Rx(q6)^T * Ry(q4 + q5)^T
+    rotX(rx, (fx_angle)-angle[5]);
+    rotY(ry, (fx_angle)-(angle[3] + angle[4]));
+    mulMat(r7, rx, t);
+    mulMat(t, ry, r);
+
+    angle[0] = fx_atan2(-r[0][1], r[1][1]);
+    s1 = fx_sin(angle[0]);
+    c1 = fx_cos(angle[0]);
+    angle[1] = fx_atan2(r[2][1], MUL_Q15(-r[0][1], s1) + MUL_Q15(r[1][1], c1));
+    angle[2] = fx_atan2(-r[2][0], r[2][2]);
+}
+
+int legik_solve(const LegParams *leg, const FootPose *foot, fx_angle angle[LEGIK_NUM_JOINTS])
+{
+    const int a = leg->thigh;
+    const int b = leg->shin;
+    Mat3 r7;
+    fx_angle other[LEGIK_NUM_JOINTS];
+    int ankle[3], toHip[3], d[3];
+    int c, cosKnee, sinKnee, knee, alpha, excess;
+    int status = 0;
+    int i;
+
+    footRotation(foot, r7);
+
+    // ankle centre, then the hip seen from the ankle in foot coordinates
+    d[0] = 0;
+    d[1] = 0;
+    d[2] = leg->ankleHeight;
+    mulVec(r7, d, ankle, 0);
+    ankle[0] += foot->x;
+    ankle[1] += foot->y;
+    ankle[2] += foot->z;
+    for (i = 0; i < 3; i++)
+        toHip[i] = -ankle[i];
+    mulVec(r7, toHip, d, 1);
+
+    // hip to ankle distance, held within what the leg can span
+    c = fx_isqrt((unsigned int)(d[0] * d[0]) + (unsigned int)(d[1] * d[1]) + (unsigned int)(d[2] * d[2]));
+    if (c > a + b) {
+        c = a + b;
+        status |= LEGIK_UNREACHABLE;
+    } else if (c < (a > b ? a - b : b - a) + 1) {
+        c = (a > b ? a - b : b - a) + 1;
+        status |= LEGIK_UNREACHABLE;
+    }
+
+    // knee from the law of cosines, pi less the interior angle
+    cosKnee = (int)(((long long)(a * a + b * b - c * c) << 15) / (2 * a * b));
+    if (cosKnee > 32768)
+        cosKnee = 32768;
+    if (cosKnee < -32768)
+        cosKnee = -32768;
+    sinKnee = fx_isqrt((1u << 30) - (unsigned int)(cosKnee * cosKnee));
+    knee = 0x8000 - fx_atan2(sinKnee, cosKnee);
+
+    // shin to hip line at the ankle, tan = 2ab sin(k) / (b^2 + c^2 - a^2)
+    alpha = (short)fx_atan2((int)(((long long)2 * a * b * sinKnee) >> 15), b * b + c * c - a * a);
+
+    // the branch that keeps the ankle roll within a quarter turn, the other
+    // only when it keeps closer to the joint limits
+    solveBranch(r7, d, knee, alpha, d[2] < 0, angle);
+    excess = limitExcess(leg, angle);
+    if (excess != 0) {
+        solveBranch(r7, d, knee, alpha, d[2] >= 0, other);
+        if (limitExcess(leg, other) < excess) {
+            for (i = 0; i < LEGIK_NUM_JOINTS; i++)
+                angle[i] = other[i];
+        }
+    }
+
+    for (i = 0; i < LEGIK_NUM_JOINTS; i++) {
+        short q = (short)angle[i];
+        if (q < leg->minAngle[i]) {
+            angle[i] = (fx_angle)leg->minAngle[i];
+            status |= LEGIK_LIMITED;
+        } else if (q > leg->maxAngle[i]) {
+            angle[i] = (fx_angle)leg->maxAngle[i];
+            status |= LEGIK_LIMITED;
+        }
+    }
+    return status;
+}
+
+void legik_forward(const LegParams *leg, const fx_angle angle[LEGIK_NUM_JOINTS], FootPose *foot)
+{
+    Mat3 m, t, hip, knee, foot7;
+    int v[3], p[3], q[3];
+    int i;
+
+    // hip rotation Rz(q1) Rx(q2) Ry(q3)
+    rotZ(m, angle[0]);
+    rotX(t, angle[1]);
+    mulMat(m, t, knee);
+    rotY(t, angle[2]);
+    mulMat(knee, t, hip);
+
+    // thigh and shin hang along -z
+    rotY(m, angle[3]);
+    v[0] = 0;
+    v[1] = 0;
+    v[2] = -leg->shin;
+    mulVec(m, v, q, 0);
+    q[2] -= leg->thigh;
+    mulVec(hip, q, p, 0);
+
+    // foot rotation and the sole below the ankle
+    rotY(m, (fx_angle)(angle[3] + angle[4]));
+    mulMat(hip, m, knee);
+    rotX(m, angle[5]);
+    mulMat(knee, m, foot7);
+    v[2] = -leg->ankleHeight;
+    mulVec(foot7, v, q, 0);
+    for (i = 0; i < 3; i++)
+        p[i] += q[i];
+
+    foot->x = p[0];
+    foot->y = p[1];
+    foot->z = p[2];
+    foot->yaw = fx_atan2(foot7[1][0], foot7[0][0]);
+    foot->pitch = fx_atan2(-foot7[2][0],
+                           fx_isqrt((unsigned int)(foot7[2][1] * foot7[2][1]) + (unsigned int)(foot7[2][2] * foot7[2][2])));
+    foot->roll = fx_atan2(foot7[2][1], foot7[2][2]);
+}
@@ -0,0 +1,74 @@
+/*=============================================================================
+ * Analytic inverse kinematics for the 6-DOF leg
+ *
+ * Joint order matches JointType in LegController:
+ *     0 HIP1    hip rotate     yaw about z
+ *     1 HIP2    hip in/out     roll about x
+ *     2 HIP3    hip front/back pitch about y
+ *     3 KNEE    knee           pitch about y, 0 is straight, flexing is positive
+ *     4 ANKLE1  ankle front/back pitch about y
+ *     5 ANKLE2  ankle left/right roll about x
+ *
+ * The three hip axes meet at the hip centre and the two ankle axes at the
+ * ankle centre, so the leg has the closed form solution of a humanoid leg
+ * (Kajita, Introduction to Humanoid Robotics, 2.5). Coordinates are in the
+ * hip frame: x forward, y left, z up, lengths in 0.1 mm. The foot pose is
+ * the sole point under the ankle and the foot's yaw, pitch and roll. The
+ * ankle roll has two solutions half a turn apart; the one within a quarter
+ * turn is taken unless only the other keeps the joints within their
+ * limits. PCprojects' ikcheck round trips the solver through
+ * legik_forward().
+ *
+ * All arithmetic is fixed point (FixMath), one solve is a few dozen table
+ * lookups and a handful of divides, so both legs fit easily in a 20 ms
+ * frame on the PIC32.
+ *===========================================================================*/
+#ifndef __LEG_IK_H__
+#define __LEG_IK_H__
+
+#include "FixMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LEGIK_NUM_JOINTS 6
+
+// Lengths are in tenths of a millimetre
+#define LEGIK_MM(mm) ((int)((mm) * 10))
+
+// legik_solve() status bits, 0 when the pose was met exactly
+#define LEGIK_UNREACHABLE 0x01  // too far or too close, the leg is stretched or folded toward it
+#define LEGIK_LIMITED     0x02  // at least one joint was clamped to its limits
+
+typedef struct {
+    int thigh;          // hip centre to knee axis
+    int shin;           // knee axis to ankle centre
+    int ankleHeight;    // ankle centre to sole
+    // joint limits as signed angles, see FX_DEG()
+    short minAngle[LEGIK_NUM_JOINTS];
+    short maxAngle[LEGIK_NUM_JOINTS];
+} LegParams;
+
+typedef struct {
+    int x, y, z;            // sole point, hip frame
+    fx_angle yaw;           // foot heading
+    fx_angle pitch;         // toe down is positive
+    fx_angle roll;
+} FootPose;
+
+/*
+ * Joint angles for a foot pose. Unreachable poses give the closest stretched
+ * or folded leg along the same line, out of range joints are clamped; both
+ * are reported in the returned status bits.
+ */
+int legik_solve(const LegParams *leg, const FootPose *foot, fx_angle angle[LEGIK_NUM_JOINTS]);
+
+// Foot pose for joint angles, the forward kinematics of legik_solve()
+void legik_forward(const LegParams *leg, const fx_angle angle[LEGIK_NUM_JOINTS], FootPose *foot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
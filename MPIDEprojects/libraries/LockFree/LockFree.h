@@ -0,0 +1,285 @@
+/*=============================================================================
+ * Lock-free data exchange between interrupts and the main loop
+ *
+ * Four pieces, all header-only, none disabling interrupts:
+ *
+ * SpscRing<T, N>   a ring of N elements, N a power of two, with exactly one
+ *                  producer and one consumer, an ISR filling it and a task
+ *                  draining it or the other way round:
+ *
+ *     static SpscRing<unsigned short, 256> samples;
+ *     // ISR
+ *     samples.push(ADC1BUF0);
+ *     // task
+ *     unsigned short s;
+ *     while (samples.pop(s))
+ *         ...
+ *
+ * Seqlock<T>       a snapshot of a multi-word state, an IMU sample or the
+ *                  joint targets, from one writer to any number of
+ *                  readers. The writer never waits. A reader copies the
+ *                  state and checks the sequence count did not move, so it
+ *                  never sees half of one write and half of the next:
+ *
+ *     static Seqlock<ImuSample> imuState;
+ *     imuState.write(sample);         // ISR
+ *     ImuSample s = imuState.read();  // task
+ *
+ *                  A reader that can interrupt the writer, an ISR reading
+ *                  what the main loop writes, must use tryRead() and keep
+ *                  its last copy on failure: read() would spin for a write
+ *                  that cannot finish until the ISR returns.
+ *
+ * AtomicCounter,   a word and a flag updated with read-modify-write
+ * AtomicFlag       sequences that are atomic against interrupts. On the
+ *                  PIC32 the __sync builtins are ll/sc loops, and an
+ *                  interrupt between the ll and the sc makes the sc fail
+ *                  and retry, as Trace.c relies on.
+ *
+ * SfrBits          atomic set, clear and toggle of peripheral register
+ *                  bits through the PIC32's CLR, SET and INV aliases, one
+ *                  store with no read, for bits an ISR also changes. Plain
+ *                  RAM has no such aliases; use AtomicCounter there.
+ *
+ * Ordering: the PIC32 is one in-order core and an ISR sees its stores in
+ * program order, so only the compiler has to be kept from reordering. On
+ * the host, where PCprojects/LockFreeBench stresses these with threads, a
+ * full fence is used.
+ *
+ * Elements and states are copied as plain memory, so they must be plain
+ * structs or scalars. C++ only, C++98 for chipKIT's gcc 4.5; C code has
+ * the byte ring of LockFreeRing.h.
+ *===========================================================================*/
+#ifndef __LOCK_FREE_H__
+#define __LOCK_FREE_H__
+
+#include "LockFreeRing.h"   // LOCKFREE_BARRIER()
+
+// Fails to compile where cond is false, C++98 has no static_assert
+template <bool Cond> struct LockFreeCheck;
+template <> struct LockFreeCheck<true> { enum { ok = 1 }; };
+
+/*---------------------------------------------------------------------------*/
+
+template <typename T, unsigned N>
+class SpscRing {
+    enum { powerOfTwo = LockFreeCheck<N != 0 && (N & (N - 1)) == 0>::ok };
+
+    public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Producer side. false if the ring is full, the element is not queued
+    bool push(const T &value)
+    {
+        unsigned int h = head;
+
+        if (h - tail == N)
+            return false;
+        data[h & (N - 1)] = value;
+        LOCKFREE_BARRIER();
+        head = h + 1;
+        return true;
+    }
+
+    // Queues all count elements or, if they do not fit, none
+    bool push(const T *values, unsigned int count)
+    {
+        unsigned int h = head;
+        unsigned int i;
+
+        if (count > N - (h - tail))
+            return false;
+        for (i = 0; i < count; i++)
+            data[(h + i) & (N - 1)] = values[i];
+        LOCKFREE_BARRIER();
+        head = h + count;
+        return true;
+    }
+
+    // Consumer side. false if the ring is empty
+    bool pop(T &value)
+    {
+        unsigned int t = tail;
+
+        if (head == t)
+            return false;
+        LOCKFREE_BARRIER();
+        value = data[t & (N - 1)];
+        LOCKFREE_BARRIER();
+        tail = t + 1;
+        return true;
+    }
+
+    // Takes up to max elements, returns how many
+    unsigned int pop(T *values, unsigned int max)
+    {
+        unsigned int t = tail;
+        unsigned int count = head - t;
+        unsigned int i;
+
+        if (count > max)
+            count = max;
+        LOCKFREE_BARRIER();
+        for (i = 0; i < count; i++)
+            values[i] = data[(t + i) & (N - 1)];
+        LOCKFREE_BARRIER();
+        tail = t + count;
+        return count;
+    }
+
+    // Either side, a snapshot that the other side may change at once
+    unsigned int size() const { return head - tail; }
+    bool empty() const { return head == tail; }
+    static unsigned int capacity() { return N; }
+
+    private:
+    T data[N];
+    volatile unsigned int head;     // free running, written by the producer
+    volatile unsigned int tail;     // free running, written by the consumer
+};
+
+/*---------------------------------------------------------------------------*/
+
+template <typename T>
+class Seqlock {
+    enum { words = (sizeof(T) + sizeof(unsigned int) - 1) / sizeof(unsigned int) };
+
+    public:
+    Seqlock() : sequence(0)
+    {
+        for (int i = 0; i < words; i++)
+            store.word[i] = 0;
+    }
+
+    // The one writer. Never waits
+    void write(const T &value)
+    {
+        Words in;
+        int i;
+
+        in.value = value;
+        sequence = sequence + 1;        // odd, a write in progress
+        LOCKFREE_BARRIER();
+        for (i = 0; i < words; i++)
+            store.word[i] = in.word[i];
+        LOCKFREE_BARRIER();
+        sequence = sequence + 1;
+    }
+
+    // Copies the last complete write, false if it was torn and value is unusable
+    bool tryRead(T &value) const
+    {
+        Words out;
+        unsigned int before = sequence;
+        int i;
+
+        if (before & 1)
+            return false;
+        LOCKFREE_BARRIER();
+        for (i = 0; i < words; i++)
+            out.word[i] = store.word[i];
+        LOCKFREE_BARRIER();
+        if (sequence != before)
+            return false;
+        value = out.value;
+        return true;
+    }
+
+    // Retries until a copy is whole, only where the writer cannot be held up
+    T read() const
+    {
+        T value;
+
+        while (!tryRead(value))
+            ;
+        return value;
+    }
+
+    // Writes completed so far, to tell a fresh snapshot from the last one
+    unsigned int version() const { return sequence >> 1; }
+
+    private:
+    union Words {
+        T value;
+        unsigned int word[words];
+    };
+
+    volatile unsigned int sequence;
+    // copied a word at a time through volatile so a torn copy is only detected, never trusted
+    volatile Words store;
+};
+
+/*---------------------------------------------------------------------------*/
+
+class AtomicCounter {
+    public:
+    explicit AtomicCounter(unsigned int initial = 0) : value(initial) {}
+
+    unsigned int load() const { return value; }
+    void store(unsigned int v) { value = v; }
+
+    // These return the value after the change
+    unsigned int add(unsigned int n) { return __sync_add_and_fetch(&value, n); }
+    unsigned int sub(unsigned int n) { return __sync_sub_and_fetch(&value, n); }
+    unsigned int increment() { return add(1); }
+    unsigned int decrement() { return sub(1); }
+
+    // Reads and zeroes in one step, for counts reported and restarted
+    unsigned int take() { return __sync_fetch_and_and(&value, 0); }
+
+    // Sets v if the value is still expected, true if it was
+    bool compareExchange(unsigned int expected, unsigned int v)
+    {
+        return __sync_bool_compare_and_swap(&value, expected, v);
+    }
+
+    // Raises the value to v if below, for maximums kept by several writers
+    void max(unsigned int v)
+    {
+        unsigned int now = value;
+
+        while (v > now && !__sync_bool_compare_and_swap(&value, now, v))
+            now = value;
+    }
+
+    private:
+    volatile unsigned int value;
+};
+
+class AtomicFlag {
+    public:
+    AtomicFlag() : flag(0) {}
+
+    // Sets the flag, true if it was already set
+    bool testAndSet() { return __sync_lock_test_and_set(&flag, 1) != 0; }
+    void clear() { __sync_lock_release(&flag); }
+    bool test() const { return flag != 0; }
+
+    // Clears the flag, true if it was set, the consumer's side of a signal
+    bool take() { return __sync_fetch_and_and(&flag, 0) != 0; }
+
+    private:
+    volatile unsigned int flag;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Every PIC32 peripheral register is followed by its CLR, SET and INV
+ * aliases, 4, 8 and 12 bytes on: writing a mask there clears, sets or
+ * toggles those bits in one bus write. Off the PIC32 the same calls are
+ * atomic read-modify-writes, so code using them runs on the host.
+ */
+struct SfrBits {
+#if defined(__PIC32MX__)
+    static inline void clear(volatile unsigned int &reg, unsigned int mask) { (&reg)[1] = mask; }
+    static inline void set(volatile unsigned int &reg, unsigned int mask) { (&reg)[2] = mask; }
+    static inline void toggle(volatile unsigned int &reg, unsigned int mask) { (&reg)[3] = mask; }
+#else
+    static inline void clear(volatile unsigned int &reg, unsigned int mask) { __sync_fetch_and_and(&reg, ~mask); }
+    static inline void set(volatile unsigned int &reg, unsigned int mask) { __sync_fetch_and_or(&reg, mask); }
+    static inline void toggle(volatile unsigned int &reg, unsigned int mask) { __sync_fetch_and_xor(&reg, mask); }
+#endif
+};
+
+#endif
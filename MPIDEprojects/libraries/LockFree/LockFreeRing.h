@@ -0,0 +1,119 @@
+/*=============================================================================
+ * Lock-free byte ring for C, LockFree.h's SpscRing for code that cannot
+ * use templates: the MPLAB projects' USB and UART rings
+ *
+ * One producer and one consumer, an ISR on one side and a task on the
+ * other. head and tail are free running byte counts, head written only by
+ * the producer and tail only by the consumer, so neither side ever
+ * disables interrupts. The size is a power of two:
+ *
+ *     static unsigned char txData[512];
+ *     static LfRing txRing = LFRING_INIT(txData);
+ *     // task
+ *     if (!lfring_put_all(&txRing, frame, length))
+ *         dropped++;
+ *     // ISR
+ *     unsigned char c;
+ *     while (UARTTransmitterIsReady(UART1) && lfring_get(&txRing, &c, 1))
+ *         UARTSendDataByte(UART1, c);
+ *
+ * A consumer that has to look into the data before taking it, such as
+ * whole records of several sizes, reads lfring_used() once, then
+ * LOCKFREE_BARRIER(), then lfring_peek() within that count.
+ *
+ * The data is copied before the index that publishes it is stored, with
+ * LOCKFREE_BARRIER() between, as in LockFree.h, which takes the barrier
+ * from here.
+ *===========================================================================*/
+#ifndef __LOCK_FREE_RING_H__
+#define __LOCK_FREE_RING_H__
+
+#if defined(__PIC32MX__)
+#define LOCKFREE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define LOCKFREE_BARRIER() __sync_synchronize()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned char *data;
+    unsigned int mask;              // size - 1
+    volatile unsigned int head;     // free running, written by the producer
+    volatile unsigned int tail;     // free running, written by the consumer
+} LfRing;
+
+// A ring over a byte array whose size is a power of two
+#define LFRING_INIT(array) { (array), sizeof(array) - 1, 0, 0 }
+
+// Either side, a snapshot that the other side may change at once
+static inline int lfring_used(const LfRing *ring)
+{
+    return (int)(ring->head - ring->tail);
+}
+
+static inline int lfring_free(const LfRing *ring)
+{
+    return (int)(ring->mask + 1 - (ring->head - ring->tail));
+}
+
+// Producer side. Copies in as much of src as fits, returns the bytes taken
+static inline int lfring_put(LfRing *ring, const void *src, int length)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    unsigned int head = ring->head;
+    int room = lfring_free(ring);
+    int i;
+
+    if (length > room)
+        length = room;
+    for (i = 0; i < length; i++)
+        ring->data[head++ & ring->mask] = p[i];
+
+    LOCKFREE_BARRIER();
+    ring->head = head;
+    return length;
+}
+
+// Producer side. Queues all length bytes or, if they do not fit, none
+static inline int lfring_put_all(LfRing *ring, const void *src, int length)
+{
+    if (length > lfring_free(ring))
+        return 0;
+    lfring_put(ring, src, length);
+    return 1;
+}
+
+// Consumer side. The byte offset bytes past the oldest without taking it,
+// offset below a lfring_used() read before a LOCKFREE_BARRIER()
+static inline unsigned char lfring_peek(const LfRing *ring, int offset)
+{
+    return ring->data[(ring->tail + offset) & ring->mask];
+}
+
+// Consumer side. Copies out up to length bytes, returns the bytes read
+static inline int lfring_get(LfRing *ring, void *dst, int length)
+{
+    unsigned char *p = (unsigned char *)dst;
+    unsigned int tail = ring->tail;
+    int used = (int)(ring->head - tail);
+    int i;
+
+    LOCKFREE_BARRIER();
+    if (length > used)
+        length = used;
+    for (i = 0; i < length; i++)
+        p[i] = ring->data[tail++ & ring->mask];
+
+    LOCKFREE_BARRIER();
+    ring->tail = tail;
+    return length;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
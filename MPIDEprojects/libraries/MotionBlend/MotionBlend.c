@@ -0,0 +1,88 @@
+/*=============================================================================
+ * Cross-fades between motion sources, see MotionBlend.h
+ *===========================================================================*/
+#include "MotionBlend.h"
+
+// Quarter turn in 100 ms, 24.8 per ms
+#define MAX_VELOCITY (16384 * 256 / 100)
+
+static int clampInt(int value, int low, int high)
+{
+    return value < low ? low : value > high ? high : value;
+}
+
+// 10 s^3 - 15 s^4 + 6 s^5 with s and the result in Q15
+static int smoothStep(int s)
+{
+    int s2 = (s * s) >> 15;
+    int s3 = (s2 * s) >> 15;
+    int q = 10 * 32768 - 15 * s + 6 * s2;   // up to 10.0 in Q15, shifted to fit
+
+    return (s3 * (q >> 3)) >> 12;
+}
+
+void blend_init(MotionBlend *blend, int numJoints, unsigned int frameMs, const int *pose)
+{
+    int i;
+
+    if (numJoints > BLEND_MAX_JOINTS)
+        numJoints = BLEND_MAX_JOINTS;
+    blend->numJoints = numJoints;
+    blend->frameMs = frameMs ? frameMs : 1;
+    blend->duration = 0;
+    blend->elapsed = 0;
+    for (i = 0; i < numJoints; i++) {
+        blend->last[i] = pose[i];
+        blend->previous[i] = pose[i];
+    }
+}
+
+void blend_start(MotionBlend *blend, unsigned int durationMs)
+{
+    int i;
+
+    if (durationMs > BLEND_MAX_TIME)
+        durationMs = BLEND_MAX_TIME;
+    blend->duration = durationMs;
+    blend->elapsed = 0;
+    for (i = 0; i < blend->numJoints; i++) {
+        int v = (blend->last[i] - blend->previous[i]) * 256 / (int)blend->frameMs;
+        blend->start[i] = blend->last[i];
+        blend->velocity[i] = clampInt(v, -MAX_VELOCITY, MAX_VELOCITY);
+    }
+}
+
+int blend_active(const MotionBlend *blend)
+{
+    return blend->duration != 0;
+}
+
+void blend_tick(MotionBlend *blend, int *angle)
+{
+    int i;
+
+    if (blend->duration) {
+        unsigned int t, T = blend->duration;
+        int coast, w;
+
+        blend->elapsed += blend->frameMs;
+        t = blend->elapsed < T ? blend->elapsed : T;
+        // distance covered by a speed falling linearly from v0 to 0 at T, in ms of v0
+        coast = (int)((t * (2 * T - t)) / (2 * T));
+        w = smoothStep((int)((t << 15) / T));
+
+        for (i = 0; i < blend->numJoints; i++) {
+            int source = blend->start[i] + ((blend->velocity[i] * coast) >> 8);
+
+            source = clampInt(source, -32767, 32767);
+            angle[i] = source + (((angle[i] - source) * w) >> 15);
+        }
+        if (blend->elapsed >= T)
+            blend->duration = 0;
+    }
+
+    for (i = 0; i < blend->numJoints; i++) {
+        blend->previous[i] = blend->last[i];
+        blend->last[i] = angle[i];
+    }
+}
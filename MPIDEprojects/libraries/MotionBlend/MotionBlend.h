@@ -0,0 +1,65 @@
+/*=============================================================================
+ * Cross-fades between motion sources on a mode change
+ *
+ * Each control mode produces a target pose every frame. blend_tick() passes
+ * it through unchanged until blend_start() is called, then for the blend
+ * time the output moves from the pose the old mode left behind to the new
+ * mode's moving target:
+ *
+ *     source(t) = start + v0 * (t - t^2 / 2T)     old motion, coasting to rest
+ *     w(s)      = 10 s^3 - 15 s^4 + 6 s^5         s = t / T
+ *     out(t)    = source(t) + w(s) * (target(t) - source(t))
+ *
+ * start and v0 are the last output and its velocity when the blend began.
+ * w and its slope are 0 at the start and 1 and 0 at the end, so the output
+ * leaves with the old velocity and arrives on the new trajectory with its
+ * velocity: no step in position or speed at either end, even when a blend
+ * is started during another.
+ *
+ * Values are joint angles in fx_angle units, within +-32767. Velocities are
+ * held to a quarter turn in 100 ms, faster than the servos can move, so a
+ * step in a target is not carried on as a huge speed.
+ *===========================================================================*/
+#ifndef __MOTION_BLEND_H__
+#define __MOTION_BLEND_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SSC-32 channels
+#define BLEND_MAX_JOINTS 32
+
+// Longest blend in ms, keeps t * 2T in 32 bits
+#define BLEND_MAX_TIME 10000
+
+typedef struct {
+    int numJoints;
+    unsigned int frameMs;
+
+    unsigned int duration;                  // ms, 0 when not blending
+    unsigned int elapsed;                   // ms into the blend
+    int start[BLEND_MAX_JOINTS];            // output when the blend began
+    int velocity[BLEND_MAX_JOINTS];         // and its velocity, 24.8 per ms
+
+    int last[BLEND_MAX_JOINTS];             // output of the last frame
+    int previous[BLEND_MAX_JOINTS];         // and the one before
+} MotionBlend;
+
+// Starts at rest at pose, frameMs is the blend_tick() period
+void blend_init(MotionBlend *blend, int numJoints, unsigned int frameMs, const int *pose);
+
+// Begins a cross-fade from the current output to the targets of the next durationMs
+void blend_start(MotionBlend *blend, unsigned int durationMs);
+
+// True while a cross-fade is running
+int blend_active(const MotionBlend *blend);
+
+// Advances one frame, angle holds the target and is replaced by the output
+void blend_tick(MotionBlend *blend, int *angle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/*=============================================================================
+ * Oversampled, filtered supply readings, see PowerSense.h
+ *===========================================================================*/
+#include "PowerSense.h"
+
+// Raw full scale with the fraction bits
+#define RAW_FULL_SCALE (1023 << PSENSE_FRACTION_BITS)
+
+// Extra bits the filter state keeps, so the shift does not leave it short
+#define FILTER_BITS 8
+
+static int clamp(int x, int low, int high)
+{
+    return x < low ? low : x > high ? high : x;
+}
+
+// Raw counts with fraction bits to the channel's units
+static int toUnits(const PowerSense *ps, int channel, int raw)
+{
+    return (int)((long long)(raw - ps->offset[channel]) * ps->fullScale[channel] / RAW_FULL_SCALE);
+}
+
+void psense_init(PowerSense *ps, int channels, int oversample)
+{
+    int i;
+
+    ps->channels = clamp(channels, 1, PSENSE_MAX_CHANNELS);
+    ps->oversample = clamp(oversample, 1, PSENSE_MAX_OVERSAMPLE);
+    ps->count = 0;
+    ps->blocks = 0;
+    for (i = 0; i < PSENSE_MAX_CHANNELS; i++) {
+        ps->sum[i] = 0;
+        ps->fullScale[i] = 1023;
+        ps->offset[i] = 0;
+        ps->shift[i] = 0;
+        ps->block[i] = 0;
+        ps->filtered[i] = 0;
+        ps->peak[i] = 0;
+    }
+}
+
+void psense_set_channel(PowerSense *ps, int channel, int fullScale, int offset, int shift)
+{
+    if (channel < 0 || channel >= ps->channels)
+        return;
+    ps->fullScale[channel] = clamp(fullScale, -32767, 32767);
+    ps->offset[channel] = clamp(offset, 0, 1023) << PSENSE_FRACTION_BITS;
+    ps->shift[channel] = (unsigned char)clamp(shift, 0, PSENSE_MAX_SHIFT);
+}
+
+void psense_zero(PowerSense *ps, int channel)
+{
+    if (channel >= 0 && channel < ps->channels)
+        ps->offset[channel] = ps->filtered[channel] >> FILTER_BITS;
+}
+
+int psense_add(PowerSense *ps, const unsigned short *sample)
+{
+    int i, block;
+
+    for (i = 0; i < ps->channels; i++)
+        ps->sum[i] += sample[i] & 0x3FF;
+    if (++ps->count < ps->oversample)
+        return 0;
+
+    for (i = 0; i < ps->channels; i++) {
+        block = (int)((ps->sum[i] << PSENSE_FRACTION_BITS) / ps->oversample);
+        ps->sum[i] = 0;
+        ps->block[i] = block;
+        // the first block starts the filter where the input is
+        if (ps->blocks == 0) {
+            ps->filtered[i] = block << FILTER_BITS;
+            ps->peak[i] = block;
+        } else {
+            ps->filtered[i] += ((block << FILTER_BITS) - ps->filtered[i]) >> ps->shift[i];
+            if (block > ps->peak[i])
+                ps->peak[i] = block;
+        }
+    }
+    ps->count = 0;
+    ps->blocks++;
+    return 1;
+}
+
+int psense_value(const PowerSense *ps, int channel)
+{
+    return toUnits(ps, channel, ps->filtered[channel] >> FILTER_BITS);
+}
+
+int psense_block(const PowerSense *ps, int channel)
+{
+    return toUnits(ps, channel, ps->block[channel]);
+}
+
+int psense_take_peak(PowerSense *ps, int channel)
+{
+    int peak = ps->peak[channel];
+
+    ps->peak[channel] = ps->block[channel];
+    return toUnits(ps, channel, peak);
+}
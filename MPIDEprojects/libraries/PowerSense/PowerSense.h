@@ -0,0 +1,87 @@
+/*=============================================================================
+ * Oversampled, filtered supply current and voltage readings
+ *
+ * Raw 10 bit ADC scans go in one at a time, every scan one sample of each
+ * channel. Each run of `oversample` scans is averaged into a block, kept
+ * with 6 fraction bits, so averaging 4 or more samples adds resolution as
+ * well as taking out the noise. Each block then goes through a first order
+ * low pass per channel,
+ *
+ *     filtered += (block - filtered) >> shift
+ *
+ * shift 0 passing blocks as they are and shift n settling over about 2^n
+ * blocks. Servo currents want a short filter, so the control loop sees a
+ * stall within a millisecond; the battery voltage a long one, so the dip
+ * under a step load does not read as a flat battery.
+ *
+ * Readings are in the channel's own units, mA for a current shunt and mV
+ * for a divider, from its full scale (the units a raw 1023 reads) and its
+ * offset (the raw counts that read 0, a shunt amplifier's zero). The
+ * largest block of each channel is also kept, since a stall peak that the
+ * filter smooths is still the one that browns the supply out.
+ *
+ * A scan costs an add per channel and a block a divide per channel, cheap
+ * enough for a task fed by the ADC interrupt at several kHz.
+ *===========================================================================*/
+#ifndef __POWER_SENSE_H__
+#define __POWER_SENSE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PSENSE_MAX_CHANNELS 8
+
+// Most scans averaged into a block, the sums stay within 32 bits
+#define PSENSE_MAX_OVERSAMPLE 256
+
+// Longest filter taken
+#define PSENSE_MAX_SHIFT 8
+
+// Fraction bits of the averaged raw counts
+#define PSENSE_FRACTION_BITS 6
+
+typedef struct {
+    int channels;
+    int oversample;                         // scans to a block
+    int count;                              // scans in this block so far
+    unsigned int sum[PSENSE_MAX_CHANNELS];
+    int fullScale[PSENSE_MAX_CHANNELS];     // units at raw 1023
+    int offset[PSENSE_MAX_CHANNELS];        // raw counts, 6 fraction bits
+    unsigned char shift[PSENSE_MAX_CHANNELS];
+    int block[PSENSE_MAX_CHANNELS];         // last block, raw counts, 6 fraction bits
+    int filtered[PSENSE_MAX_CHANNELS];      // the same filtered, 8 more fraction bits
+    int peak[PSENSE_MAX_CHANNELS];          // largest block since taken
+    unsigned int blocks;                    // blocks since psense_init()
+} PowerSense;
+
+// Channels in a scan and scans to a block, each clamped to its range.
+// Every channel starts at full scale 1023, offset 0 and no filter.
+void psense_init(PowerSense *ps, int channels, int oversample);
+
+// A channel's scaling, fullScale the reading at raw 1023 (within +-32767)
+// and offset the raw counts that read 0, and its filter shift
+void psense_set_channel(PowerSense *ps, int channel, int fullScale, int offset, int shift);
+
+// Takes the present filtered level of a channel as its zero, for a
+// current shunt read with the servos off
+void psense_zero(PowerSense *ps, int channel);
+
+// Adds one scan, channels samples. 1 when it completed a block and the
+// readings changed, else 0.
+int psense_add(PowerSense *ps, const unsigned short *sample);
+
+// Filtered reading of a channel in its units
+int psense_value(const PowerSense *ps, int channel);
+
+// The last block unfiltered, in its units
+int psense_block(const PowerSense *ps, int channel);
+
+// Largest block since the last call, in its units, then starts again
+int psense_take_peak(PowerSense *ps, int channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*=============================================================================
+ * Hot-path profiler using the PIC32 core timer, see Profiler.h
+ *===========================================================================*/
+#include "Profiler.h"
+
+#ifdef PROFILE_ENABLE
+
+#define PROF_NAME_ENTRY(id, name) name,
+static const char *const profNames[PROF_NUM_SCOPES] = {
+    PROF_SCOPE_LIST(PROF_NAME_ENTRY)
+};
+#undef PROF_NAME_ENTRY
+
+static ProfStats profStats[PROF_NUM_SCOPES];
+
+void prof_record(int id, unsigned int ticks)
+{
+    ProfStats *s = &profStats[id];
+    int bin;
+
+    if (s->count == 0 || ticks < s->min)
+        s->min = ticks;
+    if (ticks > s->max)
+        s->max = ticks;
+    s->count++;
+    s->total += ticks;
+
+    // log2 with the MIPS clz instruction, zero ticks go in bin 0
+    bin = ticks ? 31 - __builtin_clz(ticks) : 0;
+    if (bin >= PROF_HIST_BINS)
+        bin = PROF_HIST_BINS - 1;
+    s->hist[bin]++;
+}
+
+void prof_reset(void)
+{
+    int i, j;
+
+    for (i = 0; i < PROF_NUM_SCOPES; i++) {
+        profStats[i].count = 0;
+        profStats[i].min = 0;
+        profStats[i].max = 0;
+        profStats[i].total = 0;
+        for (j = 0; j < PROF_HIST_BINS; j++)
+            profStats[i].hist[j] = 0;
+    }
+}
+
+const ProfStats *prof_stats(void)
+{
+    return profStats;
+}
+
+const char *prof_name(int id)
+{
+    return profNames[id];
+}
+
+// Appends a string, dropping what does not fit
+static int appendStr(char *buf, int pos, int size, const char *s)
+{
+    while (*s && pos < size - 1)
+        buf[pos++] = *s++;
+    return pos;
+}
+
+// Appends an unsigned number followed by sep, no separator when sep is 0
+static int appendNum(char *buf, int pos, int size, unsigned int n, char sep)
+{
+    char digits[11];
+    int len = 0;
+
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    while (len && pos < size - 1)
+        buf[pos++] = digits[--len];
+    if (sep && pos < size - 1)
+        buf[pos++] = sep;
+    return pos;
+}
+
+int prof_write_csv(char *buf, int size)
+{
+    int pos = 0;
+    int i, j;
+
+    if (size <= 0)
+        return 0;
+
+    pos = appendStr(buf, pos, size, "scope,count,min,max,mean");
+    for (j = 0; j < PROF_HIST_BINS; j++) {
+        pos = appendStr(buf, pos, size, ",h");
+        pos = appendNum(buf, pos, size, j, 0);
+    }
+    pos = appendStr(buf, pos, size, "\r\n");
+
+    for (i = 0; i < PROF_NUM_SCOPES; i++) {
+        const ProfStats *s = &profStats[i];
+        unsigned int mean = s->count ? (unsigned int)(s->total / s->count) : 0;
+
+        pos = appendStr(buf, pos, size, profNames[i]);
+        pos = appendStr(buf, pos, size, ",");
+        pos = appendNum(buf, pos, size, s->count, ',');
+        pos = appendNum(buf, pos, size, s->min, ',');
+        pos = appendNum(buf, pos, size, s->max, ',');
+        pos = appendNum(buf, pos, size, mean, ',');
+        for (j = 0; j < PROF_HIST_BINS; j++)
+            pos = appendNum(buf, pos, size, s->hist[j],
+                            j == PROF_HIST_BINS - 1 ? 0 : ',');
+        pos = appendStr(buf, pos, size, "\r\n");
+    }
+
+    buf[pos] = '\0';
+    return pos;
+}
+
+#endif // PROFILE_ENABLE
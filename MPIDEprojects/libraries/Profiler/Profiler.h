@@ -0,0 +1,117 @@
+/*=============================================================================
+ * Hot-path profiler using the PIC32 core timer
+ *
+ * The core timer counts at half the system clock, 40MHz at 80MHz SYSCLK, so
+ * one tick is 25ns. Every scope keeps count, min, max, total and a log2
+ * histogram of elapsed ticks in fixed static storage, no heap.
+ *
+ *     void walkingMode()
+ *     {
+ *         PROF_START(PROF_WALKING_MODE);
+ *         ...
+ *         PROF_STOP(PROF_WALKING_MODE);
+ *     }
+ *
+ * Profiling is compiled in for MPLAB debug builds (__DEBUG) or when
+ * PROFILE_ENABLE is defined below. Otherwise the PROF_ macros expand to
+ * nothing and Profiler.c is empty, so release builds carry no cost.
+ *===========================================================================*/
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+// Uncomment to profile MPIDE builds, MPIDE has no debug configuration
+//#define PROFILE_ENABLE
+
+#if defined(__DEBUG) && !defined(PROFILE_ENABLE)
+#define PROFILE_ENABLE
+#endif
+
+#if defined(__PIC32MX__)
+#include <p32xxxx.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Profiled scopes, id and name. Add new hot paths here; the id is an index
+ * into the static statistics table.
+ */
+#define PROF_SCOPE_LIST(X) \
+    X(PROF_WALKING_MODE,   "walkingMode")         \
+    X(PROF_FOOT_PLAN,      "planner_foot")        \
+    X(PROF_SEND_SSC32,     "sendSSC32Command")    \
+    X(PROF_ACCEL_ANGLES,   "Get_Accel_Angles")    \
+    X(PROF_PROCESS_IO,     "ProcessIO")           \
+    X(PROF_USB_ISR,        "USBInterruptHandler") \
+    X(PROF_LEG_IK,         "legik_solve")         \
+    X(PROF_INTERP,         "interp_tick")         \
+    X(PROF_BALANCE,        "balance")             \
+    X(PROF_IMU_FUSION,     "imu_update")
+
+#define PROF_ENUM_ENTRY(id, name) id,
+enum ProfScope {
+    PROF_SCOPE_LIST(PROF_ENUM_ENTRY)
+    PROF_NUM_SCOPES
+};
+#undef PROF_ENUM_ENTRY
+
+// Histogram bin i counts samples of [2^i, 2^(i+1)) ticks, the last bin
+// also takes everything longer (2^23 ticks is about 210ms)
+#define PROF_HIST_BINS 24
+
+// Largest CSV dump prof_write_csv() produces for the current scope list
+#define PROF_CSV_SIZE (128 + PROF_NUM_SCOPES * (64 + PROF_HIST_BINS * 11))
+
+typedef struct {
+    unsigned int count;
+    unsigned int min;
+    unsigned int max;
+    unsigned long long total;
+    unsigned int hist[PROF_HIST_BINS];
+} ProfStats;
+
+#ifdef PROFILE_ENABLE
+
+#if defined(__PIC32MX__)
+#define PROF_NOW() ((unsigned int)_CP0_GET_COUNT())
+#else
+#define PROF_NOW() 0u
+#endif
+
+#define PROF_START(id) unsigned int prof_start_##id = PROF_NOW()
+#define PROF_STOP(id)  prof_record((id), PROF_NOW() - prof_start_##id)
+
+// Adds one sample of ticks to a scope
+void prof_record(int id, unsigned int ticks);
+
+// Clears all statistics
+void prof_reset(void);
+
+// Raw statistics table, PROF_NUM_SCOPES entries, for binary dumps
+const ProfStats *prof_stats(void);
+
+// Name of a scope as listed in PROF_SCOPE_LIST
+const char *prof_name(int id);
+
+/*
+ * Writes every scope as one CSV block:
+ *     scope,count,min,max,mean,h0,...,h23
+ * Times are in core-timer ticks. Returns the number of characters written,
+ * never more than size - 1, and always terminates the string.
+ */
+int prof_write_csv(char *buf, int size);
+
+#else
+
+#define PROF_START(id)
+#define PROF_STOP(id)
+
+#endif // PROFILE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+/*=============================================================================
+ * Cooperative scheduler with per-task timing, see Scheduler.h
+ *===========================================================================*/
+#include "Scheduler.h"
+
+#define TICKS_PER_US (SCHED_TICKS_PER_MS / 1000)
+
+void sched_init(Scheduler *sched, SchedClock clock)
+{
+    sched->clock = clock;
+    sched->count = 0;
+    sched_reset_stats(sched);
+}
+
+int sched_add(Scheduler *sched, const char *name, SchedFunc run, unsigned int period)
+{
+    SchedTask *task;
+
+    if (sched->count >= SCHED_MAX_TASKS)
+        return -1;
+    task = &sched->task[sched->count];
+    task->name = name;
+    task->run = run;
+    task->period = period;
+    task->release = sched->clock();
+    task->count = 0;
+    task->overruns = 0;
+    task->maxTicks = 0;
+    task->maxLate = 0;
+    task->totalTicks = 0;
+    return sched->count++;
+}
+
+void sched_set_period(Scheduler *sched, int id, unsigned int period)
+{
+    if (id >= 0 && id < sched->count)
+        sched->task[id].period = period;
+}
+
+void sched_run(Scheduler *sched)
+{
+    unsigned int now = sched->clock();
+    int i;
+
+    sched->passes++;
+    sched->elapsedTicks += now - sched->lastPass;
+    sched->lastPass = now;
+    for (i = 0; i < sched->count; i++) {
+        SchedTask *task = &sched->task[i];
+        unsigned int start = sched->clock();
+        unsigned int late = start - task->release;
+        unsigned int ticks;
+
+        if ((int)late < 0)
+            continue;
+        if (task->period) {
+            task->release += task->period;
+            // released again already, skip to now instead of bursting
+            if ((int)(start - task->release) >= 0) {
+                task->overruns++;
+                task->release = start + task->period;
+            }
+            if (late > task->maxLate)
+                task->maxLate = late;
+        }
+        else
+            task->release = start;
+
+        task->run();
+
+        ticks = sched->clock() - start;
+        task->count++;
+        task->totalTicks += ticks;
+        sched->busyTicks += ticks;
+        if (ticks > task->maxTicks)
+            task->maxTicks = ticks;
+    }
+}
+
+void sched_reset_stats(Scheduler *sched)
+{
+    int i;
+
+    for (i = 0; i < sched->count; i++) {
+        SchedTask *task = &sched->task[i];
+        task->count = 0;
+        task->overruns = 0;
+        task->maxTicks = 0;
+        task->maxLate = 0;
+        task->totalTicks = 0;
+    }
+    sched->passes = 0;
+    sched->busyTicks = 0;
+    sched->elapsedTicks = 0;
+    sched->lastPass = sched->clock();
+}
+
+int sched_load(const Scheduler *sched)
+{
+    if (sched->elapsedTicks == 0)
+        return 0;
+    return (int)(sched->busyTicks * 1000 / sched->elapsedTicks);
+}
+
+// Appends s, stopping short of the terminator's place
+static int appendStr(char *buf, int pos, int size, const char *s)
+{
+    while (*s && pos < size - 1)
+        buf[pos++] = *s++;
+    return pos;
+}
+
+// Appends an unsigned number followed by sep, no separator when sep is 0
+static int appendNum(char *buf, int pos, int size, unsigned int n, char sep)
+{
+    char digits[11];
+    int len = 0;
+
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    while (len && pos < size - 1)
+        buf[pos++] = digits[--len];
+    if (sep && pos < size - 1)
+        buf[pos++] = sep;
+    return pos;
+}
+
+int sched_write_report(const Scheduler *sched, char *buf, int size)
+{
+    int pos = 0;
+    int load = sched_load(sched);
+    int i;
+
+    if (size <= 0)
+        return 0;
+
+    pos = appendStr(buf, pos, size, "task period count overruns max mean late\r\n");
+    for (i = 0; i < sched->count; i++) {
+        const SchedTask *task = &sched->task[i];
+        unsigned int mean = task->count ? (unsigned int)(task->totalTicks / task->count) : 0;
+
+        pos = appendStr(buf, pos, size, task->name);
+        pos = appendStr(buf, pos, size, " ");
+        pos = appendNum(buf, pos, size, task->period / TICKS_PER_US, ' ');
+        pos = appendNum(buf, pos, size, task->count, ' ');
+        pos = appendNum(buf, pos, size, task->overruns, ' ');
+        pos = appendNum(buf, pos, size, task->maxTicks / TICKS_PER_US, ' ');
+        pos = appendNum(buf, pos, size, mean / TICKS_PER_US, ' ');
+        pos = appendNum(buf, pos, size, task->maxLate / TICKS_PER_US, 0);
+        pos = appendStr(buf, pos, size, "\r\n");
+    }
+    pos = appendStr(buf, pos, size, "passes ");
+    pos = appendNum(buf, pos, size, sched->passes, ' ');
+    pos = appendStr(buf, pos, size, "busy ");
+    pos = appendNum(buf, pos, size, load / 10, '.');
+    pos = appendNum(buf, pos, size, load % 10, '%');
+    pos = appendStr(buf, pos, size, "\r\n");
+
+    buf[pos] = '\0';
+    return pos;
+}
@@ -0,0 +1,94 @@
+/*=============================================================================
+ * Cooperative scheduler with per-task timing
+ *
+ * Each task is a function run to completion every period, in the order the
+ * tasks were added, so the first added wins when several are due. Nothing
+ * preempts a task but the interrupts, so tasks share data without locks
+ * and a task running long only delays the others:
+ *
+ *     sched_add(&sched, "imu", imuTask, 5 * SCHED_TICKS_PER_MS);
+ *     sched_add(&sched, "control", controlTask, 20 * SCHED_TICKS_PER_MS);
+ *     while (1)
+ *         sched_run(&sched);
+ *
+ * Periods and times are in ticks of the clock passed to sched_init(), the
+ * PIC32 core timer in the firmware, and wrap at 32 bits. A task runs at
+ * the first pass on or after its release. One that is released again
+ * before it has run, a whole period late, counts an overrun and restarts
+ * from now rather than bursting to catch up.
+ *
+ * Every task keeps its run count, longest and mean run time, longest
+ * release jitter and overruns, always on and a couple of clock reads per
+ * run, for the firmware's "tasks" report.
+ *===========================================================================*/
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCHED_MAX_TASKS 8
+
+// Core timer ticks, half the 80 MHz system clock
+#define SCHED_TICKS_PER_MS 40000u
+
+typedef unsigned int (*SchedClock)(void);
+typedef void (*SchedFunc)(void);
+
+typedef struct {
+    const char *name;
+    SchedFunc run;
+    unsigned int period;            // ticks, 0 to run on every pass
+    unsigned int release;           // next release time
+
+    unsigned int count;
+    unsigned int overruns;          // releases missed
+    unsigned int maxTicks;          // longest run
+    unsigned int maxLate;           // longest wait from release to start
+    unsigned long long totalTicks;
+} SchedTask;
+
+typedef struct {
+    SchedClock clock;
+    int count;
+    SchedTask task[SCHED_MAX_TASKS];
+
+    unsigned int passes;            // sched_run() calls since the last reset
+    unsigned int lastPass;          // time of the last pass
+    unsigned long long elapsedTicks;    // since the last reset
+    unsigned long long busyTicks;       // spent in tasks since then
+} Scheduler;
+
+// No tasks, timed by clock
+void sched_init(Scheduler *sched, SchedClock clock);
+
+// Adds a task first released now, the task's index or -1 if the table is full
+int sched_add(Scheduler *sched, const char *name, SchedFunc run, unsigned int period);
+
+// Changes a task's period, taking effect from its next release
+void sched_set_period(Scheduler *sched, int id, unsigned int period);
+
+// One pass, runs every task that is due
+void sched_run(Scheduler *sched);
+
+// Clears the statistics
+void sched_reset_stats(Scheduler *sched);
+
+// CPU share spent in tasks since the last reset, 0..1000
+int sched_load(const Scheduler *sched);
+
+/*
+ * Writes one line per task,
+ *     name period count overruns max mean late
+ * times in us, then the passes and the busy share. Returns the number of
+ * characters written, never more than size - 1, and always terminates the
+ * string.
+ */
+int sched_write_report(const Scheduler *sched, char *buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
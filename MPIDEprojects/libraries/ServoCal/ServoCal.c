@@ -0,0 +1,194 @@
+/*=============================================================================
+ * Per-servo calibration and soft limits, see ServoCal.h
+ *===========================================================================*/
+#include "ServoCal.h"
+#include "Crc16.h"
+
+#define CAL_MAGIC 0x4C414353u   // "SCAL"
+
+// PIC32MX program flash erases in 4 KB pages
+#define FLASH_PAGE 4096
+
+// Saved form of the calibration, one page of flash
+typedef struct {
+    short offset;
+    short gain;
+    signed char dir;
+    unsigned char reserved;
+    short minPulse;
+    short maxPulse;
+    unsigned short slew;
+} SavedServo;
+
+typedef struct {
+    unsigned int magic;
+    unsigned short count;
+    unsigned short crc;             // of servo[0..count-1]
+    SavedServo servo[SERVOCAL_MAX_SERVOS];
+} SavedRecord;
+
+#define SAVED_WORDS ((sizeof(SavedRecord) + 3) / 4)
+
+typedef union {
+    SavedRecord cal;
+    unsigned int word[SAVED_WORDS];
+} SavedCal;
+
+#if defined(__PIC32MX__)
+#include <peripheral/nvm.h>
+// A page to itself, read through a volatile pointer so the compiler never
+// assumes the erased contents it was built with
+static const unsigned int calFlash[FLASH_PAGE / 4] __attribute__((aligned(FLASH_PAGE))) = { 0xFFFFFFFF };
+#else
+static unsigned int calFlash[FLASH_PAGE / 4];
+#endif
+
+// Branch-free min and max, the operands are pulses so a - b cannot overflow
+static inline int minInt(int a, int b)
+{
+    int d = a - b;
+    return b + (d & (d >> 31));
+}
+
+static inline int maxInt(int a, int b)
+{
+    int d = a - b;
+    return a - (d & (d >> 31));
+}
+
+void servocal_init(ServoCal *cal, int count)
+{
+    int i;
+
+    if (count > SERVOCAL_MAX_SERVOS)
+        count = SERVOCAL_MAX_SERVOS;
+    cal->count = count;
+    for (i = 0; i < count; i++) {
+        cal->neutral[i] = 1500;
+        cal->offset[i] = 0;
+        cal->gain[i] = 1000;
+        cal->dir[i] = 1;
+        cal->minPulse[i] = 500;
+        cal->maxPulse[i] = 2500;
+        cal->slew[i] = SERVOCAL_DEFAULT_SLEW;
+    }
+    servocal_update(cal);
+}
+
+void servocal_update(ServoCal *cal)
+{
+    int i;
+
+    for (i = 0; i < cal->count; i++) {
+        cal->center[i] = cal->neutral[i] + cal->offset[i];
+        cal->scale[i] = (cal->dir[i] < 0 ? -1 : 1) * cal->gain[i];
+        // no limit is a step larger than the whole pulse range
+        cal->rate[i] = cal->slew[i] ? (cal->slew[i] * 1024 + 500) / 1000 : 2000 << 10;
+    }
+}
+
+void servocal_reset(ServoCal *cal)
+{
+    int i;
+
+    for (i = 0; i < cal->count; i++)
+        cal->last[i] = minInt(maxInt(cal->center[i], cal->minPulse[i]), cal->maxPulse[i]);
+}
+
+void servocal_apply(ServoCal *cal, const int *angle, unsigned int dtMs, unsigned short *pulse)
+{
+    int count = cal->count;
+    int i;
+
+    if (dtMs > 1000)
+        dtMs = 1000;
+    for (i = 0; i < count; i++) {
+        int p = cal->center[i] + ((angle[i] * cal->scale[i]) >> 14);
+        int step = (cal->rate[i] * (int)dtMs) >> 10;
+        int d;
+
+        p = minInt(maxInt(p, cal->minPulse[i]), cal->maxPulse[i]);
+        d = minInt(maxInt(p - cal->last[i], -step), step);
+        p = cal->last[i] + d;
+        cal->last[i] = p;
+        pulse[i] = (unsigned short)p;
+    }
+}
+
+int servocal_valid(int offset, int gain, int dir, int minPulse, int maxPulse, int slew)
+{
+    return offset >= -SERVOCAL_MAX_OFFSET && offset <= SERVOCAL_MAX_OFFSET
+           && gain >= 0 && gain <= SERVOCAL_MAX_GAIN
+           && (dir == 1 || dir == -1)
+           && minPulse >= SERVOCAL_MIN_PULSE && minPulse <= maxPulse && maxPulse <= SERVOCAL_MAX_PULSE
+           && slew >= 0 && slew <= SERVOCAL_MAX_SLEW;
+}
+
+int servocal_load(ServoCal *cal)
+{
+    const volatile unsigned int *flash = calFlash;
+    SavedCal saved;
+    unsigned int i;
+    int count;
+
+    for (i = 0; i < SAVED_WORDS; i++)
+        saved.word[i] = flash[i];
+    count = saved.cal.count;
+    if (saved.cal.magic != CAL_MAGIC || count != cal->count)
+        return 0;
+    if (crc16_update(CRC16_INIT, saved.cal.servo, count * sizeof(SavedServo)) != saved.cal.crc)
+        return 0;
+    // a record saved by an older build could hold what this one rejects
+    for (i = 0; i < (unsigned int)count; i++) {
+        const SavedServo *s = &saved.cal.servo[i];
+        if (!servocal_valid(s->offset, s->gain, s->dir, s->minPulse, s->maxPulse, s->slew))
+            return 0;
+    }
+
+    for (i = 0; i < (unsigned int)count; i++) {
+        const SavedServo *s = &saved.cal.servo[i];
+        cal->offset[i] = s->offset;
+        cal->gain[i] = s->gain;
+        cal->dir[i] = s->dir;
+        cal->minPulse[i] = s->minPulse;
+        cal->maxPulse[i] = s->maxPulse;
+        cal->slew[i] = s->slew;
+    }
+    servocal_update(cal);
+    return 1;
+}
+
+int servocal_save(const ServoCal *cal)
+{
+    SavedCal saved;
+    unsigned int i;
+
+    for (i = 0; i < SAVED_WORDS; i++)
+        saved.word[i] = 0xFFFFFFFF;
+    saved.cal.magic = CAL_MAGIC;
+    saved.cal.count = (unsigned short)cal->count;
+    for (i = 0; i < (unsigned int)cal->count; i++) {
+        SavedServo *s = &saved.cal.servo[i];
+        s->offset = cal->offset[i];
+        s->gain = cal->gain[i];
+        s->dir = cal->dir[i];
+        s->reserved = 0;
+        s->minPulse = cal->minPulse[i];
+        s->maxPulse = cal->maxPulse[i];
+        s->slew = cal->slew[i];
+    }
+    saved.cal.crc = crc16_update(CRC16_INIT, saved.cal.servo, cal->count * sizeof(SavedServo));
+
+#if defined(__PIC32MX__)
+    // the CPU stalls while the page erases, about 20 ms
+    if (NVMErasePage((void *)calFlash))
+        return 0;
+    for (i = 0; i < SAVED_WORDS; i++)
+        if (NVMWriteWord((void *)&calFlash[i], saved.word[i]))
+            return 0;
+#else
+    for (i = 0; i < SAVED_WORDS; i++)
+        calFlash[i] = saved.word[i];
+#endif
+    return 1;
+}
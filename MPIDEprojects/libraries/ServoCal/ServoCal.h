@@ -0,0 +1,107 @@
+/*=============================================================================
+ * Per-servo calibration and soft limits, the last stage before encoding
+ *
+ * Every commanded joint angle passes through servocal_apply() once per
+ * frame:
+ *
+ *     pulse = neutral + offset + dir * gain * angle / 16384
+ *     pulse = clamp(pulse, minPulse, maxPulse)
+ *     pulse = last + clamp(pulse - last, -slew * dt, slew * dt)
+ *
+ * with angles in fx_angle units (16384 is a quarter turn) and gain in us
+ * per quarter turn, 1000 for a nominal SSC-32 servo. The limits are the
+ * mechanical ones found by moving each joint by hand, so a bad command
+ * never drives a servo into its stop and stalls it at 1.2 A, and the slew
+ * limit keeps sudden jumps, such as a mode change, to a speed the servo
+ * can follow.
+ *
+ * Storage is a struct of arrays and the pass has no branches per servo,
+ * clamps are done with sign masks. servocal_update() folds the edited
+ * fields into the arrays the pass reads.
+ *
+ * The calibration (offset, gain, dir, limits, slew) is kept in one page of
+ * program flash with a CRC and loaded at start up; neutrals come from the
+ * sketch's servo table. On the PC a RAM page stands in for the flash.
+ *===========================================================================*/
+#ifndef __SERVO_CAL_H__
+#define __SERVO_CAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SSC-32 channels
+#define SERVOCAL_MAX_SERVOS 32
+
+// Default slew limit in us per second, about the speed of a standard servo
+#define SERVOCAL_DEFAULT_SLEW 5000
+
+// Accepted calibration, see servocal_valid(). Pulses are the SSC-32's range,
+// the offset and gain a generous bound on any servo horn and linkage.
+#define SERVOCAL_MIN_PULSE 500
+#define SERVOCAL_MAX_PULSE 2500
+#define SERVOCAL_MAX_OFFSET 500
+#define SERVOCAL_MAX_GAIN 4000
+#define SERVOCAL_MAX_SLEW 65535
+
+typedef struct {
+    int count;
+
+    // from the servo table, not saved
+    short neutral[SERVOCAL_MAX_SERVOS];
+
+    // calibration, saved to flash
+    short offset[SERVOCAL_MAX_SERVOS];          // us added to neutral
+    short gain[SERVOCAL_MAX_SERVOS];            // us per quarter turn, 0 holds
+    signed char dir[SERVOCAL_MAX_SERVOS];       // 1 or -1
+    short minPulse[SERVOCAL_MAX_SERVOS];
+    short maxPulse[SERVOCAL_MAX_SERVOS];
+    unsigned short slew[SERVOCAL_MAX_SERVOS];   // us per second, 0 for none
+
+    // derived by servocal_update()
+    int center[SERVOCAL_MAX_SERVOS];            // neutral + offset
+    int scale[SERVOCAL_MAX_SERVOS];             // dir * gain
+    int rate[SERVOCAL_MAX_SERVOS];              // slew in us per ms, 22.10
+
+    // output of the last frame
+    int last[SERVOCAL_MAX_SERVOS];
+} ServoCal;
+
+/*
+ * Nominal calibration for count servos: neutral 1500, no offset, gain
+ * 1000, full 500..2500 range, default slew. Set neutrals and anything else
+ * known, then call servocal_update(). The last outputs are left alone so
+ * defaults can be restored while moving; call servocal_reset() at start up.
+ */
+void servocal_init(ServoCal *cal, int count);
+
+// Recomputes the derived arrays after fields were changed
+void servocal_update(ServoCal *cal);
+
+// Puts every servo's last output at its neutral, the assumed pose at power up
+void servocal_reset(ServoCal *cal);
+
+// Pulses for one frame dtMs after the last, angle and pulse have count entries
+void servocal_apply(ServoCal *cal, const int *angle, unsigned int dtMs, unsigned short *pulse);
+
+/*
+ * 1 when one servo's calibration is within range: offset within
+ * +-SERVOCAL_MAX_OFFSET, gain 0..SERVOCAL_MAX_GAIN, dir 1 or -1,
+ * SERVOCAL_MIN_PULSE <= minPulse <= maxPulse <= SERVOCAL_MAX_PULSE and slew
+ * 0..SERVOCAL_MAX_SLEW. Check edits with it before storing them in the
+ * struct's short fields.
+ */
+int servocal_valid(int offset, int gain, int dir, int minPulse, int maxPulse, int slew);
+
+// Replaces the calibration with the copy in flash, 0 if none is valid or any
+// servo in it is out of range
+int servocal_load(ServoCal *cal);
+
+// Writes the calibration to flash, 0 on a flash error
+int servocal_save(const ServoCal *cal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+/*=============================================================================
+ * Compile-time servo tables
+ *
+ * A sketch describes its servos once, in output order, as an X-macro and
+ * expands it with SERVO_TABLE_DEFINE:
+ *
+ *     // name, SSC-32 channel, joint, neutral, min and max pulse, direction, source
+ *     #define SERVO_TABLE(X) \
+ *         X(R_HIP1, 0,  HIP1, 1500, 1000, 2000,  1, SERVO_ANGLE) \
+ *         X(L_HIP1, 16, HIP1, 1500, 1000, 2000, -1, SERVO_ANGLE)
+ *     SERVO_TABLE_DEFINE(SERVO_TABLE)
+ *
+ * Pulses are SSC-32 microseconds and direction is 1 or -1. The source says
+ * where a servo's position comes from: SERVO_ANGLE follows a joint angle
+ * from the gait (16384 is a quarter turn, 1000 us from neutral) and
+ * SERVO_HOLD stays at neutral.
+ *
+ * SERVO_TABLE_DEFINE declares enum ServoId, the names in order ending in
+ * NUM_SERVOS, and one ServoAt<id> specialization per entry carrying its
+ * fields as template constants. ServoFrame<NUM_SERVOS> expands into
+ * straight-line code for every servo with those constants folded in: no
+ * table in RAM, no loop, and no test of source or direction at run time.
+ * Moving from the legs to legs and arms is an edit of the table.
+ *
+ * servoChannel[] is the one table kept as data, in flash, for code that
+ * picks servos at run time.
+ *
+ * chipKIT's gcc 4.5 predates constexpr, so this is C++98 templates. C has
+ * none, so there the table expands to data instead: the same enum and
+ * servoChannel[], and servoDef[] with every entry's fields, in flash.
+ *===========================================================================*/
+#ifndef __SERVO_TABLE_H__
+#define __SERVO_TABLE_H__
+
+enum ServoSource {
+    SERVO_HOLD,     // stays at neutral
+    SERVO_ANGLE     // follows its joint angle
+};
+
+// Longest frame format() writes for n servos, "#31 P2500 " each, "T65535" and nul
+#define SERVO_FRAME_SIZE(n) ((n) * 10 + 8)
+
+// Writes value in decimal, returns the end
+static inline char *servo_put_uint(char *p, unsigned int value)
+{
+    char digits[10];
+    int n = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+#ifdef __cplusplus
+
+template <int Channel, int Joint, int Neutral, int Min, int Max, int Dir, int Source>
+struct ServoJoint {
+    enum {
+        channel = Channel,
+        joint = Joint,
+        neutral = Neutral,
+        minPulse = Min,
+        maxPulse = Max,
+        direction = Dir,
+        source = Source
+    };
+
+    // Holds a pulse in the servo's range, a held servo gets neutral
+    static inline unsigned short limit(int pulse)
+    {
+        if (Source == SERVO_HOLD)
+            return Neutral;
+        return (unsigned short)(pulse < Min ? Min : pulse > Max ? Max : pulse);
+    }
+
+    // Pulse for a joint angle, P = theta / 90 * 1000 + neutral
+    static inline unsigned short pulse(int angle)
+    {
+        return limit(Neutral + Dir * angle * 1000 / 16384);
+    }
+
+    // "#<channel> P<pulse> "
+    static inline char *format(char *p, unsigned short pulse)
+    {
+        *p++ = '#';
+        p = servo_put_uint(p, Channel);
+        *p++ = ' ';
+        *p++ = 'P';
+        p = servo_put_uint(p, pulse);
+        *p++ = ' ';
+        return p;
+    }
+};
+
+// Specialized for every entry by SERVO_TABLE_DEFINE
+template <int Id> struct ServoAt;
+
+// Whole-frame operations over servos 0..N-1, unrolled at compile time
+template <int N>
+struct ServoFrame {
+    // Pulses from joint angles indexed by ServoId
+    static inline void fromAngles(const int *angle, unsigned short *pulse)
+    {
+        ServoFrame<N - 1>::fromAngles(angle, pulse);
+        pulse[N - 1] = ServoAt<N - 1>::pulse(angle[N - 1]);
+    }
+
+    static inline void neutral(unsigned short *pulse)
+    {
+        ServoFrame<N - 1>::neutral(pulse);
+        pulse[N - 1] = ServoAt<N - 1>::neutral;
+    }
+
+    // Holds pulses from elsewhere, such as a gait table, to the servo ranges
+    static inline void limit(unsigned short *pulse)
+    {
+        ServoFrame<N - 1>::limit(pulse);
+        pulse[N - 1] = ServoAt<N - 1>::limit(pulse[N - 1]);
+    }
+
+    // SSC-32 group move without the time, returns the end
+    static inline char *format(char *p, const unsigned short *pulse)
+    {
+        p = ServoFrame<N - 1>::format(p, pulse);
+        return ServoAt<N - 1>::format(p, pulse[N - 1]);
+    }
+
+    /*
+     * Copies the table into run time arrays, such as ServoCal defaults. Gain
+     * is us per quarter turn, 1000 or 0 for a held servo.
+     */
+    static inline void describe(short *neutral, short *minPulse, short *maxPulse, signed char *dir, short *gain)
+    {
+        ServoFrame<N - 1>::describe(neutral, minPulse, maxPulse, dir, gain);
+        neutral[N - 1] = ServoAt<N - 1>::neutral;
+        minPulse[N - 1] = ServoAt<N - 1>::minPulse;
+        maxPulse[N - 1] = ServoAt<N - 1>::maxPulse;
+        dir[N - 1] = ServoAt<N - 1>::direction;
+        gain[N - 1] = (int)ServoAt<N - 1>::source == SERVO_HOLD ? 0 : 1000;
+    }
+};
+
+template <>
+struct ServoFrame<0> {
+    static inline void fromAngles(const int *, unsigned short *) {}
+    static inline void neutral(unsigned short *) {}
+    static inline void limit(unsigned short *) {}
+    static inline char *format(char *p, const unsigned short *) { return p; }
+    static inline void describe(short *, short *, short *, signed char *, short *) {}
+};
+
+#define SERVO_ID_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) name,
+#define SERVO_AT_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) \
+    template <> struct ServoAt<name> : ServoJoint<channel, joint, neutral, minPulse, maxPulse, dir, source> {};
+#define SERVO_CHANNEL_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) channel,
+
+#define SERVO_TABLE_DEFINE(TABLE)                                              \
+    enum ServoId { TABLE(SERVO_ID_ENTRY) NUM_SERVOS };                         \
+    TABLE(SERVO_AT_ENTRY)                                                      \
+    static const unsigned char servoChannel[NUM_SERVOS] = { TABLE(SERVO_CHANNEL_ENTRY) };
+
+#else
+
+typedef struct {
+    unsigned char channel;
+    unsigned char joint;
+    short neutral, minPulse, maxPulse;
+    signed char direction;
+    unsigned char source;
+} ServoDef;
+
+#define SERVO_ID_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) name,
+#define SERVO_DEF_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) \
+    { channel, joint, neutral, minPulse, maxPulse, dir, source },
+#define SERVO_CHANNEL_ENTRY(name, channel, joint, neutral, minPulse, maxPulse, dir, source) channel,
+
+#define SERVO_TABLE_DEFINE(TABLE)                                              \
+    enum ServoId { TABLE(SERVO_ID_ENTRY) NUM_SERVOS };                         \
+    static const ServoDef servoDef[NUM_SERVOS] = { TABLE(SERVO_DEF_ENTRY) };   \
+    static const unsigned char servoChannel[NUM_SERVOS] = { TABLE(SERVO_CHANNEL_ENTRY) };
+
+#endif // __cplusplus
+
+#endif
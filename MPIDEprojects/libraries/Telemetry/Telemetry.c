@@ -0,0 +1,95 @@
+/*=============================================================================
+ * Binary telemetry stream, see Telemetry.h
+ *===========================================================================*/
+#include "Telemetry.h"
+#include "LockFreeRing.h"
+
+// Smallest record with its type byte, a packet with less room is full
+#define TLM_MIN_RECORD (sizeof(TlmImu) + 1)
+
+static unsigned char tlmData[TLM_RING_SIZE];
+static LfRing tlmRing = LFRING_INIT(tlmData);
+
+static unsigned short tlmSeq;
+static unsigned short tlmDropped;
+
+static const unsigned char tlmSizes[TLM_NUM_TYPES] = {
+    0,
+    sizeof(TlmImu),
+    sizeof(TlmJoints),
+    sizeof(TlmTiming),
+    sizeof(TlmAdc),
+    sizeof(TlmSupply),
+};
+
+int tlm_record_size(int type)
+{
+    if (type <= 0 || type >= TLM_NUM_TYPES)
+        return 0;
+    return tlmSizes[type];
+}
+
+int tlm_put(int type, const void *payload)
+{
+    unsigned char code = (unsigned char)type;
+    int size = tlm_record_size(type);
+
+    if (size == 0)
+        return 0;
+    if (lfring_free(&tlmRing) < size + 1) {
+        tlmDropped++;
+        return 0;
+    }
+
+    // the type may show before its payload, tlm_next_packet() waits for both
+    lfring_put(&tlmRing, &code, 1);
+    lfring_put(&tlmRing, payload, size);
+    return 1;
+}
+
+int tlm_next_packet(unsigned char *packet, int flush)
+{
+    int queued = lfring_used(&tlmRing);
+    unsigned char sum = 0;
+    int length = 0;
+    int size;
+
+    // take as many whole records as fit and have arrived
+    LOCKFREE_BARRIER();
+    while (length < queued) {
+        size = tlm_record_size(lfring_peek(&tlmRing, length)) + 1;
+        if (length + size > TLM_PAYLOAD_SIZE || length + size > queued)
+            break;
+        length += size;
+    }
+
+    // hold a part filled packet back until more records arrive or a flush
+    if (length == 0)
+        return 0;
+    if (length == queued && !flush && length + TLM_MIN_RECORD <= TLM_PAYLOAD_SIZE)
+        return 0;
+
+    packet[0] = TLM_SYNC0;
+    packet[1] = TLM_SYNC1;
+    packet[2] = tlmSeq;
+    packet[3] = tlmSeq >> 8;
+    packet[4] = length;
+    lfring_get(&tlmRing, packet + TLM_HEADER_SIZE, length);
+    for (size = 0; size < length; size++)
+        sum += packet[TLM_HEADER_SIZE + size];
+    packet[TLM_HEADER_SIZE + length] = sum;
+    tlmSeq++;
+    return TLM_HEADER_SIZE + length + 1;
+}
+
+int tlm_queued(void)
+{
+    return lfring_used(&tlmRing);
+}
+
+int tlm_take_dropped(void)
+{
+    int dropped = tlmDropped;
+    tlmDropped = 0;
+    return dropped;
+}
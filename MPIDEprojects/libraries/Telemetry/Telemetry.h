@@ -0,0 +1,123 @@
+/*=============================================================================
+ * Binary telemetry stream
+ *
+ * Fixed binary records (IMU samples, joint targets, timing stats, ADC scans,
+ * supply readings) are queued in a RAM ring by the control code and
+ * coalesced into packets by the USB CDC service task whenever the endpoint
+ * is free, or the UART task when it has room, instead of formatting text on
+ * every pass.
+ *
+ * Packet, at most one 64 byte CDC endpoint buffer:
+ *     0xA5 0x5A | u16 seq | u8 length | records... | u8 checksum
+ * The sequence number counts packets so the PC can detect gaps, the checksum
+ * is the 8 bit sum of the records. Every record is a type byte followed by
+ * the fixed size payload for that type, records never straddle packets. All
+ * fields are little endian.
+ *
+ * The PC side tools include this header for the record layouts.
+ *===========================================================================*/
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TLM_SYNC0 0xA5
+#define TLM_SYNC1 0x5A
+#define TLM_HEADER_SIZE 5
+#define TLM_PACKET_SIZE 64
+#define TLM_PAYLOAD_SIZE (TLM_PACKET_SIZE - TLM_HEADER_SIZE - 1)
+
+// Bytes queued between the control code and the USB task, power of two
+#define TLM_RING_SIZE 2048
+
+#define TLM_NUM_JOINTS 12
+
+// Raw ADC samples a TLM_ADC record carries, whole scans of up to 8 channels
+#define TLM_ADC_SAMPLES 24
+
+// Current shunts a TLM_SUPPLY record carries, one per leg
+#define TLM_NUM_LEGS 2
+
+enum TlmType {
+    TLM_IMU = 1,
+    TLM_JOINTS,
+    TLM_TIMING,
+    TLM_ADC,
+    TLM_SUPPLY,
+    TLM_NUM_TYPES
+};
+
+#define TLM_PACKED __attribute__((packed))
+
+// Raw MPU6050 sample, register units
+typedef struct TLM_PACKED {
+    unsigned int time;          // ms
+    short accel[3];
+    short gyro[3];
+    short temperature;
+} TlmImu;
+
+// Commanded SSC-32 pulse widths in us, in servo table order
+typedef struct TLM_PACKED {
+    unsigned int time;          // ms
+    unsigned short pulse[TLM_NUM_JOINTS];
+} TlmJoints;
+
+// Main loop timing over the last report interval
+typedef struct TLM_PACKED {
+    unsigned int time;            // ms
+    unsigned int loops;           // main loop passes
+    unsigned int loopMaxTicks;    // longest pass, core timer ticks
+    unsigned int usbIsrMaxTicks;  // longest USB interrupt, core timer ticks
+    unsigned short dropped;       // records dropped because the ring was full
+    unsigned short queued;        // bytes waiting in the ring
+} TlmTiming;
+
+// Consecutive ADC scans, raw 10 bit results with the channels of a scan together
+typedef struct TLM_PACKED {
+    unsigned int scan;            // index of the first scan, gaps are scans lost
+    unsigned short rate;          // scans per second
+    unsigned char channels;       // samples per scan
+    unsigned char count;          // samples used, whole scans
+    unsigned short sample[TLM_ADC_SAMPLES];
+} TlmAdc;
+
+// Filtered supply readings, peaks and latency over the last record interval
+typedef struct TLM_PACKED {
+    unsigned int time;            // ms
+    short current[TLM_NUM_LEGS];  // servo current of each leg, mA
+    short peak[TLM_NUM_LEGS];     // largest unfiltered block, mA
+    unsigned short servoMv;       // servo battery
+    unsigned short logicMv;       // logic supply
+    unsigned short latencyMaxUs;  // longest ADC scan to published reading
+} TlmSupply;
+
+// Payload size of a record type, 0 for unknown types
+int tlm_record_size(int type);
+
+/*
+ * Queues a record, payload points at the struct for type. Returns 0 and
+ * counts a drop if the ring is full. One producer only, not for ISRs.
+ */
+int tlm_put(int type, const void *payload);
+
+/*
+ * Builds the next packet into packet (TLM_PACKET_SIZE bytes) and returns its
+ * length, or 0 if there is nothing to send. A partly filled packet is only
+ * built when flush is set, so the caller decides the latency bound.
+ */
+int tlm_next_packet(unsigned char *packet, int flush);
+
+// Bytes waiting in the ring
+int tlm_queued(void);
+
+// Records dropped since the last call, the count is cleared
+int tlm_take_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/*=============================================================================
+ * Binary event trace, see Trace.h
+ *===========================================================================*/
+#include "Trace.h"
+
+#ifdef TRACE_ENABLE
+
+#if defined(__PIC32MX__)
+#define TRACE_NOW() ((unsigned int)_CP0_GET_COUNT())
+#else
+#define TRACE_NOW() 0u
+#endif
+
+static TraceRecord traceRing[TRACE_SIZE];
+
+// Total records claimed, the slot is traceHead % TRACE_SIZE
+static volatile unsigned int traceHead;
+static volatile int traceOn = 1;
+
+void trace_write(unsigned int id, unsigned int arg)
+{
+    unsigned int slot;
+    TraceRecord *r;
+
+    if (!traceOn)
+        return;
+
+    slot = __sync_fetch_and_add(&traceHead, 1) & (TRACE_SIZE - 1);
+    r = &traceRing[slot];
+    r->time = TRACE_NOW();
+    r->id = (unsigned short)id;
+    r->arg = (unsigned short)arg;
+}
+
+void trace_enable(int on)
+{
+    traceOn = on;
+}
+
+void trace_clear(void)
+{
+    traceHead = 0;
+}
+
+static void putU16(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void putU32(unsigned char *p, unsigned int v)
+{
+    putU16(p, v);
+    putU16(p + 2, v >> 16);
+}
+
+int trace_read(unsigned char *dst, int offset, int size)
+{
+    unsigned char header[TRACE_HEADER_SIZE];
+    unsigned int head = traceHead;
+    unsigned int count = head < TRACE_SIZE ? head : TRACE_SIZE;
+    unsigned int first = head - count;
+    int total = TRACE_HEADER_SIZE + count * sizeof(TraceRecord);
+    int n = 0;
+
+    header[0] = TRACE_MAGIC[0];
+    header[1] = TRACE_MAGIC[1];
+    header[2] = TRACE_MAGIC[2];
+    header[3] = TRACE_MAGIC[3];
+    putU32(&header[4], TRACE_TICK_HZ);
+    putU16(&header[8], count);
+    putU16(&header[10], 0);
+
+    while (n < size && offset < total) {
+        if (offset < TRACE_HEADER_SIZE) {
+            dst[n++] = header[offset++];
+        } else {
+            int byte = offset - TRACE_HEADER_SIZE;
+            unsigned int index = (first + byte / sizeof(TraceRecord)) & (TRACE_SIZE - 1);
+            const TraceRecord *r = &traceRing[index];
+            unsigned char record[sizeof(TraceRecord)];
+
+            putU32(&record[0], r->time);
+            putU16(&record[4], r->id);
+            putU16(&record[6], r->arg);
+            dst[n++] = record[byte % sizeof(TraceRecord)];
+            offset++;
+        }
+    }
+    return n;
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,121 @@
+/*=============================================================================
+ * Binary event trace
+ *
+ * A RAM ring of fixed 8 byte records (core timer timestamp, event id, 16 bit
+ * argument) for seeing how the control tick, UART, I2C and USB interleave.
+ * Records are written lock-free: a slot is claimed with an atomic increment
+ * (ll/sc on the PIC32), so ISRs and the main loop can trace at the same time.
+ * The ring overwrites the oldest records, like a flight recorder.
+ *
+ *     TRACE_BEGIN(TRACE_CONTROL_TICK, counter);
+ *     ...
+ *     TRACE_END(TRACE_CONTROL_TICK, 0);
+ *
+ * To read it out, stop tracing with trace_enable(0) and pull the dump with
+ * trace_read() from the main loop:
+ *     "TRC1" | u32 tick rate | u16 record count | u16 0 | records...
+ * oldest record first, all little endian. PCprojects/TraceExport converts a
+ * dump to Chrome trace JSON.
+ *
+ * Tracing is built for MPLAB debug builds (__DEBUG) or when TRACE_ENABLE is
+ * defined below, otherwise the TRACE_ macros expand to nothing.
+ *===========================================================================*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+// Uncomment to trace MPIDE builds, MPIDE has no debug configuration
+//#define TRACE_ENABLE
+
+#if defined(__DEBUG) && !defined(TRACE_ENABLE)
+#define TRACE_ENABLE
+#endif
+
+#if defined(__PIC32MX__)
+#include <p32xxxx.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Traced events: id, name and the timeline track it is drawn on. The host
+ * converter includes this header, so names only live here.
+ */
+#define TRACE_EVENT_LIST(X) \
+    X(TRACE_CONTROL_TICK,  "controlTick",      "control") \
+    X(TRACE_FOOT_PLAN,     "planner_foot",     "control") \
+    X(TRACE_SSC32_SEND,    "sendSSC32Command", "control") \
+    X(TRACE_COMMAND,       "command",          "control") \
+    X(TRACE_MODE_CHANGE,   "modeChange",       "control") \
+    X(TRACE_UART_TX_ISR,   "uartTxIsr",        "uart")    \
+    X(TRACE_I2C_READ,      "i2cRead",          "i2c")     \
+    X(TRACE_USB_TASKS,     "USBDeviceTasks",   "usb")     \
+    X(TRACE_PROCESS_IO,    "ProcessIO",        "usb")
+
+#define TRACE_ENUM_ENTRY(id, name, track) id,
+enum TraceEvent {
+    TRACE_EVENT_LIST(TRACE_ENUM_ENTRY)
+    TRACE_NUM_EVENTS
+};
+#undef TRACE_ENUM_ENTRY
+
+// Record kind in the top two bits of the id field
+#define TRACE_KIND_INSTANT 0x0000
+#define TRACE_KIND_BEGIN   0x4000
+#define TRACE_KIND_END     0x8000
+#define TRACE_KIND_COUNTER 0xC000
+#define TRACE_KIND_MASK    0xC000
+
+// Records in the ring, must be a power of two
+#define TRACE_SIZE 512
+
+// Core timer rate, SYSCLK/2
+#define TRACE_TICK_HZ 40000000UL
+
+#define TRACE_MAGIC "TRC1"
+#define TRACE_HEADER_SIZE 12
+
+typedef struct {
+    unsigned int time;      // core timer ticks
+    unsigned short id;      // TraceEvent | TRACE_KIND_
+    unsigned short arg;
+} TraceRecord;
+
+#ifdef TRACE_ENABLE
+
+#define TRACE_BEGIN(event, arg)   trace_write((event) | TRACE_KIND_BEGIN, (arg))
+#define TRACE_END(event, arg)     trace_write((event) | TRACE_KIND_END, (arg))
+#define TRACE_INSTANT(event, arg) trace_write((event) | TRACE_KIND_INSTANT, (arg))
+#define TRACE_COUNTER(event, arg) trace_write((event) | TRACE_KIND_COUNTER, (arg))
+
+// Appends one record, safe from any ISR or task
+void trace_write(unsigned int id, unsigned int arg);
+
+// Turns recording on or off, off while a dump is read out
+void trace_enable(int on);
+
+// Drops all records
+void trace_clear(void);
+
+/*
+ * Copies up to size bytes of the dump starting at byte offset into dst and
+ * returns the number copied, 0 at the end. Only call with tracing stopped
+ * and from the main loop.
+ */
+int trace_read(unsigned char *dst, int offset, int size);
+
+#else
+
+#define TRACE_BEGIN(event, arg)
+#define TRACE_END(event, arg)
+#define TRACE_INSTANT(event, arg)
+#define TRACE_COUNTER(event, arg)
+
+#endif // TRACE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,293 @@
+/* ADC acquisition: Timer3 triggers each conversion of an auto scan, the
+   ADC interrupt copies a finished scan into a ring and nothing else, and
+   the main loop takes whole scans out at its own pace. Formatting and
+   output stay out of the interrupt, so a slow UART only ever costs
+   scans counted as overruns, never a late sample.
+
+   The ADC result buffer is split in two halves (BUFM): while the ISR
+   reads one scan the next fills the other half, so the ISR has a whole
+   scan time to answer.
+
+   Latency is timed on the core timer from the end of the scan the ISR
+   is answering. Scan n ends (n + 1) scan periods after AdcStart(), and
+   Timer3 and the core timer run from the same crystal, so that time is
+   exact however late the ISR is; Timer3 itself would have wrapped. */
+
+#include <plib.h>
+#include "GenericTypeDefs.h"
+#include "AdcAcquire.h"
+
+#define RING_MASK				(ADC_RING_SCANS - 1)
+
+// Core timer tick at 40 MHz, half the 80 MHz system clock
+#define CORE_TICK_NS			25
+#define CORE_TICK_HZ			40000000u
+
+// Keeps the compiler from moving ring accesses past the index updates
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/** P R I V A T E  V A R I A B L E S *****************************************/
+
+static unsigned int PbClk;
+static int Channels;
+
+// Timer3 prescaler for each TCKPS setting
+static const unsigned short Prescale[8] = { 1, 2, 4, 8, 16, 32, 64, 256 };
+
+// Scan period in core timer ticks, ScanTicks and ScanFrac / PbClk
+static unsigned int ScanTicks;
+static unsigned int ScanFrac;
+
+// Free running scan counts, head written by the ISR and tail by AdcRead()
+static AdcScan Ring[ADC_RING_SCANS];
+volatile static unsigned int Head;
+volatile static unsigned int Tail;
+
+volatile static unsigned int ScanIndex;
+
+// Core timer at the end of scan ScanIndex, ScanEndTicks and ScanEndFrac / PbClk
+volatile static unsigned int ScanEndTicks;
+volatile static unsigned int ScanEndFrac;
+
+// Since the last AdcTakeTiming(), in core timer ticks
+volatile static unsigned int Scans;
+volatile static unsigned int Overruns;
+volatile static unsigned int LatencyMaxTicks;
+volatile static unsigned int IsrMaxTicks;
+
+/********************************************************************
+ * Function:        BOOL AdcInit(unsigned int pbClk,
+ *                               unsigned int channelMask)
+ *
+ * Overview:        Sets the ADC up to scan the ANx inputs in
+ *                  channelMask, bit n for ANn, in ascending order on
+ *                  each Timer3 trigger, referenced to AVDD and AVSS.
+ *                  FALSE if the mask is empty or has more than
+ *                  ADC_MAX_CHANNELS inputs. Nothing is sampled until
+ *                  AdcStart().
+ *******************************************************************/
+BOOL AdcInit(unsigned int pbClk, unsigned int channelMask)
+{
+	unsigned int bits;
+	int count = 0;
+
+	channelMask &= 0xFFFF;
+	for (bits = channelMask; bits; bits &= bits - 1)
+		count++;
+	if (count == 0 || count > ADC_MAX_CHANNELS)
+		return FALSE;
+
+	AdcStop();
+	PbClk = pbClk;
+	Channels = count;
+
+	// Integer results | Timer3 ends sampling and starts a conversion | sample again after it
+	#define PARAM1  ADC_FORMAT_INTG | ADC_CLK_TMR | ADC_AUTO_SAMPLING_ON
+
+	// AVDD/AVSS reference | scan | interrupt after a whole scan | two buffer halves | MUXA only
+	#define PARAM2  ADC_VREF_AVDD_AVSS | ADC_OFFSET_CAL_DISABLE | ADC_SCAN_ON | ((count - 1) << _AD1CON2_SMPI_POSITION) | ADC_ALT_BUF_ON | ADC_ALT_INPUT_OFF
+
+	// internal RC clock, the sample time runs from one trigger to the next
+	#define PARAM3  ADC_CONV_CLK_INTERNAL_RC | ADC_SAMPLE_TIME_15
+
+	AD1CON1 = PARAM1;
+	AD1CON2 = PARAM2;
+	AD1CON3 = PARAM3;
+	AD1CHS = ADC_CH0_NEG_SAMPLEA_NVREF;
+	AD1PCFGCLR = channelMask;	// analog inputs
+	AD1CSSL = channelMask;		// and the ones scanned
+
+	mAD1SetIntPriority(ADC_INT_PRIORITY);
+	mAD1ClearIntFlag();
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        BOOL AdcStart(unsigned int scanHz)
+ *
+ * Overview:        Starts scanning all channels scanHz times a second,
+ *                  the scan index and the ring from zero. FALSE if the
+ *                  rate needs triggers faster than ADC_MAX_TRIGGER_HZ
+ *                  or slower than Timer3 can count.
+ *******************************************************************/
+BOOL AdcStart(unsigned int scanHz)
+{
+	unsigned int trigger, period = 0;
+	unsigned long long scan;
+	int ps;
+
+	if (Channels == 0 || scanHz == 0 || scanHz > ADC_MAX_TRIGGER_HZ / Channels)
+		return FALSE;
+	trigger = scanHz * Channels;
+	for (ps = 0; ps < 8; ps++)
+	{
+		period = PbClk / Prescale[ps] / trigger;
+		if (period <= 0x10000)
+			break;
+	}
+	if (ps == 8)
+		return FALSE;
+
+	AdcStop();
+	Head = Tail = 0;
+	ScanIndex = 0;
+
+	// peripheral clocks per scan in core timer ticks, whole and fraction
+	scan = (unsigned long long)period * Prescale[ps] * Channels * CORE_TICK_HZ;
+	ScanTicks = (unsigned int)(scan / PbClk);
+	ScanFrac = (unsigned int)(scan % PbClk);
+	ScanEndFrac = ScanFrac;
+
+	T3CON = 0;
+	TMR3 = 0;
+	PR3 = period - 1;
+	T3CONbits.TCKPS = ps;
+
+	mAD1ClearIntFlag();
+	AD1CON1bits.ON = 1;
+	mAD1IntEnable(1);
+	ScanEndTicks = ReadCoreTimer() + ScanTicks;
+	T3CONbits.ON = 1;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        void AdcStop(void)
+ *
+ * Overview:        Stops the trigger and the ADC. Scans already in
+ *                  the ring can still be read.
+ *******************************************************************/
+void AdcStop(void)
+{
+	T3CONbits.ON = 0;
+	mAD1IntEnable(0);
+	AD1CON1bits.ON = 0;
+	mAD1ClearIntFlag();
+}
+
+/********************************************************************
+ * Function:        int AdcChannels(void)
+ *
+ * Overview:        Samples in each scan.
+ *******************************************************************/
+int AdcChannels(void)
+{
+	return Channels;
+}
+
+/********************************************************************
+ * Function:        int AdcRead(AdcScan *scans, int max)
+ *
+ * Overview:        Takes up to max of the oldest scans, returns how
+ *                  many. Main loop only.
+ *******************************************************************/
+int AdcRead(AdcScan *scans, int max)
+{
+	unsigned int tail = Tail;
+	int count = (int)(Head - tail);
+	int i;
+
+	if (count > max)
+		count = max;
+	RING_BARRIER();
+	for (i = 0; i < count; i++)
+		scans[i] = Ring[(tail + i) & RING_MASK];
+	RING_BARRIER();
+	Tail = tail + count;
+	return count;
+}
+
+/********************************************************************
+ * Function:        void AdcTakeTiming(AdcTiming *timing)
+ *
+ * Overview:        Scan and overrun counts and the longest interrupt
+ *                  latency and run time since the last call, which
+ *                  clears them. The latency runs from the Timer3
+ *                  trigger of the scan's last conversion, so it holds
+ *                  that conversion too, about 12 TAD. An ISR a scan
+ *                  or more late shows here, and its lost scans among
+ *                  the overruns.
+ *******************************************************************/
+void AdcTakeTiming(AdcTiming *timing)
+{
+	unsigned int status = INTDisableInterrupts();
+	unsigned int latency = LatencyMaxTicks;
+	unsigned int isr = IsrMaxTicks;
+
+	timing->scans = Scans;
+	timing->overruns = Overruns;
+	Scans = 0;
+	Overruns = 0;
+	LatencyMaxTicks = 0;
+	IsrMaxTicks = 0;
+	INTRestoreInterrupts(status);
+
+	timing->latencyMaxNs = latency * CORE_TICK_NS;
+	timing->isrMaxNs = isr * CORE_TICK_NS;
+}
+
+// Moves the scan index and its end time on to the next scan
+static void NextScan(void)
+{
+	ScanIndex++;
+	Scans++;
+	ScanEndTicks += ScanTicks;
+	ScanEndFrac += ScanFrac;
+	if (ScanEndFrac >= PbClk)
+	{
+		ScanEndTicks++;
+		ScanEndFrac -= PbClk;
+	}
+}
+
+/********************************************************************
+ * Function:        void AdcInterruptHandler(void)
+ *
+ * Overview:        One scan is complete. Copies it from the buffer
+ *                  half the ADC has just left into the ring, or counts
+ *                  an overrun if the main loop has fallen a ring
+ *                  behind. An interrupt a whole scan late has found
+ *                  the next scan in that half, and the one it was due
+ *                  for is counted lost.
+ *
+ * Note:            The priority here must match ADC_INT_PRIORITY.
+ *******************************************************************/
+void __ISR(_ADC_VECTOR, ipl5) AdcInterruptHandler(void)
+{
+	unsigned int start = ReadCoreTimer();
+	unsigned int latency = start - ScanEndTicks;
+	// BUFS set, the ADC is filling the upper half and the lower one is done
+	volatile unsigned int *result = AD1CON2bits.BUFS ? &ADC1BUF0 : &ADC1BUF8;
+	unsigned int head = Head;
+	unsigned int ticks;
+	AdcScan *scan;
+	int i;
+
+	if (latency < 0x80000000u && latency > LatencyMaxTicks)
+		LatencyMaxTicks = latency;
+	while (latency < 0x80000000u && latency >= ScanTicks)
+	{
+		Overruns++;
+		NextScan();
+		latency = start - ScanEndTicks;
+	}
+
+	if (head - Tail < ADC_RING_SCANS)
+	{
+		scan = &Ring[head & RING_MASK];
+		scan->index = ScanIndex;
+		// result registers are 16 bytes apart, clear, set and invert between
+		for (i = 0; i < Channels; i++)
+			scan->sample[i] = (unsigned short)result[i * 4];
+		RING_BARRIER();
+		Head = head + 1;
+	}
+	else
+		Overruns++;
+	NextScan();
+	mAD1ClearIntFlag();
+
+	ticks = ReadCoreTimer() - start;
+	if (ticks > IsrMaxTicks)
+		IsrMaxTicks = ticks;
+}
@@ -0,0 +1,41 @@
+#ifndef ADC_ACQUIRE_H
+#define ADC_ACQUIRE_H
+
+// Most inputs in one scan, the ADC result buffer is split in two halves of 8
+#define ADC_MAX_CHANNELS		8
+
+// Scans the ring holds for the deferred task, a power of two
+#define ADC_RING_SCANS			256
+
+// Fastest Timer3 trigger, one conversion each, within the RC clock's 12 TAD
+// conversion plus the shortest useful sampling time
+#define ADC_MAX_TRIGGER_HZ		200000
+
+// ADC interrupt priority, above the UARTs so a scan is never left waiting
+// for text output; the ISR only copies the results out
+#define ADC_INT_PRIORITY		5
+
+// One scan, sample[i] from the i-th lowest numbered channel in the mask
+typedef struct
+{
+	unsigned int index;				// scans since AdcStart(), gaps are scans lost
+	unsigned short sample[ADC_MAX_CHANNELS];
+} AdcScan;
+
+// Acquisition health since the last AdcTakeTiming()
+typedef struct
+{
+	unsigned int scans;				// scans converted
+	unsigned int overruns;			// scans lost, the ring was full or the ISR a scan late
+	unsigned int latencyMaxNs;		// longest Timer3 trigger to ISR entry
+	unsigned int isrMaxNs;			// longest ISR run
+} AdcTiming;
+
+extern BOOL AdcInit(unsigned int pbClk, unsigned int channelMask);
+extern BOOL AdcStart(unsigned int scanHz);
+extern void AdcStop(void);
+extern int AdcChannels(void);
+extern int AdcRead(AdcScan *scans, int max);
+extern void AdcTakeTiming(AdcTiming *timing);
+
+#endif
@@ -64,12 +64,13 @@
 
 #include <p32xxxx.h>	// Include PIC32 specifics header file.
 #include <plib.h>	// Include the PIC32 Peripheral Library.
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "MPU6050.h"
 #include "shared.h"
 #include "i2c_functions.h"
+#include "Profiler.h"
+#include "FixMath.h"
 
 char GYRO_XOUT_H;
 char GYRO_XOUT_L;
@@ -285,11 +286,46 @@ void Get_Accel_Values()
 	ACCEL_ZOUT = ((ACCEL_ZOUT_H<<8)|ACCEL_ZOUT_L);		
 }	
  
+//Reads one raw accel, gyro and temperature sample in register units
+void Get_Raw_Values(short *accel, short *gyro, short *temperature)
+{
+	char h, l;
+
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_XOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_XOUT_L, &l, 1);
+	accel[0] = (h << 8) | (unsigned char)l;
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_YOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_YOUT_L, &l, 1);
+	accel[1] = (h << 8) | (unsigned char)l;
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_ZOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_ACCEL_ZOUT_L, &l, 1);
+	accel[2] = (h << 8) | (unsigned char)l;
+
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_TEMP_OUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_TEMP_OUT_L, &l, 1);
+	*temperature = (h << 8) | (unsigned char)l;
+
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_XOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_XOUT_L, &l, 1);
+	gyro[0] = (h << 8) | (unsigned char)l;
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_YOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_YOUT_L, &l, 1);
+	gyro[1] = (h << 8) | (unsigned char)l;
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_ZOUT_H, &h, 1);
+	LDByteReadI2C(MPU6050_ADDRESS, MPU6050_RA_GYRO_ZOUT_L, &l, 1);
+	gyro[2] = (h << 8) | (unsigned char)l;
+}
+ 
 //Converts the already acquired accelerometer data into 3D euler angles
 void Get_Accel_Angles()
 {
-	ACCEL_XANGLE = 57.295*atan((float)ACCEL_YOUT/ sqrt(pow((float)ACCEL_ZOUT,2)+pow((float)ACCEL_XOUT,2)));
-	ACCEL_YANGLE = 57.295*atan((float)-ACCEL_XOUT/ sqrt(pow((float)ACCEL_ZOUT,2)+pow((float)ACCEL_YOUT,2)));	
+	int x = ACCEL_XOUT, y = ACCEL_YOUT, z = ACCEL_ZOUT;
+
+	// atan(y / sqrt(z^2 + x^2)) in degrees, fixed point, the squares fit unsigned
+	PROF_START(PROF_ACCEL_ANGLES);
+	ACCEL_XANGLE = (fx_angle_to_deg(fx_atan2(y, fx_isqrt((unsigned int)(z*z) + (unsigned int)(x*x)))) + 0x8000) >> 16;
+	ACCEL_YANGLE = (fx_angle_to_deg(fx_atan2(-x, fx_isqrt((unsigned int)(z*z) + (unsigned int)(y*y)))) + 0x8000) >> 16;
+	PROF_STOP(PROF_ACCEL_ANGLES);
 }	
  
 //Function to read the gyroscope rate data and convert it into degrees/s
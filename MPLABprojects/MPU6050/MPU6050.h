@@ -400,6 +400,7 @@ void Calibrate_Gyros(void);
 void Get_Accel_Values(void);
 void Get_Accel_Angles(void);
 void Get_Gyro_Rates(void);
+void Get_Raw_Values(short *accel, short *gyro, short *temperature);
 
 #endif
 
@@ -12,13 +12,23 @@
 #include "USB/usb_function_cdc.h"
 #include "HardwareProfile.h"
 #include "USBProcess.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "LockFreeRing.h"
 
 // Let compile time pre-processor calculate the CORE_TICK_PERIOD
 #define SYS_FREQ 				(80000000L)
 #define TOGGLES_PER_SEC			1000
 #define CORE_TICK_RATE	       (SYS_FREQ/2/TOGGLES_PER_SEC)
 
+// Byte rings between the USB interrupt and ProcessIO, powers of two
+#define RX_RING_SIZE			128
+#define TX_RING_SIZE			256
+
 /** P R I V A T E  P R O T O T Y P E S ***************************************/
+static void ProcessCommand(unsigned char c);
+static void FinishRateCommand(void);
 
 /** P R I V A T E  V A R I A B L E S *****************************************/
 char USB_In_Buffer[64];
@@ -27,8 +37,62 @@ char USB_Out_Buffer[64];
 // Decriments every 1 ms.
 volatile static unsigned int OneMSTimer;
 
+// Counts up every 1 ms, telemetry timestamps
+volatile static unsigned int MillisecondCount;
+
+// Telemetry IMU sample period, set with the 'f<hz>' command, 0 is off
+static unsigned int TelemetryPeriodMs = 1000 / TELEMETRY_DEFAULT_HZ;
+volatile static unsigned int TelemetryImuTimer;
+volatile static unsigned int TelemetryTimingTimer;
+
+// A part filled telemetry packet is sent once this runs out
+volatile static unsigned int TelemetryFlushTimer;
+
+#ifdef PROFILE_ENABLE
+// Profiler CSV dump, sent one endpoint packet at a time after a 'p' command
+static char ProfDump[PROF_CSV_SIZE];
+static int ProfDumpLength;
+static int ProfDumpSent;
+#endif
+
+#ifdef TRACE_ENABLE
+// Event trace dump in progress after a 't' command, bytes sent so far
+static BOOL TraceDumpActive;
+static int TraceDumpSent;
+#endif
+
+// Host commands from the USB interrupt, dump data to it
+static unsigned char RxData[RX_RING_SIZE];
+static unsigned char TxData[TX_RING_SIZE];
+static LfRing RxRing = LFRING_INIT(RxData);
+static LfRing TxRing = LFRING_INIT(TxData);
+
+// Set while a dump owns the link, telemetry packets wait until it is sent
+volatile static BOOL TxDumpActive;
+
+// 'f<hz>' in progress, finished by a non-digit or the end of the packet
+static BOOL RateCommand;
+static unsigned int RateValue;
+
+// Longest USB interrupt since the last report, core timer ticks
+volatile static unsigned int UsbIsrMaxTicks;
+
+// Counts down to the next time the core timer raises the USB interrupt
+volatile static unsigned int UsbServiceTimer;
+
 /** D E C L A R A T I O N S **************************************************/
 
+// Raises the USB interrupt when output waits for an idle IN endpoint. The
+// endpoint interrupts only as a transfer completes, so the first packet
+// after a quiet spell has to be started from here.
+static void KickTx(void)
+{
+	if ((USBDeviceState < CONFIGURED_STATE) || (USBSuspendControl == 1))
+		return;
+	if ((lfring_used(&TxRing) != 0 || tlm_queued() != 0) && USBUSARTIsTxTrfReady())
+		INTSetFlag(INT_USB);
+}
+
 /******************************************************************************
  * Function:        void UserInit(void)
  *
@@ -79,47 +143,228 @@ void UserInit(void)
  *
  * Note:            None
  *******************************************************************/
-void ProcessIO(int n)
+void ProcessIO(void)
 {
-	unsigned char numBytesRead = 0;
+	unsigned char c;
+	int numBytesRead = 0;
+
+	PROF_START(PROF_PROCESS_IO);
+	TRACE_BEGIN(TRACE_PROCESS_IO, 0);
 
     //Blink the LEDs according to the USB device status
     BlinkUSBStatus();
 
-    // User Application USB tasks
-    if (
-    	(USBDeviceState < CONFIGURED_STATE)
-    	||
-    	(USBSuspendControl == 1)
-    )
-    {
-	    return;
+	// Commands were pulled off the endpoint by the USB interrupt. A packet
+	// is published to the ring at once, so an empty ring ends the command.
+	while (lfring_get(&RxRing, &c, 1))
+	{
+		ProcessCommand(c);
+		numBytesRead++;
 	}
+	FinishRateCommand();
 
-	// Pull in some new data if there is new data to pull in
-	numBytesRead = getsUSBUSART (USB_In_Buffer,64);
-
-        sprintf (USB_Out_Buffer, "value is %d\r\n", n);
-        putUSBUSART (USB_Out_Buffer, strlen (USB_Out_Buffer));
-        
-        /*
-	if (numBytesRead != 0)
+	// Feed a dump in progress to the USB interrupt as the ring drains
+#ifdef PROFILE_ENABLE
+	if (ProfDumpSent < ProfDumpLength)
 	{
-		sprintf (USB_Out_Buffer, "value is %d\n", n);
-		putUSBUSART (USB_Out_Buffer, strlen (USB_Out_Buffer));
-		mLED_2_Toggle();
-		mLED_3_On();
-		OneMSTimer = 1000;
+		ProfDumpSent += lfring_put(&TxRing, &ProfDump[ProfDumpSent], ProfDumpLength - ProfDumpSent);
 	}
-	
-	if (!OneMSTimer)
+	else
+#endif
+#ifdef TRACE_ENABLE
+	if (TraceDumpActive)
 	{
-		mLED_3_Off();
-	}*/
+		unsigned char chunk[CDC_DATA_IN_EP_SIZE];
+		int length = lfring_free(&TxRing);
 
-    CDCTxService();
+		if (length > (int)sizeof(chunk))
+			length = sizeof(chunk);
+		if (length != 0)
+		{
+			length = trace_read(chunk, TraceDumpSent, length);
+			if (length != 0)
+			{
+				lfring_put(&TxRing, chunk, length);
+				TraceDumpSent += length;
+			}
+			else
+			{
+				trace_clear ();
+				trace_enable (1);
+				TraceDumpActive = FALSE;
+			}
+		}
+	}
+	else
+#endif
+	if (TxDumpActive && lfring_used(&TxRing) == 0)
+	{
+		TxDumpActive = FALSE;
+	}
+
+	KickTx();
+
+	TRACE_END(TRACE_PROCESS_IO, numBytesRead);
+	PROF_STOP(PROF_PROCESS_IO);
 }//end ProcessIO
 
+/********************************************************************
+ * Function:        static void ProcessCommand(unsigned char c)
+ *
+ * Overview:        Handles one byte of a host command.
+ *******************************************************************/
+static void ProcessCommand(unsigned char c)
+{
+	if (RateCommand)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			RateValue = RateValue * 10 + c - '0';
+			return;
+		}
+		FinishRateCommand();
+	}
+
+	switch (c)
+	{
+		case 'f':
+			// 'f<hz>' sets the telemetry IMU sample rate, f0 stops it
+			RateCommand = TRUE;
+			RateValue = 0;
+			break;
+#ifdef PROFILE_ENABLE
+		case 'p':
+			// dumps the profiler statistics as CSV
+			ProfDumpLength = prof_write_csv (ProfDump, sizeof (ProfDump));
+			ProfDumpSent = 0;
+			TxDumpActive = TRUE;
+			break;
+		case 'r':
+			prof_reset ();
+			break;
+#endif
+#ifdef TRACE_ENABLE
+		case 't':
+			// dumps the event trace as binary and then starts a new trace
+			trace_enable (0);
+			TraceDumpActive = TRUE;
+			TraceDumpSent = 0;
+			TxDumpActive = TRUE;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+static void FinishRateCommand(void)
+{
+	if (!RateCommand)
+		return;
+	RateCommand = FALSE;
+	TelemetryPeriodMs = (RateValue == 0) ? 0 : (RateValue > 1000) ? 1 : 1000 / RateValue;
+}
+
+/********************************************************************
+ * Function:        void USBPollDetached(void)
+ *
+ * Overview:        Called every main loop pass. Until the bus is
+ *                  seen the stack is polled from here, then the USB
+ *                  interrupt takes over all stack calls.
+ *
+ * Note:            The interrupt is masked while polling, so the
+ *                  stack never runs in both contexts at once.
+ *******************************************************************/
+void USBPollDetached(void)
+{
+	if (USBDeviceState != DETACHED_STATE)
+		return;
+
+	INTEnable(INT_USB, INT_DISABLED);
+	TRACE_BEGIN(TRACE_USB_TASKS, 0);
+	USBDeviceTasks();
+	TRACE_END(TRACE_USB_TASKS, 0);
+
+	if (USBDeviceState != DETACHED_STATE)
+	{
+		INTSetVectorPriority(INT_USB_1_VECTOR, USB_SERVICE_PRIORITY);
+		INTSetVectorSubPriority(INT_USB_1_VECTOR, INT_SUB_PRIORITY_LEVEL_0);
+		INTEnable(INT_USB, INT_ENABLED);
+	}
+}
+
+/********************************************************************
+ * Function:        unsigned int UsbIsrTakeMaxTicks(void)
+ *
+ * Overview:        Longest USB interrupt since the last call in core
+ *                  timer ticks, the maximum is cleared.
+ *******************************************************************/
+unsigned int UsbIsrTakeMaxTicks(void)
+{
+	unsigned int status = INTDisableInterrupts();
+	unsigned int ticks = UsbIsrMaxTicks;
+	UsbIsrMaxTicks = 0;
+	INTRestoreInterrupts(status);
+	return ticks;
+}
+
+/********************************************************************
+ * Function:        void USBInterruptHandler(void)
+ *
+ * Overview:        Services the stack and the CDC endpoints. Each
+ *                  pass moves at most one packet each way, so its
+ *                  length is bounded and below the core timer tick.
+ *                  Raised by the bus, by the core timer every
+ *                  USB_SERVICE_MS and by ProcessIO() when output
+ *                  waits for an idle endpoint.
+ *******************************************************************/
+void __ISR(_USB_1_VECTOR, ipl1) USBInterruptHandler(void)
+{
+	unsigned int start = ReadCoreTimer();
+	unsigned int ticks;
+	int length;
+
+	PROF_START(PROF_USB_ISR);
+	TRACE_BEGIN(TRACE_USB_TASKS, 0);
+
+	USBDeviceTasks();
+	INTClearFlag(INT_USB);
+
+	if ((USBDeviceState >= CONFIGURED_STATE) && (USBSuspendControl != 1))
+	{
+		// Leave data in the endpoint until there is room, the host
+		// is NAKed meanwhile
+		if (lfring_free(&RxRing) >= (int)sizeof(USB_In_Buffer))
+		{
+			length = getsUSBUSART(USB_In_Buffer, sizeof(USB_In_Buffer));
+			lfring_put(&RxRing, USB_In_Buffer, length);
+		}
+
+		if (USBUSARTIsTxTrfReady())
+		{
+			length = lfring_get(&TxRing, USB_Out_Buffer, CDC_DATA_IN_EP_SIZE);
+			if (length == 0 && !TxDumpActive)
+			{
+				// Coalesce queued telemetry records into one endpoint packet
+				length = tlm_next_packet((unsigned char *)USB_Out_Buffer, TelemetryFlushTimer == 0);
+				if (length != 0)
+					TelemetryFlushTimer = TELEMETRY_FLUSH_MS;
+			}
+			if (length != 0)
+				putUSBUSART(USB_Out_Buffer, length);
+		}
+
+		CDCTxService();
+	}
+
+	TRACE_END(TRACE_USB_TASKS, 0);
+	PROF_STOP(PROF_USB_ISR);
+
+	ticks = ReadCoreTimer() - start;
+	if (ticks > UsbIsrMaxTicks)
+		UsbIsrMaxTicks = ticks;
+}
+
 void __ISR(_CORE_TIMER_VECTOR, ipl2) CoreTimerHandler(void)
 {
     // clear the interrupt flag
@@ -130,6 +375,62 @@ void __ISR(_CORE_TIMER_VECTOR, ipl2) CoreTimerHandler(void)
 		OneMSTimer--;
 	}
 
+	MillisecondCount++;
+	if (TelemetryImuTimer)
+		TelemetryImuTimer--;
+	if (TelemetryTimingTimer)
+		TelemetryTimingTimer--;
+	if (TelemetryFlushTimer)
+		TelemetryFlushTimer--;
+
+	// Services the stack without bus traffic, a flush that fell due and a
+	// detach are seen within USB_SERVICE_MS
+	if (UsbServiceTimer)
+		UsbServiceTimer--;
+	if (UsbServiceTimer == 0 && USBDeviceState != DETACHED_STATE)
+	{
+		UsbServiceTimer = USB_SERVICE_MS;
+		INTSetFlag(INT_USB);
+	}
+
     // update the period
     UpdateCoreTimer(CORE_TICK_RATE);
 }
+
+/********************************************************************
+ * Function:        BOOL TelemetryImuDue(void)
+ *
+ * Overview:        TRUE once per telemetry sample period, the caller
+ *                  then queues one TLM_IMU record.
+ *******************************************************************/
+BOOL TelemetryImuDue(void)
+{
+	if (TelemetryPeriodMs == 0 || TelemetryImuTimer != 0)
+		return FALSE;
+	TelemetryImuTimer = TelemetryPeriodMs;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        BOOL TelemetryTimingDue(void)
+ *
+ * Overview:        TRUE once per second, the caller then queues one
+ *                  TLM_TIMING record.
+ *******************************************************************/
+BOOL TelemetryTimingDue(void)
+{
+	if (TelemetryTimingTimer != 0)
+		return FALSE;
+	TelemetryTimingTimer = 1000;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        unsigned int Millis(void)
+ *
+ * Overview:        Milliseconds since UserInit, for record timestamps.
+ *******************************************************************/
+unsigned int Millis(void)
+{
+	return MillisecondCount;
+}
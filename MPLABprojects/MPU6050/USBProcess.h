@@ -2,8 +2,26 @@
 #ifndef HelloUSBWorld_H
 #define HelloUSBWorld_H
 
+// Telemetry IMU records per second until changed with the 'f' command
+#define TELEMETRY_DEFAULT_HZ	100
+
+// Longest a part filled telemetry packet waits for more records
+#define TELEMETRY_FLUSH_MS		10
+
+// USB interrupt priority, below the core timer tick at 2
+#define USB_SERVICE_PRIORITY	INT_PRIORITY_LEVEL_1
+
+// Longest the USB interrupt goes unraised while attached. A NAKed IN token
+// raises nothing, so without this an idle link would leave output queued.
+#define USB_SERVICE_MS			1
+
 extern void UserInit(void);
-extern void ProcessIO(int n);
+extern void ProcessIO(void);
+extern void USBPollDetached(void);
+extern unsigned int UsbIsrTakeMaxTicks(void);
+extern BOOL TelemetryImuDue(void);
+extern BOOL TelemetryTimingDue(void);
+extern unsigned int Millis(void);
 
 #endif
 
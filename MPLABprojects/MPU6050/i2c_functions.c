@@ -69,6 +69,7 @@
 #include <stdlib.h>
 #include "i2c_functions.h"
 #include "shared.h"
+#include "Trace.h"
 
 void i2c_dly(void) {}
 
@@ -141,6 +142,7 @@ void LDByteWriteI2C(char address, char command_address, char command) {
 }
 
 void LDByteReadI2C(char address, char read_address, char * info, int test) {
+	TRACE_BEGIN(TRACE_I2C_READ, (unsigned char)read_address);
 	i2c_start();              // send start sequence
 	i2c_tx(0x68);             // SRF08 I2C address with R/W bit clear
 	i2c_tx(read_address);             // SRF08 light sensor register address
@@ -151,6 +153,7 @@ void LDByteReadI2C(char address, char read_address, char * info, int test) {
 	//char rangehigh = i2c_rx(1);    // get the high byte of the range and send acknowledge.
 	//char rangelow = i2c_rx(0);     // get low byte of the range - note we don't acknowledge the last byte.
 	i2c_stop();               // send stop sequence
+	TRACE_END(TRACE_I2C_READ, (unsigned char)*info);
 }
 
 
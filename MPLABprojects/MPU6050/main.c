@@ -54,6 +54,8 @@
 #include "MPU6050.h"
 #include "i2c_functions.h"
 #include "shared.h"
+#include "Trace.h"
+#include "Telemetry.h"
 
 /** V A R I A B L E S ********************************************************/
 #pragma udata
@@ -77,32 +79,61 @@ void BlinkUSBStatus(void);
 
 int main(void)
 {   
+    TlmTiming timing = {0};
+    unsigned int passStart, passTicks;
+
     InitializeSystem();
+    passStart = ReadCoreTimer();
 
     while(1)
     {
-		// Check bus status and service USB interrupts.
-        USBDeviceTasks(); // Interrupt or polling method.  If using polling, must call
-        				  // this function periodically.  This function will take care
-        				  // of processing and responding to SETUP transactions 
-        				  // (such as during the enumeration process when you first
-        				  // plug in).  USB hosts require that USB devices should accept
-        				  // and process SETUP packets in a timely fashion.  Therefore,
-        				  // when using polling, this function should be called 
-        				  // frequently (such as once about every 100 microseconds) at any
-        				  // time that a SETUP packet might reasonably be expected to
-        				  // be sent by the host to your device.  In most cases, the
-        				  // USBDeviceTasks() function does not take very long to
-        				  // execute (~50 instruction cycles) before it returns.
+        // The stack is polled here only until the bus is seen, after that
+        // the USB interrupt services it, so SETUP packets and the CDC
+        // endpoints no longer wait for a slow pass of this loop.
+        USBPollDetached();
     				  
 
 		// Application-specific tasks.
 		// Application related code may be added here, or in the ProcessIO() function.
+        if (TelemetryImuDue())
+        {
+            TlmImu sample;
+            short accel[3], gyro[3], temperature;
+            int i;
+
+            // Read into aligned locals, the packed record's halfwords may
+            // sit at odd addresses and Get_Raw_Values() stores whole ones
+            Get_Raw_Values(accel, gyro, &temperature);
+            sample.time = Millis();
+            for (i = 0; i < 3; i++)
+            {
+                sample.accel[i] = accel[i];
+                sample.gyro[i] = gyro[i];
+            }
+            sample.temperature = temperature;
+            tlm_put(TLM_IMU, &sample);
+        }
+
         Get_Accel_Angles();
 
-        int accel_angle = 10; //Where is the angle stored?
+        ProcessIO(); //USB CDC commands and binary telemetry to the PC
 
-        ProcessIO(accel_angle); //USB function to print stuff to putty Terminal        
+        // Main loop timing, reported once a second
+        passTicks = ReadCoreTimer() - passStart;
+        passStart += passTicks;
+        if (passTicks > timing.loopMaxTicks)
+            timing.loopMaxTicks = passTicks;
+        timing.loops++;
+        if (TelemetryTimingDue())
+        {
+            timing.time = Millis();
+            timing.dropped = tlm_take_dropped();
+            timing.queued = tlm_queued();
+            timing.usbIsrMaxTicks = UsbIsrTakeMaxTicks();
+            tlm_put(TLM_TIMING, &timing);
+            timing.loops = 0;
+            timing.loopMaxTicks = 0;
+        }
     }//end while
 }//end main
 
@@ -78,6 +78,10 @@
 //#define USB_PING_PONG_MODE USB_PING_PONG__ALL_BUT_EP0		//NOTE: This mode is not supported in PIC18F4550 family rev A3 devices
 
 
+// The stack is built for polling but is serviced from USBInterruptHandler()
+// in USBProcess.c once attached, not from the main loop. The firmware owns
+// the USB vector so the handler can be timed and bounded; USB_INTERRUPT
+// would compile in the stack's own handler instead.
 #define USB_POLLING
 //#define USB_INTERRUPT
 
@@ -0,0 +1,189 @@
+/* The robot controller's side of the gait engine (MPIDEprojects/libraries/
+   GaitEngine), the same engine the leg controller sketch runs. The modes,
+   the gaits, the balance, the calibration and the commands are the
+   engine's; here the IMU is read on the I2C bus of this board, frames go
+   out through the SSC-32 UART ring and the current budget's model is
+   corrected by the leg currents the ADC measures. */
+
+#include <plib.h>
+#include <string.h>
+#include "GenericTypeDefs.h"
+#include "ServoTable.h"
+#include "GaitEngine.h"
+#include "ReportGait.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "MPU6050.h"
+#include "Control.h"
+#include "Ssc32.h"
+#include "USBProcess.h"
+#include "Power.h"
+
+#if FRAME_TIME_MS != ENGINE_FRAME_MS
+#error "the control task must run at the gait engine's frame rate"
+#endif
+
+#define IMU_GYRO_RANGE			500		// gyro full scale set by Setup_MPU6050()
+
+#define TICKS_PER_US			40		// core timer at half of 80 MHz
+
+// The robot's servos, see GaitEngine.h
+SERVO_TABLE_DEFINE(ENGINE_SERVO_TABLE)
+
+static void PrintLine(const char *line);
+static void CalDefaults(ServoCal *cal);
+
+static const EngineConfig EngineSetup = {
+	NUM_SERVOS, servoChannel, &reportGait, IMU_GYRO_RANGE, PrintLine, CalDefaults
+};
+
+/** P R I V A T E  V A R I A B L E S *****************************************/
+
+static GaitEngine Engine;
+
+// Core timer at the last IMU sample
+static unsigned int ImuSampleTicks;
+
+// Reply text for the PC
+static char Reply[128];
+
+/** D E C L A R A T I O N S **************************************************/
+
+// One engine reply to the PC, cut to fit Reply
+static void PrintLine(const char *line)
+{
+	int length = strlen(line);
+
+	if (length > (int)sizeof(Reply) - 3)
+		length = sizeof(Reply) - 3;
+	memcpy(Reply, line, length);
+	strcpy(Reply + length, "\r\n");
+	UsbPrint(Reply);
+}
+
+// Calibration from the servo table, nothing saved until "calsave"
+static void CalDefaults(ServoCal *cal)
+{
+	int i;
+
+	servocal_init(cal, NUM_SERVOS);
+	for (i = 0; i < NUM_SERVOS; i++)
+	{
+		cal->neutral[i] = servoDef[i].neutral;
+		cal->minPulse[i] = servoDef[i].minPulse;
+		cal->maxPulse[i] = servoDef[i].maxPulse;
+		cal->dir[i] = servoDef[i].direction;
+		cal->gain[i] = servoDef[i].source == SERVO_HOLD ? 0 : 1000;
+	}
+	servocal_update(cal);
+}
+
+/********************************************************************
+ * Function:        void ControlInit(void)
+ *
+ * Overview:        Starts the gait engine, in direct mode at the
+ *                  calibrated neutral pose. The gyro zero is taken
+ *                  from the first samples, so the robot should be
+ *                  still at power up.
+ *******************************************************************/
+void ControlInit(void)
+{
+	engine_init(&Engine, &EngineSetup);
+	engine_imu_zero(&Engine);
+	ImuSampleTicks = ReadCoreTimer();
+}
+
+// Queues the pulses as one SSC-32 group move taking time ms
+static void SendFrame(const unsigned short *pulse, int time)
+{
+	char frame[SERVO_FRAME_SIZE(NUM_SERVOS)];
+	char *p = frame;
+	int i;
+
+	PROF_START(PROF_SEND_SSC32);
+	for (i = 0; i < NUM_SERVOS; i++)
+	{
+		*p++ = '#';
+		p = servo_put_uint(p, servoChannel[i]);
+		*p++ = ' ';
+		*p++ = 'P';
+		p = servo_put_uint(p, pulse[i]);
+		*p++ = ' ';
+	}
+	*p++ = 'T';
+	p = servo_put_uint(p, time);
+	Ssc32Send(frame, p - frame);
+	PROF_STOP(PROF_SEND_SSC32);
+}
+
+/********************************************************************
+ * Function:        void ControlTask(void)
+ *
+ * Overview:        One gait engine frame, run every FRAME_TIME_MS,
+ *                  sent when the engine has one. The leg currents of
+ *                  the last frame correct the budget's model, once
+ *                  there are readings.
+ *******************************************************************/
+void ControlTask(void)
+{
+	const PowerReading *power = PowerLatest();
+	unsigned short pulse[NUM_SERVOS];
+	unsigned int imuAge = (ReadCoreTimer() - ImuSampleTicks) / TICKS_PER_US;
+
+	if (engine_frame(&Engine, imuAge, power->count != 0 ? power->current : NULL, pulse))
+		SendFrame(pulse, FRAME_TIME_MS);
+}
+
+/********************************************************************
+ * Function:        void ImuTask(void)
+ *
+ * Overview:        Reads the MPU6050 every IMU_PERIOD_MS for the gait
+ *                  engine and queues a telemetry sample when one is
+ *                  due.
+ *******************************************************************/
+void ImuTask(void)
+{
+	unsigned int now = ReadCoreTimer();
+	short accel[3], gyro[3], temperature;
+	TlmImu sample;
+	int i;
+
+	// Read into aligned locals, the packed record's halfwords may sit at
+	// odd addresses and Get_Raw_Values() stores whole ones
+	TRACE_BEGIN(TRACE_I2C_READ, 0);
+	Get_Raw_Values(accel, gyro, &temperature);
+	TRACE_END(TRACE_I2C_READ, 0);
+
+	engine_imu_update(&Engine, accel, gyro, (now - ImuSampleTicks) / TICKS_PER_US);
+	ImuSampleTicks = now;
+
+	if (TelemetryImuDue())
+	{
+		sample.time = Millis();
+		for (i = 0; i < 3; i++)
+		{
+			sample.accel[i] = accel[i];
+			sample.gyro[i] = gyro[i];
+		}
+		sample.temperature = temperature;
+		tlm_put(TLM_IMU, &sample);
+	}
+}
+
+/********************************************************************
+ * Function:        void ControlCommand(const char *line)
+ *
+ * Overview:        Handles a gait engine command, the line without
+ *                  its end. Anything else goes to the SSC-32 as it
+ *                  is, as in the sketch, and the engine's next frame
+ *                  starts from wherever that leaves the servos.
+ *******************************************************************/
+void ControlCommand(const char *line)
+{
+	if (engine_command(&Engine, line))
+		return;
+	if (!Ssc32Send(line, strlen(line)))
+		UsbPrint("ssc32 queue full\r\n");
+	engine_servos_moved(&Engine);
+}
@@ -0,0 +1,15 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+// Servo frame period, the "control" task's period, ENGINE_FRAME_MS
+#define FRAME_TIME_MS			20
+
+// IMU sample period, the "imu" task's period
+#define IMU_PERIOD_MS			5
+
+extern void ControlInit(void);
+extern void ImuTask(void);
+extern void ControlTask(void);
+extern void ControlCommand(const char *line);
+
+#endif
@@ -0,0 +1,101 @@
+/********************************************************************
+ FileName:      HardwareProfile.h
+ Dependencies:  See INCLUDES section
+ Processor:     PIC18, PIC24, or PIC32 USB Microcontrollers
+ Hardware:      The code is natively intended to be used on the 
+                  following hardware platforms: 
+                    PICDEM FS USB Demo Board
+                    PIC18F46J50 FS USB Plug-In Module
+                    PIC18F87J50 FS USB Plug-In Module
+                    Explorer 16 + PIC24 or PIC32 USB PIMs
+                    PIC24F Starter Kit
+                    Low Pin Count USB Development Kit
+                  The firmware may be modified for use on other USB 
+                    platforms by editing this file (HardwareProfile.h)
+ Compiler:  	Microchip C18 (for PIC18), C30 (for PIC24), 
+                  or C32 (for PIC32)
+ Company:       Microchip Technology, Inc.
+
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the Company) for its PIC Microcontroller is intended and
+ supplied to you, the Companys customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN AS IS CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+********************************************************************
+ File Description:
+
+ Change History:
+  Rev   Date         Description
+  1.0   11/19/2004   Initial release
+  2.1   02/26/2007   Updated for simplicity and to use common
+                     coding style
+  2.3   09/15/2008   Broke out each hardware platform into its own
+                     "HardwareProfile - xxx.h" file
+********************************************************************/
+
+#ifndef HARDWARE_PROFILE_H
+#define HARDWARE_PROFILE_H
+
+//#define DEMO_BOARD USER_DEFINED_BOARD
+#define UBW32
+
+#if !defined(DEMO_BOARD)
+    #if defined(__C32__)
+        #if defined(__32MX460F512L__) || defined(__32MX795F512L__)
+            #if defined(PIC32MX460F512L_PIM)
+                #include "HardwareProfile - PIC32MX460F512L PIM.h"
+            #elif defined(PIC32_USB_STARTER_KIT)
+                #include "HardwareProfile - PIC32 USB Starter Kit.h"
+            #elif defined(UBW32)
+                #include "HardwareProfile - UBW32.h"
+            #endif
+        #endif
+    #endif
+
+    #if defined(__C30__)
+        #if defined(__PIC24FJ256GB110__)
+            #include "HardwareProfile - PIC24FJ256GB110 PIM.h"
+        #elif defined(__PIC24FJ256GB106__)
+            #include "HardwareProfile - PIC24F Starter Kit.h"
+        #elif defined(__PIC24FJ64GB004__)
+            #include "HardwareProfile - PIC24FJ64GB004 PIM.h"
+        #endif
+    #endif
+
+    #if defined(__18CXX)
+        #if defined(__18F4550)
+            #include "HardwareProfile - PICDEM FSUSB.h"
+        #elif defined(__18F87J50)
+            #include "HardwareProfile - PIC18F87J50 PIM.h"
+        #elif defined(__18F14K50)
+            #include "HardwareProfile - Low Pin Count USB Development Kit.h"
+        #elif defined(__18F46J50)
+            #if defined(PIC18F_STARTER_KIT_1)
+                #include "HardwareProfile - PIC18F Starter Kit 1.h"
+            #else
+                #include "HardwareProfile - PIC18F46J50 PIM.h"
+            #endif
+        #endif
+    #endif
+#endif
+
+#if !defined(DEMO_BOARD)
+    #error "Demo board not defined.  Either define DEMO_BOARD for a custom board or select the correct processor for the demo board."
+#endif
+
+#endif  //HARDWARE_PROFILE_H
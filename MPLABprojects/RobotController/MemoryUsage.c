@@ -0,0 +1,82 @@
+/* RAM and flash use of the running image, for the "mem" command.
+
+   RAM is the static data and bss below _end, the heap the linker reserved
+   and the deepest the stack has reached. The stack is measured by painting
+   the free RAM at start up and looking for the lowest word since written.
+   Flash is found by scanning down from the top of program flash for the
+   last word that is not erased, so it counts everything programmed, the
+   bootloader, the vectors and the saved calibration included. */
+
+#include <plib.h>
+#include <stdio.h>
+#include "GenericTypeDefs.h"
+#include "MemoryUsage.h"
+
+#define STACK_PAINT				0x5AA5C33Cu
+
+// Words left below the stack pointer when painting, for the painting call
+#define PAINT_MARGIN			16
+
+// Start of RAM and program flash, sizes from the bus matrix
+#define RAM_BASE				0xA0000000u
+#define FLASH_BASE				0x9D000000u
+
+// Linker script symbols, their addresses are the values
+extern unsigned int _end[];
+extern unsigned int _splim[];
+extern unsigned int _stack[];
+
+/********************************************************************
+ * Function:        void MemPaintStack(void)
+ *
+ * Overview:        Fills the RAM between the heap and the stack with
+ *                  a pattern. Call first thing in main(), before the
+ *                  stack has been deep.
+ *******************************************************************/
+void MemPaintStack(void)
+{
+	unsigned int *p = _splim;
+	unsigned int *sp = (unsigned int *)__builtin_frame_address(0) - PAINT_MARGIN;
+
+	while (p < sp)
+		*p++ = STACK_PAINT;
+}
+
+// Bytes from the stack top down to the lowest word written
+static unsigned int StackPeak(void)
+{
+	const unsigned int *p = _splim;
+
+	while (p < _stack && *p == STACK_PAINT)
+		p++;
+	return (unsigned int)_stack - (unsigned int)p;
+}
+
+// Bytes of program flash up to the last word programmed
+static unsigned int FlashUsed(void)
+{
+	const unsigned int *p = (const unsigned int *)(FLASH_BASE + BMXPFMSZ);
+
+	while (p > (const unsigned int *)FLASH_BASE && p[-1] == 0xFFFFFFFF)
+		p--;
+	return (unsigned int)p - FLASH_BASE;
+}
+
+/********************************************************************
+ * Function:        int MemWriteReport(char *buf, int size)
+ *
+ * Overview:        Writes "ram <static> <heap> <stack peak> of <size>"
+ *                  and "flash <used> of <size>" lines, in bytes.
+ *                  Returns the characters written. The flash scan
+ *                  takes a few ms, so it is for commands only.
+ *******************************************************************/
+int MemWriteReport(char *buf, int size)
+{
+	unsigned int data = (unsigned int)_end - RAM_BASE;
+	unsigned int heap = (unsigned int)_splim - (unsigned int)_end;
+	unsigned int stack = StackPeak();
+	unsigned int ram = BMXDRMSZ;
+
+	return snprintf(buf, size, "ram %u %u %u of %u, %u free\r\nflash %u of %u\r\n",
+		data, heap, stack, ram, ram - data - heap - stack, FlashUsed(), BMXPFMSZ);
+}
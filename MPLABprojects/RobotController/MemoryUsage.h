@@ -0,0 +1,10 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+// Longest report MemWriteReport() writes
+#define MEM_REPORT_SIZE			160
+
+extern void MemPaintStack(void);
+extern int MemWriteReport(char *buf, int size);
+
+#endif
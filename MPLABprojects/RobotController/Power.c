@@ -0,0 +1,193 @@
+/* Supply sensing: the leg servo currents and the two supply voltages,
+   scanned by ..\AdcAcquire.c at POWER_SCAN_HZ. The ADC interrupt only
+   keeps the raw scans; PowerTask() runs on every scheduler pass, averages
+   them POWER_OVERSAMPLE at a time through PowerSense and publishes a
+   reading for the control task and telemetry every 0.5 ms.
+
+   Latency is timed from the conversion of a reading's last scan to its
+   publishing. Scan n ends (n + 1) scan periods after AdcStart(); Timer3
+   and the core timer run from the same crystal, so that time is exact in
+   core timer ticks. */
+
+#include <plib.h>
+#include <stdio.h>
+#include <string.h>
+#include "GenericTypeDefs.h"
+#include "AdcAcquire.h"
+#include "PowerSense.h"
+#include "Telemetry.h"
+#include "Power.h"
+#include "USBProcess.h"
+
+#define TICKS_PER_US			40		// core timer at half of 80 MHz
+#define TICKS_PER_SCAN			(TICKS_PER_US * 1000000 / POWER_SCAN_HZ)
+
+// Scans taken from the ring at a time, the ring holds 32 ms of them
+#define SCANS_PER_READ			16
+
+// Readers of the latency, each with its own maximum
+#define LATENCY_TELEMETRY		0		// supply records
+#define LATENCY_REPORT			1		// "power"
+#define LATENCY_READERS			2
+
+/** P R I V A T E  V A R I A B L E S *****************************************/
+
+static PowerSense Sense;
+static PowerReading Latest;
+static BOOL Running;
+
+// Core timer at AdcStart(), scan 0 begins here
+static unsigned int StartTicks;
+
+// Longest scan to reading since each reader last took it, core timer ticks
+static unsigned int LatencyMaxTicks[LATENCY_READERS];
+
+// Reply text for the PC
+static char Reply[160];
+
+/********************************************************************
+ * Function:        void PowerInit(unsigned int pbClk)
+ *
+ * Overview:        Sets the channel scaling and filters and starts
+ *                  scanning. Call after AD1PCFG has been set, the
+ *                  inputs are made analog here.
+ *******************************************************************/
+void PowerInit(unsigned int pbClk)
+{
+	int leg;
+
+	psense_init(&Sense, POWER_NUM_CHANNELS, POWER_OVERSAMPLE);
+	for (leg = 0; leg < POWER_NUM_LEGS; leg++)
+		psense_set_channel(&Sense, POWER_RIGHT_LEG + leg, POWER_CURRENT_FULL_SCALE, POWER_CURRENT_OFFSET, POWER_CURRENT_SHIFT);
+	psense_set_channel(&Sense, POWER_SERVO_SUPPLY, POWER_SERVO_FULL_SCALE, 0, POWER_VOLTAGE_SHIFT);
+	psense_set_channel(&Sense, POWER_LOGIC_SUPPLY, POWER_LOGIC_FULL_SCALE, 0, POWER_VOLTAGE_SHIFT);
+	memset(&Latest, 0, sizeof(Latest));
+
+	Running = AdcInit(pbClk, POWER_CHANNEL_MASK);
+	StartTicks = ReadCoreTimer();
+	Running = Running && AdcStart(POWER_SCAN_HZ);
+}
+
+// Copies the readings out of the filters
+static void Publish(void)
+{
+	int leg;
+
+	for (leg = 0; leg < POWER_NUM_LEGS; leg++)
+	{
+		Latest.current[leg] = psense_value(&Sense, POWER_RIGHT_LEG + leg);
+		Latest.currentBlock[leg] = psense_block(&Sense, POWER_RIGHT_LEG + leg);
+	}
+	Latest.servoMv = psense_value(&Sense, POWER_SERVO_SUPPLY);
+	Latest.logicMv = psense_value(&Sense, POWER_LOGIC_SUPPLY);
+	Latest.ticks = ReadCoreTimer();
+	Latest.count = Sense.blocks;
+}
+
+/********************************************************************
+ * Function:        void PowerTask(void)
+ *
+ * Overview:        Runs on every scheduler pass. Filters the scans
+ *                  taken since the last pass, publishes the newest
+ *                  reading and queues a supply record when one is
+ *                  due.
+ *******************************************************************/
+void PowerTask(void)
+{
+	AdcScan scans[SCANS_PER_READ];
+	unsigned int firstEnd = 0, latency;
+	BOOL completed = FALSE;
+	TlmSupply supply;
+	int count, i, leg, reader;
+
+	do
+	{
+		count = AdcRead(scans, SCANS_PER_READ);
+		for (i = 0; i < count; i++)
+		{
+			if (psense_add(&Sense, scans[i].sample) && !completed)
+			{
+				// the oldest reading of this pass waited longest
+				firstEnd = StartTicks + (scans[i].index + 1) * TICKS_PER_SCAN;
+				completed = TRUE;
+			}
+		}
+	} while (count == SCANS_PER_READ);
+
+	if (completed)
+	{
+		Publish();
+		latency = Latest.ticks - firstEnd;
+		if (latency < 0x80000000u)
+			for (reader = 0; reader < LATENCY_READERS; reader++)
+				if (latency > LatencyMaxTicks[reader])
+					LatencyMaxTicks[reader] = latency;
+	}
+
+	if (TelemetrySupplyDue())
+	{
+		supply.time = Millis();
+		for (leg = 0; leg < POWER_NUM_LEGS; leg++)
+		{
+			supply.current[leg] = (short)Latest.current[leg];
+			supply.peak[leg] = (short)psense_take_peak(&Sense, POWER_RIGHT_LEG + leg);
+		}
+		supply.servoMv = (unsigned short)Latest.servoMv;
+		supply.logicMv = (unsigned short)Latest.logicMv;
+		supply.latencyMaxUs = (unsigned short)(LatencyMaxTicks[LATENCY_TELEMETRY] / TICKS_PER_US);
+		LatencyMaxTicks[LATENCY_TELEMETRY] = 0;
+		tlm_put(TLM_SUPPLY, &supply);
+	}
+}
+
+/********************************************************************
+ * Function:        const PowerReading *PowerLatest(void)
+ *
+ * Overview:        The newest readings, for the control task. They
+ *                  change only when PowerTask() runs, so a task can
+ *                  use them through a whole frame.
+ *******************************************************************/
+const PowerReading *PowerLatest(void)
+{
+	return &Latest;
+}
+
+// Prints the readings, the latency and the acquisition health
+static void PrintPower(void)
+{
+	AdcTiming timing;
+	int length;
+
+	AdcTakeTiming(&timing);
+	length = sprintf(Reply, "power %d %d mA, servo %d mV, logic %d mV\r\n",
+		Latest.current[0], Latest.current[1], Latest.servoMv, Latest.logicMv);
+	sprintf(Reply + length, "latency max %u us, adc isr max %u ns, %u scans, %u lost%s\r\n",
+		LatencyMaxTicks[LATENCY_REPORT] / TICKS_PER_US, timing.isrMaxNs, timing.scans, timing.overruns,
+		Running ? "" : ", not running");
+	LatencyMaxTicks[LATENCY_REPORT] = 0;
+	UsbPrint(Reply);
+}
+
+/********************************************************************
+ * Function:        BOOL PowerCommand(const char *line)
+ *
+ * Overview:        "power" prints the readings and how fresh they
+ *                  are, "powerzero" takes the present leg currents as
+ *                  zero, with the servos unpowered. FALSE for other
+ *                  lines.
+ *******************************************************************/
+BOOL PowerCommand(const char *line)
+{
+	int leg;
+
+	if (strcmp(line, "power") == 0)
+		PrintPower();
+	else if (strcmp(line, "powerzero") == 0)
+	{
+		for (leg = 0; leg < POWER_NUM_LEGS; leg++)
+			psense_zero(&Sense, POWER_RIGHT_LEG + leg);
+	}
+	else
+		return FALSE;
+	return TRUE;
+}
@@ -0,0 +1,54 @@
+#ifndef POWER_H
+#define POWER_H
+
+// ADC scans a second, every scan one sample of each input below
+#define POWER_SCAN_HZ			8000
+
+// Scans averaged into a reading, a new one every 0.5 ms
+#define POWER_OVERSAMPLE		4
+
+// Inputs in AN order: the right and left leg servo shunts on AN2 and AN3,
+// the servo battery divider on AN4 and the logic supply divider on AN8.
+// RB5 is left for the USB bus sense.
+#define POWER_CHANNEL_MASK		((1 << 2) | (1 << 3) | (1 << 4) | (1 << 8))
+
+enum PowerChannel {
+	POWER_RIGHT_LEG,
+	POWER_LEFT_LEG,
+	POWER_SERVO_SUPPLY,
+	POWER_LOGIC_SUPPLY,
+	POWER_NUM_CHANNELS
+};
+
+#define POWER_NUM_LEGS			2
+
+// Readings at a raw 1023, 3.3 V at the pin
+#define POWER_CURRENT_FULL_SCALE	10000	// mA, 10 mOhm shunt into a gain of 33
+#define POWER_SERVO_FULL_SCALE		16500	// mV, 40k over 10k divider
+#define POWER_LOGIC_FULL_SCALE		6600	// mV, 10k over 10k divider
+
+// Shunt amplifier output at no current, raw counts, until "powerzero"
+#define POWER_CURRENT_OFFSET	0
+
+// Filter shifts, about 2^n readings: currents follow a stall within a
+// millisecond, the battery reading rides through the dip of a step load
+#define POWER_CURRENT_SHIFT		1
+#define POWER_VOLTAGE_SHIFT		5
+
+// Latest readings, changed only by PowerTask()
+typedef struct
+{
+	unsigned int ticks;						// core timer when published
+	unsigned int count;						// readings since start up
+	int current[POWER_NUM_LEGS];			// filtered, mA
+	int currentBlock[POWER_NUM_LEGS];		// the last 0.5 ms unfiltered, mA
+	int servoMv;
+	int logicMv;
+} PowerReading;
+
+extern void PowerInit(unsigned int pbClk);
+extern void PowerTask(void);
+extern const PowerReading *PowerLatest(void);
+extern BOOL PowerCommand(const char *line);
+
+#endif
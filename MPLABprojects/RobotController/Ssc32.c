@@ -0,0 +1,122 @@
+/* SSC-32 servo controller on UART1, U1TX = F8. Frames are queued whole in
+   a byte ring and fed to the UART FIFO by its TX interrupt, so sending a
+   frame costs the copy instead of the 9 ms it takes on the wire. */
+
+#include <plib.h>
+#include "GenericTypeDefs.h"
+#include "Ssc32.h"
+#include "Trace.h"
+#include "LockFreeRing.h"
+
+/** P R I V A T E  V A R I A B L E S *****************************************/
+
+// Filled here, drained by the interrupt
+static unsigned char TxData[SSC32_RING_SIZE];
+static LfRing TxRing = LFRING_INIT(TxData);
+
+// Frames that did not fit since the last report
+static unsigned int Dropped;
+
+// Longest UART interrupt since the last report, core timer ticks
+volatile static unsigned int IsrMaxTicks;
+
+/********************************************************************
+ * Function:        void Ssc32Init(unsigned int pbClk)
+ *
+ * Overview:        Opens UART1 at SSC32_BAUDRATE, 8N1. The TX
+ *                  interrupt stays off until there is something to
+ *                  send.
+ *******************************************************************/
+void Ssc32Init(unsigned int pbClk)
+{
+	#define config1 UART_EN | UART_IDLE_CON | UART_RX_TX | UART_DIS_WAKE | UART_DIS_LOOPBACK | UART_DIS_ABAUD | UART_NO_PAR_8BIT | UART_1STOPBIT | UART_IRDA_DIS | UART_DIS_BCLK_CTS_RTS| UART_NORMAL_RX | UART_BRGH_SIXTEEN
+
+	// interrupt whenever the FIFO has room
+	#define config2	UART_TX_PIN_LOW | UART_RX_ENABLE | UART_TX_ENABLE | UART_INT_TX | UART_INT_RX_CHAR | UART_ADR_DETECT_DIS | UART_RX_OVERRUN_CLEAR
+
+	OpenUART1(config1, config2, pbClk/16/SSC32_BAUDRATE-1);
+
+	// above the core timer tick, so the FIFO does not run dry mid frame
+	ConfigIntUART1(UART_INT_PR3 | UART_RX_INT_DIS | UART_TX_INT_DIS);
+}
+
+/********************************************************************
+ * Function:        BOOL Ssc32Send(const char *command, int length)
+ *
+ * Overview:        Queues one command and its carriage return. A
+ *                  command that does not fit is dropped whole, the
+ *                  next frame supersedes it anyway.
+ *******************************************************************/
+BOOL Ssc32Send(const char *command, int length)
+{
+	TRACE_BEGIN(TRACE_SSC32_SEND, length);
+	if (length + 1 > lfring_free(&TxRing))
+	{
+		Dropped++;
+		TRACE_END(TRACE_SSC32_SEND, 0);
+		return FALSE;
+	}
+	lfring_put(&TxRing, command, length);
+	lfring_put(&TxRing, "\r", 1);
+	INTEnable(INT_U1TX, INT_ENABLED);
+	TRACE_END(TRACE_SSC32_SEND, 0);
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        unsigned int Ssc32TakeDropped(void)
+ *
+ * Overview:        Commands dropped since the last call.
+ *******************************************************************/
+unsigned int Ssc32TakeDropped(void)
+{
+	unsigned int dropped = Dropped;
+	Dropped = 0;
+	return dropped;
+}
+
+/********************************************************************
+ * Function:        unsigned int Ssc32IsrTakeMaxTicks(void)
+ *
+ * Overview:        Longest UART interrupt since the last call in core
+ *                  timer ticks, the maximum is cleared.
+ *******************************************************************/
+unsigned int Ssc32IsrTakeMaxTicks(void)
+{
+	unsigned int status = INTDisableInterrupts();
+	unsigned int ticks = IsrMaxTicks;
+	IsrMaxTicks = 0;
+	INTRestoreInterrupts(status);
+	return ticks;
+}
+
+/********************************************************************
+ * Function:        void Ssc32InterruptHandler(void)
+ *
+ * Overview:        Tops up the 8 byte TX FIFO from the ring and turns
+ *                  itself off once the ring is empty. The SSC-32 only
+ *                  answers queries, which are never sent, so there
+ *                  is no receive interrupt.
+ *******************************************************************/
+void __ISR(_UART1_VECTOR, ipl3) Ssc32InterruptHandler(void)
+{
+	unsigned int start = ReadCoreTimer();
+	unsigned int ticks;
+	unsigned char c;
+
+	if (INTGetFlag(INT_U1TX))
+	{
+		TRACE_BEGIN(TRACE_UART_TX_ISR, 0);
+		while (UARTTransmitterIsReady(UART1) && lfring_get(&TxRing, &c, 1))
+			UARTSendDataByte(UART1, c);
+
+		INTClearFlag(INT_U1TX);
+		if (lfring_used(&TxRing) == 0)
+			INTEnable(INT_U1TX, INT_DISABLED);
+		TRACE_END(TRACE_UART_TX_ISR, 0);
+	}
+
+	ticks = ReadCoreTimer() - start;
+	if (ticks > IsrMaxTicks)
+		IsrMaxTicks = ticks;
+}
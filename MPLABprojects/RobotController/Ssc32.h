@@ -0,0 +1,15 @@
+#ifndef SSC32_H
+#define SSC32_H
+
+// SSC-32 baud jumpers set to 115.2k, a 12 servo frame takes about 9 ms
+#define SSC32_BAUDRATE			115200
+
+// Bytes queued for the UART, a power of two holding a couple of frames
+#define SSC32_RING_SIZE			512
+
+extern void Ssc32Init(unsigned int pbClk);
+extern BOOL Ssc32Send(const char *command, int length);
+extern unsigned int Ssc32TakeDropped(void);
+extern unsigned int Ssc32IsrTakeMaxTicks(void);
+
+#endif
@@ -0,0 +1,469 @@
+/* USB CDC link of the robot controller, from MPU6050/USBProcess.c. The PC
+   sends the leg controller's text commands a line at a time; replies,
+   dumps and binary telemetry share the IN endpoint. */
+
+#include <string.h>
+#include "GenericTypeDefs.h"
+#include "Compiler.h"
+#include "usb_config.h"
+#include "USB/usb.h"
+#include "USB/usb_function_cdc.h"
+#include "HardwareProfile.h"
+#include "USBProcess.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "LockFreeRing.h"
+
+// Let compile time pre-processor calculate the CORE_TICK_PERIOD
+#define SYS_FREQ 				(80000000L)
+#define TOGGLES_PER_SEC			1000
+#define CORE_TICK_RATE	       (SYS_FREQ/2/TOGGLES_PER_SEC)
+
+// Byte rings between the USB interrupt and ProcessIO, powers of two
+#define RX_RING_SIZE			128
+#define TX_RING_SIZE			1024
+
+/** P R I V A T E  P R O T O T Y P E S ***************************************/
+static void ProcessLine(const char *line);
+
+/** P R I V A T E  V A R I A B L E S *****************************************/
+char USB_In_Buffer[64];
+char USB_Out_Buffer[64];
+
+// Decriments every 1 ms.
+volatile static unsigned int OneMSTimer;
+
+// Counts up every 1 ms, telemetry timestamps
+volatile static unsigned int MillisecondCount;
+
+// Telemetry IMU sample period, set with the 'f<hz>' command, 0 is off
+static unsigned int TelemetryPeriodMs = TELEMETRY_DEFAULT_HZ ? 1000 / TELEMETRY_DEFAULT_HZ : 0;
+volatile static unsigned int TelemetryImuTimer;
+volatile static unsigned int TelemetryTimingTimer;
+volatile static unsigned int TelemetrySupplyTimer;
+
+// A part filled telemetry packet is sent once this runs out
+volatile static unsigned int TelemetryFlushTimer;
+
+#ifdef PROFILE_ENABLE
+// Profiler CSV dump, sent one endpoint packet at a time after a 'p' command
+static char ProfDump[PROF_CSV_SIZE];
+static int ProfDumpLength;
+static int ProfDumpSent;
+#endif
+
+#ifdef TRACE_ENABLE
+// Event trace dump in progress after a 't' command, bytes sent so far
+static BOOL TraceDumpActive;
+static int TraceDumpSent;
+#endif
+
+// Host commands from the USB interrupt, dump data to it
+static unsigned char RxData[RX_RING_SIZE];
+static unsigned char TxData[TX_RING_SIZE];
+static LfRing RxRing = LFRING_INIT(RxData);
+static LfRing TxRing = LFRING_INIT(TxData);
+
+// Set while a dump owns the link, telemetry packets wait until it is sent
+volatile static BOOL TxDumpActive;
+
+// Command line being received, dropped when it outgrows the buffer
+static char CommandLine[COMMAND_LINE_SIZE];
+static int CommandLength;
+static BOOL CommandOverflow;
+
+// Longest USB interrupt since each reader last took it, core timer ticks
+volatile static unsigned int UsbIsrMaxTicks[USB_ISR_READERS];
+
+// Counts down to the next time the core timer raises the USB interrupt
+volatile static unsigned int UsbServiceTimer;
+
+/** D E C L A R A T I O N S **************************************************/
+
+// Raises the USB interrupt when output waits for an idle IN endpoint. The
+// endpoint interrupts only as a transfer completes, so the first packet
+// after a quiet spell has to be started from here.
+static void KickTx(void)
+{
+	if ((USBDeviceState < CONFIGURED_STATE) || (USBSuspendControl == 1))
+		return;
+	if ((lfring_used(&TxRing) != 0 || tlm_queued() != 0) && USBUSARTIsTxTrfReady())
+		INTSetFlag(INT_USB);
+}
+
+/******************************************************************************
+ * Function:        void UserInit(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This routine should take care of all of the demo code
+ *                  initialization that is required.
+ *
+ * Note:            
+ *
+ *****************************************************************************/
+void UserInit(void)
+{
+    //Initialize all of the LED pins
+	mInitAllLEDs();
+
+	// Open up the core timer at our 1ms rate
+	OpenCoreTimer(CORE_TICK_RATE);
+
+    // set up the core timer interrupt with a prioirty of 2 and zero sub-priority
+	mConfigIntCoreTimer((CT_INT_ON | CT_INT_PRIOR_2 | CT_INT_SUB_PRIOR_0));
+
+    // enable multi-vector interrupts
+	INTEnableSystemMultiVectoredInt();
+
+}//end UserInit
+
+/********************************************************************
+ * Function:        void ProcessIO(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function is a place holder for other user
+ *                  routines. It is a mixture of both USB and
+ *                  non-USB tasks.
+ *
+ * Note:            None
+ *******************************************************************/
+void ProcessIO(void)
+{
+	unsigned char c;
+	int numBytesRead = 0;
+
+	PROF_START(PROF_PROCESS_IO);
+	TRACE_BEGIN(TRACE_PROCESS_IO, 0);
+
+	// Commands were pulled off the endpoint by the USB interrupt, a line
+	// is handled once its end has arrived
+	while (lfring_get(&RxRing, &c, 1))
+	{
+		numBytesRead++;
+		if (c == '\r' || c == '\n')
+		{
+			CommandLine[CommandLength] = 0;
+			if (CommandLength != 0 && !CommandOverflow)
+				ProcessLine(CommandLine);
+			CommandLength = 0;
+			CommandOverflow = FALSE;
+		}
+		else if (CommandLength < COMMAND_LINE_SIZE - 1)
+			CommandLine[CommandLength++] = c;
+		else
+			CommandOverflow = TRUE;
+	}
+
+	// Feed a dump in progress to the USB interrupt as the ring drains
+#ifdef PROFILE_ENABLE
+	if (ProfDumpSent < ProfDumpLength)
+	{
+		ProfDumpSent += lfring_put(&TxRing, &ProfDump[ProfDumpSent], ProfDumpLength - ProfDumpSent);
+	}
+	else
+#endif
+#ifdef TRACE_ENABLE
+	if (TraceDumpActive)
+	{
+		unsigned char chunk[CDC_DATA_IN_EP_SIZE];
+		int length = lfring_free(&TxRing);
+
+		if (length > (int)sizeof(chunk))
+			length = sizeof(chunk);
+		if (length != 0)
+		{
+			length = trace_read(chunk, TraceDumpSent, length);
+			if (length != 0)
+			{
+				lfring_put(&TxRing, chunk, length);
+				TraceDumpSent += length;
+			}
+			else
+			{
+				trace_clear ();
+				trace_enable (1);
+				TraceDumpActive = FALSE;
+			}
+		}
+	}
+	else
+#endif
+	if (TxDumpActive && lfring_used(&TxRing) == 0)
+	{
+		TxDumpActive = FALSE;
+	}
+
+	KickTx();
+
+	TRACE_END(TRACE_PROCESS_IO, numBytesRead);
+	PROF_STOP(PROF_PROCESS_IO);
+}//end ProcessIO
+
+/********************************************************************
+ * Function:        static void ProcessLine(const char *line)
+ *
+ * Overview:        Handles the link's own commands, the telemetry
+ *                  rate and the dumps, and passes the rest on to
+ *                  ProcessCommand().
+ *******************************************************************/
+static void ProcessLine(const char *line)
+{
+	unsigned int rate;
+
+	TRACE_INSTANT(TRACE_COMMAND, strlen(line));
+	if (line[0] == 'f' && line[1] >= '0' && line[1] <= '9')
+	{
+		// 'f<hz>' sets the telemetry IMU sample rate, f0 stops it
+		rate = 0;
+		for (line++; *line >= '0' && *line <= '9'; line++)
+			rate = rate * 10 + *line - '0';
+		TelemetryPeriodMs = (rate == 0) ? 0 : (rate > 1000) ? 1 : 1000 / rate;
+	}
+#ifdef PROFILE_ENABLE
+	else if (strcmp(line, "prof") == 0)
+	{
+		// dumps the profiler statistics as CSV
+		ProfDumpLength = prof_write_csv (ProfDump, sizeof (ProfDump));
+		ProfDumpSent = 0;
+		TxDumpActive = TRUE;
+	}
+	else if (strcmp(line, "profreset") == 0)
+	{
+		prof_reset ();
+	}
+#endif
+#ifdef TRACE_ENABLE
+	else if (strcmp(line, "trace") == 0)
+	{
+		// dumps the event trace as binary and then starts a new trace
+		trace_enable (0);
+		TraceDumpActive = TRUE;
+		TraceDumpSent = 0;
+		TxDumpActive = TRUE;
+	}
+#endif
+	else
+	{
+		ProcessCommand(line);
+	}
+}
+
+/********************************************************************
+ * Function:        void UsbPrint(const char *text)
+ *
+ * Overview:        Queues a reply for the PC. Text that does not fit
+ *                  in the ring is dropped whole rather than waited
+ *                  for, so a closed terminal never stalls the
+ *                  control tasks, and so is text during a dump,
+ *                  which it would corrupt.
+ *******************************************************************/
+void UsbPrint(const char *text)
+{
+	if (!TxDumpActive)
+		lfring_put_all(&TxRing, text, strlen(text));
+}
+
+/********************************************************************
+ * Function:        void USBPollDetached(void)
+ *
+ * Overview:        Called every main loop pass. Until the bus is
+ *                  seen the stack is polled from here, then the USB
+ *                  interrupt takes over all stack calls.
+ *
+ * Note:            The interrupt is masked while polling, so the
+ *                  stack never runs in both contexts at once.
+ *******************************************************************/
+void USBPollDetached(void)
+{
+	if (USBDeviceState != DETACHED_STATE)
+		return;
+
+	INTEnable(INT_USB, INT_DISABLED);
+	TRACE_BEGIN(TRACE_USB_TASKS, 0);
+	USBDeviceTasks();
+	TRACE_END(TRACE_USB_TASKS, 0);
+
+	if (USBDeviceState != DETACHED_STATE)
+	{
+		INTSetVectorPriority(INT_USB_1_VECTOR, USB_SERVICE_PRIORITY);
+		INTSetVectorSubPriority(INT_USB_1_VECTOR, INT_SUB_PRIORITY_LEVEL_0);
+		INTEnable(INT_USB, INT_ENABLED);
+	}
+}
+
+/********************************************************************
+ * Function:        unsigned int UsbIsrTakeMaxTicks(int reader)
+ *
+ * Overview:        Longest USB interrupt since this reader's last
+ *                  call in core timer ticks, its maximum is cleared.
+ *                  The telemetry record and the "tasks" report each
+ *                  keep their own, USB_ISR_TELEMETRY and
+ *                  USB_ISR_REPORT, so neither clears the other's.
+ *******************************************************************/
+unsigned int UsbIsrTakeMaxTicks(int reader)
+{
+	unsigned int status = INTDisableInterrupts();
+	unsigned int ticks = UsbIsrMaxTicks[reader];
+	UsbIsrMaxTicks[reader] = 0;
+	INTRestoreInterrupts(status);
+	return ticks;
+}
+
+/********************************************************************
+ * Function:        void USBInterruptHandler(void)
+ *
+ * Overview:        Services the stack and the CDC endpoints. Each
+ *                  pass moves at most one packet each way, so its
+ *                  length is bounded and below the core timer tick.
+ *                  Raised by the bus, by the core timer every
+ *                  USB_SERVICE_MS and by ProcessIO() when output
+ *                  waits for an idle endpoint.
+ *******************************************************************/
+void __ISR(_USB_1_VECTOR, ipl1) USBInterruptHandler(void)
+{
+	unsigned int start = ReadCoreTimer();
+	unsigned int ticks;
+	int length, i;
+
+	PROF_START(PROF_USB_ISR);
+	TRACE_BEGIN(TRACE_USB_TASKS, 0);
+
+	USBDeviceTasks();
+	INTClearFlag(INT_USB);
+
+	if ((USBDeviceState >= CONFIGURED_STATE) && (USBSuspendControl != 1))
+	{
+		// Leave data in the endpoint until there is room, the host
+		// is NAKed meanwhile
+		if (lfring_free(&RxRing) >= (int)sizeof(USB_In_Buffer))
+		{
+			length = getsUSBUSART(USB_In_Buffer, sizeof(USB_In_Buffer));
+			lfring_put(&RxRing, USB_In_Buffer, length);
+		}
+
+		if (USBUSARTIsTxTrfReady())
+		{
+			length = lfring_get(&TxRing, USB_Out_Buffer, CDC_DATA_IN_EP_SIZE);
+			if (length == 0 && !TxDumpActive)
+			{
+				// Coalesce queued telemetry records into one endpoint packet
+				length = tlm_next_packet((unsigned char *)USB_Out_Buffer, TelemetryFlushTimer == 0);
+				if (length != 0)
+					TelemetryFlushTimer = TELEMETRY_FLUSH_MS;
+			}
+			if (length != 0)
+				putUSBUSART(USB_Out_Buffer, length);
+		}
+
+		CDCTxService();
+	}
+
+	TRACE_END(TRACE_USB_TASKS, 0);
+	PROF_STOP(PROF_USB_ISR);
+
+	ticks = ReadCoreTimer() - start;
+	for (i = 0; i < USB_ISR_READERS; i++)
+		if (ticks > UsbIsrMaxTicks[i])
+			UsbIsrMaxTicks[i] = ticks;
+}
+
+void __ISR(_CORE_TIMER_VECTOR, ipl2) CoreTimerHandler(void)
+{
+    // clear the interrupt flag
+    mCTClearIntFlag();
+
+	if (OneMSTimer)
+	{
+		OneMSTimer--;
+	}
+
+	MillisecondCount++;
+	if (TelemetryImuTimer)
+		TelemetryImuTimer--;
+	if (TelemetryTimingTimer)
+		TelemetryTimingTimer--;
+	if (TelemetrySupplyTimer)
+		TelemetrySupplyTimer--;
+	if (TelemetryFlushTimer)
+		TelemetryFlushTimer--;
+
+	// Services the stack without bus traffic, a flush that fell due and a
+	// detach are seen within USB_SERVICE_MS
+	if (UsbServiceTimer)
+		UsbServiceTimer--;
+	if (UsbServiceTimer == 0 && USBDeviceState != DETACHED_STATE)
+	{
+		UsbServiceTimer = USB_SERVICE_MS;
+		INTSetFlag(INT_USB);
+	}
+
+    // update the period
+    UpdateCoreTimer(CORE_TICK_RATE);
+}
+
+/********************************************************************
+ * Function:        BOOL TelemetryImuDue(void)
+ *
+ * Overview:        TRUE once per telemetry sample period, the caller
+ *                  then queues one TLM_IMU record.
+ *******************************************************************/
+BOOL TelemetryImuDue(void)
+{
+	if (TelemetryPeriodMs == 0 || TelemetryImuTimer != 0)
+		return FALSE;
+	TelemetryImuTimer = TelemetryPeriodMs;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        BOOL TelemetryTimingDue(void)
+ *
+ * Overview:        TRUE once per second while telemetry is on, the
+ *                  caller then queues one TLM_TIMING record.
+ *******************************************************************/
+BOOL TelemetryTimingDue(void)
+{
+	if (TelemetryPeriodMs == 0 || TelemetryTimingTimer != 0)
+		return FALSE;
+	TelemetryTimingTimer = 1000;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        BOOL TelemetrySupplyDue(void)
+ *
+ * Overview:        TRUE every TELEMETRY_SUPPLY_MS while telemetry is
+ *                  on, the caller then queues one TLM_SUPPLY record.
+ *******************************************************************/
+BOOL TelemetrySupplyDue(void)
+{
+	if (TelemetryPeriodMs == 0 || TelemetrySupplyTimer != 0)
+		return FALSE;
+	TelemetrySupplyTimer = TELEMETRY_SUPPLY_MS;
+	return TRUE;
+}
+
+/********************************************************************
+ * Function:        unsigned int Millis(void)
+ *
+ * Overview:        Milliseconds since UserInit, for record timestamps.
+ *******************************************************************/
+unsigned int Millis(void)
+{
+	return MillisecondCount;
+}
@@ -0,0 +1,43 @@
+#ifndef USBPROCESS_H
+#define USBPROCESS_H
+
+// Telemetry IMU records per second until changed with the 'f' command, off
+// at start up since the leg controller's text replies share the link
+#define TELEMETRY_DEFAULT_HZ	0
+
+// Longest a part filled telemetry packet waits for more records
+#define TELEMETRY_FLUSH_MS		10
+
+// Supply record interval while telemetry is on
+#define TELEMETRY_SUPPLY_MS		10
+
+// USB interrupt priority, below the core timer tick at 2
+#define USB_SERVICE_PRIORITY	INT_PRIORITY_LEVEL_1
+
+// Longest the USB interrupt goes unraised while attached. A NAKed IN token
+// raises nothing, so without this an idle link would leave output queued.
+#define USB_SERVICE_MS			1
+
+// Readers of the longest USB interrupt, each takes its own maximum
+#define USB_ISR_TELEMETRY		0
+#define USB_ISR_REPORT			1
+#define USB_ISR_READERS			2
+
+// Longest command line from the PC, longer ones are dropped
+#define COMMAND_LINE_SIZE		96
+
+extern void UserInit(void);
+extern void ProcessIO(void);
+extern void USBPollDetached(void);
+extern unsigned int UsbIsrTakeMaxTicks(int reader);
+extern BOOL TelemetryImuDue(void);
+extern BOOL TelemetryTimingDue(void);
+extern BOOL TelemetrySupplyDue(void);
+extern unsigned int Millis(void);
+extern void UsbPrint(const char *text);
+
+// Called by ProcessIO for every command line it does not handle itself,
+// without the line end
+extern void ProcessCommand(const char *line);
+
+#endif
@@ -0,0 +1,277 @@
+/********************************************************************
+ FileName:     main.c
+ Processor:    PIC32MX795F512L on the UBW32
+ Complier:     Microchip C32
+
+ Robot controller: the USB CDC link to the PC, the MPU6050 on I2C, the
+ SSC-32 on UART1 and the gait engine on one board, the jobs the leg
+ controller sketch and the MPU6050 project did on two. Every job is a
+ task of one cooperative scheduler, timed so "tasks" shows where each
+ millisecond goes and "mem" how much of the RAM and flash is left.
+ The leg currents and supply voltages are scanned by the ADC.
+
+ Task        Period      Job
+ power       every pass  supply readings from the ADC scans, telemetry
+ imu         5 ms        MPU6050 sample, attitude, IMU telemetry
+ control     20 ms       gait, balance and one SSC-32 frame
+ usb         every pass  USB attach, PC commands, telemetry packets
+ report      1 s         timing telemetry record
+********************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <plib.h>
+#include <stdio.h>
+#include <string.h>
+#include "GenericTypeDefs.h"
+#include "Compiler.h"
+#include "usb_config.h"
+#include "./USB/usb.h"
+#include "./USB/usb_function_cdc.h"
+
+#include "HardwareProfile.h"
+#include "USBProcess.h"
+#include "MPU6050.h"
+#include "i2c_functions.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
+#include "Control.h"
+#include "Ssc32.h"
+#include "MemoryUsage.h"
+#include "Power.h"
+
+/** V A R I A B L E S ********************************************************/
+#define SYSCLK 80000000L
+
+// Peripheral bus clock, SYSTEMConfigPerformance() divides SYSCLK by 1
+#define PBCLK SYSCLK
+
+// Timing telemetry interval
+#define REPORT_PERIOD_MS		1000
+
+static Scheduler Tasks;
+
+// Reply text for the PC, the longest is the "tasks" report
+static char Reply[SCHED_MAX_TASKS * 48 + 128];
+
+/** P R I V A T E  P R O T O T Y P E S ***************************************/
+static void InitializeSystem(void);
+static unsigned int CoreTicks(void);
+static void UsbTask(void);
+static void ReportTask(void);
+
+/** DECLARATIONS ***************************************************/
+
+int main(void)
+{
+	// before anything else has used the stack, so its peak can be found
+	MemPaintStack();
+	InitializeSystem();
+
+	sched_init(&Tasks, CoreTicks);
+	sched_add(&Tasks, "power", PowerTask, 0);
+	sched_add(&Tasks, "imu", ImuTask, IMU_PERIOD_MS * SCHED_TICKS_PER_MS);
+	sched_add(&Tasks, "control", ControlTask, FRAME_TIME_MS * SCHED_TICKS_PER_MS);
+	sched_add(&Tasks, "usb", UsbTask, 0);
+	sched_add(&Tasks, "report", ReportTask, REPORT_PERIOD_MS * SCHED_TICKS_PER_MS);
+
+	while(1)
+		sched_run(&Tasks);
+}//end main
+
+static void InitializeSystem(void)
+{
+	SYSTEMConfigPerformance(SYSCLK);
+
+	AD1PCFG = 0xFFFF;
+
+	#if defined(USE_USB_BUS_SENSE_IO)
+	tris_usb_bus_sense = INPUT_PIN; // See HardwareProfile.h
+	#endif
+
+	#if defined(USE_SELF_POWER_SENSE_IO)
+	tris_self_power = INPUT_PIN;	// See HardwareProfile.h
+	#endif
+
+	TRISDCLR = 0x0100;	// RD8 output
+	TRISESET = 0x0080;	// RE7 (PROG button) input
+
+	// bit-banged I2C lines released high, then the MPU6050 woken
+	SDA = SCL = 1;
+	SCL_IN = SDA_IN = 0;
+	Setup_MPU6050();
+
+	Ssc32Init(PBCLK);
+	PowerInit(PBCLK);
+	ControlInit();
+	UserInit();
+
+	USBDeviceInit();	//usb_device.c.  Initializes USB module SFRs and firmware
+						//variables to known states.
+
+	// Configure the proper PB frequency and the number of wait states
+	SYSTEMConfigWaitStatesAndPB(SYSCLK);
+
+	// Enable the cache for the best performance
+	CheKseg0CacheOn();
+
+	mJTAGPortEnable(0);
+	PMCONbits.ON = 0;
+}//end InitializeSystem
+
+// Scheduler clock, the core timer at SYSCLK / 2
+static unsigned int CoreTicks(void)
+{
+	return ReadCoreTimer();
+}
+
+/********************************************************************
+ * Function:        void UsbTask(void)
+ *
+ * Overview:        Runs on every scheduler pass. Polls the USB stack
+ *                  until the bus is seen, the USB interrupt services
+ *                  it after that, then handles PC commands and sends
+ *                  telemetry.
+ *******************************************************************/
+static void UsbTask(void)
+{
+	USBPollDetached();
+	ProcessIO();
+}
+
+/********************************************************************
+ * Function:        void ReportTask(void)
+ *
+ * Overview:        Queues a timing record when one is due. loops and
+ *                  loopMaxTicks are the scheduler's passes and its
+ *                  longest task this interval, as the MPU6050
+ *                  project's main loop reported them.
+ *******************************************************************/
+static void ReportTask(void)
+{
+	TlmTiming timing;
+	unsigned int longest = 0;
+	int i;
+
+	if (!TelemetryTimingDue())
+		return;
+	for (i = 0; i < Tasks.count; i++)
+		if (Tasks.task[i].maxTicks > longest)
+			longest = Tasks.task[i].maxTicks;
+	timing.time = Millis();
+	timing.loops = Tasks.passes;
+	timing.loopMaxTicks = longest;
+	timing.usbIsrMaxTicks = UsbIsrTakeMaxTicks(USB_ISR_TELEMETRY);
+	timing.dropped = tlm_take_dropped();
+	timing.queued = tlm_queued();
+	tlm_put(TLM_TIMING, &timing);
+	sched_reset_stats(&Tasks);
+}
+
+/********************************************************************
+ * Function:        void ProcessCommand(const char *line)
+ *
+ * Overview:        Called by ProcessIO() for every command line it
+ *                  does not handle itself. "tasks" prints the
+ *                  scheduler report and the interrupt times, "mem"
+ *                  the memory budget, "power" and "powerzero" go to
+ *                  the supply sensing and the rest to the gait engine,
+ *                  which passes what it does not know to the SSC-32.
+ *******************************************************************/
+void ProcessCommand(const char *line)
+{
+	int length;
+
+	if (strcmp(line, "tasks") == 0)
+	{
+		length = sched_write_report(&Tasks, Reply, sizeof(Reply));
+		sprintf(Reply + length, "usb isr max %u us\r\nssc32 isr max %u us, %u dropped\r\n",
+			UsbIsrTakeMaxTicks(USB_ISR_REPORT) / 40, Ssc32IsrTakeMaxTicks() / 40, Ssc32TakeDropped());
+		UsbPrint(Reply);
+	}
+	else if (strcmp(line, "tasksreset") == 0)
+		sched_reset_stats(&Tasks);
+	else if (strcmp(line, "mem") == 0)
+	{
+		MemWriteReport(Reply, sizeof(Reply));
+		UsbPrint(Reply);
+	}
+	else if (!PowerCommand(line))
+		ControlCommand(line);
+}
+
+/** USB CALLBACKS *************************************************/
+
+void USBCBSuspend(void){}
+
+void USBCBWakeFromSuspend(void){}
+
+void USBCB_SOF_Handler(void){}
+
+void USBCBErrorHandler(void){}
+
+void USBCBCheckOtherReq(void)
+{
+	USBCheckCDCRequest();
+}//end
+
+void USBCBStdSetDscHandler(void){}//end
+
+void USBCBInitEP(void)
+{
+	CDCInitEP();
+}
+
+void USBCBSendResume(void)
+{
+	static WORD delay_count;
+
+	USBResumeControl = 1;				// Start RESUME signaling
+
+	delay_count = 1800U;				// Set RESUME line for 1-13 ms
+	do
+	{
+		delay_count--;
+	}while(delay_count);
+	USBResumeControl = 0;
+}
+
+#if defined(ENABLE_EP0_DATA_RECEIVED_CALLBACK)
+void USBCBEP0DataReceived(void){}
+#endif
+
+BOOL USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, WORD size)
+{
+	switch(event)
+	{
+		case EVENT_CONFIGURED:
+			USBCBInitEP();
+			break;
+		case EVENT_SET_DESCRIPTOR:
+			USBCBStdSetDscHandler();
+			break;
+		case EVENT_EP0_REQUEST:
+			USBCBCheckOtherReq();
+			break;
+		case EVENT_SOF:
+			USBCB_SOF_Handler();
+			break;
+		case EVENT_SUSPEND:
+			USBCBSuspend();
+			break;
+		case EVENT_RESUME:
+			USBCBWakeFromSuspend();
+			break;
+		case EVENT_BUS_ERROR:
+			USBCBErrorHandler();
+			break;
+		case EVENT_TRANSFER:
+			Nop();
+			break;
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+
+/** EOF main.c *************************************************/
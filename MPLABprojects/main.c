@@ -1,30 +1,89 @@
 
+#include <stdio.h>
 #include "GenericTypeDefs.h"
 #include "Compiler.h"
 #include "HardwareProfile.h"
+#include "AdcAcquire.h"
+#include "Telemetry.h"
 
 // NOTE THAT BECAUSE WE USE THE BOOTLOADER, NO CONFIGURATION IS NECESSARY
 // THE BOOTLOADER PROJECT ACTUALLY CONTROLS ALL OF OUR CONFIG BITS
 
+// ADC sampling example. Timer3 triggers the ADC, AdcAcquire.c's interrupt
+// keeps the raw scans and this main loop sends them to the PC, as text
+// lines "a <AN4> <AN5>" or as binary Telemetry.h TLM_ADC packets that
+// PCprojects tlmrec records and decodes. Interrupts only move bytes, so
+// no rate keeps the UART RX interrupt waiting.
+//
+// Build with AdcAcquire.c and ..\MPIDEprojects\libraries\Telemetry\Telemetry.c,
+// that directory and ..\MPIDEprojects\libraries\LockFree on the include path.
+//
+// Commands, one character each:
+//     a, t 5 Hz    b 10 Hz    c 100 Hz    d 1 kHz    e 2 kHz    p stop
+//     x text       y binary   l acquisition report   w toggle LED3
+//
+// Text lines are dropped when the UART cannot keep up, about 1 kHz at
+// 115200 baud. Binary fits 2 kHz of two channels; faster scans need a
+// faster link or fewer channels.
+
 #define SYS_FREQ (80000000L)
 #define DESIRED_BAUDRATE (115200) // The desired rs232 BaudRate
 
-unsigned short int channel4;	// conversion result as read from result buffer
+// Inputs scanned, AN4 (B4) and AN5 (B5)
+#define ADC_CHANNEL_MASK ((1 << 4) | (1 << 5))
+
+// Scans taken from the acquisition ring per main loop pass
+#define SCANS_PER_PASS 16
+
+// A part filled binary record is sent once it is this old
+#define BATCH_FLUSH_MS 50
+
+// Bytes waiting for the UART, powers of two
+#define TX_RING_SIZE 2048
+#define RX_RING_SIZE 16
+
+// Keeps the compiler from moving ring accesses past the index updates
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+int hz5 = 5;
+int hz10 = 10;
+int hz100 = 100;
+int hz1k = 1000;
+int hz2k = 2000;
+
+// Free running byte counts, the main loop writes TX and the UART interrupt RX
+unsigned char TxRing[TX_RING_SIZE];
+volatile unsigned int TxHead, TxTail;
+unsigned char RxRing[RX_RING_SIZE];
+volatile unsigned int RxHead, RxTail;
+
+unsigned int scanRate;				// scans per second, 0 when stopped
+BOOL binaryOutput = FALSE;
+unsigned int linesDropped;			// text lines the UART had no room for
 
-char UART1_out_buffer[64];
-int hz5 = 62500; // 80000000/256/5
-int hz10 = 31250; // 80000000/256/10
-int hz100 = 3125; // 80000000/256/100
+TlmAdc batch;						// binary record being filled
+unsigned int batchFlushScans;		// scans a record may wait for more
 
 // functions
-void init_serial();
-void init_analog();
-void init_timer(int freq);
+void init_serial(unsigned int pbClk);
+void set_rate(unsigned int hz);
+void process_command(char command);
+void adc_task(void);
+void send_text_scan(const AdcScan *scan);
+void add_binary_scan(const AdcScan *scan);
+void put_batch(void);
+void send_packets(void);
+unsigned int tx_free(void);
+void tx_write(const void *data, unsigned int length);
+void print_report(void);
 
 int main(void)
-{   
+{
+	unsigned int pbClk;
+	char command;
+
     // Configure the proper PB frequency and the number of wait states
-	SYSTEMConfigPerformance(80000000L);
+	pbClk = SYSTEMConfigPerformance(SYS_FREQ);
 
 	// Turn off JTAG so we get the pins back
  	mJTAGPortEnable(0);
@@ -35,130 +94,228 @@ int main(void)
     // enable multi-vector interrupts
 	INTEnableSystemMultiVectoredInt();
 
-	init_serial();
-	init_timer(hz10);
-	init_analog();
+	init_serial(pbClk);
+	AdcInit(pbClk, ADC_CHANNEL_MASK);
+	set_rate(hz10);
 
     while(1)
     {
-		// empty, interrupt driven code	    
+		// commands from the UART interrupt
+		while (RxTail != RxHead)
+		{
+			command = RxRing[RxTail & (RX_RING_SIZE - 1)];
+			RING_BARRIER();
+			RxTail++;
+			process_command(command);
+		}
+
+		adc_task();
     }
 }
 
-// UART 1 interrupt handler, gets info from processing
-// it is set at priority level 1
+// UART 1 interrupt handler, gets info from processing and feeds the
+// transmitter, priority level 1. Received commands are queued for the main
+// loop, which is where they are acted on.
 void __ISR(_UART1_VECTOR, ipl1) IntUart1Handler(void)
 {
-	char data;
+	unsigned int tail;
+
 	// Is this an RX interrupt?
 	if(mU1RXGetIntFlag())
 	{
+		while (UARTReceivedDataIsAvailable(UART1))
+		{
+			if (RxHead - RxTail < RX_RING_SIZE)
+			{
+				RxRing[RxHead & (RX_RING_SIZE - 1)] = (unsigned char) ReadUART1();
+				RING_BARRIER();
+				RxHead++;
+			}
+			else
+				ReadUART1();
+		}
 		// Clear the RX interrupt Flag
 	    mU1RXClearIntFlag();
-
-		data = (char) ReadUART1();
-		
-		// Echo what we just received.
-		//putcUART1(data);
-		
-		if (data == 'a'){
-			init_timer(hz5);
-		}
-		else if (data == 'b'){
-			init_timer(hz10);
-		}
-		else if (data == 'c'){
-			init_timer(hz100);
-		}
-		else if (data == 'p'){
-			mT3IntEnable(0);
-		}
-		else if (data == 't'){
-			init_timer(hz5);
-		}
-		else if (data == 'w'){
-			mLED_3_Toggle();
-		}
 	}
 
-	// We don't care about TX interrupt
+	// Tops up the TX FIFO, off once the ring is empty
 	if ( mU1TXGetIntFlag() )
 	{
+		tail = TxTail;
+		while (tail != TxHead && UARTTransmitterIsReady(UART1))
+			UARTSendDataByte(UART1, TxRing[tail++ & (TX_RING_SIZE - 1)]);
+		RING_BARRIER();
+		TxTail = tail;
+
 		mU1TXClearIntFlag();
+		if (tail == TxHead)
+			INTEnable(INT_U1TX, INT_DISABLED);
 	}
 } // end UART1 interrupt
 
-// interrput code for the timer 3, priority level 2
-void __ISR( _TIMER_3_VECTOR, ipl2) T3Interrupt( void)
+void process_command(char command)
 {
-	// read analog
-	channel4 = ReadADC10(0); // read the result of channel 4
+	if (command == 'a'){
+		set_rate(hz5);
+	}
+	else if (command == 'b'){
+		set_rate(hz10);
+	}
+	else if (command == 'c'){
+		set_rate(hz100);
+	}
+	else if (command == 'd'){
+		set_rate(hz1k);
+	}
+	else if (command == 'e'){
+		set_rate(hz2k);
+	}
+	else if (command == 'p'){
+		set_rate(0);
+	}
+	else if (command == 't'){
+		set_rate(hz5);
+	}
+	else if (command == 'x'){
+		put_batch();
+		send_packets();
+		binaryOutput = FALSE;
+	}
+	else if (command == 'y'){
+		binaryOutput = TRUE;
+	}
+	else if (command == 'l'){
+		print_report();
+	}
+	else if (command == 'w'){
+		mLED_3_Toggle();
+	}
+}
+
+// Restarts acquisition at hz scans per second, 0 stops it
+void set_rate(unsigned int hz) {
+	adc_task();		// what the last rate left in the ring
+	put_batch();
+	AdcStop();
+	scanRate = 0;
+	if (hz != 0 && AdcStart(hz))
+		scanRate = hz;
+	batchFlushScans = hz * BATCH_FLUSH_MS / 1000;
+	if (batchFlushScans == 0)
+		batchFlushScans = 1;
+}
+
+// The deferred half of acquisition: encodes the scans the ADC interrupt
+// has kept and queues them for the UART
+void adc_task(void) {
+	AdcScan scans[SCANS_PER_PASS];
+	int count, i;
+
+	count = AdcRead(scans, SCANS_PER_PASS);
+	for (i = 0; i < count; i++)
+	{
+		if (binaryOutput)
+			add_binary_scan(&scans[i]);
+		else
+			send_text_scan(&scans[i]);
+	}
+	if (binaryOutput)
+		send_packets();
+}
+
+void send_text_scan(const AdcScan *scan) {
+	char line[8 + ADC_MAX_CHANNELS * 6];
+	int length, i;
+
+	length = sprintf(line, "a");
+	for (i = 0; i < AdcChannels(); i++)
+		length += sprintf(line + length, " %d", scan->sample[i]);
+	length += sprintf(line + length, "\r\n");
+
+	if (tx_free() < length)
+		linesDropped++;
+	else
+		tx_write(line, length);
+}
+
+// Appends a scan to the record being filled, sending it first if it is
+// full or the scan does not follow on
+void add_binary_scan(const AdcScan *scan) {
+	int channels = AdcChannels();
+	int i;
+
+	if (batch.count != 0 && (batch.count + channels > TLM_ADC_SAMPLES
+			|| scan->index != batch.scan + batch.count / channels))
+		put_batch();
+	if (batch.count == 0)
+	{
+		batch.scan = scan->index;
+		batch.rate = scanRate;
+		batch.channels = channels;
+	}
+	for (i = 0; i < channels; i++)
+		batch.sample[batch.count++] = scan->sample[i];
+	if (batch.count / channels >= batchFlushScans)
+		put_batch();
+}
+
+void put_batch(void) {
+	if (batch.count == 0)
+		return;
+	tlm_put(TLM_ADC, &batch);
+	batch.count = 0;
+}
 
-	sprintf(UART1_out_buffer,"a %d\r\n",channel4);
-	putsUART1(UART1_out_buffer);
+// Moves whole telemetry packets into the UART ring while they fit
+void send_packets(void) {
+	unsigned char packet[TLM_PACKET_SIZE];
+	int length;
+
+	while (tx_free() >= TLM_PACKET_SIZE && (length = tlm_next_packet(packet, 1)) != 0)
+		tx_write(packet, length);
+}
+
+unsigned int tx_free(void) {
+	return TX_RING_SIZE - (TxHead - TxTail);
+}
 
-	// clear interrupt flag and exit
-	mT3ClearIntFlag();
-} // end T3 Interrupt
+// Queues bytes for the UART interrupt, the caller checks they fit
+void tx_write(const void *data, unsigned int length) {
+	const unsigned char *bytes = (const unsigned char *)data;
+	unsigned int head = TxHead;
+	unsigned int i;
+
+	for (i = 0; i < length; i++)
+		TxRing[head++ & (TX_RING_SIZE - 1)] = bytes[i];
+	RING_BARRIER();
+	TxHead = head;
+	INTEnable(INT_U1TX, INT_ENABLED);
+}
 
-void init_serial() {
-	int	pbClk;
-	// Configure the system performance
-	pbClk = SYSTEMConfigPerformance(SYS_FREQ); 
+// Acquisition health since the last report, as one text line
+void print_report(void) {
+	AdcTiming timing;
+	char line[128];
+	int length;
+
+	AdcTakeTiming(&timing);
+	length = sprintf(line, "scans %u overruns %u latency max %u ns isr max %u ns lines dropped %u records dropped %d\r\n",
+		timing.scans, timing.overruns, timing.latencyMaxNs, timing.isrMaxNs, linesDropped, tlm_take_dropped());
+	linesDropped = 0;
+	if (tx_free() >= length)
+		tx_write(line, length);
+}
 
+void init_serial(unsigned int pbClk) {
 	// define setup Configuration 1 for OpenUARTx
 	#define config1 UART_EN | UART_IDLE_CON | UART_RX_TX | UART_DIS_WAKE | UART_DIS_LOOPBACK | UART_DIS_ABAUD | UART_NO_PAR_8BIT | UART_1STOPBIT | UART_IRDA_DIS | UART_DIS_BCLK_CTS_RTS| UART_NORMAL_RX | UART_BRGH_SIXTEEN
-	
+
 	// define setup Configuration 2 for OpenUARTx
 	#define config2	UART_TX_PIN_LOW | UART_RX_ENABLE | UART_TX_ENABLE | UART_INT_TX | UART_INT_RX_CHAR | UART_ADR_DETECT_DIS | UART_RX_OVERRUN_CLEAR
 
     // Open UART1 with config1 and config2
 	OpenUART1( config1, config2, pbClk/16/DESIRED_BAUDRATE-1); //U1RX=F2, U1TX=F8
 
-	// Configure UART1 RX Interrupt with priority 1
-	ConfigIntUART1(UART_INT_PR1 | UART_RX_INT_EN);
+	// Configure UART1 RX Interrupt with priority 1, TX turned on when there is output
+	ConfigIntUART1(UART_INT_PR1 | UART_RX_INT_EN | UART_TX_INT_DIS);
 } // end init serial
-
-void init_analog() {
-	// configure and enable the ADC
-	CloseADC10();	// ensure the ADC is off before setting the configuration
-
-	// define setup parameters for OpenADC10
-	// Turn module on | output in integer | trigger mode auto | enable  autosample
-	#define PARAM1  ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_AUTO | ADC_AUTO_SAMPLING_ON
-
-	// define setup parameters for OpenADC10
-	// ADC ref external    | disable offset test    | enable scan mode | perform 2 samples | use one buffer | use MUXA mode
-	#define PARAM2  ADC_VREF_AVDD_AVSS | ADC_OFFSET_CAL_DISABLE | ADC_SCAN_ON | ADC_SAMPLES_PER_INT_2 | ADC_ALT_BUF_OFF | ADC_ALT_INPUT_OFF
-
-	// define setup parameters for OpenADC10
-	// 				  use ADC internal clock | set sample time
-	#define PARAM3  ADC_CONV_CLK_INTERNAL_RC | ADC_SAMPLE_TIME_15
-
-	// define setup parameters for OpenADC10
-	// set AN4 
-	#define PARAM4	ENABLE_AN4_ANA
-
-	// define setup parameters for OpenADC10
-	// do not assign channels to scan
-	#define PARAM5	SKIP_SCAN_AN0 | SKIP_SCAN_AN1 | SKIP_SCAN_AN2 | SKIP_SCAN_AN3 | SKIP_SCAN_AN6 | SKIP_SCAN_AN7 | SKIP_SCAN_AN8 | SKIP_SCAN_AN9 | SKIP_SCAN_AN10 | SKIP_SCAN_AN11 | SKIP_SCAN_AN12 | SKIP_SCAN_AN13 | SKIP_SCAN_AN14 | SKIP_SCAN_AN15
-
-	// use ground as neg ref for A | use AN4 (B4) and AN5(B5) for input A
-	// configure to sample AN4
-	SetChanADC10( ADC_CH0_NEG_SAMPLEA_NVREF); // configure to sample AN4
-	OpenADC10( PARAM1, PARAM2, PARAM3, PARAM4, PARAM5 ); // configure ADC using parameter define above
-
-	EnableADC10(); // Enable the ADC
- 	while ( ! mAD1GetIntFlag() ) { } // wait for the first conversion to complete so there will be valid data in ADC result registers
-} // end init_analog
-
-void init_timer(int freq) {
-	// init Timer3 mode and period (PR3)
-	OpenTimer3( T3_ON | T3_PS_1_256 | T3_SOURCE_INT, freq); // 30Hz
-	mT3SetIntPriority( 2); 	// set Timer3 Interrupt Priority
-	mT3ClearIntFlag(); 		// clear interrupt flag
-	mT3IntEnable( 1);		// enable timer3 interrupts
-}
-
-
-
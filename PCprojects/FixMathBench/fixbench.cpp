@@ -0,0 +1,214 @@
+/*=============================================================================
+ * fixbench - accuracy and speed of the FixMath kernels against libm
+ *
+ * Usage:
+ *     fixbench
+ *
+ * Sweeps every kernel over its input range (exhaustively where the input is
+ * 16 bits) and reports the worst error against libm in double precision,
+ * then times each kernel and its libm equivalent on the same inputs. The
+ * error columns are what FixMath.h promises; a kernel that breaks its
+ * bound is flagged and the exit status is 1.
+ *
+ * Host timings only rank the kernels, the PIC32 has no FPU so the gap to
+ * soft float libm there is far larger. Use the firmware profiler for that.
+ *===========================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "FixMath.h"
+
+static const double TWO_PI = 6.283185307179586;
+
+static double angleToRad(int a)
+{
+    return (short)a * TWO_PI / 65536.0;
+}
+
+// Small deterministic generator so runs are comparable
+static unsigned int nextRandom()
+{
+    static unsigned int state = 12345;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double seconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int failures;
+
+static void report(const char *name, double worst, double bound, const char *unit)
+{
+    bool ok = worst <= bound;
+    printf("%-12s max error %10.4g %-4s bound %6.3g  %s\n", name, worst, unit, bound, ok ? "ok" : "FAIL");
+    if (!ok)
+        failures++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void checkAccuracy()
+{
+    double worst;
+
+    worst = 0;
+    for (int a = 0; a < 65536; a++) {
+        double s = std::min(sin(angleToRad(a)) * 32768.0, 32767.0);
+        double c = std::min(cos(angleToRad(a)) * 32768.0, 32767.0);
+        worst = std::max(worst, fabs(fx_sin(a) - s));
+        worst = std::max(worst, fabs(fx_cos(a) - c));
+    }
+    report("fx_sin/cos", worst, 1.5, "lsb");
+
+    worst = 0;
+    for (int i = 0; i < 4000000; i++) {
+        // magnitudes from a few counts up to the full int range
+        int shift = nextRandom() % 31;
+        int y = (int)nextRandom() >> shift;
+        int x = (int)nextRandom() >> shift;
+        if (x == 0 && y == 0)
+            continue;
+        double ref = atan2((double)y, (double)x) * 65536.0 / TWO_PI;
+        double err = fabs((short)fx_atan2(y, x) - ref);
+        if (err > 32768)
+            err = 65536 - err;
+        worst = std::max(worst, err);
+    }
+    report("fx_atan2", worst, 1.5, "lsb");
+
+    worst = 0;
+    for (int i = 0; i < 4000000; i++) {
+        unsigned int x = i < 70000 ? i : nextRandom() >> (nextRandom() % 32);
+        if (i == 70000)
+            x = 0xFFFFFFFFu;
+        unsigned long long r = fx_isqrt(x);
+        if (r * r > x || (r + 1) * (r + 1) <= x)
+            worst = 1;
+    }
+    report("fx_isqrt", worst, 0, "lsb");
+
+    worst = 0;
+    for (int i = 0; i < 4000000; i++) {
+        q16_t x = i < 70000 ? i : (q16_t)(nextRandom() >> (1 + nextRandom() % 31));
+        if (i == 70000)
+            x = 0x7FFFFFFF;
+        double ref = sqrt(x / 65536.0) * 65536.0;
+        worst = std::max(worst, fabs(fx_sqrt_q16(x) - ref));
+    }
+    report("fx_sqrt_q16", worst, 1, "lsb");
+
+    double worstRel = 0, worstAbs = 0;
+    for (q16_t x = -772243; x <= 681391; x += 3) {
+        double ref = exp(x / 65536.0) * 65536.0;
+        double err = fabs(fx_exp(x) - ref);
+        if (ref >= 65536.0)
+            worstRel = std::max(worstRel, err / ref);
+        else
+            worstAbs = std::max(worstAbs, err);
+    }
+    report("fx_exp", worstRel, 2e-5, "rel");
+    report("fx_exp <1", worstAbs, 1, "lsb");
+
+    worst = 0;
+    for (q16_t x = -40 * 65536; x <= 40 * 65536; x += 5) {
+        double ref = std::min(32768.0 / (1.0 + exp(-x / 65536.0)), 32767.0);
+        worst = std::max(worst, fabs(fx_sigmoid(x) - ref));
+    }
+    report("fx_sigmoid", worst, 1, "lsb");
+}
+
+/*---------------------------------------------------------------------------*/
+
+static const int N = 1 << 20;
+static const int PASSES = 20;
+
+// Runs body PASSES times over N inputs, returns ns per call
+#define TIME(body)                                          \
+    ({                                                      \
+        double start = seconds();                           \
+        for (int pass = 0; pass < PASSES; pass++)           \
+            for (int i = 0; i < N; i++) {                   \
+                body;                                       \
+            }                                               \
+        (seconds() - start) * 1e9 / ((double)N * PASSES);   \
+    })
+
+static void row(const char *name, double fixed, double libm, const char *libmName)
+{
+    printf("%-16s %7.2f ns   %-14s %7.2f ns   %5.2fx\n", name, fixed, libmName, libm, libm / fixed);
+}
+
+static void checkSpeed()
+{
+    std::vector<fx_angle> angle(N);
+    std::vector<double> rad(N), xd(N), yd(N), pos(N), expIn(N);
+    std::vector<float> radf(N);
+    std::vector<int> xi(N), yi(N);
+    std::vector<q16_t> posq(N), expq(N);
+    std::vector<q15_t> out(N), out2(N);
+    std::vector<fx_angle> outAngle(N);
+    volatile double sinkd = 0;
+    volatile int sinki = 0;
+
+    for (int i = 0; i < N; i++) {
+        angle[i] = nextRandom();
+        rad[i] = angleToRad(angle[i]);
+        radf[i] = (float)rad[i];
+        xi[i] = (int)(nextRandom() >> 8) - (1 << 23);
+        yi[i] = (int)(nextRandom() >> 8) - (1 << 23);
+        xd[i] = xi[i];
+        yd[i] = yi[i];
+        posq[i] = nextRandom() >> 1;
+        pos[i] = posq[i] / 65536.0;
+        expq[i] = (q16_t)(nextRandom() % 1400000) - 720000;
+        expIn[i] = expq[i] / 65536.0;
+    }
+
+    printf("\n%-16s %10s   %-14s %10s   %6s\n", "kernel", "time", "libm", "time", "speedup");
+    double acc = 0;
+    int acci = 0;
+
+    row("fx_sin", TIME(acci += fx_sin(angle[i])), TIME(acc += sin(rad[i])), "sin");
+    row("fx_sin", TIME(acci += fx_sin(angle[i])), TIME(acc += sinf(radf[i])), "sinf");
+    row("fx_atan2", TIME(acci += fx_atan2(yi[i], xi[i])), TIME(acc += atan2(yd[i], xd[i])), "atan2");
+    row("fx_sqrt_q16", TIME(acci += fx_sqrt_q16(posq[i])), TIME(acc += sqrt(pos[i])), "sqrt");
+    row("fx_isqrt", TIME(acci += fx_isqrt(posq[i])), TIME(acc += sqrt(pos[i])), "sqrt");
+    row("fx_exp", TIME(acci += fx_exp(expq[i])), TIME(acc += exp(expIn[i])), "exp");
+    row("fx_sigmoid", TIME(acci += fx_sigmoid(expq[i])), TIME(acc += 1 / (1 + exp(-expIn[i]))), "1/(1+exp)");
+
+    // batch kernels, one call per pass over the array
+    double start = seconds();
+    for (int pass = 0; pass < PASSES; pass++)
+        fx_sincos_batch(&angle[0], &out[0], &out2[0], N);
+    double batch = (seconds() - start) * 1e9 / ((double)N * PASSES);
+    row("fx_sincos_batch", batch, TIME(acc += sin(rad[i]) + cos(rad[i])), "sin+cos");
+
+    start = seconds();
+    for (int pass = 0; pass < PASSES; pass++)
+        fx_atan2_batch(&yi[0], &xi[0], &outAngle[0], N);
+    batch = (seconds() - start) * 1e9 / ((double)N * PASSES);
+    row("fx_atan2_batch", batch, TIME(acc += atan2(yd[i], xd[i])), "atan2");
+
+    sinkd = acc;
+    sinki = acci + out[N / 2] + out2[N / 3] + outAngle[N / 5];
+    (void)sinkd;
+    (void)sinki;
+}
+
+int main()
+{
+    checkAccuracy();
+    checkSpeed();
+    return failures ? 1 : 0;
+}
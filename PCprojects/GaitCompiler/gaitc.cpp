@@ -0,0 +1,94 @@
+/*=============================================================================
+ * gaitc - compiles a Fourier series gait into a flash pulse table
+ *
+ * Usage:
+ *     gaitc [-c coeffs.txt] [-p seconds] [-n samples] [-N name] [-o table.h]
+ *
+ * The walking gait is the report's Fourier series, see common/FourierGait.h.
+ * Its coefficients are built in; -c reads others from a file of
+ * assignments in the report's form, "a13L = 73.11;", any others left as
+ * they are. Without -p the cycle time is found as the shift that best
+ * repeats the motion, then one cycle is sampled with the mismatch at its
+ * ends ramped out so the table loops without a step.
+ *
+ * Each row is the six joints of a leg in JointType order, joints the
+ * series does not drive stay at 1500 (common/PulseTable.h). The output is
+ * a C header for libraries/GaitTable; the report on stderr gives the error
+ * of linear playback between rows, to choose -n by.
+ *===========================================================================*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "FourierGait.h"
+#include "PulseTable.h"
+
+static void usage()
+{
+    fprintf(stderr, "usage: gaitc [-c coeffs.txt] [-p seconds] [-n samples] [-N name] [-o table.h]\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *coeffPath = 0;
+    const char *outPath = 0;
+    std::string name = "reportGait";
+    double period = 0;
+    int samples = 256;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-c") == 0)
+            coeffPath = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "-p") == 0)
+            period = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+            samples = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-N") == 0)
+            name = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "-o") == 0)
+            outPath = argv[++i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    int bits = 0;
+    while ((1 << bits) < samples)
+        bits++;
+    if (samples < 2 || samples > 32768 || (1 << bits) != samples) {
+        fprintf(stderr, "gaitc: samples must be a power of two from 2 to 32768\n");
+        return 2;
+    }
+    FourierGait gait = reportGait();
+    if (coeffPath) {
+        int count = readCoefficients(coeffPath, gait);
+        if (count < 0) {
+            fprintf(stderr, "gaitc: cannot open %s\n", coeffPath);
+            return 1;
+        }
+        fprintf(stderr, "%d coefficients from %s\n", count, coeffPath);
+    }
+    if (period <= 0)
+        period = findPeriod(gait);
+
+    GaitCycle cycle(gait, period);
+    fprintf(stderr, "seam ramp: hip %.2f deg, knee %.2f deg over the cycle\n", cycle.seam[HIP3], cycle.seam[KNEE]);
+
+    PulseTable table = samplePulseTable(cycle, period, samples);
+    if (table.clamped)
+        fprintf(stderr, "gaitc: %d pulses held to 500..2500\n", table.clamped);
+    double worst = playbackError(table, cycle);
+    fprintf(stderr, "%d samples (%.2f ms apart), playback error up to %.2f us (%.2f deg)\n",
+            samples, period * 1000 / samples, worst, worst * 90 / 1000);
+
+    char rebuild[512];
+    snprintf(rebuild, sizeof(rebuild), "gaitc -p %.4f -n %d -N %s%s%s", period, samples, name.c_str(),
+             coeffPath ? " -c " : "", coeffPath ? coeffPath : "");
+    if (!writePulseTable(table, name, "gaitc", rebuild, outPath)) {
+        fprintf(stderr, "gaitc: cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*=============================================================================
+ * enginecheck - host checks of the gait engine's gait set handling
+ *
+ * Usage:
+ *     enginecheck
+ *
+ * Runs GaitEngine.c with a stand-in platform and checks that a gait set
+ * staged from the PC becomes active only where a gait cycle ends:
+ *
+ *     CPG walking, whose phase the foot contact and pitch corrections may
+ *     step back within a cycle. A back step mid-cycle must leave the
+ *     staged set waiting, and the next forward wrap must take it in.
+ *
+ * and that the "gait" command and gaitset_valid() refuse values the set's
+ * fields cannot hold or the CPG cannot run at. Any failure sets the exit
+ * status to 1.
+ *===========================================================================*/
+#include <cstdio>
+#include <cstring>
+
+#include "GaitEngine.h"
+
+// Leg servos only, on channels 0 to 11
+static const int SERVOS = NUM_LEG_SERVOS;
+static const unsigned char channel[SERVOS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+// A table mode gait that holds every joint at neutral
+static const unsigned short standPulse[2 * LEGIK_NUM_JOINTS] = {
+    1500, 1500, 1500, 1500, 1500, 1500,
+    1500, 1500, 1500, 1500, 1500, 1500
+};
+static const GaitTable standTable = { 2, 1, LEGIK_NUM_JOINTS, 400, standPulse };
+
+static char lastLine[128];
+
+static void print(const char *line)
+{
+    snprintf(lastLine, sizeof(lastLine), "%s", line);
+}
+
+static void calDefaults(ServoCal *cal)
+{
+    servocal_init(cal, SERVOS);
+    servocal_update(cal);
+}
+
+static const EngineConfig config = { SERVOS, channel, &standTable, 250, print, calDefaults };
+
+static GaitEngine engine;
+static unsigned short pulse[ENGINE_MAX_SERVOS];
+static int failures;
+
+static void check(const char *name, bool ok, const char *detail)
+{
+    printf("%-28s %-4s  %s\n", name, ok ? "ok" : "FAIL", detail);
+    if (!ok)
+        failures++;
+}
+
+static void frame()
+{
+    engine_frame(&engine, 0, 0, pulse);
+}
+
+// Frames until the right leg's phase is past at, at most limit of them
+static bool runTo(unsigned int at, int limit)
+{
+    while (limit-- > 0) {
+        frame();
+        if (engine.cpg.phase[RIGHT_LEG] >= at && engine.cpg.phase[RIGHT_LEG] < at + 0x10000000u)
+            return true;
+    }
+    return false;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void checkCpgBoundary()
+{
+    char detail[120];
+    int frames;
+
+    engine_init(&engine, &config);
+    engine_command(&engine, "cpg");
+    for (frames = 0; frames < 2000 && engine.mode != CPG_MODE; frames++)
+        frame();
+    if (engine.mode != CPG_MODE) {
+        check("cpg mode", false, "never left direct mode");
+        return;
+    }
+
+    // mid-cycle, a new period staged, then the phase stepped back
+    runTo(0x80000000u, 2000);
+    unsigned int period = gaitbank_active(&engine.gaits)->period;
+    engine_command(&engine, "gait 30 20 25");
+    cpg_correct(&engine.cpg, RIGHT_LEG, engine.cpg.phase[RIGHT_LEG] - 0x20000000u, 32768);
+    frame();
+    frame();
+    snprintf(detail, sizeof(detail), "active period %u, staged %s",
+             gaitbank_active(&engine.gaits)->period, engine.gaits.ready ? "waiting" : "taken");
+    check("back step keeps staged set", gaitbank_active(&engine.gaits)->period == period && engine.gaits.ready,
+          detail);
+
+    // the next forward wrap takes it
+    for (frames = 0; frames < 2000 && engine.gaits.ready; frames++)
+        frame();
+    snprintf(detail, sizeof(detail), "active period %u after %d frames, phase %08x",
+             gaitbank_active(&engine.gaits)->period, frames, engine.cpg.phase[RIGHT_LEG]);
+    check("forward wrap takes set", gaitbank_active(&engine.gaits)->period == 25
+          && engine.cpg.phase[RIGHT_LEG] < 0x40000000u, detail);
+}
+
+static void checkGaitCommand(const char *command, bool accepted)
+{
+    char detail[120];
+
+    engine_init(&engine, &config);
+    lastLine[0] = 0;
+    engine_command(&engine, command);
+    bool staged = engine.gaits.ready != 0;
+    snprintf(detail, sizeof(detail), "\"%s\" %s, replied \"%s\"", command, staged ? "staged" : "refused", lastLine);
+    check(accepted ? "gait command accepted" : "gait command refused", staged == accepted, detail);
+}
+
+static void checkValid()
+{
+    GaitSet set;
+    char detail[120];
+
+    engine_init(&engine, &config);
+    set = *gaitbank_active(&engine.gaits);
+    bool base = gaitset_valid(&set);
+    set.period = GAITSET_MAX_PERIOD + 1;
+    bool longPeriod = gaitset_valid(&set);
+    set = *gaitbank_active(&engine.gaits);
+    set.stepLength = GAITSET_MAX_STEP_LENGTH + 1;
+    bool longStep = gaitset_valid(&set);
+    set = *gaitbank_active(&engine.gaits);
+    set.stepHeight = GAITSET_MAX_STEP_HEIGHT + 1;
+    bool highStep = gaitset_valid(&set);
+
+    snprintf(detail, sizeof(detail), "default %d, period %d, step length %d, step height %d",
+             base, longPeriod, longStep, highStep);
+    check("gaitset_valid bounds", base && !longPeriod && !longStep && !highStep, detail);
+}
+
+int main()
+{
+    checkCpgBoundary();
+    checkGaitCommand("gait 30 20 25", true);
+    checkGaitCommand("gait 10 10 70000", false);
+    checkGaitCommand("gait 10 10 201", false);
+    checkGaitCommand("gait 4000 10 20", false);
+    checkGaitCommand("gait 10 -5 20", false);
+    checkValid();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
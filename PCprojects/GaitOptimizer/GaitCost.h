@@ -0,0 +1,295 @@
+/*=============================================================================
+ * Harmonic gaits and the leg simulation gaitopt scores them with
+ *
+ * The optimizer searches exact harmonics of one cycle of period T,
+ *     phi(t) = m + sum s_k sin(k w t) + c_k cos(k w t)    w = 2 pi / T
+ * for phi_3 and phi_4, the hip at phi_3 and the knee at phi_3 - phi_4 as in
+ * the report. The parameters are linear in the motion, which suits the
+ * search better than the fitted amplitudes, frequencies and phases, and the
+ * result loops without a seam. toFourier() turns a set back into the
+ * report's a sin(b t + c) terms for gaitc.
+ *
+ * simulateLeg() runs a cycle of the sagittal leg: hip and knee pitch with
+ * the thigh, shin and foot hanging as in libraries/LegIK and the ankle at
+ * neutral, as the table leaves it. The sole is on the ground while it is
+ * within a contact band of its lowest point. Point masses at the segments give the
+ * joint torques to carry and swing the leg, plus the body's weight through
+ * the stance foot; torque over stall torque, squared, stands in for the
+ * servo current.
+ *
+ * Costs, summed with weights:
+ *     limits    squared degrees past the joint limits, and squared speed
+ *               past the servo's, hard constraints
+ *     support   stance under half the cycle, so one of two legs in
+ *               anti-phase is always down
+ *     step      relative error of the stride and foot lift against targets
+ *     jerk      rms jerk of the joints, exact from the harmonics
+ *     current   mean current proxy
+ * jerk and current are relative to the starting gait, so their weights
+ * read as "this much worse is worth one unit".
+ *===========================================================================*/
+#ifndef __GAIT_COST_H__
+#define __GAIT_COST_H__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "FourierGait.h"
+
+// Length of a parameter set, the mean and harmonics of phi_3 then phi_4
+inline int harmonicParameters(int harmonics)
+{
+    return 2 * (1 + 2 * harmonics);
+}
+
+struct HarmonicGait {
+    int harmonics;
+    double period;
+    const double *p;
+
+    /*
+     * Value and first three time derivatives of series 0 (phi_3) or 1
+     * (phi_4), in degrees and seconds
+     */
+    void series(int which, double t, double d[4]) const
+    {
+        const double *q = p + which * (1 + 2 * harmonics);
+        double w = 2 * M_PI / period;
+        d[0] = q[0];
+        d[1] = d[2] = d[3] = 0;
+        for (int k = 1; k <= harmonics; k++) {
+            double kw = k * w;
+            double s = sin(kw * t), c = cos(kw * t);
+            double a = q[2 * k - 1], b = q[2 * k];
+            double v = a * s + b * c;           // the term
+            double u = a * c - b * s;           // its derivative over kw
+            d[0] += v;
+            d[1] += kw * u;
+            d[2] -= kw * kw * v;
+            d[3] -= kw * kw * kw * u;
+        }
+    }
+
+    // Joint angles in degrees, JointType order, as a PulseTable motion
+    void operator()(double t, double angle[NUM_JOINTS]) const
+    {
+        double phi3[4], phi4[4];
+        series(0, t, phi3);
+        series(1, t, phi4);
+        for (int j = 0; j < NUM_JOINTS; j++)
+            angle[j] = 0;
+        angle[HIP3] = phi3[0];
+        angle[KNEE] = phi3[0] - phi4[0];
+    }
+
+    // Mean square jerk over a cycle of series which, (deg/s^3)^2
+    double meanSquareJerk(int which) const
+    {
+        const double *q = p + which * (1 + 2 * harmonics);
+        double w = 2 * M_PI / period, sum = 0;
+        for (int k = 1; k <= harmonics; k++) {
+            double kw3 = pow(k * w, 3);
+            sum += kw3 * kw3 * (q[2 * k - 1] * q[2 * k - 1] + q[2 * k] * q[2 * k]) / 2;
+        }
+        return sum;
+    }
+};
+
+// Least squares harmonics of a periodic motion, sampled at 256 points a cycle
+template <class Motion>
+std::vector<double> fitHarmonics(const Motion &motion, double period, int harmonics)
+{
+    const int points = 256;
+    int per = 1 + 2 * harmonics;
+    std::vector<double> p(2 * per, 0.0);
+
+    for (int i = 0; i < points; i++) {
+        double t = period * i / points;
+        double angle[NUM_JOINTS];
+        motion(t, angle);
+        double value[2] = { angle[HIP3], angle[HIP3] - angle[KNEE] };
+        for (int which = 0; which < 2; which++) {
+            double *q = &p[which * per];
+            q[0] += value[which] / points;
+            for (int k = 1; k <= harmonics; k++) {
+                double x = 2 * M_PI * k * i / points;
+                q[2 * k - 1] += 2 * value[which] * sin(x) / points;
+                q[2 * k] += 2 * value[which] * cos(x) / points;
+            }
+        }
+    }
+    return p;
+}
+
+// The report's a sin(b t + c) form, the mean as the first term at b = 0
+inline FourierGait toFourier(const HarmonicGait &gait)
+{
+    FourierGait fourier;
+    for (int which = 0; which < 2; which++) {
+        const double *q = gait.p + which * (1 + 2 * gait.harmonics);
+        Series &s = which == 0 ? fourier.phi3 : fourier.phi4;
+        s.terms = gait.harmonics + 1;
+        s.a[0] = q[0];
+        s.b[0] = 0;
+        s.c[0] = M_PI / 2;
+        for (int k = 1; k <= gait.harmonics; k++) {
+            s.a[k] = hypot(q[2 * k - 1], q[2 * k]);
+            s.b[k] = 2 * M_PI * k / gait.period;
+            s.c[k] = atan2(q[2 * k], q[2 * k - 1]);
+        }
+    }
+    return fourier;
+}
+
+/*---------------------------------------------------------------------------*/
+
+struct LegModel {
+    double thigh, shin, ankleHeight;        // m, as LegParams
+    double thighMass, shinMass, footMass;   // kg, at the knee, ankle and sole
+    double bodyMass;                        // kg carried by the stance leg
+    double stallTorque;                     // N m
+    double hipMin, hipMax;                  // deg
+    double kneeMin, kneeMax;
+    double maxSpeed;                        // deg/s
+    double contactBand;                     // m above the lowest point still on the ground
+
+    // The leg in LegController: 100 mm links, HSR-5498SG servos
+    LegModel() :
+        thigh(0.100), shin(0.100), ankleHeight(0.040),
+        thighMass(0.080), shinMass(0.130), footMass(0.050), bodyMass(1.0),
+        stallTorque(1.3),
+        hipMin(-90), hipMax(90), kneeMin(0), kneeMax(135),
+        maxSpeed(270), contactBand(0.002) {}
+};
+
+struct GaitTargets {
+    double stepLength;      // m the foot travels on the ground
+    double stepHeight;      // m it lifts
+    double jerk;            // rms jerk and current of the starting gait, 0 to leave unscaled
+    double current;
+
+    GaitTargets() : stepLength(0.040), stepHeight(0.020), jerk(0), current(0) {}
+};
+
+struct CostWeights {
+    double step, jerk, current;
+
+    CostWeights() : step(10), jerk(1), current(1) {}
+};
+
+struct GaitScore {
+    double limits, support, step, jerk, current;
+    double total;
+
+    // what the terms were measured from
+    double stepLength, stepHeight, stance;  // m, m, fraction of the cycle
+    double rmsJerk, currentProxy;
+};
+
+/*
+ * One cycle at samples points. A few hundred points resolve the
+ * accelerations well for the harmonics a table plays back.
+ */
+inline GaitScore simulateLeg(const HarmonicGait &gait, const LegModel &leg, const GaitTargets &target,
+                             const CostWeights &weight, int samples = 128)
+{
+    const double deg = M_PI / 180, g = 9.81;
+    double dt = gait.period / samples;
+    std::vector<double> pos(samples * 6);     // knee, ankle and sole x, z
+    GaitScore score = GaitScore();
+
+    // kinematics, limits and speeds
+    double limits = 0;
+    for (int i = 0; i < samples; i++) {
+        double phi3[4], phi4[4];
+        gait.series(0, i * dt, phi3);
+        gait.series(1, i * dt, phi4);
+        double q3 = phi3[0], q4 = phi3[0] - phi4[0];
+        double v3 = phi3[1], v4 = phi3[1] - phi4[1];
+
+        limits += pow(std::max(0.0, leg.hipMin - q3), 2) + pow(std::max(0.0, q3 - leg.hipMax), 2);
+        limits += pow(std::max(0.0, leg.kneeMin - q4), 2) + pow(std::max(0.0, q4 - leg.kneeMax), 2);
+        limits += 0.01 * (pow(std::max(0.0, fabs(v3) - leg.maxSpeed), 2) +
+                          pow(std::max(0.0, fabs(v4) - leg.maxSpeed), 2));
+
+        // segments hang along -z, Ry(q) takes (0, -l) to (-l sin q, -l cos q)
+        double a = q3 * deg, b = (q3 + q4) * deg;
+        double *p = &pos[i * 6];
+        p[0] = -leg.thigh * sin(a);
+        p[1] = -leg.thigh * cos(a);
+        p[2] = p[0] - leg.shin * sin(b);
+        p[3] = p[1] - leg.shin * cos(b);
+        p[4] = p[2] - leg.ankleHeight * sin(b);
+        p[5] = p[3] - leg.ankleHeight * cos(b);
+    }
+    score.limits = limits / samples;
+
+    // contact, stride and lift
+    double lowest = 1e30, highest = -1e30;
+    for (int i = 0; i < samples; i++) {
+        lowest = std::min(lowest, pos[i * 6 + 5]);
+        highest = std::max(highest, pos[i * 6 + 5]);
+    }
+    std::vector<char> stance(samples);
+    double back = 1e30, front = -1e30;
+    int down = 0;
+    for (int i = 0; i < samples; i++) {
+        stance[i] = pos[i * 6 + 5] <= lowest + leg.contactBand;
+        if (stance[i]) {
+            down++;
+            back = std::min(back, pos[i * 6 + 4]);
+            front = std::max(front, pos[i * 6 + 4]);
+        }
+    }
+    score.stance = (double)down / samples;
+    score.stepLength = front - back;
+    score.stepHeight = highest - lowest;
+    score.support = pow(std::max(0.0, 0.5 - score.stance) / 0.5, 2);
+    score.step = pow((score.stepLength - target.stepLength) / target.stepLength, 2) +
+                 pow((score.stepHeight - target.stepHeight) / target.stepHeight, 2);
+
+    // torques the hip and knee carry: the leg's masses accelerated and held
+    // against gravity, and in stance the body's weight up through the sole
+    double current = 0;
+    for (int i = 0; i < samples; i++) {
+        int before = (i + samples - 1) % samples, after = (i + 1) % samples;
+        double force[3][2];
+        const double mass[3] = { leg.thighMass, leg.shinMass, leg.footMass };
+        for (int m = 0; m < 3; m++) {
+            double ax = (pos[after * 6 + 2 * m] - 2 * pos[i * 6 + 2 * m] + pos[before * 6 + 2 * m]) / (dt * dt);
+            double az = (pos[after * 6 + 2 * m + 1] - 2 * pos[i * 6 + 2 * m + 1] + pos[before * 6 + 2 * m + 1]) / (dt * dt);
+            force[m][0] = mass[m] * ax;
+            force[m][1] = mass[m] * (az + g);
+        }
+        if (stance[i])
+            force[2][1] -= leg.bodyMass * g;
+
+        // about y with x forward and z up, r x F is r_z F_x - r_x F_z
+        const double *p = &pos[i * 6];
+        double hipTorque = 0, kneeTorque = 0;
+        for (int m = 0; m < 3; m++) {
+            hipTorque += p[2 * m + 1] * force[m][0] - p[2 * m] * force[m][1];
+            if (m > 0)
+                kneeTorque += (p[2 * m + 1] - p[1]) * force[m][0] - (p[2 * m] - p[0]) * force[m][1];
+        }
+        current += pow(hipTorque / leg.stallTorque, 2) + pow(kneeTorque / leg.stallTorque, 2);
+    }
+    score.currentProxy = current / samples;
+
+    // jerk of the hip and the knee, phi_3 - phi_4, from the harmonics
+    int per = 1 + 2 * gait.harmonics;
+    std::vector<double> kneeSeries(per);
+    for (int k = 0; k < per; k++)
+        kneeSeries[k] = gait.p[k] - gait.p[per + k];
+    HarmonicGait kneeGait = { gait.harmonics, gait.period, &kneeSeries[0] };
+    score.rmsJerk = sqrt(gait.meanSquareJerk(0) + kneeGait.meanSquareJerk(0));
+
+    score.jerk = target.jerk > 0 ? score.rmsJerk / target.jerk : score.rmsJerk;
+    score.current = target.current > 0 ? score.currentProxy / target.current : score.currentProxy;
+    score.total = score.limits + 10 * score.support + weight.step * score.step +
+                  weight.jerk * score.jerk + weight.current * score.current;
+    return score;
+}
+
+#endif
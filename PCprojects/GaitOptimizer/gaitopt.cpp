@@ -0,0 +1,244 @@
+/*=============================================================================
+ * gaitopt - re-tunes the phi_3/phi_4 walking gait for a changed leg
+ *
+ * Usage:
+ *     gaitopt [options] [-o table.h] [-s coeffs.txt]
+ *
+ * Options, lengths in mm:
+ *     -c file     start from these coefficients instead of the report's
+ *     -p seconds  cycle time, found from the start gait by default
+ *     -k terms    harmonics per series, 1..7 (5)
+ *     -l length   stride on the ground (40)    -h height  foot lift (20)
+ *     -L t,s,a    thigh, shin and ankle height (100,100,40)
+ *     -J a,b,c,d  hip min, max and knee min, max in degrees (-90,90,0,135)
+ *     -v deg/s    servo speed (270)            -m kg      body mass (1)
+ *     -w s,j,c    weights of step, jerk and current (10,1,1)
+ *     -g gens     generations (300)            -P size    population (10 per parameter)
+ *     -j threads  0 for one per core (0)       -r seed    random seed (1)
+ *     -n samples  table rows (256)             -N name    table name (optimizedGait)
+ *
+ * The start gait, the report's by default, is fitted with harmonics of one
+ * cycle and refined by differential evolution (DE/rand-to-best/1/bin with
+ * a dithered scale) against the leg simulation and costs in GaitCost.h.
+ * Every generation's trial sets are drawn on the main thread and scored on
+ * a work-stealing pool, so a run depends on the seed and not on the number
+ * of threads.
+ *
+ * The best set goes out as a libraries/GaitTable header, like gaitc's, and
+ * with -s as coefficients in the report's form that gaitc -c reads back.
+ *===========================================================================*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FourierGait.h"
+#include "GaitCost.h"
+#include "ParseList.h"
+#include "PulseTable.h"
+#include "ThreadPool.h"
+
+static void printScore(const char *label, const GaitScore &s)
+{
+    fprintf(stderr,
+            "%-6s cost %8.4f  limits %.3f support %.3f step %.3f jerk %.3f current %.3f\n"
+            "       stride %.1f mm, lift %.1f mm, stance %.0f%%, jerk %.3g deg/s^3 rms\n",
+            label, s.total, s.limits, s.support, s.step, s.jerk, s.current,
+            s.stepLength * 1000, s.stepHeight * 1000, s.stance * 100, s.rmsJerk);
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: gaitopt [-c coeffs.txt] [-p seconds] [-k terms] [-l mm] [-h mm] [-L t,s,a]\n"
+            "               [-J hipmin,hipmax,kneemin,kneemax] [-v deg/s] [-m kg] [-w s,j,c]\n"
+            "               [-g gens] [-P size] [-j threads] [-r seed] [-n samples] [-N name]\n"
+            "               [-o table.h] [-s coeffs.txt]\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *coeffPath = 0, *outPath = 0, *savePath = 0;
+    std::string name = "optimizedGait";
+    double period = 0;
+    int harmonics = 5, generations = 300, population = 0, samples = 256;
+    unsigned threads = 0, seed = 1;
+    LegModel leg;
+    GaitTargets target;
+    CostWeights weight;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            usage();
+            return 2;
+        }
+        i++;
+        double list[4];
+        bool ok = true;
+        switch (argv[i - 1][1]) {
+        case 'c': coeffPath = value; break;
+        case 'p': period = atof(value); break;
+        case 'k': harmonics = atoi(value); break;
+        case 'l': target.stepLength = atof(value) / 1000; break;
+        case 'h': target.stepHeight = atof(value) / 1000; break;
+        case 'L':
+            ok = parseList(value, list, 3) == 3;
+            leg.thigh = list[0] / 1000;
+            leg.shin = list[1] / 1000;
+            leg.ankleHeight = list[2] / 1000;
+            break;
+        case 'J':
+            ok = parseList(value, list, 4) == 4;
+            leg.hipMin = list[0];
+            leg.hipMax = list[1];
+            leg.kneeMin = list[2];
+            leg.kneeMax = list[3];
+            break;
+        case 'v': leg.maxSpeed = atof(value); break;
+        case 'm': leg.bodyMass = atof(value); break;
+        case 'w':
+            ok = parseList(value, list, 3) == 3;
+            weight.step = list[0];
+            weight.jerk = list[1];
+            weight.current = list[2];
+            break;
+        case 'g': generations = atoi(value); break;
+        case 'P': population = atoi(value); break;
+        case 'j': threads = (unsigned)atoi(value); break;
+        case 'r': seed = (unsigned)atoi(value); break;
+        case 'n': samples = atoi(value); break;
+        case 'N': name = value; break;
+        case 'o': outPath = value; break;
+        case 's': savePath = value; break;
+        default: ok = false; break;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+    int bits = 0;
+    while ((1 << bits) < samples)
+        bits++;
+    if (samples < 2 || samples > 32768 || (1 << bits) != samples) {
+        fprintf(stderr, "gaitopt: samples must be a power of two from 2 to 32768\n");
+        return 2;
+    }
+    if (harmonics < 1 || harmonics > MAX_TERMS - 1 || generations < 0 ||
+        target.stepLength <= 0 || target.stepHeight <= 0) {
+        usage();
+        return 2;
+    }
+
+    // the start gait as harmonics of one cycle
+    FourierGait start = reportGait();
+    if (coeffPath) {
+        int count = readCoefficients(coeffPath, start);
+        if (count < 0) {
+            fprintf(stderr, "gaitopt: cannot open %s\n", coeffPath);
+            return 1;
+        }
+        fprintf(stderr, "%d coefficients from %s\n", count, coeffPath);
+    }
+    if (period <= 0)
+        period = findPeriod(start);
+    GaitCycle cycle(start, period);
+    std::vector<double> seedSet = fitHarmonics(cycle, period, harmonics);
+    int D = harmonicParameters(harmonics);
+
+    HarmonicGait seedGait = { harmonics, period, &seedSet[0] };
+    GaitScore first = simulateLeg(seedGait, leg, target, weight);
+    target.jerk = first.rmsJerk;
+    target.current = first.currentProxy;
+    first = simulateLeg(seedGait, leg, target, weight);
+    printScore("start", first);
+
+    // population about the start, spread a few degrees per coefficient
+    if (population <= 0)
+        population = 10 * D;
+    if (population < 4)
+        population = 4;
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> pop(population * D), trial(population * D);
+    std::vector<double> cost(population), trialCost(population);
+    for (int i = 0; i < population; i++)
+        for (int j = 0; j < D; j++)
+            pop[i * D + j] = seedSet[j] + (i == 0 ? 0 : (uniform(random) * 2 - 1) * 5);
+
+    ThreadPool pool(threads);
+    auto score = [&](const std::vector<double> &sets, std::vector<double> &costs) {
+        pool.parallelFor(population, 4, [&](size_t i) {
+            HarmonicGait gait = { harmonics, period, &sets[i * D] };
+            costs[i] = simulateLeg(gait, leg, target, weight).total;
+        });
+    };
+    fprintf(stderr, "%d parameters, population %d, %u threads\n", D, population, pool.size());
+
+    auto began = std::chrono::steady_clock::now();
+    score(pop, cost);
+    int best = 0;
+    for (int i = 1; i < population; i++)
+        if (cost[i] < cost[best])
+            best = i;
+
+    const double CR = 0.9;
+    for (int gen = 1; gen <= generations; gen++) {
+        for (int i = 0; i < population; i++) {
+            int r1, r2, r3;
+            do r1 = (int)(uniform(random) * population); while (r1 == i);
+            do r2 = (int)(uniform(random) * population); while (r2 == i || r2 == r1);
+            do r3 = (int)(uniform(random) * population); while (r3 == i || r3 == r1 || r3 == r2);
+            double F = 0.5 + 0.5 * uniform(random);
+            int forced = (int)(uniform(random) * D);
+            const double *x = &pop[i * D], *a = &pop[r1 * D], *b = &pop[r2 * D], *c = &pop[r3 * D];
+            const double *top = &pop[best * D];
+            for (int j = 0; j < D; j++) {
+                bool cross = uniform(random) < CR || j == forced;
+                trial[i * D + j] = cross ? a[j] + F * (top[j] - a[j]) + F * (b[j] - c[j]) : x[j];
+            }
+        }
+        score(trial, trialCost);
+        for (int i = 0; i < population; i++) {
+            if (trialCost[i] <= cost[i]) {
+                std::copy(&trial[i * D], &trial[i * D] + D, &pop[i * D]);
+                cost[i] = trialCost[i];
+                if (cost[i] < cost[best])
+                    best = i;
+            }
+        }
+        if (gen % 50 == 0 || gen == generations)
+            fprintf(stderr, "generation %4d  best %.4f\n", gen, cost[best]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    fprintf(stderr, "%d evaluations in %.2f s, %.0f per second\n", population * (generations + 1), seconds,
+            population * (generations + 1) / seconds);
+
+    HarmonicGait gait = { harmonics, period, &pop[best * D] };
+    printScore("best", simulateLeg(gait, leg, target, weight));
+
+    // export, the table as gaitc would write it and the coefficients for gaitc -c
+    PulseTable table = samplePulseTable(gait, period, samples);
+    if (table.clamped)
+        fprintf(stderr, "gaitopt: %d pulses held to 500..2500\n", table.clamped);
+    double worst = playbackError(table, gait);
+    fprintf(stderr, "%d samples (%.2f ms apart), playback error up to %.2f us (%.2f deg)\n",
+            samples, period * 1000 / samples, worst, worst * 90 / 1000);
+
+    if (savePath && !writeCoefficients(savePath, toFourier(gait))) {
+        fprintf(stderr, "gaitopt: cannot write %s\n", savePath);
+        return 1;
+    }
+    std::string rebuild = "gaitopt";
+    for (int i = 1; i < argc; i++)
+        rebuild += std::string(" ") + argv[i];
+    if (!writePulseTable(table, name, "gaitopt", rebuild, outPath)) {
+        fprintf(stderr, "gaitopt: cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*=============================================================================
+ * gaitup - changes the robot's gait parameters while it walks
+ *
+ * Usage:
+ *     gaitup <tty> [options]      read the active set, change it, upload
+ *     gaitup <tty> rollback       go back to the set before the last swap
+ *
+ * Options, lengths in mm:
+ *     -l length   step length            -k mHz      CPG leg coupling
+ *     -h height   step height            -o degrees  CPG left leg lead
+ *     -w width    stance width           -t ms       gait table cycle time
+ *     -s height   hip above the sole     -c          cycloid swing
+ *     -p steps    keyframes per cycle    -b          Bezier swing
+ *     -f frac     swing part of the cycle
+ *
+ * With no options the active set is printed. Otherwise it is changed,
+ * written to the pending set with "gpend" and committed with its CRC by
+ * "gcommit". The firmware checks the CRC and the ranges and swaps the set
+ * in at the end of the current gait cycle, so the robot keeps walking.
+ * The GaitSet layout comes from the firmware's GaitSet.h.
+ *===========================================================================*/
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "Crc16.h"
+#include "GaitSet.h"
+#include "SerialPort.h"
+
+// Reads lines until one starts with one of the prefixes, empty on timeout
+static std::string waitFor(SerialPort &port, const char *prefix1, const char *prefix2 = 0)
+{
+    std::string line;
+    time_t deadline = time(0) + 3;
+
+    while (time(0) < deadline) {
+        char ch;
+        long n = port.read(&ch, 1);
+        if (n < 0)
+            break;
+        if (n == 0)
+            continue;
+        if (ch != '\n') {
+            if (ch != '\r')
+                line += ch;
+            continue;
+        }
+        if (line.compare(0, strlen(prefix1), prefix1) == 0
+                || (prefix2 && line.compare(0, strlen(prefix2), prefix2) == 0))
+            return line;
+        line.clear();
+    }
+    return std::string();
+}
+
+static bool readActive(SerialPort &port, GaitSet *set)
+{
+    port.write("gget\n");
+    std::string line = waitFor(port, "gset ");
+    unsigned char *bytes = (unsigned char *)set;
+    unsigned int crc, byte;
+    size_t i;
+
+    if (line.size() < 5 + 2 * sizeof(GaitSet)) {
+        fprintf(stderr, "gaitup: no reply to gget\n");
+        return false;
+    }
+    for (i = 0; i < sizeof(GaitSet); i++) {
+        if (sscanf(line.c_str() + 5 + 2 * i, "%2x", &byte) != 1)
+            break;
+        bytes[i] = (unsigned char)byte;
+    }
+    if (i < sizeof(GaitSet) || sscanf(line.c_str() + 5 + 2 * sizeof(GaitSet), " %x", &crc) != 1
+            || crc != gaitset_crc(set)) {
+        fprintf(stderr, "gaitup: garbled gait set: %s\n", line.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void printSet(const GaitSet *set)
+{
+    printf("step length    %.1f mm\n", set->stepLength / 10.0);
+    printf("step height    %.1f mm\n", set->stepHeight / 10.0);
+    printf("stance width   %.1f mm\n", set->stanceWidth / 10.0);
+    printf("stand height   %.1f mm\n", set->standHeight / 10.0);
+    printf("period         %u keyframes\n", set->period);
+    printf("swing          %.3f, %s\n", set->swingFraction / 32768.0, set->swingShape ? "Bezier" : "cycloid");
+    printf("coupling       %u mHz, left leads by %.1f deg\n", set->coupling, set->couplingOffset * 360.0 / 65536);
+    printf("table period   %u ms\n", set->tablePeriodMs);
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: gaitup <tty> [-l mm] [-h mm] [-w mm] [-s mm] [-p steps] [-f frac] [-c|-b]\n"
+            "                    [-k mHz] [-o deg] [-t ms]\n"
+            "       gaitup <tty> rollback\n");
+}
+
+static short mm(const char *text)
+{
+    return (short)(atof(text) * 10 + (atof(text) < 0 ? -0.5 : 0.5));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    const char *tty = argv[1];
+    SerialPort port;
+    if (!port.open(tty, 200)) {
+        fprintf(stderr, "gaitup: cannot open %s: %s\n", tty, strerror(errno));
+        return 1;
+    }
+
+    if (argc == 3 && strcmp(argv[2], "rollback") == 0) {
+        port.write("grollback\n");
+        std::string reply = waitFor(port, "rollback", "no earlier");
+        printf("%s\n", reply.empty() ? "no reply" : reply.c_str());
+        return reply.compare(0, 8, "rollback") == 0 ? 0 : 1;
+    }
+
+    GaitSet set;
+    if (!readActive(port, &set))
+        return 1;
+    if (argc == 2) {
+        printSet(&set);
+        return 0;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const char *option = argv[i];
+        if (strcmp(option, "-c") == 0 || strcmp(option, "-b") == 0) {
+            set.swingShape = option[1] == 'b' ? 1 : 0;
+            continue;
+        }
+        if (option[0] != '-' || option[1] == 0 || option[2] != 0 || i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        const char *value = argv[++i];
+        switch (option[1]) {
+        case 'l': set.stepLength = mm(value); break;
+        case 'h': set.stepHeight = mm(value); break;
+        case 'w': set.stanceWidth = mm(value); break;
+        case 's': set.standHeight = mm(value); break;
+        case 'p': set.period = (unsigned short)atoi(value); break;
+        case 'f': set.swingFraction = (short)(atof(value) * 32768 + 0.5); break;
+        case 'k': set.coupling = (unsigned short)atoi(value); break;
+        case 'o': set.couplingOffset = (unsigned short)(int)(atof(value) * 65536 / 360); break;
+        case 't': set.tablePeriodMs = (unsigned short)atoi(value); break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (!gaitset_valid(&set)) {
+        fprintf(stderr, "gaitup: values out of range\n");
+        return 2;
+    }
+
+    // the whole set and the commit in one write, the firmware takes a line
+    // at a time and leaves the commit in its serial buffer meanwhile
+    std::string command = "gpend 0 ";
+    const unsigned char *bytes = (const unsigned char *)&set;
+    for (size_t i = 0; i < sizeof(GaitSet); i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", bytes[i]);
+        command += hex;
+    }
+    char commit[32];
+    snprintf(commit, sizeof(commit), "\ngcommit %04x\n", gaitset_crc(&set));
+    port.write(command + commit);
+
+    std::string reply = waitFor(port, "gait set");
+    printf("%s\n", reply.empty() ? "no reply" : reply.c_str());
+    if (reply != "gait set accepted")
+        return 1;
+    printSet(&set);
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*=============================================================================
+ * ikcheck - forward kinematics round trip of the LegIK solver
+ *
+ * Usage:
+ *     ikcheck [poses]
+ *
+ * Draws joint angles within the leg's limits (GaitEngine.c's nominal
+ * legParams), places the foot with legik_forward() and solves it back with
+ * legik_solve(). Every such pose is reachable within the limits, so the
+ * solver must report status 0 and its angles must put the foot back where
+ * it was. The worst position and orientation errors are reported against
+ * their bounds and any failure sets the exit status to 1.
+ *
+ * Three kinds of pose are left out, as none has one answer to check
+ * against: the hip within ANKLE_ROLL_SINGULAR of the ankle roll axis, where
+ * any ankle roll places the hip; a knee within KNEE_STRAIGHT of straight,
+ * where the knee angle is a square root of rounding noise; and a foot
+ * pitched within FOOT_PITCH_SINGULAR of a quarter turn, where FootPose's
+ * yaw and roll turn about the same axis. Each is counted.
+ *
+ * A few fixed poses then check the status bits: too far, too close and a
+ * foot turned past the hip's yaw limit.
+ *===========================================================================*/
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "LegIK.h"
+
+// Bounds on the round trip, 0.1 mm and binary angle LSBs
+static const int POSITION_BOUND = 10;
+static const int ANGLE_BOUND = 40;
+
+// Poses left out, 0.1 mm and degrees
+static const double ANKLE_ROLL_SINGULAR = 100;
+static const double KNEE_STRAIGHT = 10;
+static const double FOOT_PITCH_SINGULAR = 5;
+
+// Angles are drawn this far inside the limits, so rounding does not clamp
+static const fx_angle LIMIT_MARGIN = FX_DEG(1);
+
+// FX_DEG() as the signed limits, C++ does not narrow it silently
+#define LIMIT(x) ((short)FX_DEG(x))
+
+static const LegParams leg = {
+    LEGIK_MM(100), LEGIK_MM(100), LEGIK_MM(40),
+    { LIMIT(-45), LIMIT(-30), LIMIT(-90), LIMIT(0),   LIMIT(-45), LIMIT(-30) },
+    { LIMIT(45),  LIMIT(30),  LIMIT(90),  LIMIT(90),  LIMIT(45),  LIMIT(30) }
+};
+
+static const char *jointName[LEGIK_NUM_JOINTS] = { "hip1", "hip2", "hip3", "knee", "ankle1", "ankle2" };
+
+// Small deterministic generator so runs are comparable
+static unsigned int nextRandom()
+{
+    static unsigned int state = 12345;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double toRad(fx_angle a)
+{
+    return (short)a * M_PI / 32768.0;
+}
+
+// Foot rotation, yaw then pitch then roll as LegIK takes them
+static void footRotation(const FootPose &foot, double r[3][3])
+{
+    double cy = cos(toRad(foot.yaw)), sy = sin(toRad(foot.yaw));
+    double cp = cos(toRad(foot.pitch)), sp = sin(toRad(foot.pitch));
+    double cr = cos(toRad(foot.roll)), sr = sin(toRad(foot.roll));
+
+    r[0][0] = cy * cp; r[0][1] = cy * sp * sr - sy * cr; r[0][2] = cy * sp * cr + sy * sr;
+    r[1][0] = sy * cp; r[1][1] = sy * sp * sr + cy * cr; r[1][2] = sy * sp * cr - cy * sr;
+    r[2][0] = -sp;     r[2][1] = cp * sr;                r[2][2] = cp * cr;
+}
+
+// Angle of the rotation from one foot orientation to the other, in binary
+// angle LSBs. Compared as rotations, as yaw and roll alone mean nothing with
+// the foot pitched a quarter turn.
+static int orientationError(const FootPose &a, const FootPose &b)
+{
+    double ra[3][3], rb[3][3], trace = 0;
+
+    footRotation(a, ra);
+    footRotation(b, rb);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            trace += ra[i][j] * rb[i][j];
+    double c = (trace - 1) / 2;
+    return (int)(acos(c > 1 ? 1 : c < -1 ? -1 : c) * 32768.0 / M_PI + 0.5);
+}
+
+static void printAngles(const char *label, const fx_angle *angle)
+{
+    printf("    %-8s", label);
+    for (int j = 0; j < LEGIK_NUM_JOINTS; j++)
+        printf(" %s %7.2f", jointName[j], (short)angle[j] * 180.0 / 32768.0);
+    printf("\n");
+}
+
+static int failures;
+
+static void report(const char *name, int worst, int bound, const char *unit)
+{
+    bool ok = worst <= bound;
+    printf("%-20s max error %6d %-4s bound %6d  %s\n", name, worst, unit, bound, ok ? "ok" : "FAIL");
+    if (!ok)
+        failures++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void checkRoundTrip(int poses)
+{
+    int worstPosition = 0, worstAngle = 0, statusFailures = 0;
+    int singular = 0, straight = 0, pitched = 0, shown = 0;
+
+    for (int i = 0; i < poses; i++) {
+        fx_angle q[LEGIK_NUM_JOINTS], solved[LEGIK_NUM_JOINTS];
+        FootPose foot, back;
+
+        for (int j = 0; j < LEGIK_NUM_JOINTS; j++) {
+            int low = leg.minAngle[j] + LIMIT_MARGIN, high = leg.maxAngle[j] - LIMIT_MARGIN;
+            q[j] = (fx_angle)(low + (int)(nextRandom() % (unsigned)(high - low + 1)));
+        }
+
+        // height of the hip over the ankle in the ankle's pitch frame
+        double height = leg.shin * cos(toRad(q[4])) + leg.thigh * cos(toRad((fx_angle)(q[3] + q[4])));
+        if (fabs(height) < ANKLE_ROLL_SINGULAR) {
+            singular++;
+            continue;
+        }
+        if ((short)q[3] < FX_DEG(KNEE_STRAIGHT)) {
+            straight++;
+            continue;
+        }
+        short footPitch = (short)(fx_angle)(q[2] + q[3] + q[4]);
+        if (abs(abs(footPitch) - FX_DEG(90)) < FX_DEG(FOOT_PITCH_SINGULAR)) {
+            pitched++;
+            continue;
+        }
+
+        legik_forward(&leg, q, &foot);
+        int status = legik_solve(&leg, &foot, solved);
+        legik_forward(&leg, solved, &back);
+
+        int position = abs(back.x - foot.x) + abs(back.y - foot.y) + abs(back.z - foot.z);
+        int angle = orientationError(back, foot);
+
+        if (position > worstPosition)
+            worstPosition = position;
+        if (angle > worstAngle)
+            worstAngle = angle;
+        if (status != 0)
+            statusFailures++;
+
+        if ((status != 0 || position > POSITION_BOUND || angle > ANGLE_BOUND) && shown++ < 5) {
+            printf("  pose %d: status %d, foot %.1f mm and %d lsb off, hip %.1f mm over the ankle\n",
+                   i, status, position / 10.0, angle, height / 10.0);
+            printAngles("drawn", q);
+            printAngles("solved", solved);
+        }
+    }
+
+    printf("%d poses, left out %d near the ankle roll singularity, %d with the knee near straight,"
+           " %d with the foot near upright\n", poses, singular, straight, pitched);
+    report("status", statusFailures, 0, "pose");
+    report("foot position", worstPosition, POSITION_BOUND, "0.1mm");
+    report("foot orientation", worstAngle, ANGLE_BOUND, "lsb");
+}
+
+static void checkStatus(const char *name, int x, int y, int z, fx_angle yaw, int expected)
+{
+    FootPose foot = { x, y, z, yaw, 0, 0 };
+    fx_angle angle[LEGIK_NUM_JOINTS];
+    int status = legik_solve(&leg, &foot, angle);
+    bool ok = status == expected;
+
+    printf("%-20s status %d expected %d  %s\n", name, status, expected, ok ? "ok" : "FAIL");
+    if (!ok)
+        failures++;
+}
+
+int main(int argc, char **argv)
+{
+    int poses = argc > 1 ? atoi(argv[1]) : 200000;
+
+    if (poses <= 0) {
+        fprintf(stderr, "usage: ikcheck [poses]\n");
+        return 2;
+    }
+
+    checkRoundTrip(poses);
+
+    int standing = -(leg.thigh + leg.shin + leg.ankleHeight);
+    checkStatus("standing", 0, 0, standing, 0, 0);
+    checkStatus("too far", 0, 0, standing - LEGIK_MM(20), 0, LEGIK_UNREACHABLE);
+    checkStatus("too close", 0, 0, -leg.ankleHeight, 0, LEGIK_UNREACHABLE | LEGIK_LIMITED);
+    checkStatus("yaw past limit", 0, 0, standing + LEGIK_MM(20), FX_DEG(60), LEGIK_LIMITED);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,433 @@
+/*=============================================================================
+ * lfbench - stress test of the LockFree library with threads
+ *
+ * Usage:
+ *     lfbench [count]
+ *
+ * Runs each of the firmware's lock-free pieces with real threads standing
+ * in for the ISR and the main loop, count operations a test (10 million
+ * by default):
+ *
+ *     spsc      a producer pushes a numbered sequence, one at a time and in
+ *               batches, and the consumer checks every element arrives once
+ *               and in order
+ *     lfring    the same through LockFreeRing.h's C byte ring, the USB and
+ *               UART rings' write and read pattern
+ *     seqlock   a writer stores states whose fields all derive from one
+ *               number while readers check no copy mixes two writes; a
+ *               reader that hardly ever got a copy has tested nothing, so
+ *               each must succeed at least once per SEQ_READ_FLOOR writes
+ *     counter   threads add, take and raise a shared counter and the totals
+ *               must add up
+ *     flag      a spin lock built on AtomicFlag guards a plain counter
+ *     sfrbits   threads toggle their own bits of one shared word
+ *
+ * On the PIC32 the "threads" are an ISR preempting the main loop, one core
+ * and one order of stores; threads on a multi-core host are the harsher
+ * test of the same code. Any lost, duplicated, reordered or torn value
+ * is a failure and the exit status is 1. The rates printed are host
+ * numbers, only good for comparing changes. A side that finds the ring
+ * full or the lock taken yields, and the seqlock writer yields SEQ_YIELDS
+ * times in its run, so the test also runs on one core.
+ *===========================================================================*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "LockFree.h"
+
+static unsigned int count = 10000000;
+static int failures;
+
+static double seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static unsigned hostThreads()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n < 2 ? 2 : n > 8 ? 8 : n;
+}
+
+static void report(const char *name, bool ok, double elapsed, unsigned long long operations, const char *detail)
+{
+    printf("%-8s %-4s %8.1f Mops/s  %s\n", name, ok ? "ok" : "FAIL", operations / elapsed * 1e-6, detail);
+    if (!ok)
+        failures++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static SpscRing<unsigned int, 256> ring;
+
+static void spscProducer()
+{
+    unsigned int next = 0;
+    unsigned int batch[16];
+
+    while (next < count) {
+        // alternate single pushes and batches, as ISRs push samples and tasks push frames
+        if (next & 1024) {
+            unsigned int n = count - next < 16 ? count - next : 16;
+            for (unsigned int i = 0; i < n; i++)
+                batch[i] = next + i;
+            if (ring.push(batch, n))
+                next += n;
+            else
+                std::this_thread::yield();
+        }
+        else if (ring.push(next))
+            next++;
+        else
+            std::this_thread::yield();
+    }
+}
+
+static void testSpsc()
+{
+    unsigned int expected = 0, value, errors = 0;
+    unsigned int batch[24];
+    char detail[80];
+    double start = seconds();
+
+    std::thread producer(spscProducer);
+    while (expected < count) {
+        if (expected & 512) {
+            unsigned int n = ring.pop(batch, 24);
+            if (n == 0)
+                std::this_thread::yield();
+            for (unsigned int i = 0; i < n; i++)
+                if (batch[i] != expected++)
+                    errors++;
+        }
+        else if (ring.pop(value)) {
+            if (value != expected++)
+                errors++;
+        }
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+    double elapsed = seconds() - start;
+
+    snprintf(detail, sizeof(detail), "%u elements, %u out of sequence, %u left over",
+             count, errors, ring.size());
+    report("spsc", errors == 0 && ring.empty(), elapsed, count, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static unsigned char byteData[256];
+static LfRing byteRing = LFRING_INIT(byteData);
+
+// Bytes of a numbered sequence, in chunks of 1 to 37 as replies and frames
+static void lfringProducer()
+{
+    unsigned int next = 0;
+    unsigned char chunk[37];
+
+    while (next < count) {
+        unsigned int n = next % 37 + 1;
+        if (n > count - next)
+            n = count - next;
+        for (unsigned int i = 0; i < n; i++)
+            chunk[i] = (unsigned char)(next + i);
+        // whole chunks and partial puts in turn, as UsbPrint and the dumps
+        int put = next & 2048 ? (lfring_put_all(&byteRing, chunk, n) ? n : 0)
+                              : lfring_put(&byteRing, chunk, n);
+        if (put == 0)
+            std::this_thread::yield();
+        next += put;
+    }
+}
+
+static void testLfring()
+{
+    unsigned int expected = 0, errors = 0;
+    unsigned char buffer[64];
+    char detail[80];
+    double start = seconds();
+
+    std::thread producer(lfringProducer);
+    while (expected < count) {
+        // a byte at a time as the UART interrupt, an endpoint packet as the USB
+        int n = lfring_get(&byteRing, buffer, expected & 4096 ? 1 : 64);
+        if (n == 0)
+            std::this_thread::yield();
+        for (int i = 0; i < n; i++)
+            if (buffer[i] != (unsigned char)expected++)
+                errors++;
+    }
+    producer.join();
+    double elapsed = seconds() - start;
+
+    snprintf(detail, sizeof(detail), "%u bytes, %u out of sequence, %d left over",
+             count, errors, lfring_used(&byteRing));
+    report("lfring", errors == 0 && lfring_used(&byteRing) == 0, elapsed, count, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+// An IMU sample sized state, every field a function of n
+struct State {
+    unsigned int n;
+    short accel[3];
+    short gyro[3];
+    unsigned int check;
+};
+
+static State makeState(unsigned int n)
+{
+    State s;
+
+    s.n = n;
+    for (int i = 0; i < 3; i++) {
+        s.accel[i] = (short)(n * (i + 3));
+        s.gyro[i] = (short)(n ^ (0x5555u << i));
+    }
+    s.check = ~n * 2654435761u;
+    return s;
+}
+
+static bool consistent(const State &s)
+{
+    State ref = makeState(s.n);
+
+    for (int i = 0; i < 3; i++)
+        if (s.accel[i] != ref.accel[i] || s.gyro[i] != ref.gyro[i])
+            return false;
+    return s.check == ref.check;
+}
+
+static Seqlock<State> seqState;
+
+// Times the writer yields in a run, and writes per successful read a reader
+// must at least make
+static const unsigned int SEQ_YIELDS = 1000;
+static const unsigned int SEQ_READ_FLOOR = 10000;
+static volatile bool seqWriting;
+static AtomicCounter seqReaders;    // started, the writer waits for all
+
+struct ReaderResult {
+    unsigned long long reads, retries;
+    unsigned int torn, backwards;
+};
+
+static void seqReader(ReaderResult *result)
+{
+    unsigned int last = 0;
+    State s;
+
+    result->reads = result->retries = 0;
+    result->torn = result->backwards = 0;
+    seqReaders.increment();
+    while (seqWriting) {
+        if (!seqState.tryRead(s)) {
+            result->retries++;
+            continue;
+        }
+        result->reads++;
+        if (!consistent(s))
+            result->torn++;
+        if (s.n < last)
+            result->backwards++;
+        last = s.n;
+    }
+}
+
+static void testSeqlock()
+{
+    unsigned readers = hostThreads() - 1;
+    std::vector<ReaderResult> results(readers);
+    std::vector<std::thread> threads;
+    unsigned long long reads = 0, retries = 0, fewest = ~0ull;
+    unsigned int torn = 0, backwards = 0;
+    unsigned long long floor = count / SEQ_READ_FLOOR ? count / SEQ_READ_FLOOR : 1;
+    unsigned int yieldWrites = count / SEQ_YIELDS;
+    char detail[160];
+
+    seqState.write(makeState(0));
+    seqWriting = true;
+    double start = seconds();
+    for (unsigned i = 0; i < readers; i++)
+        threads.push_back(std::thread(seqReader, &results[i]));
+    while (seqReaders.load() < readers)
+        std::this_thread::yield();
+    for (unsigned int n = 1; n <= count; n++) {
+        seqState.write(makeState(n));
+        // between writes, so a reader sharing the core sees whole ones
+        if (n % yieldWrites == 0)
+            std::this_thread::yield();
+    }
+    seqWriting = false;
+    for (unsigned i = 0; i < readers; i++) {
+        threads[i].join();
+        reads += results[i].reads;
+        retries += results[i].retries;
+        torn += results[i].torn;
+        backwards += results[i].backwards;
+        if (results[i].reads < fewest)
+            fewest = results[i].reads;
+    }
+    double elapsed = seconds() - start;
+
+    bool ok = torn == 0 && backwards == 0 && fewest >= floor &&
+              seqState.version() == count + 1 && consistent(seqState.read());
+    snprintf(detail, sizeof(detail), "%u writes, %u readers, %llu reads (fewest %llu, floor %llu), %llu retried, %u torn, %u backwards",
+             count, readers, reads, fewest, floor, retries, torn, backwards);
+    report("seqlock", ok, elapsed, count, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static AtomicCounter counter;
+static AtomicCounter highest;
+
+static void counterWorker(unsigned int id, unsigned int adds, unsigned long long *taken)
+{
+    unsigned int state = id * 7919 + 1;
+
+    *taken = 0;
+    for (unsigned int i = 0; i < adds; i++) {
+        counter.increment();
+        // one thread plays the reporter, taking the count as it grows
+        if (id == 0 && (i & 63) == 0)
+            *taken += counter.take();
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        highest.max(state >> 8);
+    }
+}
+
+static void testCounter()
+{
+    unsigned threadCount = hostThreads();
+    unsigned int adds = count / threadCount;
+    std::vector<unsigned long long> taken(threadCount);
+    std::vector<std::thread> threads;
+    unsigned long long total = 0;
+    unsigned int expectedMax = 0;
+    char detail[100];
+
+    double start = seconds();
+    for (unsigned i = 0; i < threadCount; i++)
+        threads.push_back(std::thread(counterWorker, i, adds, &taken[i]));
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads[i].join();
+        total += taken[i];
+    }
+    double elapsed = seconds() - start;
+    total += counter.load();
+
+    // the maximum every thread offered, replayed without threads
+    for (unsigned i = 0; i < threadCount; i++) {
+        unsigned int state = i * 7919 + 1;
+        for (unsigned int n = 0; n < adds; n++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            if (state >> 8 > expectedMax)
+                expectedMax = state >> 8;
+        }
+    }
+
+    bool ok = total == (unsigned long long)adds * threadCount && highest.load() == expectedMax;
+    snprintf(detail, sizeof(detail), "%u threads, %llu counted of %llu, max %s",
+             threadCount, total, (unsigned long long)adds * threadCount,
+             highest.load() == expectedMax ? "right" : "wrong");
+    report("counter", ok, elapsed, (unsigned long long)adds * threadCount * 2, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static AtomicFlag lock;
+static volatile unsigned int guarded;
+
+static void flagWorker(unsigned int rounds)
+{
+    for (unsigned int i = 0; i < rounds; i++) {
+        while (lock.testAndSet())
+            std::this_thread::yield();
+        guarded = guarded + 1;
+        lock.clear();
+    }
+}
+
+static void testFlag()
+{
+    unsigned threadCount = hostThreads();
+    unsigned int rounds = count / threadCount / 4;
+    std::vector<std::thread> threads;
+    char detail[80];
+
+    double start = seconds();
+    for (unsigned i = 0; i < threadCount; i++)
+        threads.push_back(std::thread(flagWorker, rounds));
+    for (unsigned i = 0; i < threadCount; i++)
+        threads[i].join();
+    double elapsed = seconds() - start;
+
+    bool ok = guarded == rounds * threadCount && !lock.test();
+    snprintf(detail, sizeof(detail), "%u threads, %u of %u increments kept", threadCount, guarded, rounds * threadCount);
+    report("flag", ok, elapsed, rounds * threadCount, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static volatile unsigned int sfr;
+
+static void sfrWorker(unsigned int bit, unsigned int toggles)
+{
+    for (unsigned int i = 0; i < toggles; i++)
+        SfrBits::toggle(sfr, 1u << bit);
+    SfrBits::set(sfr, 1u << (bit + 16));
+}
+
+static void testSfrBits()
+{
+    unsigned threadCount = hostThreads();
+    unsigned int toggles = count / threadCount;
+    unsigned int expected = 0;
+    std::vector<std::thread> threads;
+    char detail[80];
+
+    // each thread owns a toggled bit and a bit it sets once at the end
+    double start = seconds();
+    for (unsigned i = 0; i < threadCount; i++) {
+        unsigned int t = toggles + i;
+        threads.push_back(std::thread(sfrWorker, i, t));
+        if (t & 1)
+            expected |= 1u << i;
+        expected |= 1u << (i + 16);
+    }
+    for (unsigned i = 0; i < threadCount; i++)
+        threads[i].join();
+    double elapsed = seconds() - start;
+
+    bool ok = sfr == expected;
+    SfrBits::clear(sfr, 0xFFFF0000u);
+    ok = ok && sfr == (expected & 0xFFFF);
+    snprintf(detail, sizeof(detail), "%u threads, word %08x, expected %08x", threadCount, sfr, expected & 0xFFFF);
+    report("sfrbits", ok, elapsed, (unsigned long long)toggles * threadCount, detail);
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 || (argc == 2 && (count = strtoul(argv[1], 0, 0)) < 1000)) {
+        fprintf(stderr, "usage: lfbench [count], count at least 1000\n");
+        return 2;
+    }
+    testSpsc();
+    testLfring();
+    testSeqlock();
+    testCounter();
+    testFlag();
+    testSfrBits();
+    return failures ? 1 : 0;
+}
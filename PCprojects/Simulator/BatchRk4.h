@@ -0,0 +1,174 @@
+/*=============================================================================
+ * RK4 over many systems at once, struct of arrays with AVX2
+ *
+ * A batch is count copies of one model, each with its own initial state and
+ * optionally its own gains, stored as struct of arrays:
+ *
+ *     x[i * stride + k]    state i of system k, stride a multiple of 4
+ *
+ * integrateBatchRk4() takes four systems at a time, one per AVX2 lane, and
+ * runs them through every step in lockstep with their whole state in
+ * registers, then writes the end state back. All systems share the time
+ * grid, so the part of the model that depends only on time, the test
+ * force sin(2 pi t), is worked out once per stage for the whole batch
+ * before the lanes start. The state-dependent exp and sin come from
+ * SimdMath.h.
+ *
+ * Batch models are built from the scalar ones in PendulumModels.h and copy
+ * their constants, so both paths integrate the same model:
+ *     enum { N = states };
+ *     double input(double t) const;
+ *     void operator()(double u, const __m256d *x, __m256d *xdot, size_t k) const;
+ * with u = input(t) and k the first of the four systems, for per-system
+ * parameters.
+ *
+ * The AVX2 code is SIMD_TARGET, check the CPU before integrating a batch.
+ *===========================================================================*/
+#ifndef __BATCH_RK4_H__
+#define __BATCH_RK4_H__
+
+#include <cmath>
+#include <cstddef>
+#include <immintrin.h>
+#include <vector>
+
+#include "PendulumModels.h"
+#include "SimdMath.h"
+
+// SoA length for count systems, a whole number of AVX2 vectors
+static inline size_t batchStride(size_t count)
+{
+    return (count + 3) & ~(size_t)3;
+}
+
+struct SimplePendulumBatch {
+    enum { N = 2 };
+
+    SimplePendulum model;
+
+    explicit SimplePendulumBatch(const SimplePendulum &m = SimplePendulum()) : model(m) {}
+
+    double input(double t) const { return sin(2 * M_PI * t) / model.m; }
+
+    SIMD_TARGET void operator()(double u, const __m256d *x, __m256d *xdot, size_t) const
+    {
+        __m256d gL = _mm256_set1_pd(-model.g * model.L);
+        __m256d L = _mm256_set1_pd(model.L);
+
+        xdot[0] = x[1];
+        xdot[1] = _mm256_fnmadd_pd(_mm256_mul_pd(L, x[1]), x[1],
+                                   _mm256_fmadd_pd(gL, simd_sin(x[0]), _mm256_set1_pd(u)));
+    }
+};
+
+/*
+ * FuzzyPendulum with per-system PDC gains: gain[(r * 4 + j) * stride + k]
+ * is K[r][j] of system k, null for the shared model.K.
+ */
+struct FuzzyPendulumBatch {
+    enum { N = 4 };
+
+    FuzzyPendulum model;
+    const double *gain;
+    size_t stride;
+    double crossing;    // e^-(2 slope edge), the ratio of the two sigmoid terms
+
+    explicit FuzzyPendulumBatch(const FuzzyPendulum &m = FuzzyPendulum(), const double *g = 0, size_t s = 0) :
+        model(m), gain(g), stride(s), crossing(exp(-2 * m.slope * m.edge)) {}
+
+    double input(double t) const { return model.drive * sin(2 * M_PI * t); }
+
+    SIMD_TARGET void operator()(double drive, const __m256d *x, __m256d *xdot, size_t k) const
+    {
+        const __m256d one = _mm256_set1_pd(1.0);
+        __m256d slope = _mm256_set1_pd(-model.slope);
+        __m256d edge = _mm256_set1_pd(model.edge);
+
+        // w1 = (1 - s(x1 - edge)) s(x1 + edge) = e^a / ((1 + e^a)(1 + e^b))
+        // with a = -slope (x1 - edge) and b = a - 2 slope edge
+        __m256d ea = simd_exp(_mm256_mul_pd(slope, _mm256_sub_pd(x[0], edge)));
+        __m256d eb = _mm256_mul_pd(ea, _mm256_set1_pd(crossing));
+        __m256d w[2];
+        w[0] = _mm256_div_pd(ea, _mm256_mul_pd(_mm256_add_pd(one, ea), _mm256_add_pd(one, eb)));
+        w[1] = _mm256_sub_pd(one, w[0]);
+
+        __m256d u = _mm256_set1_pd(drive);
+        for (int r = 0; r < 2; r++) {
+            __m256d feedback = _mm256_setzero_pd();
+            for (int j = 0; j < 4; j++) {
+                __m256d g = gain ? _mm256_loadu_pd(gain + (r * 4 + j) * stride + k) : _mm256_set1_pd(model.K[r][j]);
+                feedback = _mm256_fmadd_pd(g, x[j], feedback);
+            }
+            u = _mm256_fnmadd_pd(w[r], feedback, u);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            __m256d sum = _mm256_setzero_pd();
+            for (int r = 0; r < 2; r++) {
+                __m256d rule = _mm256_mul_pd(_mm256_set1_pd(model.B[r][i]), u);
+                for (int j = 0; j < 4; j++)
+                    rule = _mm256_fmadd_pd(_mm256_set1_pd(model.A[r][i][j]), x[j], rule);
+                sum = _mm256_fmadd_pd(w[r], rule, sum);
+            }
+            xdot[i] = sum;
+        }
+    }
+};
+
+/*
+ * Integrates count systems from t0 to t1 in steps of h, the last one
+ * shortened to land on t1, as integrateRk4(). x holds the initial states
+ * and receives the end states. Lanes past count in the last vector are
+ * computed and written too, so x must have stride entries per state.
+ */
+template <class Batch>
+SIMD_TARGET void integrateBatchRk4(const Batch &f, double t0, double t1, double h, double *x, size_t count, size_t stride)
+{
+    const int N = Batch::N;
+    long steps = (long)ceil((t1 - t0) / h - 1e-9);
+    std::vector<double> grid(steps + 1), start(steps), middle(steps), end(steps);
+
+    // the time grid and the time-only inputs, shared by every system
+    grid[0] = t0;
+    for (long n = 1; n <= steps; n++)
+        grid[n] = n == steps ? t1 : t0 + n * h;
+    for (long n = 0; n < steps; n++) {
+        start[n] = f.input(grid[n]);
+        middle[n] = f.input(grid[n] + (grid[n + 1] - grid[n]) / 2);
+        end[n] = f.input(grid[n + 1]);
+    }
+
+    for (size_t k = 0; k < count; k += 4) {
+        __m256d y[N], k1[N], k2[N], k3[N], k4[N], s[N];
+
+        for (int i = 0; i < N; i++)
+            y[i] = _mm256_loadu_pd(x + i * stride + k);
+
+        for (long n = 0; n < steps; n++) {
+            double dt = grid[n + 1] - grid[n];
+            __m256d half = _mm256_set1_pd(dt / 2), full = _mm256_set1_pd(dt), sixth = _mm256_set1_pd(dt / 6);
+            const __m256d two = _mm256_set1_pd(2.0);
+
+            f(start[n], y, k1, k);
+            for (int i = 0; i < N; i++)
+                s[i] = _mm256_fmadd_pd(half, k1[i], y[i]);
+            f(middle[n], s, k2, k);
+            for (int i = 0; i < N; i++)
+                s[i] = _mm256_fmadd_pd(half, k2[i], y[i]);
+            f(middle[n], s, k3, k);
+            for (int i = 0; i < N; i++)
+                s[i] = _mm256_fmadd_pd(full, k3[i], y[i]);
+            f(end[n], s, k4, k);
+            for (int i = 0; i < N; i++) {
+                __m256d sum = _mm256_add_pd(_mm256_add_pd(k1[i], k4[i]),
+                                            _mm256_mul_pd(two, _mm256_add_pd(k2[i], k3[i])));
+                y[i] = _mm256_fmadd_pd(sixth, sum, y[i]);
+            }
+        }
+
+        for (int i = 0; i < N; i++)
+            _mm256_storeu_pd(x + i * stride + k, y[i]);
+    }
+}
+
+#endif
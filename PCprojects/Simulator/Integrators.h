@@ -0,0 +1,192 @@
+/*=============================================================================
+ * ODE integrators for the simulator models
+ *
+ *     rk4Step / integrateRk4   classic fixed step Runge-Kutta, 4 evaluations
+ *                              a step
+ *     integrateRk23            adaptive Bogacki-Shampine 3(2) pair, step for
+ *                              step the algorithm of MATLAB's ode23 with its
+ *                              default tolerances, so its output reproduces
+ *                              the matlab/ scripts' trajectories
+ *
+ * A model is any functor with enum N and operator()(t, x, xdot), see
+ * PendulumModels.h. Results go to an observer called as out(t, x) for the
+ * start and every step; Trajectory records them. State lives on the stack,
+ * nothing is allocated per step.
+ *===========================================================================*/
+#ifndef __INTEGRATORS_H__
+#define __INTEGRATORS_H__
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+// Every point of a run, x row major with n values per point
+struct Trajectory {
+    int n;
+    std::vector<double> t;
+    std::vector<double> x;
+
+    explicit Trajectory(int states) : n(states) {}
+
+    void operator()(double time, const double *state)
+    {
+        t.push_back(time);
+        x.insert(x.end(), state, state + n);
+    }
+
+    size_t size() const { return t.size(); }
+    const double *at(size_t i) const { return &x[i * n]; }
+};
+
+// Keeps the last point only, for runs where only the end state matters
+template <int N>
+struct FinalState {
+    double t;
+    double x[N];
+
+    void operator()(double time, const double *state)
+    {
+        t = time;
+        std::copy(state, state + N, x);
+    }
+};
+
+template <class Model>
+void rk4Step(const Model &f, double t, double *x, double h)
+{
+    const int N = Model::N;
+    double k1[N], k2[N], k3[N], k4[N], y[N];
+
+    f(t, x, k1);
+    for (int i = 0; i < N; i++)
+        y[i] = x[i] + h / 2 * k1[i];
+    f(t + h / 2, y, k2);
+    for (int i = 0; i < N; i++)
+        y[i] = x[i] + h / 2 * k2[i];
+    f(t + h / 2, y, k3);
+    for (int i = 0; i < N; i++)
+        y[i] = x[i] + h * k3[i];
+    f(t + h, y, k4);
+    for (int i = 0; i < N; i++)
+        x[i] += h / 6 * (k1[i] + 2 * k2[i] + 2 * k3[i] + k4[i]);
+}
+
+// Steps of h from t0 to t1, the last one shortened to land on t1
+template <class Model, class Observer>
+void integrateRk4(const Model &f, double t0, double t1, double h, double *x, Observer &out)
+{
+    long steps = (long)ceil((t1 - t0) / h - 1e-9);
+    double t = t0;
+
+    out(t, x);
+    for (long i = 1; i <= steps; i++) {
+        double next = i == steps ? t1 : t0 + i * h;
+        rk4Step(f, t, x, next - t);
+        t = next;
+        out(t, x);
+    }
+}
+
+// ode23 defaults, maxStep 0 is a tenth of the span
+struct Rk23Options {
+    double relTol;
+    double absTol;
+    double maxStep;
+
+    Rk23Options() : relTol(1e-3), absTol(1e-6), maxStep(0) {}
+};
+
+/*
+ * Adaptive steps from t0 to t1 > t0 as ode23 takes them, returns the
+ * number of steps or -1 if the step size fell below the resolution of t.
+ */
+template <class Model, class Observer>
+long integrateRk23(const Model &f, double t0, double t1, double *x, Observer &out,
+                   const Rk23Options &options = Rk23Options())
+{
+    const int N = Model::N;
+    const double power = 1.0 / 3;
+    const double rtol = options.relTol;
+    const double threshold = options.absTol / rtol;
+    double span = t1 - t0;
+    double hmax = options.maxStep > 0 ? options.maxStep : 0.1 * span;
+    double f1[N], f2[N], f3[N], f4[N], y[N], ynew[N];
+    double t = t0;
+    long steps = 0;
+
+    std::copy(x, x + N, y);
+    f(t, y, f1);
+    out(t, y);
+
+    // first step from the size of the derivative, as ode23
+    double absh = std::min(hmax, span);
+    double rh = 0;
+    for (int i = 0; i < N; i++)
+        rh = std::max(rh, fabs(f1[i]) / std::max(fabs(y[i]), threshold));
+    rh /= 0.8 * ::pow(rtol, power);
+    if (absh * rh > 1)
+        absh = 1 / rh;
+
+    bool done = false;
+    while (!done) {
+        double hmin = 16 * (nextafter(fabs(t), DBL_MAX) - fabs(t));
+        absh = std::min(hmax, std::max(hmin, absh));
+        double h = absh;
+        if (1.1 * absh >= t1 - t) {
+            h = t1 - t;
+            absh = fabs(h);
+            done = true;
+        }
+
+        bool nofailed = true;
+        double err, tnew;
+        for (;;) {
+            for (int i = 0; i < N; i++)
+                y[i] = x[i] + h / 2 * f1[i];
+            f(t + h / 2, y, f2);
+            for (int i = 0; i < N; i++)
+                y[i] = x[i] + h * 3 / 4 * f2[i];
+            f(t + h * 3 / 4, y, f3);
+
+            tnew = done ? t1 : t + h;
+            h = tnew - t;
+            for (int i = 0; i < N; i++)
+                ynew[i] = x[i] + h * (2.0 / 9 * f1[i] + 1.0 / 3 * f2[i] + 4.0 / 9 * f3[i]);
+            f(tnew, ynew, f4);
+
+            err = 0;
+            for (int i = 0; i < N; i++) {
+                double e = -5.0 / 72 * f1[i] + 1.0 / 12 * f2[i] + 1.0 / 9 * f3[i] - 1.0 / 8 * f4[i];
+                double scale = std::max(std::max(fabs(x[i]), fabs(ynew[i])), threshold);
+                err = std::max(err, fabs(e) / scale);
+            }
+            err *= absh;
+
+            if (err <= rtol)
+                break;
+            if (absh <= hmin)
+                return -1;
+            if (nofailed) {
+                nofailed = false;
+                absh = std::max(hmin, absh * std::max(0.5, 0.8 * ::pow(rtol / err, power)));
+            } else
+                absh = std::max(hmin, 0.5 * absh);
+            h = absh;
+            done = false;
+        }
+
+        steps++;
+        out(tnew, ynew);
+        if (nofailed) {
+            double temp = 1.25 * ::pow(err / rtol, power);
+            absh = temp > 0.2 ? absh / temp : absh * 5;
+        }
+        t = tnew;
+        std::copy(ynew, ynew + N, x);
+        std::copy(f4, f4 + N, f1);
+    }
+    return steps;
+}
+
+#endif
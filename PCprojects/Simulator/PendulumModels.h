@@ -0,0 +1,144 @@
+/*=============================================================================
+ * Pendulum models from the MATLAB experiments in matlab/
+ *
+ * Each model is a functor for the integrators in Integrators.h,
+ *     enum { N = states };
+ *     void operator()(double t, const double *x, double *xdot) const;
+ * with its constants as public members, so a sweep can change them between
+ * runs. The defaults are the values in the .m files.
+ *===========================================================================*/
+#ifndef __PENDULUM_MODELS_H__
+#define __PENDULUM_MODELS_H__
+
+#include <cmath>
+
+/*
+ * robot.m, a simple pendulum with a velocity squared damping term driven by
+ * u = sin(2 pi t):
+ *     x1' = x2
+ *     x2' = -g L sin(x1) - L x2^2 + u / m
+ */
+struct SimplePendulum {
+    enum { N = 2 };
+
+    double g, L, m;
+
+    SimplePendulum() : g(9.8), L(1), m(10) {}
+
+    void operator()(double t, const double *x, double *xdot) const
+    {
+        double u = sin(2 * M_PI * t);
+        xdot[0] = x[1];
+        xdot[1] = -g * L * sin(x[0]) - L * x[1] * x[1] + u / m;
+    }
+};
+
+/*
+ * fuzzyPendulumnTest.m and fuzzyControlTest.m, the two rule Takagi-Sugeno
+ * model of a pendulum on a cart after H.K. Lam:
+ *     x' = w1 (A1 x + B1 u) + w2 (A2 x + B2 u)
+ *     w1 = (1 - s(x1 - pi/6)) s(x1 + pi/6),  w2 = 1 - w1
+ *     s(v) = 1 / (1 + exp(-7 v))
+ * State: angle (rad), angular velocity, cart position (m), cart velocity.
+ * Rule 1 is linearized about upright, rule 2 about 60 degrees.
+ *
+ * The input is the scripts' test force sin(2 pi t) plus parallel
+ * distributed compensation, u -= (w1 K1 + w2 K2) x. The gains start at
+ * zero, which gives the scripts' open loop model exactly. Call build()
+ * after changing a physical constant.
+ *
+ * The A2 entry for the cart velocity's own damping divides by a1 rather
+ * than a2 in both scripts. It is kept, so trajectories match MATLAB.
+ */
+struct FuzzyPendulum {
+    enum { N = 4 };
+
+    // fuzzyPendulumnTest.m constants
+    double g;       // gravity, m/s^2
+    double m;       // pendulum mass, kg
+    double M;       // cart mass, kg
+    double l;       // shaft to pendulum centre of mass, m
+    double J0;      // pendulum inertia about its centre of mass, kg m^2
+    double F0;      // cart friction, N/(m/s)
+    double F1;      // pendulum friction, N/(rad/s)
+
+    double slope;   // membership sigmoid slope, 1/rad
+    double edge;    // membership crossover angle, rad
+    double drive;   // amplitude of the sin(2 pi t) test force, N
+
+    double K[2][4]; // PDC state feedback gains per rule
+
+    double A[2][4][4];
+    double B[2][4];
+
+    FuzzyPendulum() :
+        g(9.8), m(0.022), M(1.3282), l(0.304), J0(0.022 * 0.304 * 0.304 / 3), F0(22.915), F1(0.007056),
+        slope(7), edge(M_PI / 6), drive(1)
+    {
+        for (int r = 0; r < 2; r++)
+            for (int i = 0; i < 4; i++)
+                K[r][i] = 0;
+        build();
+    }
+
+    void build()
+    {
+        double c = cos(M_PI / 3);
+        double k = 3 * sqrt(3.0) / (2 * M_PI);  // sin(x1) / x1 at 60 degrees
+        double a1 = (M + m) * (J0 + m * l * l) - m * m * l * l;
+        double a2 = (M + m) * (J0 + m * l * l) - m * m * l * l * c * c;
+        const double a[2][4][4] = {
+            {
+                { 0, 1, 0, 0 },
+                { (M + m) * m * g * l / a1, -F1 * (M + m) / a1, 0, F0 * m * l / a1 },
+                { 0, 0, 0, 1 },
+                { -m * m * g * l * l / a1, F1 * m * l / a1, 0, -F0 * (J0 + m * l * l) / a1 }
+            },
+            {
+                { 0, 1, 0, 0 },
+                { k * (M + m) * m * g * l / a2, -F1 * (M + m) / a2, 0, F0 * m * l * c / a2 },
+                { 0, 0, 0, 1 },
+                { -k * m * m * g * l * l * c / a2, F1 * m * l * c / a2, 0, -F0 * (J0 + m * l * l) / a1 }
+            }
+        };
+        const double b[2][4] = {
+            { 0, -m * l / a1, 0, (J0 + m * l * l) / a1 },
+            { 0, -m * l * c / a2, 0, (J0 + m * l * l) / a2 }
+        };
+        for (int r = 0; r < 2; r++)
+            for (int i = 0; i < 4; i++) {
+                B[r][i] = b[r][i];
+                for (int j = 0; j < 4; j++)
+                    A[r][i][j] = a[r][i][j];
+            }
+    }
+
+    // Grade of rule 1, upright
+    double membership(double angle) const
+    {
+        double upper = 1 / (1 + exp(-slope * (angle - edge)));
+        double lower = 1 / (1 + exp(-slope * (angle + edge)));
+        return (1 - upper) * lower;
+    }
+
+    void operator()(double t, const double *x, double *xdot) const
+    {
+        double w[2];
+        w[0] = membership(x[0]);
+        w[1] = 1 - w[0];
+
+        double u = drive * sin(2 * M_PI * t);
+        for (int r = 0; r < 2; r++)
+            u -= w[r] * (K[r][0] * x[0] + K[r][1] * x[1] + K[r][2] * x[2] + K[r][3] * x[3]);
+
+        for (int i = 0; i < 4; i++) {
+            double sum = 0;
+            for (int r = 0; r < 2; r++)
+                sum += w[r] * (A[r][i][0] * x[0] + A[r][i][1] * x[1] + A[r][i][2] * x[2] + A[r][i][3] * x[3]
+                               + B[r][i] * u);
+            xdot[i] = sum;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*=============================================================================
+ * pendsim - runs the matlab/ pendulum models without MATLAB
+ *
+ * Usage:
+ *     pendsim [-m fuzzy|robot] [-i rk23|rk4] [-h step] [-t seconds]
+ *             [-x x1,x2,...] [-k gains] [-r runs] [-o out.csv] [-c ref.csv]
+ *
+ * fuzzy is the Takagi-Sugeno cart pendulum of fuzzyPendulumnTest.m, robot
+ * the pendulum of robot.m. The default is odeTest.m: the fuzzy model from
+ * x = [5 pi/12 0 0] over 1 s with ode23's algorithm. -i rk4 uses fixed
+ * steps of -h seconds (1 ms by default) instead.
+ *
+ * -k gives the fuzzy model's PDC feedback gains, four for both rules or
+ * eight for rule 1 then rule 2. The trajectory is written as CSV, t then
+ * the states. -r repeats the run and reports the time per run on stderr,
+ * for comparison with MATLAB's tic/toc.
+ *
+ * -c checks the run against a reference trajectory of the same run instead
+ * of writing it: every point's time and states must match within
+ * CHECK_TOLERANCE, scaled by the size of the reference value. The exit
+ * status is 1 on a mismatch. Simulator/odeTest.csv is the default run and
+ * Simulator/robotRk4.csv "-m robot -i rk4 -h 0.01", "make check" runs both.
+ *===========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Integrators.h"
+#include "ParseList.h"
+#include "PendulumModels.h"
+
+// Largest difference from a reference point, relative to 1 + |reference|.
+// The references are printed to 9 digits; this leaves room for another
+// compiler's rounding but not for a changed step or model.
+static const double CHECK_TOLERANCE = 1e-6;
+
+// Reads a trajectory written by pendsim, false if the file cannot be read or
+// a line does not hold t and n states
+static bool readTrajectory(const char *path, Trajectory &trajectory)
+{
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return false;
+
+    char line[512];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), in)) {
+        double values[1 + 4];          // t and the fuzzy model's four states
+        line[strcspn(line, "\r\n")] = 0;
+        int count = parseList(line, values, 1 + trajectory.n);
+        ok = count == 1 + trajectory.n;
+        if (ok)
+            trajectory(values[0], values + 1);
+    }
+    fclose(in);
+    return ok && trajectory.size() > 0;
+}
+
+// Compares a run with its reference point by point, 0 if they match
+static int check(const Trajectory &trajectory, const char *referencePath)
+{
+    Trajectory reference(trajectory.n);
+    if (!readTrajectory(referencePath, reference)) {
+        fprintf(stderr, "pendsim: cannot read %s as a trajectory of %d states\n", referencePath, trajectory.n);
+        return 1;
+    }
+    if (reference.size() != trajectory.size()) {
+        printf("%s: %zu points, the run has %zu  FAIL\n", referencePath, reference.size(), trajectory.size());
+        return 1;
+    }
+
+    double worst = 0;
+    size_t worstPoint = 0;
+    for (size_t i = 0; i < reference.size(); i++) {
+        double error = fabs(trajectory.t[i] - reference.t[i]) / (1 + fabs(reference.t[i]));
+        for (int j = 0; j < reference.n; j++)
+            error = std::max(error, fabs(trajectory.at(i)[j] - reference.at(i)[j]) / (1 + fabs(reference.at(i)[j])));
+        if (error > worst) {
+            worst = error;
+            worstPoint = i;
+        }
+    }
+    bool ok = worst <= CHECK_TOLERANCE;
+    printf("%s: %zu points, max error %.3g at t = %g, bound %g  %s\n", referencePath, reference.size(), worst,
+           reference.t[worstPoint], CHECK_TOLERANCE, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+template <class Model>
+static int run(const Model &model, bool adaptive, double step, double seconds, const double *x0, int runs,
+               FILE *out, const char *referencePath)
+{
+    const int N = Model::N;
+    Trajectory trajectory(N);
+    long steps = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; r++) {
+        double x[N];
+        std::copy(x0, x0 + N, x);
+        trajectory = Trajectory(N);
+        if (adaptive)
+            steps = integrateRk23(model, 0.0, seconds, x, trajectory);
+        else
+            integrateRk4(model, 0.0, seconds, step, x, trajectory);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (adaptive && steps < 0) {
+        fprintf(stderr, "pendsim: step size too small at t = %g\n", trajectory.t.back());
+        return 1;
+    }
+    fprintf(stderr, "%zu points, %.2f us per run over %d runs\n", trajectory.size(), elapsed * 1e6 / runs, runs);
+
+    if (referencePath)
+        return check(trajectory, referencePath);
+    for (size_t i = 0; i < trajectory.size(); i++) {
+        fprintf(out, "%.9g", trajectory.t[i]);
+        for (int j = 0; j < N; j++)
+            fprintf(out, ",%.9g", trajectory.at(i)[j]);
+        fprintf(out, "\n");
+    }
+    return 0;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: pendsim [-m fuzzy|robot] [-i rk23|rk4] [-h step] [-t seconds]\n"
+            "               [-x x1,x2,...] [-k gains] [-r runs] [-o out.csv] [-c ref.csv]\n");
+}
+
+int main(int argc, char **argv)
+{
+    std::string modelName = "fuzzy";
+    bool adaptive = true;
+    double step = 1e-3, seconds = 1;
+    double x0[4] = { 5 * M_PI / 12, 0, 0, 0 };
+    double gains[8];
+    int numStates = -1, numGains = 0, runs = 1;
+    const char *outPath = 0, *referencePath = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            usage();
+            return 2;
+        }
+        i++;
+        switch (argv[i - 1][1]) {
+        case 'm': modelName = value; break;
+        case 'i':
+            if (strcmp(value, "rk23") != 0 && strcmp(value, "rk4") != 0) {
+                usage();
+                return 2;
+            }
+            adaptive = strcmp(value, "rk23") == 0;
+            break;
+        case 'h': step = atof(value); break;
+        case 't': seconds = atof(value); break;
+        case 'x': numStates = parseList(value, x0, 4); break;
+        case 'k': numGains = parseList(value, gains, 8); break;
+        case 'r': runs = atoi(value); break;
+        case 'o': outPath = value; break;
+        case 'c': referencePath = value; break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (step <= 0 || seconds <= 0 || runs < 1 || numGains < 0 || numStates == 0) {
+        usage();
+        return 2;
+    }
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "pendsim: cannot write %s\n", outPath);
+        return 1;
+    }
+
+    int status;
+    if (modelName == "robot") {
+        if (numStates < 0)
+            x0[0] = 0;
+        status = run(SimplePendulum(), adaptive, step, seconds, x0, runs, out, referencePath);
+    } else if (modelName == "fuzzy") {
+        FuzzyPendulum model;
+        if (numGains != 0 && numGains != 4 && numGains != 8) {
+            fprintf(stderr, "pendsim: -k takes 4 or 8 gains\n");
+            return 2;
+        }
+        for (int r = 0; r < 2; r++)
+            for (int j = 0; j < numGains && j < 4; j++)
+                model.K[r][j] = gains[numGains == 8 ? r * 4 + j : j];
+        status = run(model, adaptive, step, seconds, x0, runs, out, referencePath);
+    } else {
+        usage();
+        return 2;
+    }
+
+    if (outPath)
+        fclose(out);
+    return status;
+}
@@ -0,0 +1,159 @@
+/*=============================================================================
+ * simbench - batched AVX2 RK4 against the scalar path
+ *
+ * Usage:
+ *     simbench [-m fuzzy|robot] [-n systems] [-t seconds] [-h step] [-g]
+ *
+ * Integrates n systems from a spread of initial angles, -5 pi/12..5 pi/12
+ * as in fuzzyControlTest.m for the fuzzy model, once one at a time with
+ * integrateRk4() and once with integrateBatchRk4(). -g also gives every
+ * fuzzy system its own PDC gains, a spread of one gain vector, as a gain
+ * sweep would. Reports trajectories per second for both and the largest
+ * difference between their end states.
+ *===========================================================================*/
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BatchRk4.h"
+#include "Integrators.h"
+#include "PendulumModels.h"
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Largest end state difference, systems that blew up in both paths agree
+template <int N>
+static double compare(const std::vector<double> &scalar, const std::vector<double> &batch, size_t count,
+                      size_t stride)
+{
+    double worst = 0;
+    for (int i = 0; i < N; i++)
+        for (size_t k = 0; k < count; k++) {
+            double a = scalar[i * stride + k], b = batch[i * stride + k];
+            if (std::isfinite(a) || std::isfinite(b))
+                worst = std::max(worst, fabs(a - b) / std::max(1.0, fabs(a)));
+        }
+    return worst;
+}
+
+template <class Model, class Batch>
+static void bench(const Model &model, const Batch &batch, const std::vector<double> &x0, size_t count,
+                  size_t stride, double span, double h)
+{
+    const int N = Model::N;
+    std::vector<double> scalar(x0), vector(x0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < count; k++) {
+        Model system = model;
+        FinalState<N> end;
+        double x[N];
+        batch.gainsFor(k, system);
+        for (int i = 0; i < N; i++)
+            x[i] = x0[i * stride + k];
+        integrateRk4(system, 0.0, span, h, x, end);
+        for (int i = 0; i < N; i++)
+            scalar[i * stride + k] = end.x[i];
+    }
+    double scalarTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    integrateBatchRk4(batch, 0.0, span, h, &vector[0], count, stride);
+    double batchTime = seconds(start);
+
+    long steps = (long)ceil(span / h - 1e-9);
+    printf("%zu systems, %ld RK4 steps each\n", count, steps);
+    printf("scalar  %10.0f trajectories/s\n", count / scalarTime);
+    printf("AVX2    %10.0f trajectories/s, %.1fx\n", count / batchTime, scalarTime / batchTime);
+    printf("largest end state difference %.3g (relative)\n", compare<N>(scalar, vector, count, stride));
+}
+
+// Batch wrappers that also hand their per-system gains to the scalar model
+struct FuzzyBench : FuzzyPendulumBatch {
+    FuzzyBench(const double *g, size_t s) : FuzzyPendulumBatch(FuzzyPendulum(), g, s) {}
+
+    bool gainsFor(size_t k, FuzzyPendulum &system) const
+    {
+        if (!gain)
+            return false;
+        for (int r = 0; r < 2; r++)
+            for (int j = 0; j < 4; j++)
+                system.K[r][j] = gain[(r * 4 + j) * stride + k];
+        return true;
+    }
+};
+
+struct RobotBench : SimplePendulumBatch {
+    bool gainsFor(size_t, SimplePendulum &) const { return false; }
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: simbench [-m fuzzy|robot] [-n systems] [-t seconds] [-h step] [-g]\n");
+}
+
+int main(int argc, char **argv)
+{
+    std::string modelName = "fuzzy";
+    size_t count = 4096;
+    double span = 1, h = 1e-3;
+    bool gains = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0)
+            gains = true;
+        else if (i + 1 < argc && strcmp(argv[i], "-m") == 0)
+            modelName = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+            count = strtoul(argv[++i], 0, 10);
+        else if (i + 1 < argc && strcmp(argv[i], "-t") == 0)
+            span = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-h") == 0)
+            h = atof(argv[++i]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (count < 1 || span <= 0 || h <= 0 || (modelName != "fuzzy" && modelName != "robot")) {
+        usage();
+        return 2;
+    }
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        fprintf(stderr, "simbench: this CPU has no AVX2 and FMA\n");
+        return 1;
+    }
+
+    size_t stride = batchStride(count);
+    double range = modelName == "fuzzy" ? 5 * M_PI / 12 : 1;
+    int states = modelName == "fuzzy" ? (int)FuzzyPendulum::N : (int)SimplePendulum::N;
+    std::vector<double> x0(states * stride, 0.0);
+    for (size_t k = 0; k < stride; k++)
+        x0[k] = count > 1 ? -range + 2 * range * std::min(k, count - 1) / (count - 1) : range;
+
+    if (modelName == "robot") {
+        RobotBench batch;
+        bench(batch.model, batch, x0, count, stride, span, h);
+        return 0;
+    }
+
+    std::vector<double> gainSets;
+    if (gains) {
+        static const double base[4] = { -20, -2, -1, -2 };
+        gainSets.assign(8 * stride, 0.0);
+        for (int r = 0; r < 2; r++)
+            for (int j = 0; j < 4; j++)
+                for (size_t k = 0; k < stride; k++)
+                    gainSets[(r * 4 + j) * stride + k] = base[j] * (r + 1) * (double)(k % 64) / 64;
+    }
+    FuzzyBench batch(gains ? &gainSets[0] : 0, stride);
+    bench(batch.model, batch, x0, count, stride, span, h);
+    return 0;
+}
@@ -0,0 +1,762 @@
+/*=============================================================================
+ * tlmrec - records and analyzes the robot's binary telemetry stream
+ *
+ * Usage:
+ *     tlmrec record <tty> <capture.bin> [-r hz] [-t seconds]
+ *     tlmrec stats  <capture.bin> [-d deadline_ms]
+ *     tlmrec log    <capture.bin> <log.tlc>
+ *     tlmrec csv    <capture.bin | log.tlc> <imu|joints|timing|adc|supply> [out.csv]
+ *
+ * record appends the raw CDC byte stream to a capture file until Ctrl-C or
+ * the time limit, -r first sets the firmware's IMU rate with 'f<hz>'. The
+ * port is only read and written to disk, decoding happens afterwards, so
+ * the recorder keeps up with anything full speed USB delivers.
+ *
+ * The other commands map the capture and decode the packets in place.
+ * stats reports link errors, the IMU sample rate and interval jitter, and
+ * main loop timing from the once a second TLM_TIMING records: loop period,
+ * jitter (longest pass over the mean) and the report windows in which a
+ * pass missed the frame deadline (20 ms by default). ADC scan records, from
+ * the MPLAB ADC example's binary mode over a serial adapter, add their scan
+ * count and the scans lost between records. Supply records add the peak leg
+ * currents, the lowest supply voltages and how stale a reading got.
+ *
+ * log writes a columnar log, one array per record field, that csv and
+ * later tools read without decoding packets again:
+ *     "TLC1" | u16 tables | u16 0
+ *     per table: u8 type | u8 columns | u16 0 | u32 rows
+ *                columns x { char name[15] | u8 size, 0x80 if signed }
+ *                columns x { rows x size bytes }
+ *
+ * Packet and record layouts come from the firmware's Telemetry.h.
+ *===========================================================================*/
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SerialPort.h"
+#include "Telemetry.h"
+
+// Firmware core timer, half the 80 MHz system clock
+static const double CORE_TIMER_HZ = 40e6;
+
+static const char LOG_MAGIC[4] = { 'T', 'L', 'C', '1' };
+static const size_t LOG_NAME_SIZE = 15;
+
+struct Column {
+    const char *name;
+    size_t offset;
+    unsigned char size;
+    bool isSigned;
+};
+
+#define FIELD(type, field, name, isSigned) \
+    { name, offsetof(type, field), sizeof(((type *)0)->field), isSigned }
+
+static const Column imuColumns[] = {
+    FIELD(TlmImu, time, "time", false),
+    FIELD(TlmImu, accel[0], "ax", true),
+    FIELD(TlmImu, accel[1], "ay", true),
+    FIELD(TlmImu, accel[2], "az", true),
+    FIELD(TlmImu, gyro[0], "gx", true),
+    FIELD(TlmImu, gyro[1], "gy", true),
+    FIELD(TlmImu, gyro[2], "gz", true),
+    FIELD(TlmImu, temperature, "temperature", true),
+};
+
+static const Column jointColumns[] = {
+    FIELD(TlmJoints, time, "time", false),
+    FIELD(TlmJoints, pulse[0], "pulse0", false),
+    FIELD(TlmJoints, pulse[1], "pulse1", false),
+    FIELD(TlmJoints, pulse[2], "pulse2", false),
+    FIELD(TlmJoints, pulse[3], "pulse3", false),
+    FIELD(TlmJoints, pulse[4], "pulse4", false),
+    FIELD(TlmJoints, pulse[5], "pulse5", false),
+    FIELD(TlmJoints, pulse[6], "pulse6", false),
+    FIELD(TlmJoints, pulse[7], "pulse7", false),
+    FIELD(TlmJoints, pulse[8], "pulse8", false),
+    FIELD(TlmJoints, pulse[9], "pulse9", false),
+    FIELD(TlmJoints, pulse[10], "pulse10", false),
+    FIELD(TlmJoints, pulse[11], "pulse11", false),
+};
+
+static const Column timingColumns[] = {
+    FIELD(TlmTiming, time, "time", false),
+    FIELD(TlmTiming, loops, "loops", false),
+    FIELD(TlmTiming, loopMaxTicks, "loopMaxTicks", false),
+    FIELD(TlmTiming, usbIsrMaxTicks, "usbIsrMaxTicks", false),
+    FIELD(TlmTiming, dropped, "dropped", false),
+    FIELD(TlmTiming, queued, "queued", false),
+};
+
+static const Column adcColumns[] = {
+    FIELD(TlmAdc, scan, "scan", false),
+    FIELD(TlmAdc, rate, "rate", false),
+    FIELD(TlmAdc, channels, "channels", false),
+    FIELD(TlmAdc, count, "count", false),
+    FIELD(TlmAdc, sample[0], "s0", false),
+    FIELD(TlmAdc, sample[1], "s1", false),
+    FIELD(TlmAdc, sample[2], "s2", false),
+    FIELD(TlmAdc, sample[3], "s3", false),
+    FIELD(TlmAdc, sample[4], "s4", false),
+    FIELD(TlmAdc, sample[5], "s5", false),
+    FIELD(TlmAdc, sample[6], "s6", false),
+    FIELD(TlmAdc, sample[7], "s7", false),
+    FIELD(TlmAdc, sample[8], "s8", false),
+    FIELD(TlmAdc, sample[9], "s9", false),
+    FIELD(TlmAdc, sample[10], "s10", false),
+    FIELD(TlmAdc, sample[11], "s11", false),
+    FIELD(TlmAdc, sample[12], "s12", false),
+    FIELD(TlmAdc, sample[13], "s13", false),
+    FIELD(TlmAdc, sample[14], "s14", false),
+    FIELD(TlmAdc, sample[15], "s15", false),
+    FIELD(TlmAdc, sample[16], "s16", false),
+    FIELD(TlmAdc, sample[17], "s17", false),
+    FIELD(TlmAdc, sample[18], "s18", false),
+    FIELD(TlmAdc, sample[19], "s19", false),
+    FIELD(TlmAdc, sample[20], "s20", false),
+    FIELD(TlmAdc, sample[21], "s21", false),
+    FIELD(TlmAdc, sample[22], "s22", false),
+    FIELD(TlmAdc, sample[23], "s23", false),
+};
+
+static const Column supplyColumns[] = {
+    FIELD(TlmSupply, time, "time", false),
+    FIELD(TlmSupply, current[0], "currentRight", true),
+    FIELD(TlmSupply, current[1], "currentLeft", true),
+    FIELD(TlmSupply, peak[0], "peakRight", true),
+    FIELD(TlmSupply, peak[1], "peakLeft", true),
+    FIELD(TlmSupply, servoMv, "servoMv", false),
+    FIELD(TlmSupply, logicMv, "logicMv", false),
+    FIELD(TlmSupply, latencyMaxUs, "latencyMaxUs", false),
+};
+
+#undef FIELD
+
+struct RecordType {
+    const char *name;
+    const Column *columns;
+    int numColumns;
+};
+
+#define COUNT(a) (int)(sizeof(a) / sizeof((a)[0]))
+static const RecordType recordTypes[TLM_NUM_TYPES] = {
+    { 0, 0, 0 },
+    { "imu", imuColumns, COUNT(imuColumns) },
+    { "joints", jointColumns, COUNT(jointColumns) },
+    { "timing", timingColumns, COUNT(timingColumns) },
+    { "adc", adcColumns, COUNT(adcColumns) },
+    { "supply", supplyColumns, COUNT(supplyColumns) },
+};
+#undef COUNT
+
+static long long getField(const unsigned char *p, int size, bool isSigned)
+{
+    unsigned long long v = 0;
+    for (int i = size - 1; i >= 0; i--)
+        v = (v << 8) | p[i];
+    if (isSigned && size < 8 && (v >> (size * 8 - 1)))
+        v |= ~0ULL << (size * 8);
+    return (long long)v;
+}
+
+// Reads a record struct out of the mapping, payloads are not aligned
+template <class T> static T getRecord(const unsigned char *payload)
+{
+    T record;
+    memcpy(&record, payload, sizeof(record));
+    return record;
+}
+
+/*-----------------------------------------------------------------------------
+ * Packet decoding
+ *---------------------------------------------------------------------------*/
+
+struct LinkStats {
+    unsigned long long packets;
+    unsigned long long records;
+    unsigned long long skippedBytes;    // resync, or dumps in the stream
+    unsigned long long lostPackets;     // sequence number gaps
+    unsigned long long badPackets;      // synced but failed a check
+};
+
+// Calls sink.record(type, payload) for every record of every valid packet
+template <class Sink>
+static void decodeCapture(const unsigned char *data, size_t size, Sink &sink, LinkStats &link)
+{
+    bool haveSeq = false;
+    unsigned int lastSeq = 0;
+    size_t pos = 0;
+
+    memset(&link, 0, sizeof(link));
+    while (pos + TLM_HEADER_SIZE + 1 <= size) {
+        const unsigned char *p = data + pos;
+        if (p[0] != TLM_SYNC0 || p[1] != TLM_SYNC1) {
+            pos++;
+            link.skippedBytes++;
+            continue;
+        }
+
+        size_t length = p[4];
+        bool valid = length <= TLM_PAYLOAD_SIZE && pos + TLM_HEADER_SIZE + length + 1 <= size;
+        if (valid) {
+            unsigned char sum = 0;
+            for (size_t i = 0; i < length; i++)
+                sum += p[TLM_HEADER_SIZE + i];
+            valid = sum == p[TLM_HEADER_SIZE + length];
+        }
+        // records must tile the payload exactly
+        for (size_t i = 0; valid && i < length; ) {
+            int recordSize = tlm_record_size(p[TLM_HEADER_SIZE + i]);
+            valid = recordSize != 0 && i + 1 + recordSize <= length;
+            i += 1 + recordSize;
+        }
+        if (!valid) {
+            if (pos + TLM_HEADER_SIZE + length + 1 <= size)
+                link.badPackets++;
+            pos++;
+            link.skippedBytes++;
+            continue;
+        }
+
+        unsigned int seq = p[2] | (p[3] << 8);
+        if (haveSeq)
+            link.lostPackets += (seq - lastSeq - 1) & 0xFFFF;
+        haveSeq = true;
+        lastSeq = seq;
+        link.packets++;
+
+        for (size_t i = 0; i < length; ) {
+            int type = p[TLM_HEADER_SIZE + i];
+            sink.record(type, p + TLM_HEADER_SIZE + i + 1);
+            link.records++;
+            i += 1 + tlm_record_size(type);
+        }
+        pos += TLM_HEADER_SIZE + length + 1;
+    }
+    link.skippedBytes += size - pos;
+}
+
+/*-----------------------------------------------------------------------------
+ * record
+ *---------------------------------------------------------------------------*/
+
+static volatile sig_atomic_t stopRecording;
+
+static void onSignal(int)
+{
+    stopRecording = 1;
+}
+
+static double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int recordCommand(const char *tty, const char *path, int rateHz, double seconds)
+{
+    SerialPort port;
+    if (!port.open(tty, 200)) {
+        fprintf(stderr, "tlmrec: cannot open %s: %s\n", tty, strerror(errno));
+        return 1;
+    }
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    if (rateHz >= 0) {
+        char command[16];
+        snprintf(command, sizeof(command), "f%d\n", rateHz);
+        if (!port.write(command)) {
+            fprintf(stderr, "tlmrec: cannot write to %s\n", tty);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    // Large reads drain whatever the driver has buffered in one call
+    std::vector<unsigned char> buf(1 << 16);
+    unsigned long long total = 0;
+    double start = now();
+    double reportTime = start;
+    unsigned long long reported = 0;
+
+    while (!stopRecording && (seconds <= 0 || now() - start < seconds)) {
+        long n = port.read(&buf[0], buf.size());
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "tlmrec: read from %s failed: %s\n", tty, strerror(errno));
+            break;
+        }
+        if (n > 0 && fwrite(&buf[0], 1, n, out) != (size_t)n) {
+            perror(path);
+            break;
+        }
+        total += n;
+
+        double t = now();
+        if (t - reportTime >= 1) {
+            fprintf(stderr, "\r%llu bytes, %.1f kB/s   ", total, (total - reported) / 1e3 / (t - reportTime));
+            reported = total;
+            reportTime = t;
+        }
+    }
+
+    fclose(out);
+    double elapsed = now() - start;
+    fprintf(stderr, "\nrecorded %llu bytes in %.1f s (%.1f kB/s) to %s\n",
+            total, elapsed, elapsed > 0 ? total / 1e3 / elapsed : 0.0, path);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * stats
+ *---------------------------------------------------------------------------*/
+
+// Running mean, deviation and range, Welford's update
+class RunningStats {
+
+    public:
+    RunningStats() : n(0), mean(0), m2(0), lo(0), hi(0) {}
+
+    void add(double x)
+    {
+        n++;
+        double delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+        if (n == 1 || x < lo)
+            lo = x;
+        if (n == 1 || x > hi)
+            hi = x;
+    }
+
+    unsigned long long count() const { return n; }
+    double average() const { return mean; }
+    double deviation() const { return n > 1 ? sqrt(m2 / (n - 1)) : 0; }
+    double min() const { return lo; }
+    double max() const { return hi; }
+
+    private:
+    unsigned long long n;
+    double mean, m2, lo, hi;
+};
+
+struct StatsSink {
+    unsigned long long counts[TLM_NUM_TYPES];
+
+    unsigned int imuFirst, imuLast;
+    RunningStats imuInterval;           // ms between samples
+
+    bool haveTiming;
+    unsigned int timingLast;
+    RunningStats loopPeriod;            // us, mean per report window
+    RunningStats loopMax;               // us, longest pass per window
+    RunningStats loopJitter;            // us, longest pass over the mean
+    RunningStats usbIsrMax;             // us
+    double deadlineUs;
+    unsigned long long deadlineMisses;  // windows with a pass over deadline
+    unsigned long long droppedRecords;
+    unsigned int maxQueued;
+
+    unsigned int adcNext;               // scan index the next record should start at
+    unsigned int adcRate;
+    unsigned long long adcScans;
+    unsigned long long adcLost;         // scans missing between records
+
+    int peakCurrent[TLM_NUM_LEGS];      // mA
+    RunningStats totalCurrent;          // mA, filtered, both legs
+    unsigned int servoMinMv, logicMinMv;
+    RunningStats supplyLatency;         // us, longest per record
+
+    explicit StatsSink(double deadlineMs)
+        : imuFirst(0), imuLast(0), haveTiming(false), timingLast(0),
+          deadlineUs(deadlineMs * 1e3), deadlineMisses(0), droppedRecords(0), maxQueued(0),
+          adcNext(0), adcRate(0), adcScans(0), adcLost(0), servoMinMv(0xFFFF), logicMinMv(0xFFFF)
+    {
+        memset(counts, 0, sizeof(counts));
+        memset(peakCurrent, 0, sizeof(peakCurrent));
+    }
+
+    void record(int type, const unsigned char *payload)
+    {
+        counts[type]++;
+        if (type == TLM_IMU) {
+            TlmImu imu = getRecord<TlmImu>(payload);
+            if (counts[type] == 1)
+                imuFirst = imu.time;
+            else
+                imuInterval.add((int)(imu.time - imuLast));
+            imuLast = imu.time;
+        } else if (type == TLM_TIMING) {
+            TlmTiming timing = getRecord<TlmTiming>(payload);
+            double maxUs = timing.loopMaxTicks * 1e6 / CORE_TIMER_HZ;
+            loopMax.add(maxUs);
+            usbIsrMax.add(timing.usbIsrMaxTicks * 1e6 / CORE_TIMER_HZ);
+            if (maxUs > deadlineUs)
+                deadlineMisses++;
+            droppedRecords += timing.dropped;
+            if (timing.queued > maxQueued)
+                maxQueued = timing.queued;
+            // the first window started at reset, its length is unknown
+            if (haveTiming && timing.loops > 0) {
+                double period = (timing.time - timingLast) * 1e3 / timing.loops;
+                loopPeriod.add(period);
+                loopJitter.add(maxUs - period);
+            }
+            haveTiming = true;
+            timingLast = timing.time;
+        } else if (type == TLM_ADC) {
+            TlmAdc adc = getRecord<TlmAdc>(payload);
+            unsigned int scans = adc.channels ? adc.count / adc.channels : 0;
+            // a new stream, after a rate change, starts again from scan 0
+            if (counts[type] > 1 && adc.scan >= adcNext)
+                adcLost += adc.scan - adcNext;
+            adcNext = adc.scan + scans;
+            adcScans += scans;
+            adcRate = adc.rate;
+        } else if (type == TLM_SUPPLY) {
+            TlmSupply supply = getRecord<TlmSupply>(payload);
+            for (int leg = 0; leg < TLM_NUM_LEGS; leg++)
+                if (supply.peak[leg] > peakCurrent[leg])
+                    peakCurrent[leg] = supply.peak[leg];
+            totalCurrent.add(supply.current[0] + supply.current[1]);
+            if (supply.servoMv < servoMinMv)
+                servoMinMv = supply.servoMv;
+            if (supply.logicMv < logicMinMv)
+                logicMinMv = supply.logicMv;
+            supplyLatency.add(supply.latencyMaxUs);
+        }
+    }
+};
+
+static int statsCommand(const char *path, double deadlineMs)
+{
+    MappedFile capture;
+    if (!capture.open(path)) {
+        perror(path);
+        return 1;
+    }
+
+    StatsSink stats(deadlineMs);
+    LinkStats link;
+    decodeCapture(capture.data(), capture.size(), stats, link);
+
+    printf("capture          %s, %zu bytes\n", path, capture.size());
+    printf("packets          %llu, %llu records\n", link.packets, link.records);
+    printf("lost packets     %llu (%.3f%%)\n", link.lostPackets,
+           link.packets ? 100.0 * link.lostPackets / (link.packets + link.lostPackets) : 0.0);
+    printf("bad packets      %llu, %llu bytes skipped\n", link.badPackets, link.skippedBytes);
+    printf("records          imu %llu, joints %llu, timing %llu, adc %llu, supply %llu\n",
+           stats.counts[TLM_IMU], stats.counts[TLM_JOINTS], stats.counts[TLM_TIMING], stats.counts[TLM_ADC],
+           stats.counts[TLM_SUPPLY]);
+
+    if (stats.imuInterval.count() > 0) {
+        const RunningStats &dt = stats.imuInterval;
+        double span = (unsigned int)(stats.imuLast - stats.imuFirst);
+        printf("imu rate         %.2f Hz over %.1f s\n",
+               span > 0 ? dt.count() * 1e3 / span : 0.0, span / 1e3);
+        printf("imu interval     mean %.3f ms, sd %.3f ms, min %.0f ms, max %.0f ms\n",
+               dt.average(), dt.deviation(), dt.min(), dt.max());
+    }
+
+    if (stats.adcScans > 0)
+        printf("adc scans        %llu at %u Hz, %llu lost (%.3f%%)\n", stats.adcScans, stats.adcRate,
+               stats.adcLost, 100.0 * stats.adcLost / (stats.adcScans + stats.adcLost));
+
+    if (stats.counts[TLM_SUPPLY] > 0) {
+        printf("servo current    mean %.0f mA, max %.0f mA, peaks right %d mA, left %d mA\n",
+               stats.totalCurrent.average(), stats.totalCurrent.max(),
+               stats.peakCurrent[0], stats.peakCurrent[1]);
+        printf("supply minimum   servo %u mV, logic %u mV\n", stats.servoMinMv, stats.logicMinMv);
+        printf("supply latency   mean max %.0f us, max %.0f us\n",
+               stats.supplyLatency.average(), stats.supplyLatency.max());
+    }
+
+    if (stats.loopMax.count() > 0) {
+        printf("loop period      mean %.1f us (%.0f Hz)\n", stats.loopPeriod.average(),
+               stats.loopPeriod.average() > 0 ? 1e6 / stats.loopPeriod.average() : 0.0);
+        printf("loop longest     mean %.1f us, max %.1f us\n",
+               stats.loopMax.average(), stats.loopMax.max());
+        printf("loop jitter      mean %.1f us, max %.1f us\n",
+               stats.loopJitter.average(), stats.loopJitter.max());
+        printf("deadline misses  %llu of %llu windows over %.1f ms\n", stats.deadlineMisses,
+               stats.loopMax.count(), deadlineMs);
+        printf("usb interrupt    mean max %.1f us, max %.1f us\n",
+               stats.usbIsrMax.average(), stats.usbIsrMax.max());
+        printf("firmware drops   %llu records, ring peak %u bytes\n",
+               stats.droppedRecords, stats.maxQueued);
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * log
+ *---------------------------------------------------------------------------*/
+
+// Gathers every record field into its own column
+struct ColumnSink {
+    std::vector<std::vector<unsigned char> > columns[TLM_NUM_TYPES];
+    unsigned int rows[TLM_NUM_TYPES];
+
+    ColumnSink()
+    {
+        for (int t = 1; t < TLM_NUM_TYPES; t++) {
+            columns[t].resize(recordTypes[t].numColumns);
+            rows[t] = 0;
+        }
+    }
+
+    void record(int type, const unsigned char *payload)
+    {
+        const RecordType &rt = recordTypes[type];
+        for (int c = 0; c < rt.numColumns; c++) {
+            const Column &col = rt.columns[c];
+            columns[type][c].insert(columns[type][c].end(),
+                                    payload + col.offset, payload + col.offset + col.size);
+        }
+        rows[type]++;
+    }
+};
+
+static void putU16(FILE *out, unsigned int v)
+{
+    fputc(v & 0xFF, out);
+    fputc((v >> 8) & 0xFF, out);
+}
+
+static void putU32(FILE *out, unsigned int v)
+{
+    putU16(out, v & 0xFFFF);
+    putU16(out, v >> 16);
+}
+
+static int logCommand(const char *path, const char *logPath)
+{
+    MappedFile capture;
+    if (!capture.open(path)) {
+        perror(path);
+        return 1;
+    }
+
+    ColumnSink sink;
+    LinkStats link;
+    decodeCapture(capture.data(), capture.size(), sink, link);
+
+    FILE *out = fopen(logPath, "wb");
+    if (!out) {
+        perror(logPath);
+        return 1;
+    }
+    fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), out);
+    putU16(out, TLM_NUM_TYPES - 1);
+    putU16(out, 0);
+
+    for (int t = 1; t < TLM_NUM_TYPES; t++) {
+        const RecordType &rt = recordTypes[t];
+        fputc(t, out);
+        fputc(rt.numColumns, out);
+        putU16(out, 0);
+        putU32(out, sink.rows[t]);
+        for (int c = 0; c < rt.numColumns; c++) {
+            char name[LOG_NAME_SIZE] = { 0 };
+            strncpy(name, rt.columns[c].name, sizeof(name) - 1);
+            fwrite(name, 1, sizeof(name), out);
+            fputc(rt.columns[c].size | (rt.columns[c].isSigned ? 0x80 : 0), out);
+        }
+        for (int c = 0; c < rt.numColumns; c++)
+            if (!sink.columns[t][c].empty())
+                fwrite(&sink.columns[t][c][0], 1, sink.columns[t][c].size(), out);
+    }
+
+    if (fclose(out) != 0) {
+        perror(logPath);
+        return 1;
+    }
+    fprintf(stderr, "%s: %llu imu, %u joints, %u timing, %u adc, %u supply records from %llu packets\n",
+            logPath, (unsigned long long)sink.rows[TLM_IMU], sink.rows[TLM_JOINTS], sink.rows[TLM_TIMING],
+            sink.rows[TLM_ADC], sink.rows[TLM_SUPPLY], link.packets);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * csv
+ *---------------------------------------------------------------------------*/
+
+static void writeHeader(FILE *out, const RecordType &rt)
+{
+    for (int c = 0; c < rt.numColumns; c++)
+        fprintf(out, "%s%s", c ? "," : "", rt.columns[c].name);
+    fputc('\n', out);
+}
+
+// Writes the rows of one record type straight from a capture
+struct CsvSink {
+    FILE *out;
+    int type;
+
+    void record(int recordType, const unsigned char *payload)
+    {
+        if (recordType != type)
+            return;
+        const RecordType &rt = recordTypes[type];
+        for (int c = 0; c < rt.numColumns; c++) {
+            const Column &col = rt.columns[c];
+            fprintf(out, "%s%lld", c ? "," : "", getField(payload + col.offset, col.size, col.isSigned));
+        }
+        fputc('\n', out);
+    }
+};
+
+// Writes the rows of one table of a columnar log, false if it is malformed
+static bool writeLogCsv(const unsigned char *data, size_t size, int type, FILE *out)
+{
+    size_t pos = 8;
+    int tables = data[4] | (data[5] << 8);
+
+    for (int t = 0; t < tables; t++) {
+        if (pos + 8 > size)
+            return false;
+        int tableType = data[pos];
+        int numColumns = data[pos + 1];
+        size_t rows = getField(data + pos + 4, 4, false);
+        pos += 8;
+
+        const unsigned char *header = data + pos;
+        size_t rowSize = 0;
+        pos += numColumns * (LOG_NAME_SIZE + 1);
+        if (pos > size)
+            return false;
+        for (int c = 0; c < numColumns; c++)
+            rowSize += header[c * (LOG_NAME_SIZE + 1) + LOG_NAME_SIZE] & 0x7F;
+        if (pos + rows * rowSize > size)
+            return false;
+
+        if (tableType == type) {
+            std::vector<const unsigned char *> column(numColumns);
+            std::vector<int> width(numColumns);
+            std::vector<bool> isSigned(numColumns);
+            const unsigned char *p = data + pos;
+            for (int c = 0; c < numColumns; c++) {
+                const unsigned char *h = header + c * (LOG_NAME_SIZE + 1);
+                fprintf(out, "%s%.*s", c ? "," : "", (int)LOG_NAME_SIZE, (const char *)h);
+                width[c] = h[LOG_NAME_SIZE] & 0x7F;
+                isSigned[c] = (h[LOG_NAME_SIZE] & 0x80) != 0;
+                column[c] = p;
+                p += rows * width[c];
+            }
+            fputc('\n', out);
+            for (size_t r = 0; r < rows; r++) {
+                for (int c = 0; c < numColumns; c++)
+                    fprintf(out, "%s%lld", c ? "," : "",
+                            getField(column[c] + r * width[c], width[c], isSigned[c]));
+                fputc('\n', out);
+            }
+            return true;
+        }
+        pos += rows * rowSize;
+    }
+    return true;
+}
+
+static int csvCommand(const char *path, const char *typeName, const char *csvPath)
+{
+    int type = 0;
+    for (int t = 1; t < TLM_NUM_TYPES; t++)
+        if (strcmp(typeName, recordTypes[t].name) == 0)
+            type = t;
+    if (type == 0) {
+        fprintf(stderr, "tlmrec: unknown record type %s\n", typeName);
+        return 2;
+    }
+
+    MappedFile input;
+    if (!input.open(path)) {
+        perror(path);
+        return 1;
+    }
+    FILE *out = stdout;
+    if (csvPath && !(out = fopen(csvPath, "w"))) {
+        perror(csvPath);
+        return 1;
+    }
+
+    int result = 0;
+    if (input.size() >= 8 && memcmp(input.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) == 0) {
+        if (!writeLogCsv(input.data(), input.size(), type, out)) {
+            fprintf(stderr, "tlmrec: %s is truncated\n", path);
+            result = 1;
+        }
+    } else {
+        CsvSink sink = { out, type };
+        LinkStats link;
+        writeHeader(out, recordTypes[type]);
+        decodeCapture(input.data(), input.size(), sink, link);
+    }
+
+    if (out != stdout)
+        fclose(out);
+    return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: tlmrec record <tty> <capture.bin> [-r hz] [-t seconds]\n"
+            "       tlmrec stats  <capture.bin> [-d deadline_ms]\n"
+            "       tlmrec log    <capture.bin> <log.tlc>\n"
+            "       tlmrec csv    <capture.bin|log.tlc> <imu|joints|timing|adc|supply> [out.csv]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    std::string command = argv[1];
+
+    // options after the positional arguments
+    int rateHz = -1;
+    double seconds = 0;
+    double deadlineMs = 20;
+    std::vector<const char *> args;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-r") == 0)
+            rateHz = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-t") == 0)
+            seconds = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-d") == 0)
+            deadlineMs = atof(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (command == "record" && args.size() == 2)
+        return recordCommand(args[0], args[1], rateHz, seconds);
+    if (command == "stats" && args.size() == 1)
+        return statsCommand(args[0], deadlineMs);
+    if (command == "log" && args.size() == 2)
+        return logCommand(args[0], args[1]);
+    if (command == "csv" && (args.size() == 2 || args.size() == 3))
+        return csvCommand(args[0], args[1], args.size() == 3 ? args[2] : 0);
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,206 @@
+/*=============================================================================
+ * trace2json - converts a firmware event trace dump to Chrome trace JSON
+ *
+ * Usage:
+ *     trace2json [-c command] <dump.bin | /dev/ttyACM0> [trace.json]
+ *
+ * The input is either a saved dump or the robot's USB serial port. For a
+ * port the dump command is sent first: "t" for the MPU6050 firmware (the
+ * default) or "trace\n" for the leg controller. With no output file the
+ * JSON goes to stdout. Open the result in about://tracing or ui.perfetto.dev.
+ *
+ * Dump layout and the event names come from the firmware's Trace.h.
+ *===========================================================================*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SerialPort.h"
+#include "Trace.h"
+
+struct EventInfo {
+    const char *name;
+    const char *track;
+};
+
+#define TRACE_INFO_ENTRY(id, name, track) { name, track },
+static const EventInfo eventInfo[TRACE_NUM_EVENTS] = {
+    TRACE_EVENT_LIST(TRACE_INFO_ENTRY)
+};
+#undef TRACE_INFO_ENTRY
+
+static unsigned int getU16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int getU32(const unsigned char *p)
+{
+    return getU16(p) | (getU16(p + 2) << 16);
+}
+
+// Reads the whole dump from a file or, after sending command, from a port
+static bool readDump(const std::string &path, const std::string &command,
+                     std::vector<unsigned char> &dump)
+{
+    dump.resize(TRACE_HEADER_SIZE);
+
+    if (SerialPort::isDevice(path)) {
+        SerialPort port;
+        if (!port.open(path, 2000) || !port.write(command)) {
+            fprintf(stderr, "trace2json: cannot use %s\n", path.c_str());
+            return false;
+        }
+        // Skip any telemetry or echo until the magic shows up
+        size_t matched = 0;
+        while (matched < 4) {
+            unsigned char c;
+            if (port.read(&c, 1) != 1) {
+                fprintf(stderr, "trace2json: no trace from %s\n", path.c_str());
+                return false;
+            }
+            if (c == (unsigned char)TRACE_MAGIC[matched])
+                dump[matched++] = c;
+            else
+                matched = c == (unsigned char)TRACE_MAGIC[0] ? 1 : 0;
+        }
+        if (!port.readFully(&dump[4], TRACE_HEADER_SIZE - 4))
+            return false;
+        size_t count = getU16(&dump[8]);
+        dump.resize(TRACE_HEADER_SIZE + count * sizeof(TraceRecord));
+        if (!port.readFully(&dump[TRACE_HEADER_SIZE], count * sizeof(TraceRecord))) {
+            fprintf(stderr, "trace2json: dump from %s cut short\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    FILE *in = fopen(path.c_str(), "rb");
+    if (!in) {
+        perror(path.c_str());
+        return false;
+    }
+    dump.clear();
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        dump.insert(dump.end(), buf, buf + n);
+    fclose(in);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string command = "t";
+    int arg = 1;
+
+    if (arg + 1 < argc && strcmp(argv[arg], "-c") == 0) {
+        command = argv[arg + 1];
+        // allow "trace\n" to be typed on the command line
+        size_t pos;
+        while ((pos = command.find("\\n")) != std::string::npos)
+            command.replace(pos, 2, "\n");
+        arg += 2;
+    }
+    if (arg >= argc) {
+        fprintf(stderr, "usage: trace2json [-c command] <dump.bin|tty> [trace.json]\n");
+        return 2;
+    }
+
+    std::vector<unsigned char> dump;
+    if (!readDump(argv[arg], command, dump))
+        return 1;
+    if (dump.size() < TRACE_HEADER_SIZE || memcmp(&dump[0], TRACE_MAGIC, 4) != 0) {
+        fprintf(stderr, "trace2json: %s is not a trace dump\n", argv[arg]);
+        return 1;
+    }
+
+    double tickHz = getU32(&dump[4]);
+    size_t count = getU16(&dump[8]);
+    if (dump.size() < TRACE_HEADER_SIZE + count * sizeof(TraceRecord)) {
+        fprintf(stderr, "trace2json: dump truncated\n");
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (arg + 1 < argc && !(out = fopen(argv[arg + 1], "w"))) {
+        perror(argv[arg + 1]);
+        return 1;
+    }
+
+    // One Chrome thread per firmware track, in event list order
+    std::map<std::string, int> tids;
+    for (int i = 0; i < TRACE_NUM_EVENTS; i++)
+        if (!tids.count(eventInfo[i].track)) {
+            int tid = tids.size() + 1;
+            tids[eventInfo[i].track] = tid;
+        }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (std::map<std::string, int>::const_iterator t = tids.begin(); t != tids.end(); ++t) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t->second, t->first.c_str());
+        first = false;
+    }
+
+    // Timestamps are 32 bit core timer counts, unwrap them against the
+    // previous record. Records are close together, so a signed delta works
+    // even when an ISR took its timestamp just before a preempted task.
+    long long ticks = 0;
+    unsigned int previous = 0;
+    std::vector<int> open(TRACE_NUM_EVENTS, 0);
+    const unsigned char *p = &dump[TRACE_HEADER_SIZE];
+
+    for (size_t i = 0; i < count; i++, p += sizeof(TraceRecord)) {
+        unsigned int time = getU32(p);
+        unsigned int id = getU16(p + 4);
+        unsigned int value = getU16(p + 6);
+        unsigned int event = id & ~TRACE_KIND_MASK;
+
+        if (i > 0)
+            ticks += (int)(time - previous);
+        previous = time;
+
+        if (event >= TRACE_NUM_EVENTS)
+            continue;
+
+        const char *ph;
+        switch (id & TRACE_KIND_MASK) {
+            case TRACE_KIND_BEGIN:
+                ph = "B";
+                open[event]++;
+                break;
+            case TRACE_KIND_END:
+                // its begin was overwritten in the ring
+                if (open[event] == 0)
+                    continue;
+                open[event]--;
+                ph = "E";
+                break;
+            case TRACE_KIND_COUNTER:
+                ph = "C";
+                break;
+            default:
+                ph = "i";
+                break;
+        }
+
+        fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                eventInfo[event].name, ph, ticks * 1e6 / tickHz, tids[eventInfo[event].track]);
+        if (ph[0] == 'C')
+            fprintf(out, ",\"args\":{\"%s\":%u}}", eventInfo[event].name, value);
+        else if (ph[0] == 'i')
+            fprintf(out, ",\"s\":\"t\",\"args\":{\"arg\":%u}}", value);
+        else
+            fprintf(out, ",\"args\":{\"arg\":%u}}", value);
+    }
+    fprintf(out, "\n]}\n");
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
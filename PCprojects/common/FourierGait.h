@@ -0,0 +1,191 @@
+/*=============================================================================
+ * The report's Fourier series walking gait
+ *
+ * The gait is two sums of sines fitted offline,
+ *     phi_3(t) = sum a_k3L sin(b_k3L t + c_k3L)    k = 1..8
+ *     phi_4(t) = sum a_k4L sin(b_k4L t + c_k4L)    k = 1..7
+ * with the hip at phi_3 and the knee at phi_3 - phi_4, in degrees.
+ * Coefficient files hold assignments in the report's form, "a13L = 73.11;",
+ * and change only the terms they name.
+ *
+ * The fit covers several strides, so its terms are not exact harmonics of
+ * one cycle. findPeriod() picks the shift between 0.2 and 1 s that best
+ * repeats the motion, and GaitCycle spreads the small mismatch left at the
+ * ends of one cycle over it as a linear ramp, so a table sampled from it
+ * loops without a step.
+ *
+ * Shared by gaitc and gaitopt.
+ *===========================================================================*/
+#ifndef __FOURIER_GAIT_H__
+#define __FOURIER_GAIT_H__
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+static const int NUM_JOINTS = 6;
+static const int HIP3 = 2;
+static const int KNEE = 3;
+
+// Terms per series, coefficient names have one digit for the term
+static const int MAX_TERMS = 8;
+
+struct Series {
+    int terms;
+    double a[MAX_TERMS], b[MAX_TERMS], c[MAX_TERMS];
+
+    double operator()(double t) const
+    {
+        double sum = 0;
+        for (int k = 0; k < terms; k++)
+            sum += a[k] * sin(b[k] * t + c[k]);
+        return sum;
+    }
+};
+
+struct FourierGait {
+    Series phi3, phi4;
+
+    // Joint angles in degrees at time t, JointType order
+    void operator()(double t, double angle[NUM_JOINTS]) const
+    {
+        for (int j = 0; j < NUM_JOINTS; j++)
+            angle[j] = 0;
+        angle[HIP3] = phi3(t);
+        angle[KNEE] = phi3(t) - phi4(t);
+    }
+};
+
+// phi_3 and phi_4 from the report's locomotion controller section
+inline FourierGait reportGait()
+{
+    FourierGait gait = {
+        {
+            8,
+            { 73.11, 52.58, 12.35, 3.357, 62.63, 12.04, 1.786, 1.418 },
+            { 19.69, 0.6307, 12.05, 29.81, 20.15, 5.405, 34.76, 47.2 },
+            { -0.6449, 2.671, -2.836, -0.797, 2.236, 3.598, 1.995, -0.402 }
+        },
+        {
+            7,
+            { 14.91, 1.559, 27.52, 28.88, 15.08, 1.769, 31.1 },
+            { 0.8727, 19.4, 15.42, 45.43, 31.49, 9.852, 45.58 },
+            { 4.016, -1.197, 0.9818, -5.819, 1.844, -5.219, -2.751 }
+        }
+    };
+    return gait;
+}
+
+// Reads "a13L = 73.11;" style assignments into gait, returns the number taken or -1
+inline int readCoefficients(const char *path, FourierGait &gait)
+{
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return -1;
+    std::string text;
+    int ch;
+    while ((ch = fgetc(in)) != EOF)
+        text += (char)ch;
+    fclose(in);
+
+    int count = 0;
+    for (size_t i = 0; i + 4 < text.size(); i++) {
+        char kind = text[i];
+        if ((kind != 'a' && kind != 'b' && kind != 'c') || (i > 0 && isalnum((unsigned char)text[i - 1])))
+            continue;
+        if (!isdigit((unsigned char)text[i + 1]) || !isdigit((unsigned char)text[i + 2]) || text[i + 3] != 'L')
+            continue;
+        int term = text[i + 1] - '1';
+        int which = text[i + 2] - '0';
+        Series *series = which == 3 ? &gait.phi3 : which == 4 ? &gait.phi4 : 0;
+        double value;
+        if (!series || term < 0 || term >= MAX_TERMS || sscanf(text.c_str() + i + 4, " = %lf", &value) != 1)
+            continue;
+        (kind == 'a' ? series->a : kind == 'b' ? series->b : series->c)[term] = value;
+        series->terms = std::max(series->terms, term + 1);
+        count++;
+    }
+    return count;
+}
+
+/*
+ * Writes gait in the form readCoefficients() takes, every term with the
+ * unused ones zero so none of the report's are left over when it is read
+ * back. False if path cannot be written.
+ */
+inline bool writeCoefficients(const char *path, const FourierGait &gait)
+{
+    FILE *out = fopen(path, "w");
+    if (!out)
+        return false;
+    for (int which = 3; which <= 4; which++) {
+        const Series &s = which == 3 ? gait.phi3 : gait.phi4;
+        fprintf(out, "%% phi_%d\n", which);
+        for (int k = 0; k < MAX_TERMS; k++) {
+            bool used = k < s.terms;
+            fprintf(out, "a%d%dL = %.10g; b%d%dL = %.10g; c%d%dL = %.10g;\n", k + 1, which, used ? s.a[k] : 0.0,
+                    k + 1, which, used ? s.b[k] : 0.0, k + 1, which, used ? s.c[k] : 0.0);
+        }
+    }
+    return fclose(out) == 0;
+}
+
+// RMS difference in degrees between the motion and itself shifted by period
+inline double repeatError(const FourierGait &gait, double period)
+{
+    const int points = 200;
+    double sum = 0;
+    for (int i = 0; i < points; i++) {
+        double t = period * i / points;
+        double x[NUM_JOINTS], y[NUM_JOINTS];
+        gait(t, x);
+        gait(t + period, y);
+        for (int j = 0; j < NUM_JOINTS; j++)
+            sum += (x[j] - y[j]) * (x[j] - y[j]);
+    }
+    return sqrt(sum / (points * NUM_JOINTS));
+}
+
+// Cycle time of the fit to 0.1 ms, reported on stderr
+inline double findPeriod(const FourierGait &gait)
+{
+    double best = 0, bestError = 1e30;
+    for (int i = 2000; i <= 10000; i++) {
+        double period = i * 1e-4;
+        double error = repeatError(gait, period);
+        if (error < bestError) {
+            bestError = error;
+            best = period;
+        }
+    }
+    fprintf(stderr, "period %.4f s, cycles repeat within %.2f deg rms\n", best, bestError);
+    return best;
+}
+
+// One cycle with the end mismatch ramped out, so it is periodic in value
+struct GaitCycle {
+    FourierGait gait;
+    double period;
+    double start[NUM_JOINTS];
+    double seam[NUM_JOINTS];
+
+    GaitCycle(const FourierGait &g, double p) : gait(g), period(p)
+    {
+        double end[NUM_JOINTS];
+        gait(0, start);
+        gait(period, end);
+        for (int j = 0; j < NUM_JOINTS; j++)
+            seam[j] = end[j] - start[j];
+    }
+
+    void operator()(double t, double angle[NUM_JOINTS]) const
+    {
+        gait(t, angle);
+        for (int j = 0; j < NUM_JOINTS; j++)
+            angle[j] -= seam[j] * t / period;
+    }
+};
+
+#endif
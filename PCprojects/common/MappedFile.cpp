@@ -0,0 +1,51 @@
+/*=============================================================================
+ * Read only memory mapped file, see MappedFile.h
+ *===========================================================================*/
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : base(0), length(0) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        // parsed front to back
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        base = static_cast<const unsigned char *>(p);
+        length = st.st_size;
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (base)
+        munmap(const_cast<unsigned char *>(base), length);
+    base = 0;
+    length = 0;
+}
@@ -0,0 +1,35 @@
+/*=============================================================================
+ * Read only memory mapped file
+ *
+ * Captures and logs are parsed in place through the mapping, so nothing is
+ * copied however large the recording is.
+ *===========================================================================*/
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+
+    public:
+    MappedFile();
+    ~MappedFile();
+
+    // Maps the whole file, false if it cannot be opened. An empty file
+    // maps to a null pointer with size 0.
+    bool open(const std::string &path);
+    void close();
+
+    const unsigned char *data() const { return base; }
+    size_t size() const { return length; }
+
+    private:
+    const unsigned char *base;
+    size_t length;
+
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*=============================================================================
+ * Comma separated number lists on the command line, "100,100,40"
+ *
+ * Shared by pendsim and gaitopt.
+ *===========================================================================*/
+#ifndef __PARSE_LIST_H__
+#define __PARSE_LIST_H__
+
+#include <cstdlib>
+
+// Reads up to max comma separated numbers, returns the count or -1 if the
+// text is not such a list or holds more than max
+inline int parseList(const char *text, double *values, int max)
+{
+    int count = 0;
+    while (count < max && *text) {
+        char *end;
+        values[count++] = strtod(text, &end);
+        if (end == text)
+            return -1;
+        text = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',')
+            return -1;
+    }
+    return *text ? -1 : count;
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*=============================================================================
+ * Flash pulse tables for libraries/GaitTable
+ *
+ * A motion is any functor motion(t, angle) giving the six joint angles of a
+ * leg in degrees, JointType order, periodic in the cycle time. It is
+ * sampled at a power of two rows per cycle and angles become SSC-32 pulses
+ * with P = theta / 90 * 1000 + 1500, rounded and held in 500..2500.
+ * playbackError() compares linear playback between rows with the motion,
+ * to choose the row count by, and writePulseTable() emits the C header the
+ * firmware includes.
+ *
+ * Shared by gaitc and gaitopt.
+ *===========================================================================*/
+#ifndef __PULSE_TABLE_H__
+#define __PULSE_TABLE_H__
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct PulseTable {
+    static const int JOINTS = 6;
+
+    double period;                      // s
+    int samples, bits;
+    int clamped;                        // pulses held to 500..2500
+    std::vector<unsigned short> pulse;  // samples rows of JOINTS
+};
+
+inline double anglePulse(double degrees)
+{
+    return degrees / 90 * 1000 + 1500;
+}
+
+// samples must be a power of two
+template <class Motion>
+PulseTable samplePulseTable(const Motion &motion, double period, int samples)
+{
+    PulseTable table;
+    table.period = period;
+    table.samples = samples;
+    table.bits = 0;
+    while ((1 << table.bits) < samples)
+        table.bits++;
+    table.clamped = 0;
+    table.pulse.resize(samples * PulseTable::JOINTS);
+
+    for (int i = 0; i < samples; i++) {
+        double angle[PulseTable::JOINTS];
+        motion(period * i / samples, angle);
+        for (int j = 0; j < PulseTable::JOINTS; j++) {
+            double p = floor(anglePulse(angle[j]) + 0.5);
+            if (p < 500 || p > 2500) {
+                p = std::min(std::max(p, 500.0), 2500.0);
+                table.clamped++;
+            }
+            table.pulse[i * PulseTable::JOINTS + j] = (unsigned short)p;
+        }
+    }
+    return table;
+}
+
+// Worst difference in us between linear playback of the table and the motion
+template <class Motion>
+double playbackError(const PulseTable &table, const Motion &motion)
+{
+    const int sub = 16;
+    const int J = PulseTable::JOINTS;
+    double worst = 0;
+    for (int i = 0; i < table.samples; i++) {
+        const unsigned short *a = &table.pulse[i * J];
+        const unsigned short *b = &table.pulse[((i + 1) % table.samples) * J];
+        for (int s = 0; s < sub; s++) {
+            double f = (double)s / sub;
+            double angle[J];
+            motion(table.period * (i + f) / table.samples, angle);
+            for (int j = 0; j < J; j++)
+                worst = std::max(worst, fabs(a[j] + (b[j] - a[j]) * f - anglePulse(angle[j])));
+        }
+    }
+    return worst;
+}
+
+// "reportGait" -> "__REPORT_GAIT_H__"
+inline std::string includeGuard(const std::string &name)
+{
+    std::string guard = "__";
+    for (size_t i = 0; i < name.size(); i++) {
+        if (isupper((unsigned char)name[i]) && i > 0)
+            guard += '_';
+        guard += (char)toupper((unsigned char)name[i]);
+    }
+    return guard + "_H__";
+}
+
+/*
+ * The table as a header defining GaitTable name, to outPath or stdout when
+ * it is null. tool and rebuild go in the banner. False if it cannot be
+ * written.
+ */
+inline bool writePulseTable(const PulseTable &table, const std::string &name, const char *tool,
+                            const std::string &rebuild, const char *outPath)
+{
+    const int J = PulseTable::JOINTS;
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out)
+        return false;
+
+    std::string rows;
+    for (int i = 0; i < table.samples; i++) {
+        rows += "    ";
+        for (int j = 0; j < J; j++) {
+            char text[16];
+            snprintf(text, sizeof(text), "%d,%s", table.pulse[i * J + j], j + 1 < J ? " " : "\n");
+            rows += text;
+        }
+    }
+
+    std::string guard = includeGuard(name);
+    int periodMs = (int)floor(table.period * 1000 + 0.5);
+    fprintf(out,
+            "/*\n"
+            " * Generated by %s, do not edit. Rebuild with\n"
+            " *     %s\n"
+            " *\n"
+            " * SSC-32 pulses for the six joints of a leg in JointType order, one\n"
+            " * row every %.2f ms of a %d ms cycle.\n"
+            " */\n"
+            "#ifndef %s\n"
+            "#define %s\n"
+            "\n"
+            "#include <GaitTable.h>\n"
+            "\n"
+            "static const unsigned short %sPulse[%d * %d] = {\n"
+            "%s"
+            "};\n"
+            "\n"
+            "static const GaitTable %s = { %d, %d, %d, %d, %sPulse };\n"
+            "\n"
+            "#endif\n",
+            tool, rebuild.c_str(),
+            table.period * 1000 / table.samples, periodMs,
+            guard.c_str(), guard.c_str(),
+            name.c_str(), table.samples, J, rows.c_str(),
+            name.c_str(), table.samples, table.bits, J, periodMs, name.c_str());
+    if (outPath)
+        return fclose(out) == 0;
+    return true;
+}
+
+#endif
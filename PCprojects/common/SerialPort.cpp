@@ -0,0 +1,90 @@
+/*=============================================================================
+ * Raw serial port access, see SerialPort.h
+ *===========================================================================*/
+#include "SerialPort.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+SerialPort::SerialPort() : fd(-1) {}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+bool SerialPort::open(const std::string &path, int timeoutMs)
+{
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return false;
+
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = timeoutMs / 100 > 0 ? timeoutMs / 100 : 1;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+    }
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+bool SerialPort::write(const void *data, size_t length)
+{
+    const char *p = static_cast<const char *>(data);
+
+    while (length > 0) {
+        ssize_t n = ::write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+long SerialPort::read(void *data, size_t length)
+{
+    for (;;) {
+        ssize_t n = ::read(fd, data, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        return n;
+    }
+}
+
+bool SerialPort::readFully(void *data, size_t length)
+{
+    char *p = static_cast<char *>(data);
+
+    while (length > 0) {
+        long n = read(p, length);
+        if (n <= 0)
+            return false;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool SerialPort::isDevice(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISCHR(st.st_mode);
+}
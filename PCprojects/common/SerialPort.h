@@ -0,0 +1,45 @@
+/*=============================================================================
+ * Raw serial port access for the robot's USB CDC link on Linux
+ *
+ * The UBW32 enumerates as /dev/ttyACMx. CDC ignores the baud rate, so the
+ * port is only switched to raw mode with a read timeout.
+ *===========================================================================*/
+#ifndef __SERIAL_PORT_H__
+#define __SERIAL_PORT_H__
+
+#include <cstddef>
+#include <string>
+
+class SerialPort {
+
+    public:
+    SerialPort();
+    ~SerialPort();
+
+    // Opens a tty in raw mode, reads time out after timeoutMs
+    bool open(const std::string &path, int timeoutMs = 1000);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int handle() const { return fd; }
+
+    // Writes all of data, false on error
+    bool write(const void *data, size_t length);
+    bool write(const std::string &text) { return write(text.data(), text.size()); }
+
+    // Reads up to length bytes, 0 on timeout, -1 on error
+    long read(void *data, size_t length);
+
+    // Reads exactly length bytes unless the port times out first
+    bool readFully(void *data, size_t length);
+
+    // True if path is a character device such as a tty
+    static bool isDevice(const std::string &path);
+
+    private:
+    int fd;
+
+    SerialPort(const SerialPort &);
+    SerialPort &operator=(const SerialPort &);
+};
+
+#endif
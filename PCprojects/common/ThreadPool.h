@@ -0,0 +1,174 @@
+/*=============================================================================
+ * Work-stealing thread pool
+ *
+ * Every thread, the caller included, has its own task deque. parallelFor()
+ * cuts a range into tasks and deals them round the deques; a thread takes
+ * work from the back of its own and, when that is empty, steals from the
+ * front of another's. Batches whose tasks cost very different amounts,
+ * such as simulations that fail early, keep every core busy to the end
+ * without a shared queue every thread contends for. Idle workers sleep
+ * until the next batch.
+ *
+ * Tasks are plain function pointers over an index range, nothing is
+ * allocated per task beyond the deque nodes.
+ *===========================================================================*/
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+
+    public:
+    // threads in all, the caller counting as one, 0 for one per core
+    explicit ThreadPool(unsigned threads = 0) : stopping(false), queued(0), remaining(0)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+        queues = std::vector<Queue>(threads);
+        for (unsigned i = 1; i < threads; i++)
+            workers.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> hold(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    unsigned size() const { return (unsigned)queues.size(); }
+
+    /*
+     * Calls body(i) for every i in [0, n) in tasks of grain indices and
+     * returns when all have run. Calls for different i may run at once.
+     */
+    template <class Body>
+    void parallelFor(size_t n, size_t grain, const Body &body)
+    {
+        if (grain == 0)
+            grain = 1;
+        size_t tasks = (n + grain - 1) / grain;
+        if (tasks == 0)
+            return;
+        remaining = tasks;
+        {
+            std::lock_guard<std::mutex> hold(sleepLock);
+            queued += tasks;
+        }
+        for (size_t k = 0; k < tasks; k++) {
+            Task task = { &runRange<Body>, &body, k * grain, k * grain + grain < n ? k * grain + grain : n };
+            Queue &q = queues[k % queues.size()];
+            std::lock_guard<std::mutex> hold(q.lock);
+            q.tasks.push_back(task);
+        }
+        wake.notify_all();
+
+        // the caller is thread 0 and works until the batch is done
+        Task task;
+        while (remaining.load() != 0) {
+            if (take(0, task))
+                run(task);
+            else {
+                std::unique_lock<std::mutex> hold(doneLock);
+                done.wait(hold, [this] { return remaining.load() == 0; });
+            }
+        }
+    }
+
+    private:
+    struct Task {
+        void (*call)(const void *body, size_t begin, size_t end);
+        const void *body;
+        size_t begin, end;
+    };
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;               // guards stopping and queued for wake
+    std::condition_variable wake;
+    bool stopping;
+    size_t queued;                      // tasks sitting in any deque
+
+    std::atomic<size_t> remaining;      // tasks of the batch not finished
+    std::mutex doneLock;
+    std::condition_variable done;
+
+    template <class Body>
+    static void runRange(const void *body, size_t begin, size_t end)
+    {
+        const Body &f = *static_cast<const Body *>(body);
+        for (size_t i = begin; i < end; i++)
+            f(i);
+    }
+
+    // Own deque from the back, then the others' from the front
+    bool take(unsigned self, Task &task)
+    {
+        size_t count = queues.size();
+        for (size_t k = 0; k < count; k++) {
+            Queue &q = queues[(self + k) % count];
+            std::lock_guard<std::mutex> hold(q.lock);
+            if (q.tasks.empty())
+                continue;
+            if (k == 0) {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            } else {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            std::lock_guard<std::mutex> tally(sleepLock);
+            queued--;
+            return true;
+        }
+        return false;
+    }
+
+    void run(const Task &task)
+    {
+        task.call(task.body, task.begin, task.end);
+        if (--remaining == 0) {
+            std::lock_guard<std::mutex> hold(doneLock);
+            done.notify_all();
+        }
+    }
+
+    void work(unsigned self)
+    {
+        Task task;
+        for (;;) {
+            if (take(self, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> hold(sleepLock);
+            wake.wait(hold, [this] { return stopping || queued != 0; });
+            if (stopping)
+                return;
+        }
+    }
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif